@@ -0,0 +1,92 @@
+#if ! defined POTEXT_PO_ACCEPTLANGUAGE_HPP
+#define POTEXT_PO_ACCEPTLANGUAGE_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          acceptlanguage.hpp
+ *
+ *      Parsing of the HTTP Accept-Language header.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  An Accept-Language header lists language ranges with optional
+ *  q-values (RFC 9110, section 12.5.4):
+ *
+\verbatim
+    Accept-Language: de-AT, de;q=0.9, en;q=0.5, *;q=0.1
+\endverbatim
+ *
+ *  parse_accept_language() splits it into views of the header, so it does
+ *  not allocate. The ranges are sorted by q-value, keeping the header
+ *  order for equal q-values. See dictionarymgr::negotiate_language().
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <string_view>                  /* std::string_view class           */
+
+namespace po
+{
+
+/**
+ *  The most ranges parse_accept_language() keeps. Browsers send a few;
+ *  the rest of a longer header is ignored.
+ */
+
+const std::size_t c_max_language_ranges = 16;
+
+/**
+ *  One language range of the header. The country is the first two-letter
+ *  or three-digit subtag (e.g. "AT" of "de-AT", "TW" of "zh-Hant-TW");
+ *  script and other subtags are skipped. The q-value is in thousandths.
+ */
+
+struct languagerange
+{
+    std::string_view lr_language;       /* e.g. "de", or "*"                */
+    std::string_view lr_country;        /* e.g. "AT", or empty              */
+    int lr_quality;                     /* 0 to 1000                        */
+};
+
+extern std::size_t parse_accept_language
+(
+    std::string_view header,
+    languagerange * ranges,
+    std::size_t maxranges = c_max_language_ranges
+);
+
+}               // namespace po
+
+#endif          // POTEXT_PO_ACCEPTLANGUAGE_HPP
+
+/*
+ * acceptlanguage.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,178 @@
+#if ! defined POTEXT_PO_COLDSTORE_HPP
+#define POTEXT_PO_COLDSTORE_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+
+/**
+ * \file          coldstore.hpp
+ *
+ *      Compressed storage for the long, rarely used translations of a
+ *      dictionary.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Long help texts and tooltips make up most of the bytes of a catalog,
+ *  but are seldom looked up. A coldstore packs such strings into blocks
+ *  of about 16 KiB and compresses each block with a small LZ77 codec
+ *  (in the style of LZ4: byte-aligned literal runs and back references,
+ *  no entropy coding), which is fast to decode and needs no library.
+ *
+ *  get() decompresses the block of a string into a small cache kept by
+ *  each thread, so that looking up several strings of the same block
+ *  decompresses it once, and the threads need no lock. The cache holds
+ *  c_cached_blocks blocks per thread.
+ *
+ *  get_held() gives out a string in a ring of sm_held_strings slots, also
+ *  kept by each thread, rather than a copy. A reference to a held string
+ *  is valid until the same thread has taken sm_held_strings more, so a
+ *  lookup can hand one out without keeping it for the life of the store.
+ *
+ *  A dictionary stands a stored string in for the original with
+ *  reference(), a five-byte string that fits in a std::string without an
+ *  allocation. Catalog strings cannot contain a NUL byte, so a reference
+ *  cannot be mistaken for a translation. See dictionary::compress_strings().
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <cstdint>                      /* std::uint32_t, std::uint64_t     */
+#include <string>                       /* std::string class                */
+#include <string_view>                  /* std::string_view class           */
+#include <vector>                       /* std::vector<> template           */
+
+namespace po
+{
+
+extern void lz_compress (std::string_view text, std::vector<char> & out);
+extern bool lz_decompress
+(
+    const char * data,
+    std::size_t size,
+    char * out,
+    std::size_t outsize
+);
+
+/**
+ *  Holds strings compressed in blocks.
+ */
+
+class coldstore
+{
+
+public:
+
+    /**
+     *  The size of the strings packed into one block, before compression.
+     *  A longer string gets a block of its own.
+     */
+
+    static constexpr std::size_t sm_block_size = 16 * 1024;
+
+    /**
+     *  The number of strings each thread holds for get_held() and hold().
+     *  A plural lookup takes up to two for each of its (at most 10) forms.
+     */
+
+    static constexpr std::size_t sm_held_strings = 32;
+
+private:
+
+    struct block
+    {
+        std::vector<char> b_data;       /* the compressed bytes             */
+        std::uint32_t b_size;           /* the size decompressed            */
+    };
+
+    struct location
+    {
+        std::uint32_t l_block;
+        std::uint32_t l_offset;
+        std::uint32_t l_size;
+    };
+
+    std::vector<block> m_blocks;
+    std::vector<location> m_strings;
+
+    /**
+     *  The strings added since the last block was sealed.
+     */
+
+    std::string m_open;
+
+    /**
+     *  Identifies this store in the thread caches, which outlive it. Unlike
+     *  its address, it is never re-used.
+     */
+
+    std::uint64_t m_serial;
+
+public:
+
+    coldstore ();
+    coldstore (const coldstore &) = delete;
+    coldstore (coldstore &&) = delete;
+    coldstore & operator = (const coldstore &) = delete;
+    coldstore & operator = (coldstore &&) = delete;
+    ~coldstore () = default;
+
+    std::uint32_t add (std::string_view text);
+    void seal ();
+    bool get (std::uint32_t id, std::string & text) const;
+    const std::string & get_held (std::uint32_t id) const;
+    std::size_t raw_bytes () const;
+    std::size_t compressed_bytes () const;
+    std::size_t memory_usage () const;
+
+    std::size_t count () const
+    {
+        return m_strings.size();
+    }
+
+    static std::string reference (std::uint32_t id);
+
+    static bool is_reference (const std::string & s)
+    {
+        return s.size() == 5 && s[0] == '\0';
+    }
+
+    static std::uint32_t reference_id (const std::string & s);
+    static const std::string & hold (std::string text);
+    static bool is_held (const std::string * s);
+
+};              // class coldstore
+
+}               // namespace po
+
+#endif          // POTEXT_PO_COLDSTORE_HPP
+
+/*
+ * coldstore.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -33,18 +33,24 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-13
+ * \updates       2026-10-18
  * \license       See above.
  *
  */
 
+#include <memory>                       /* std::shared_ptr<> template       */
+#include <mutex>                        /* std::mutex and std::lock_guard<> */
+#include <shared_mutex>                 /* std::shared_mutex, shared_lock<> */
 #include <string>
+#include <string_view>                  /* std::string_view class           */
+#include <unordered_map>                /* std::unordered_map<> template    */
 
 #include "c_macros.h"                   /* not_nullptr() macro function     */
 #include "platform_macros.h"            /* OS & debug macroes etc.          */
 #include "po_build_macros.h"            /* feature macros with explanations */
 #include "po/po_types.hpp"              /* po::phraselist string-vector     */
 #include "po/pluralforms.hpp"           /* po::pluralforms class            */
+#include "po/flatcatalog.hpp"           /* po::flatcatalog class            */
 
 #if defined POTEXT_USE_UNORDERED_DICTIONARY
 #include <unordered_map>
@@ -55,6 +61,9 @@
 namespace po
 {
 
+class coldstore;
+class searchindex;
+
 /**
  *  A simple dictionary class that mimics gettext() behaviour. Each
  *  dictionary only works for a single language, for managing multiple
@@ -76,6 +85,7 @@ public:
         none,
         po,
         mo,
+        flat,
 
         /*
          * json, qm, ...?,
@@ -112,6 +122,15 @@ private:
     using ctxtentries = std::map<std::string, entries>;
 #endif
 
+    /**
+     *  A cache of the translations converted to one codeset, keyed by the
+     *  address of the stored UTF-8 translation (a string, or the text of a
+     *  flatcatalog).
+     */
+
+    using viewcache = std::unordered_map<const void *, std::string>;
+    using viewmap = std::map<std::string, viewcache>;
+
     /**
      *  Holds a set of phraselists, each of which is a vector of message
      *  strings keyed by a string.
@@ -125,12 +144,50 @@ private:
 
     ctxtentries m_ctxt_entries;
 
+    /**
+     *  If not null, the messages are held in this image (often mapped from
+     *  a file shared by several processes) instead of in the maps above.
+     *  See attach().
+     */
+
+    std::shared_ptr<const flatcatalog> m_flat;
+
+    /**
+     *  The search index, built by the first search_index() call after the
+     *  dictionary was changed.
+     */
+
+    mutable std::shared_ptr<const searchindex> m_search_index;
+
+    /**
+     *  If not null, holds the long translations compressed, and the entries
+     *  hold references to them. See compress_strings().
+     */
+
+    std::shared_ptr<coldstore> m_cold;
+
     /**
      *  The character encoding to apply (if not UTF-8) to translated output.
+     *  The translations are always stored in UTF-8 (see storage_charset()),
+     *  so this is only the default view of them.
      */
 
     std::string m_charset;
 
+    /**
+     *  Holds, for each output codeset other than UTF-8, the translations
+     *  converted so far. An entry is made on the first lookup of a
+     *  translation in that codeset, so a codeset change costs nothing
+     *  until the translations are used. The mutex makes const lookups
+     *  from several threads safe; a lookup that finds its conversion takes
+     *  it shared, and the conversion itself is done outside of the lock.
+     *  The translations of a compiled image are copied here only for
+     *  find() and the like, which must return a std::string.
+     */
+
+    mutable std::shared_mutex m_view_mutex;
+    mutable viewmap m_views;
+
     /**
      *  Provides an object holding a count of plurals and the function used
      *  for accessing one of the plurals.  See the from_string() function
@@ -153,6 +210,24 @@ private:
 
     bool m_has_fallback;
 
+    /**
+     *  Indicates that the catalog had fuzzy entries, whether or not they
+     *  were used. Only such a dictionary changes when the dictionarymgr's
+     *  use-fuzzy setting changes.
+     */
+
+    bool m_has_fuzzy;
+
+    /**
+     *  Set while several catalogs are loaded into the dictionary, in order
+     *  of precedence. A message already added shadows the same message in
+     *  the later catalogs, and the parsers skip it (see shadowed()). The
+     *  count is of the messages skipped.
+     */
+
+    bool m_merging;
+    std::size_t m_shadowed_count;
+
     /**
      *  Points to a dictionary to use when a lookup fails for a dictionary.
      *  If not null, then that dictionary will attempt to translate a
@@ -178,7 +253,28 @@ public:
 
     bool empty () const
     {
-        return m_entries.empty();
+        return m_flat ? m_flat->entry_count() == 0 : m_entries.empty() ;
+    }
+
+    bool attach (std::shared_ptr<const flatcatalog> flat);
+
+    const flatcatalog * flat () const
+    {
+        return m_flat.get();
+    }
+
+    std::shared_ptr<const flatcatalog> shared_flat () const
+    {
+        return m_flat;
+    }
+
+    std::shared_ptr<const searchindex> search_index () const;
+    std::size_t memory_usage () const;
+    std::size_t compress_strings (std::size_t threshold);
+
+    bool compressed () const
+    {
+        return bool(m_cold);
     }
 
     std::string get_charset () const
@@ -186,6 +282,61 @@ public:
         return m_charset;
     }
 
+    /**
+     *  The encoding in which the parsers store the translations.
+     */
+
+    static const std::string & storage_charset ()
+    {
+        static const std::string s_storage_charset{"UTF-8"};
+        return s_storage_charset;
+    }
+
+    bool set_charset (const std::string & charset);
+    const std::string & view
+    (
+        const std::string & msgstr,
+        const std::string & codeset = ""
+    ) const;
+    static std::string converted
+    (
+        const std::string & text,
+        const std::string & codeset
+    );
+    std::string converted_view
+    (
+        std::string_view msgstr,
+        const std::string & codeset = ""
+    ) const;
+
+    void note_fuzzy ()
+    {
+        m_has_fuzzy = true;
+    }
+
+    bool has_fuzzy () const
+    {
+        return m_has_fuzzy;
+    }
+
+    void merging (bool flag)
+    {
+        m_merging = flag;
+    }
+
+    bool merging () const
+    {
+        return m_merging;
+    }
+
+    std::size_t shadowed_count () const
+    {
+        return m_shadowed_count;
+    }
+
+    bool shadowed (const std::string & msgid);
+    bool shadowed (const std::string & msgctxt, const std::string & msgid);
+
     /**
      *  Registers the plural forms object for this dictionary. Recall that the
      *  Plural-Forms function is specified in the *.po file's header section.
@@ -224,25 +375,70 @@ public:
         return m_file_mode == mode::mo;
     }
 
-    std::string translate (const std::string & msgid) const;
+    std::string translate
+    (
+        const std::string & msgid,
+        const std::string & codeset = ""
+    ) const;
     std::string translate_plural
     (
         const std::string & msgid,
         const std::string & msgidplural,
-        int num
+        int num,
+        const std::string & codeset = ""
     ) const;
     std::string translate_ctxt
     (
         const std::string & msgctxt,
-        const std::string & msgid
+        const std::string & msgid,
+        const std::string & codeset = ""
     ) const;
     std::string translate_ctxt_plural
     (
         const std::string & msgctxt,
         const std::string & msgid,
         const std::string & msgidplural,
-        int num
+        int num,
+        const std::string & codeset = ""
+    ) const;
+    bool translate_plurals
+    (
+        const std::string & msgid,
+        const std::string & msgidplural,
+        const int * counts,
+        std::size_t count,
+        const std::string ** results,
+        const std::string & codeset = ""
+    ) const;
+    bool translate_ctxt_plurals
+    (
+        const std::string & msgctxt,
+        const std::string & msgid,
+        const std::string & msgidplural,
+        const int * counts,
+        std::size_t count,
+        const std::string ** results,
+        const std::string & codeset = ""
+    ) const;
+    const std::string * find (const std::string & msgid) const;
+    const std::string * find_ctxt
+    (
+        const std::string & msgctxt,
+        const std::string & msgid
     ) const;
+    std::string_view find_view (const std::string & msgid) const
+    {
+        return find_view(nullptr, msgid);
+    }
+
+    std::string_view find_ctxt_view
+    (
+        const std::string & msgctxt,
+        const std::string & msgid
+    ) const
+    {
+        return find_view(&msgctxt, msgid);
+    }
 
     bool add
     (
@@ -275,6 +471,11 @@ public:
         return m_has_fallback;
     }
 
+    const dictionary * fallback () const
+    {
+        return m_has_fallback ? m_fallback : nullptr ;
+    }
+
 #if defined POTEXT_DICTIONARY_CREATE_PO_DUMP
 
 public:
@@ -295,7 +496,9 @@ private:
         const entry & ent
     ) const;
 
-#else
+#endif
+
+public:
 
     /**
      *  Iterate over all messages, FUNC is of type:
@@ -311,11 +514,27 @@ private:
      */
 
     template<class FUNC>
-    FUNC foreach (FUNC func)
+    FUNC foreach (FUNC func) const
     {
+        if (m_flat)
+        {
+            std::string msgid, msgid_plural;
+            phraselist msgstrs;
+            for (std::size_t i = 0; i < m_flat->entry_count(); ++i)
+            {
+                if (flat_entry(i, nullptr, msgid, msgid_plural, msgstrs))
+                    func(msgid, msgid_plural, msgstrs);
+            }
+            return func;
+        }
+        phraselist scratch;
         for (const auto & e : m_entries)
         {
-            func(e.first, e.second.msgid_plural, e.second.phrase_list);
+            func
+            (
+                e.first, e.second.msgid_plural,
+                expand(e.second.phrase_list, scratch)
+            );
         }
         return func;
     }
@@ -327,13 +546,26 @@ private:
      *      (
      *          const std::string & ctxt,
      *          const std::string & msgid,
+     *          const std::string & msgid_plural,
      *          const phraselist & msgstrs
      *      )
      */
 
     template<class FUNC>
-    FUNC foreach_ctxt (FUNC func)
+    FUNC foreach_ctxt (FUNC func) const
     {
+        if (m_flat)
+        {
+            std::string ctxt, msgid, msgid_plural;
+            phraselist msgstrs;
+            for (std::size_t i = 0; i < m_flat->entry_count(); ++i)
+            {
+                if (flat_entry(i, &ctxt, msgid, msgid_plural, msgstrs))
+                    func(ctxt, msgid, msgid_plural, msgstrs);
+            }
+            return func;
+        }
+        phraselist scratch;
         for (const auto & i : m_ctxt_entries)
         {
             for (const auto & j : i.second)
@@ -341,29 +573,93 @@ private:
                 func
                 (
                     i.first, j.first, j.second.msgid_plural,
-                    j.second.phrase_list
+                    expand(j.second.phrase_list, scratch)
                 );
             }
         }
         return func;
     }
 
-#endif
 
 private:
 
     std::string translate
     (
         const entries & dict,
-        const std::string & msgid
+        const std::string * msgctxt,
+        const std::string & msgid,
+        const std::string & codeset
     ) const;
     std::string translate_plural
     (
         const entries & dict,
+        const std::string * msgctxt,
         const std::string & msgid,
         const std::string & msgidplural,
-        int num
+        int num,
+        const std::string & codeset
+    ) const;
+    std::string translate_flat
+    (
+        const std::string * msgctxt,
+        const std::string & msgid,
+        const std::string & codeset
+    ) const;
+    std::string translate_flat_plural
+    (
+        const std::string * msgctxt,
+        const std::string & msgid,
+        const std::string & msgidplural,
+        int num,
+        const std::string & codeset
+    ) const;
+    const std::string * find_flat
+    (
+        const std::string * msgctxt,
+        const std::string & msgid
+    ) const;
+    bool translate_plurals
+    (
+        const std::string * msgctxt,
+        const std::string & msgid,
+        const std::string & msgidplural,
+        const int * counts,
+        std::size_t count,
+        const std::string ** results,
+        const std::string & codeset
+    ) const;
+    std::string_view find_view
+    (
+        const std::string * msgctxt,
+        const std::string & msgid
+    ) const;
+    const std::string & flat_string (std::string_view text) const;
+    const std::string * cached_view
+    (
+        const void * key,
+        std::string_view msgstr,
+        const std::string & codeset
+    ) const;
+    std::string stored_view
+    (
+        const std::string & msgstr,
+        const std::string & codeset
+    ) const;
+    const std::string & stored_string (const std::string & msgstr) const;
+    const phraselist & expand
+    (
+        const phraselist & msgstrs,
+        phraselist & scratch
+    ) const;
+    bool flat_entry
+    (
+        std::size_t index,
+        std::string * msgctxt,
+        std::string & msgid,
+        std::string & msgid_plural,
+        phraselist & msgstrs
     ) const;
+    void clear_views ();
 
 };              // class dictionary
 
@@ -33,24 +33,65 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-03-30
+ * \updates       2026-10-18
  * \license       See above.
  *
  *  Some additions have been made:
  *
  *      -   Storage of nlsbindings, for the gettext module.
+ *      -   An optional manifest, to load only the messages an application
+ *          uses from a large, shared catalog.
+ *      -   Configuration changes drop only the dictionaries they affect:
+ *          a new or removed directory affects only the languages it has
+ *          catalogs for, a use-fuzzy change affects only catalogs with
+ *          fuzzy entries, and a charset change drops nothing at all.
+ *      -   The translations are stored in UTF-8, and converted to the
+ *          charset, or to a domain's bind_textdomain_codeset() codeset,
+ *          only when looked up (see dictionary::view()).
+ *      -   The dictionaries are keyed by (domain, language). A domain bound
+ *          by bindtextdomain() that is not itself a language name has its
+ *          own catalogs, which stay loaded when textdomain() switches to
+ *          another domain. The domains are interned as small integer IDs.
+ *      -   set_memory_budget() bounds the memory of the loaded
+ *          dictionaries. The least recently used ones are dropped, and
+ *          are loaded again if they are needed again.
+ *      -   negotiate_language() picks the catalog language that best
+ *          serves an HTTP Accept-Language header, and remembers the
+ *          answers for the most recently seen headers.
+ *      -   set_shared_cache() keeps compiled images of the catalogs in a
+ *          directory, to be mapped by other processes or later runs
+ *          instead of parsing the catalogs again.
+ *      -   The public functions lock a readers-writer mutex (see
+ *          sharedmutex.hpp), so threads can look up translations while
+ *          others change the language, the domain, or the search path.
+ *          The lookups of the gettext functions share it, and run in
+ *          parallel; the changes, and the lookups that must load a
+ *          catalog, take it exclusively. A reference a function returns
+ *          (e.g. the dictionary of get_dictionary()) stays valid only
+ *          until the next change, so a thread that uses one while others
+ *          make changes must hold mutex(), shared or not, until it is done
+ *          with it, as the gettext functions do.
  */
 
+#include <atomic>                       /* std::atomic<> template           */
+#include <cstdint>                      /* std::uint64_t                    */
 #include <deque>                        /* std::deque<> container template  */
+#include <functional>                   /* std::function<> template         */
 #include <memory>                       /* std::unique_ptr<> template       */
+#include <mutex>                        /* std::lock_guard<> template       */
 #include <set>                          /* std::set<> template              */
+#include <shared_mutex>                 /* std::shared_lock<> template      */
 #include <string>                       /* std::string                      */
 #include <unordered_map>                /* std::unordered_map<> template    */
+#include <vector>                       /* std::vector<> template           */
 
 #include "po_types.hpp"                 /* observer_ptr<> template alias    */
 #include "dictionary.hpp"               /* po::dictionary (Dictionary)      */
 #include "language.hpp"                 /* po::language (Language)          */
+#include "lrucache.hpp"                 /* po::lrucache<> template          */
+#include "manifest.hpp"                 /* po::manifest message-ID set      */
 #include "nlsbindings.hpp"              /* po::nlsbindings class            */
+#include "sharedmutex.hpp"              /* po::sharedmutex class            */
 
 namespace po
 {
@@ -78,6 +119,23 @@ struct langhash
 class dictionarymgr
 {
 
+public:
+
+    /**
+     *  An interned domain name. Comparing and hashing these is cheaper than
+     *  doing so with the names.
+     */
+
+    using domainid = std::size_t;
+
+    /**
+     *  The ID of the unnamed domain, whose catalogs are named for their
+     *  language (e.g. "de_AT.po") and are found in the search path. This
+     *  is the only domain the original tinygettext supported.
+     */
+
+    static constexpr domainid sm_default_domain = 0;
+
 private:
 
     /**
@@ -87,11 +145,93 @@ private:
 
     using dictpointer = std::shared_ptr<dictionary>;
 
+    /**
+     *  The key of a loaded dictionary.
+     */
+
+    struct dictkey
+    {
+        domainid dk_domain;
+        language dk_language;
+
+        bool operator == (const dictkey & rhs) const
+        {
+            return dk_domain == rhs.dk_domain && dk_language == rhs.dk_language;
+        }
+    };
+
+    struct dictkeyhash
+    {
+        size_t operator () (const dictkey & k) const
+        {
+            return langhash()(k.dk_language) * 31 + k.dk_domain;
+        }
+    };
+
+    /**
+     *  The time of the last lookup of a dictionary. The lookups that share
+     *  the lock set it, so it is atomic; it is copied with its slot.
+     */
+
+    struct lastuse
+    {
+        std::atomic<unsigned long> lu_clock;
+
+        lastuse (unsigned long clock = 0) : lu_clock(clock)
+        {
+            // no code
+        }
+
+        lastuse (const lastuse & rhs) : lu_clock(rhs.get())
+        {
+            // no code
+        }
+
+        lastuse & operator = (const lastuse & rhs)
+        {
+            set(rhs.get());
+            return *this;
+        }
+
+        unsigned long get () const
+        {
+            return lu_clock.load(std::memory_order_relaxed);
+        }
+
+        void set (unsigned long clock)
+        {
+            lu_clock.store(clock, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     *  A loaded dictionary, with what the memory budget needs to know of
+     *  it.
+     */
+
+    struct dictslot
+    {
+        dictpointer ds_dict;
+        std::size_t ds_bytes;           /* dictionary::memory_usage()       */
+        mutable lastuse ds_last_use;    /* m_use_clock at the last lookup   */
+        bool ds_reloadable;             /* found again by get_dictionary()  */
+    };
+
     /**
      *  Provides a hashed map/list of dictionary pointers.
      */
 
-    using dictionaries = std::unordered_map<language, dictpointer, langhash>;
+    using dictionaries = std::unordered_map<dictkey, dictslot, dictkeyhash>;
+
+    /**
+     *  The locks held by the public functions: exclusive for the changes,
+     *  shared for the lookups. The exclusive one is recursive, because the
+     *  functions call one another, and because the gettext functions hold
+     *  it across a lookup and the translation.
+     */
+
+    using lockguard = std::lock_guard<sharedmutex>;
+    using readlock = std::shared_lock<sharedmutex>;
 
     /**
      *  Provides a deque list of directories to search.
@@ -105,6 +245,24 @@ private:
 
     using fspointer = std::unique_ptr<filesystem>;
 
+    /**
+     *  A language that has catalogs in the search path, with its codes in
+     *  the case they are compared in.
+     */
+
+    struct availlang
+    {
+        language al_language;
+        std::string al_code;            /* lower case, e.g. "de"            */
+        std::string al_country;         /* upper case, e.g. "AT", or empty  */
+    };
+
+    /**
+     *  Guards all of the members below. See mutex().
+     */
+
+    mutable sharedmutex m_mutex;
+
     /**
      *  The set of loaded dictionaries. Currently, they are added as needed by
      *  the get_dictionary() functions.
@@ -146,6 +304,28 @@ private:
 
     bool m_use_fuzzy;
 
+    /**
+     *  The message IDs the application uses. If not empty, the parsers skip
+     *  every other message in the catalogs, before any conversion is done.
+     */
+
+    manifest m_manifest;
+
+    /**
+     *  If not empty, the directory (e.g. /dev/shm/potext, or the
+     *  user_cache_directory()) of the compiled catalog images that
+     *  processes share. See set_shared_cache().
+     */
+
+    std::string m_shared_cache;
+
+    /**
+     *  If not 0, the length above which the translations of the catalogs
+     *  loaded are kept compressed. See dictionary::compress_strings().
+     */
+
+    std::size_t m_cold_threshold;
+
     /**
      *  The current domain (package name or language).
      */
@@ -158,6 +338,21 @@ private:
 
     std::string m_previous_domain;
 
+    /**
+     *  Maps the names of the domains that have their own catalogs to their
+     *  IDs, and vice versa. The unnamed domain is always present, as ID 0.
+     */
+
+    std::unordered_map<std::string, domainid> m_domain_ids;
+    std::vector<std::string> m_domain_names;
+
+    /**
+     *  The ID of the current domain; sm_default_domain unless textdomain()
+     *  selected a domain with its own catalogs.
+     */
+
+    domainid m_current_domain_id;
+
     /**
      *  The current language in force.
      */
@@ -178,6 +373,14 @@ private:
 
     observer_ptr<dictionary> m_current_dict;
 
+    /**
+     *  The dictionary of the current domain and language, if the current
+     *  domain is not the unnamed domain. It caches the lookup done by
+     *  get_dictionary(), and is nulled when the domain or language changes.
+     */
+
+    observer_ptr<dictionary> m_domain_dict;
+
     /**
      *  Provides a "pointer" to a po::filesystem object used to open a
      *  directory (using std::filesystem::directory_iterator(), and open a
@@ -186,6 +389,62 @@ private:
 
     fspointer m_filesystem;
 
+    /**
+     *  Incremented whenever the main dictionary might have changed: a new
+     *  language or current dictionary, or a cleared cache. Tables of
+     *  translations built from the main dictionary (see msgidtable and
+     *  labeltable) compare it to their own copy to know when to rebuild.
+     *  It is atomic so that they can check it without taking the mutex.
+     */
+
+    std::atomic<unsigned long> m_generation;
+
+    /**
+     *  The languages of the catalogs in the search path, gathered on the
+     *  first negotiate_language() after the search path changes.
+     */
+
+    std::vector<availlang> m_available;
+    bool m_available_valid;
+
+    /**
+     *  The results of negotiate_language(), keyed by the raw header.
+     */
+
+    lrucache<std::string, language, std::hash<std::string>> m_negotiated;
+
+    /**
+     *  The most memory the loaded dictionaries may hold, or 0 for no limit,
+     *  and the memory they hold. See set_memory_budget().
+     */
+
+    std::size_t m_memory_budget;
+    std::size_t m_memory_used;
+
+    /**
+     *  Counts the dictionary lookups, to order the dictionaries by their
+     *  last use. Atomic, as are the hits, for the lookups that share the
+     *  lock.
+     */
+
+    mutable std::atomic<unsigned long> m_use_clock;
+
+    /**
+     *  The lookups that found a loaded dictionary, the lookups that had to
+     *  load one, and the dictionaries dropped to stay in the budget.
+     */
+
+    mutable std::atomic<std::size_t> m_dict_hits;
+    std::size_t m_dict_misses;
+    std::size_t m_dict_evictions;
+
+    /**
+     *  Non-zero while a dictionary and its fallbacks are being loaded, when
+     *  nothing may be evicted.
+     */
+
+    int m_load_depth;
+
 private:
 
     dictionarymgr
@@ -202,14 +461,47 @@ public:
     dictionarymgr & operator = (const dictionarymgr &) = delete;
     ~dictionarymgr ();
 
+    /**
+     *  The lock the public functions hold. Hold it, shared or exclusive,
+     *  to use a dictionary or other reference obtained from this object
+     *  while other threads may change it. See find_dictionary().
+     */
+
+    sharedmutex & mutex () const
+    {
+        return m_mutex;
+    }
+
     bool empty () const
     {
+        readlock lock(m_mutex);
         return m_dictionaries.empty();
     }
 
+    unsigned long generation () const
+    {
+        return m_generation.load(std::memory_order_acquire);
+    }
+
     dictionary & get_dictionary ();
+    const dictionary * find_dictionary (std::string & codeset) const;
+    const dictionary * find_domain_dictionary
+    (
+        const std::string & domainname,
+        std::string & codeset
+    ) const;
     dictionary & get_dictionary (const language & lang);
+    dictionary & get_dictionary (domainid domain, const language & lang);
     const dictionary & get_dictionary (const std::string & domainname) const;
+    const dictionary & get_domain_dictionary (const std::string & domainname);
+    domainid intern_domain (const std::string & domainname);
+    bool is_catalog_domain (const std::string & domainname) const;
+
+    domainid current_domain_id () const
+    {
+        readlock lock(m_mutex);
+        return m_current_domain_id;
+    }
 
     nlsbindings & get_bindings ()
     {
@@ -243,17 +535,15 @@ public:
 
     language get_language () const
     {
+        readlock lock(m_mutex);
         return m_current_language;
     }
 
-    void set_use_fuzzy (bool t)
-    {
-        clear_cache();
-        m_use_fuzzy = t;
-    }
+    void set_use_fuzzy (bool t);
 
     bool get_use_fuzzy () const
     {
+        readlock lock(m_mutex);
         return m_use_fuzzy;
     }
 
@@ -261,15 +551,107 @@ public:
      *  Set a charset that will be set on the returned dictionaries.
      */
 
-    void set_charset (const std::string & charset)
+    void set_charset (const std::string & charset);
+
+    const std::string & get_charset () const
+    {
+        return m_charset;
+    }
+
+    bool load_manifest (const std::string & filename);
+    void set_manifest (const manifest & mf);
+    void clear_manifest ();
+
+    const manifest & get_manifest () const
+    {
+        return m_manifest;
+    }
+
+    /**
+     *  Sets the directory of the shared catalog cache, or disables it if
+     *  empty. It applies to the catalogs loaded afterward. A directory in
+     *  /dev/shm shares the images between the processes running now; one
+     *  on disk, such as user_cache_directory(), keeps them for later runs,
+     *  which then map a catalog instead of parsing it.
+     */
+
+    void set_shared_cache (const std::string & dirname)
+    {
+        lockguard lock(m_mutex);
+        m_shared_cache = dirname;
+    }
+
+    const std::string & shared_cache () const
+    {
+        return m_shared_cache;
+    }
+
+    static std::string user_cache_directory ();
+
+    /**
+     *  Sets the length above which translations are kept compressed, or 0
+     *  (the default) to compress none. It applies to the catalogs loaded
+     *  afterward. A catalog mapped from the shared cache is not compressed.
+     */
+
+    void set_cold_threshold (std::size_t bytes)
     {
-        clear_cache();              /* changing charset invalidates cache   */
-        m_charset = charset;
+        lockguard lock(m_mutex);
+        m_cold_threshold = bytes;
+    }
+
+    std::size_t cold_threshold () const
+    {
+        readlock lock(m_mutex);
+        return m_cold_threshold;
     }
 
     void add_directory (const std::string & pathname, bool precedence = false);
     void remove_directory (const std::string & pathname);
     std::set<language> get_languages ();
+    void set_memory_budget (std::size_t bytes);
+
+    std::size_t memory_budget () const
+    {
+        readlock lock(m_mutex);
+        return m_memory_budget;
+    }
+
+    std::size_t memory_used () const
+    {
+        readlock lock(m_mutex);
+        return m_memory_used;
+    }
+
+    std::size_t dictionary_hits () const
+    {
+        return m_dict_hits.load(std::memory_order_relaxed);
+    }
+
+    std::size_t dictionary_misses () const
+    {
+        readlock lock(m_mutex);
+        return m_dict_misses;
+    }
+
+    std::size_t dictionary_evictions () const
+    {
+        readlock lock(m_mutex);
+        return m_dict_evictions;
+    }
+
+    language negotiate_language (const std::string & acceptlanguage);
+    void set_negotiation_cache_size (std::size_t count);
+
+    std::size_t negotiation_hits () const
+    {
+        return m_negotiated.hits();
+    }
+
+    std::size_t negotiation_misses () const
+    {
+        return m_negotiated.misses();
+    }
 
     /*
      * Additional functions for potext.
@@ -292,11 +674,43 @@ public:
         const std::string & domainname,
         const std::string & codeset
     );
+    std::string domain_codeset (const std::string & domainname) const;
 
 private:
 
     std::string filename_to_language (const std::string & s_in) const;
     void clear_cache ();
+    bool directory_languages
+    (
+        const std::string & dirname,
+        std::set<std::string> & codes
+    );
+    std::size_t drop_dictionaries
+    (
+        const std::function<bool (dictionary &, const dictkey &)> & f,
+        bool newgeneration = true
+    );
+    void note_loaded (const dictkey & key, const dictionary & dict);
+    std::size_t evict_dictionaries (const dictionary * keep = nullptr);
+    bool load_domain_catalog
+    (
+        const std::string & domainname,
+        const language & lang,
+        dictionary & dict
+    );
+    void update_current_domain ();
+    void invalidate_negotiation ();
+    phraselist find_catalogs (const language & lang);
+    bool load_catalogs (const phraselist & files, dictionary & dict);
+    bool parse_catalog (const std::string & pomofile, dictionary & dict);
+    std::string shared_cache_name (const phraselist & files) const;
+    std::uint64_t source_key (const phraselist & files) const;
+    bool parse_file
+    (
+        const std::string & pomofile,
+        std::istream & in,
+        dictionary & dict
+    );
     dictpointer make_dictionary
     (
         language & polang,
@@ -33,7 +33,7 @@
  * \library       potext
  * \author        Chris Ahlstrom
  * \date          2024-03-24
- * \updates       2024-04-02
+ * \updates       2026-10-17
  * \license       See above.
  *
  */
@@ -164,6 +164,18 @@ public:
         return sz < maxx;
     }
 
+    /**
+     *  True if the len bytes at start are all in the data. Written so that
+     *  a huge start or len from a damaged file cannot overflow.
+     */
+
+    bool valid_range (std::size_t start, std::size_t len) const
+    {
+        return start <= m_data.size() && len <= m_data.size() - start;
+    }
+
+    bool get_offset (std::size_t pos, offset & result) const;
+
     const char * find
     (
         const std::string & target,
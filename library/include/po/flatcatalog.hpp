@@ -0,0 +1,248 @@
+#if ! defined POTEXT_PO_FLATCATALOG_HPP
+#define POTEXT_PO_FLATCATALOG_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          flatcatalog.hpp
+ *
+ *      A compiled, pointer-free catalog image that can be shared between
+ *      processes by mapping it from a file.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  A dictionary holds its messages in maps of strings, on the heap of the
+ *  process that parsed the catalog. A server with many worker processes
+ *  pays for that once per worker. A flatcatalog holds the same messages in
+ *  one block of memory that uses offsets instead of pointers, so it can be
+ *  written to a file (e.g. under /dev/shm) once, and then mapped read-only
+ *  by every process. The pages are then shared by all of them.
+ *
+ *  The layout, in native byte order:
+ *
+\verbatim
+    header      magic, version, byte-order mark, checksum, size, flags,
+                counts and offsets of the tables, and the Plural-Forms
+    entries     one per message, sorted by key: the key (the msgid, or the
+                msgctxt, an EOT, and the msgid), the msgid_plural, and the
+                range of its translations in the string table
+    strings     the offset and size of each translation
+    text        the bytes of all the keys and strings
+\endverbatim
+ *
+ *  The checksum is the FNV-1a hash of everything after the header. An
+ *  image is checked (version, checksum, and the bounds of every offset)
+ *  before it is used, so a stale or damaged file is simply rejected and
+ *  the catalog is parsed again.
+ *
+ *  The header also holds a source key, which the writer of the image sets
+ *  to describe the catalogs it came from. The dictionarymgr uses the size,
+ *  time, and contents of the catalog files, so that it can tell whether an
+ *  image found in a persistent cache is still current.
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <cstdint>                      /* std::uint32_t, std::uint64_t     */
+#include <string>                       /* std::string class                */
+#include <string_view>                  /* std::string_view class           */
+
+namespace po
+{
+
+class dictionary;
+
+/**
+ *  A read-only catalog image. See the banner above.
+ */
+
+class flatcatalog
+{
+
+public:
+
+    /**
+     *  The result of a failed lookup().
+     */
+
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    /**
+     *  The version of the layout. Images of another version are rejected.
+     */
+
+    static constexpr std::uint32_t sm_version = 2;
+
+private:
+
+    /**
+     *  The location of a string in the image.
+     */
+
+    struct span
+    {
+        std::uint32_t s_offset;
+        std::uint32_t s_size;
+    };
+
+    struct header
+    {
+        char h_magic[8];                /* "POTEXTFC"                       */
+        std::uint32_t h_version;        /* sm_version                       */
+        std::uint32_t h_byte_order;     /* 0x01020304 as written            */
+        std::uint64_t h_checksum;       /* FNV-1a of the rest of the image  */
+        std::uint64_t h_size;           /* size of the whole image          */
+        std::uint64_t h_source_key;     /* see compile()                    */
+        std::uint32_t h_flags;          /* c_flag_fuzzy                     */
+        std::uint32_t h_entry_count;
+        std::uint32_t h_string_count;
+        std::uint32_t h_entries;        /* offset of the entry table        */
+        std::uint32_t h_strings;        /* offset of the string table       */
+        std::uint32_t h_reserved;
+        span h_plural_forms;            /* the Plural-Forms descriptor      */
+    };
+
+    struct entry
+    {
+        span e_key;
+        span e_plural;
+        std::uint32_t e_first;          /* first translation in strings     */
+        std::uint32_t e_count;          /* the number of translations       */
+    };
+
+    /**
+     *  Holds the image if it was not mapped from a file.
+     */
+
+    std::string m_image;
+
+    /**
+     *  The mapping of the file, if any, for unmapping it.
+     */
+
+    void * m_mapping;
+    std::size_t m_mapping_size;
+
+    /**
+     *  Point into the image; null if there is no valid image.
+     */
+
+    const char * m_data;
+    const header * m_header;
+    const entry * m_entries;
+    const span * m_strings;
+
+public:
+
+    flatcatalog ();
+    flatcatalog (const flatcatalog &) = delete;
+    flatcatalog (flatcatalog &&) = delete;
+    flatcatalog & operator = (const flatcatalog &) = delete;
+    ~flatcatalog ();
+
+    static std::string compile
+    (
+        const dictionary & dict,
+        std::uint64_t sourcekey = 0
+    );
+    static bool publish
+    (
+        const std::string & filename,
+        const std::string & image
+    );
+
+    bool assign (const std::string & image);
+    bool map_file (const std::string & filename);
+    void clear ();
+
+    bool valid () const
+    {
+        return m_header != nullptr;
+    }
+
+    bool mapped () const
+    {
+        return m_mapping != nullptr;
+    }
+
+    std::size_t size () const
+    {
+        return valid() ? std::size_t(m_header->h_size) : 0 ;
+    }
+
+    std::size_t entry_count () const
+    {
+        return valid() ? std::size_t(m_header->h_entry_count) : 0 ;
+    }
+
+    std::uint64_t source_key () const
+    {
+        return valid() ? m_header->h_source_key : 0 ;
+    }
+
+    bool holds (const char * text) const;
+    bool has_fuzzy () const;
+    std::size_t prefault () const;
+    std::string plural_forms () const;
+    std::size_t lookup (std::string_view msgid) const;
+    std::size_t lookup
+    (
+        std::string_view msgctxt,
+        std::string_view msgid
+    ) const;
+    std::size_t msgstr_count (std::size_t index) const;
+    std::string_view msgstr (std::size_t index, std::size_t n) const;
+    std::string_view key (std::size_t index) const;
+    std::string_view msgid_plural (std::size_t index) const;
+
+private:
+
+    bool validate (const char * data, std::size_t size);
+    std::size_t find_key
+    (
+        std::string_view msgctxt,
+        bool has_ctxt,
+        std::string_view msgid
+    ) const;
+
+    std::string_view text (const span & s) const
+    {
+        return std::string_view(m_data + s.s_offset, s.s_size);
+    }
+
+};              // class flatcatalog
+
+}               // namespace po
+
+#endif          // POTEXT_PO_FLATCATALOG_HPP
+
+/*
+ * flatcatalog.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -27,7 +27,7 @@
  * \library       potext
  * \author        Chris Ahlstrom
  * \date          2024-02-16
- * \updates       2024-04-01
+ * \updates       2026-10-17
  * \license       See above.
  *
  *  gettext_noop()  pseudo function call that serves as a marker for the
@@ -59,12 +59,30 @@
  *      bind_textdomain_codeset(PACKAGE, CODESET);      // OPTIONAL
  *
  *  CODESET could be something like "UTF-8".
+ *
+ *  Integer message-ID mode:
+ *
+ *      Run the potext-msgids tool on the application's sources to generate
+ *      a header of message keys (see po/msgidtable.hpp), and then:
+ *
+ *          #include "msgids.hpp"                   // generated header
+ *          #define POTEXT_MSGID_TABLE po_msgids::keys
+ *          #include "po/gettext.hpp"
+ *
+ *      Now _("literal") and C_("context", "literal") resolve to an index
+ *      into a table of translations for the current language. The argument
+ *      must be a string literal; use po::gettext() for run-time strings.
  */
 
 #include <string>                       /* std::string & std::wstring       */
 
 #include "po_build_macros.h"            /* build (and platform) macros      */
 
+#if defined POTEXT_MSGID_TABLE
+#include <type_traits>                  /* std::integral_constant<>         */
+#include "po/msgidtable.hpp"            /* po::msgid_index(), etc.          */
+#endif
+
 #define PO_HAVE_GETTEXT                 /* a friendlier header marker       */
 
 /**
@@ -79,7 +97,35 @@
 
 #undef POTEXT_ENABLE_LIBINTL
 
+#if defined POTEXT_MSGID_TABLE
+
+/**
+ *  Evaluates to the compile-time ID of a string literal, or po::msgid_none
+ *  if the generated key table lacks it.
+ */
+
+#define POTEXT_MSGID(str) \
+    std::integral_constant \
+    < \
+        std::size_t, po::msgid_index(POTEXT_MSGID_TABLE, str) \
+    >::value
+
+#define _(str) \
+    po::idgettext(POTEXT_MSGID_TABLE, POTEXT_MSGID(str), str)
+
+#define C_(ctxt, str) \
+    po::idgettext \
+    ( \
+        POTEXT_MSGID_TABLE, POTEXT_MSGID(ctxt "\004" str), ctxt "\004" str \
+    )
+
+#else
+
 #define _(str)                          po::gettext (str)
+#define C_(ctxt, str)                   po::pgettext (ctxt, str)
+
+#endif
+
 #define gettext_noop(str)               str
 #define N_(str)                         gettext_noop (str)
 
@@ -88,12 +134,14 @@
 #if defined POTEXT_ENABLE_LIBINTL       /* see po_build_macros.h            */
 
 #define _(str)                          gettext (str)
+#define C_(ctxt, str)                   pgettext (ctxt, str)
 #define gettext_noop(str)               str
 #define N_(str)                         gettext_noop(str)
 
 #else           // ! defined POTEXT_ENABLE_LIBINTL
 
 #define _(str)                          (str)
+#define C_(ctxt, str)                   (str)
 #define N_(str)                         str
 #define textdomain(domain)
 #define bindtextdomain(pkg, dir)
@@ -141,6 +189,9 @@ enum class dir_type
  *  Free functions in the po namespace.
  */
 
+class dictionarymgr;
+
+extern dictionarymgr & dictionary_manager (const std::string & chset = "");
 extern std::string gettext (const std::string & msgid);
 extern std::string dgettext
 (
@@ -210,6 +261,35 @@ extern std::string init_app_locale
 
 #if defined POTEXT_ENABLE_I18N
 
+extern const std::string & idgettext
+(
+    const char * const * keys,
+    std::size_t count,
+    std::size_t id,
+    const char * key
+);
+
+/**
+ *  The overload used by the _() and C_() macros in integer message-ID
+ *  mode. The key is the msgid, or the context, "\004", and the msgid.
+ *  The returned reference points into an immutable table of translations,
+ *  and needs no lock to read. It stays valid at least until the calling
+ *  thread calls idgettext() again after a change of language or catalogs
+ *  (see idgettext() in gettext.cpp), so copy it if it has to live longer.
+ */
+
+template <std::size_t N>
+inline const std::string &
+idgettext
+(
+    const char * const (& keys) [N],
+    std::size_t id,
+    const char * key
+)
+{
+    return idgettext(keys, N, id, key);
+}
+
 extern std::string textdomain (const std::string & domainname);
 extern std::string bindtextdomain
 (
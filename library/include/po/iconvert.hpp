@@ -33,7 +33,7 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-10
+ * \updates       2026-10-17
  * \license       See above.
  *
  */
@@ -153,6 +153,16 @@ public:
 
     std::string convert (const std::string & text) const;
 
+    const std::string & from_charset () const
+    {
+        return m_from_charset;
+    }
+
+    const std::string & to_charset () const
+    {
+        return m_to_charset;
+    }
+
     bool set_charsets
     (
         const std::string & fromcode,
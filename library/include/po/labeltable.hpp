@@ -0,0 +1,260 @@
+#if ! defined POTEXT_PO_LABELTABLE_HPP
+#define POTEXT_PO_LABELTABLE_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+
+/**
+ * \file          labeltable.hpp
+ *
+ *      Translated copies of static tables of N_() strings, refreshed when
+ *      the language changes.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Menu definitions and enum-to-label arrays are usually static tables of
+ *  strings marked with N_(), which have to be passed through _() one by
+ *  one each time they are shown. A labeltable translates the whole table
+ *  once, when it is registered, into one string holding all the
+ *  translations and a contiguous array of views of it:
+ *
+\verbatim
+    static const char * const c_colors [] =
+    {
+        N_("Red"), N_("Green"), N_("Blue")
+    };
+    static po::labeltable s_colors(po::dictionary_manager(), c_colors);
+
+    std::string_view label = s_colors[int(color::green)];
+\endverbatim
+ *
+ *  Reading a label is an index into the array, plus a check of the
+ *  dictionarymgr generation. When the generation changes (a new language
+ *  or domain, a new charset, or reloaded catalogs), the next read
+ *  translates the table again. The translations are kept in a
+ *  snapshotring, which holds the newest c_snapshots of them, and each
+ *  thread holds the last snapshotholds::sm_held snapshots it has read.
+ *  So a view returned by labels() or operator [] (and the vector of
+ *  labels()) stays valid, holding the old translations, until both:
+ *
+ *      -   the table has been translated c_snapshots - 1 more times, and
+ *      -   the thread that got it has read sm_held newer snapshots, of
+ *          this table or of other labeltables, or of idgettext().
+ *
+ *  Thus a view may be used until the thread reads the table again after a
+ *  change of language; one kept longer must be copied. The memory held is
+ *  bounded, however often the language changes. A table should still be
+ *  registered once, not for each use.
+ *
+ *  Like msgidtable, the table is not copied, and must outlive the
+ *  labeltable. Untranslated strings get their msgid, as gettext() would
+ *  return.
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <memory>                       /* std::unique_ptr<> template       */
+#include <mutex>                        /* std::mutex                       */
+#include <string>                       /* std::string class                */
+#include <string_view>                  /* std::string_view class           */
+#include <vector>                       /* std::vector<> template           */
+
+#include "po/snapshotring.hpp"          /* po::snapshotring<> template      */
+
+namespace po
+{
+
+class dictionary;
+class dictionarymgr;
+
+/**
+ *  The translations of a static table of message IDs.
+ */
+
+class labeltable
+{
+
+public:
+
+    /**
+     *  The number of translations of the table that are kept.
+     */
+
+    static constexpr std::size_t c_snapshots = 4;
+
+private:
+
+    /**
+     *  One translation of the table, for one dictionarymgr generation. The
+     *  views point into s_text.
+     */
+
+    struct snapshot
+    {
+        unsigned long s_generation;
+        std::string s_text;
+        std::vector<std::string_view> s_labels;
+    };
+
+    /**
+     *  The manager providing the dictionary and the generation.
+     */
+
+    dictionarymgr & m_manager;
+
+    /**
+     *  The registered table. Not owned.
+     */
+
+    const char * const * m_msgids;
+
+    /**
+     *  The number of strings in the table.
+     */
+
+    std::size_t m_count;
+
+    /**
+     *  The context of all the strings (see pgettext()), or empty.
+     */
+
+    std::string m_msgctxt;
+
+    /**
+     *  The text domain, or empty for the current domain.
+     */
+
+    std::string m_domain;
+
+    /**
+     *  Serializes refresh().
+     */
+
+    std::mutex m_mutex;
+
+    /**
+     *  The newest translations, the very newest read without a lock.
+     */
+
+    snapshotring<snapshot, c_snapshots> m_snapshots;
+
+public:
+
+    labeltable
+    (
+        dictionarymgr & mgr,
+        const char * const * msgids,
+        std::size_t count,
+        const std::string & msgctxt = "",
+        const std::string & domain = ""
+    );
+
+    template <std::size_t N>
+    labeltable
+    (
+        dictionarymgr & mgr,
+        const char * const (& msgids) [N],
+        const std::string & msgctxt = "",
+        const std::string & domain = ""
+    ) :
+        labeltable(mgr, msgids, N, msgctxt, domain)
+    {
+        // no code
+    }
+
+    labeltable (const labeltable &) = delete;
+    labeltable (labeltable &&) = delete;
+    labeltable & operator = (const labeltable &) = delete;
+    labeltable & operator = (labeltable &&) = delete;
+    ~labeltable () = default;
+
+    /**
+     *  Returns the translations, in the order of the table, translating it
+     *  again first if the dictionarymgr has changed.
+     */
+
+    const std::vector<std::string_view> & labels ()
+    {
+        return current()->s_labels;
+    }
+
+    /**
+     *  Returns one translation. The index is not checked.
+     */
+
+    std::string_view operator [] (std::size_t index)
+    {
+        return current()->s_labels[index];
+    }
+
+    std::size_t size () const
+    {
+        return m_count;
+    }
+
+    /**
+     *  The dictionarymgr generation of the current translations.
+     */
+
+    unsigned long generation () const
+    {
+        return m_snapshots.current()->s_generation;
+    }
+
+    /**
+     *  The number of translations of the table kept, at most c_snapshots.
+     */
+
+    std::size_t snapshots () const
+    {
+        return m_snapshots.count();
+    }
+
+    void refresh ();
+
+private:
+
+    const snapshot * current ();
+    std::unique_ptr<snapshot> translate
+    (
+        const dictionary & dict,
+        const std::string & codeset,
+        unsigned long generation
+    ) const;
+
+};              // class labeltable
+
+}               // namespace po
+
+#endif          // POTEXT_PO_LABELTABLE_HPP
+
+/*
+ * labeltable.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,205 @@
+#if ! defined POTEXT_PO_LRUCACHE_HPP
+#define POTEXT_PO_LRUCACHE_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          lrucache.hpp
+ *
+ *      A small, bounded, thread-safe cache that drops the least recently
+ *      used entry when full.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  The entries are kept in a list in order of use, most recent first, and
+ *  a hash map finds the list node of a key. A hit moves the node to the
+ *  front with std::list::splice(), which allocates nothing. One mutex
+ *  guards both; the work done under it is a hash lookup and a few pointer
+ *  changes, so there is little to gain from finer locking.
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <list>                         /* std::list<> template             */
+#include <mutex>                        /* std::mutex, std::lock_guard<>    */
+#include <unordered_map>                /* std::unordered_map<> template    */
+#include <utility>                      /* std::pair<>, std::move()         */
+
+namespace po
+{
+
+/**
+ *  A least-recently-used cache of values of type V, keyed by K.
+ */
+
+template<typename K, typename V, typename HASH = std::hash<K>>
+class lrucache
+{
+
+private:
+
+    using entry = std::pair<K, V>;
+    using entrylist = std::list<entry>;
+    using entrymap = std::unordered_map<K, typename entrylist::iterator, HASH>;
+
+    mutable std::mutex m_mutex;
+    entrylist m_entries;
+    entrymap m_index;
+    std::size_t m_capacity;
+    std::size_t m_hits;
+    std::size_t m_misses;
+
+public:
+
+    lrucache (std::size_t capacity) :
+        m_mutex     (),
+        m_entries   (),
+        m_index     (),
+        m_capacity  (capacity > 0 ? capacity : 1),
+        m_hits      (0),
+        m_misses    (0)
+    {
+        // no code
+    }
+
+    lrucache (const lrucache &) = delete;
+    lrucache (lrucache &&) = delete;
+    lrucache & operator = (const lrucache &) = delete;
+    lrucache & operator = (lrucache &&) = delete;
+    ~lrucache () = default;
+
+    /**
+     *  Looks up a key, making it the most recently used.
+     *
+     * \param key
+     *      The key to find.
+     *
+     * \param [out] value
+     *      Receives a copy of the value, if found.
+     *
+     * \return
+     *      Returns true if the key was found.
+     */
+
+    bool get (const K & key, V & value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+        {
+            ++m_misses;
+            return false;
+        }
+        ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        value = it->second->second;
+        return true;
+    }
+
+    /**
+     *  Adds or replaces the value of a key, dropping the least recently
+     *  used entry if the cache is full.
+     */
+
+    void put (const K & key, V value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it != m_index.end())
+        {
+            it->second->second = std::move(value);
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return;
+        }
+        if (m_entries.size() >= m_capacity)
+        {
+            (void) m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+        m_entries.emplace_front(key, std::move(value));
+        m_index[key] = m_entries.begin();
+    }
+
+    void clear ()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_index.clear();
+        m_entries.clear();
+    }
+
+    /**
+     *  Changes the capacity, dropping the least recently used entries that
+     *  no longer fit.
+     */
+
+    void set_capacity (std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_capacity = capacity > 0 ? capacity : 1 ;
+        while (m_entries.size() > m_capacity)
+        {
+            (void) m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+    }
+
+    std::size_t size () const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+    std::size_t capacity () const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_capacity;
+    }
+
+    std::size_t hits () const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_hits;
+    }
+
+    std::size_t misses () const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_misses;
+    }
+
+};              // class lrucache
+
+}               // namespace po
+
+#endif          // POTEXT_PO_LRUCACHE_HPP
+
+/*
+ * lrucache.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,154 @@
+#if ! defined POTEXT_PO_MANIFEST_HPP
+#define POTEXT_PO_MANIFEST_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          manifest.hpp
+ *
+ *      Provides the set of message IDs that an application actually uses.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  A translation catalog shared by a suite of applications can be far
+ *  larger than what a single application needs. A manifest lists the
+ *  message IDs of one application, so that the parsers can skip all other
+ *  entries before doing any character-set conversion or dictionary
+ *  insertion.
+ *
+ *  Two manifest formats are supported:
+ *
+ *      -   A .pot (or .po) file, as created by xgettext. Only the "msgctxt"
+ *          and "msgid" strings are used.
+ *      -   A compact key list, one message ID per line. The usual C escape
+ *          sequences are honored, so that a message containing a newline
+ *          fits on one line. A context is written before the message ID,
+ *          separated by "\004", the EOT separator used in .mo files.
+ *          Empty lines and lines starting with "#" are ignored.
+ */
+
+#include <cstdint>                      /* std::uint64_t                    */
+#include <iosfwd>                       /* std::istream forward reference   */
+#include <string>                       /* std::string class                */
+#include <unordered_set>                /* std::unordered_set<> template    */
+
+namespace po
+{
+
+/**
+ *  Holds the set of message keys (msgid, or msgctxt + EOT + msgid) to keep
+ *  when loading a catalog.
+ */
+
+class manifest
+{
+
+private:
+
+    using keyset = std::unordered_set<std::string>;
+
+    /**
+     *  The keys to keep. A key with a context is stored like the original
+     *  string in an .mo file: the context, an EOT character, and the
+     *  message ID.
+     */
+
+    keyset m_keys;
+
+    /**
+     *  The name of the file the keys were loaded from, if any. Used only
+     *  in messages.
+     */
+
+    std::string m_filename;
+
+public:
+
+    manifest ();
+    manifest (const manifest &) = default;
+    manifest (manifest &&) = default;
+    manifest & operator = (const manifest &) = default;
+    manifest & operator = (manifest &&) = default;
+    ~manifest () = default;
+
+    bool load (const std::string & filename);
+    void add (const std::string & msgid);
+    void add (const std::string & msgctxt, const std::string & msgid);
+    bool contains (const std::string & msgid) const;
+    bool contains
+    (
+        const std::string & msgctxt,
+        const std::string & msgid
+    ) const;
+
+    static std::string make_key
+    (
+        const std::string & msgctxt,
+        const std::string & msgid
+    );
+
+    void clear ()
+    {
+        m_keys.clear();
+        m_filename.clear();
+    }
+
+    bool empty () const
+    {
+        return m_keys.empty();
+    }
+
+    std::size_t size () const
+    {
+        return m_keys.size();
+    }
+
+    std::uint64_t digest () const;
+
+    const std::string & filename () const
+    {
+        return m_filename;
+    }
+
+private:
+
+    bool load_pot (std::istream & in);
+    bool load_key_list (std::istream & in);
+
+};              // class manifest
+
+}               // namespace po
+
+#endif          // POTEXT_PO_MANIFEST_HPP
+
+/*
+ * manifest.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
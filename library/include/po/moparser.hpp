@@ -33,7 +33,7 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-03-24
- * \updates       2024-04-05
+ * \updates       2026-10-17
  * \license       See above.
  *
  */
@@ -174,7 +174,8 @@ private:
         const std::string & filename,
         std::istream & in,
         dictionary & dict,
-        bool usefuzzy       = true
+        bool usefuzzy       = true,
+        const manifest * mf = nullptr
     );
     moparser (const moparser &) = delete;
     moparser (moparser &&) = delete;
@@ -215,13 +216,23 @@ public:
      *
      * \param dict
      *      Dictionary to which the translation strings are written.
+     *
+     * \param usefuzzy
+     *      Not used. The .mo format does not store the "fuzzy" flag; msgfmt
+     *      drops fuzzy entries unless told otherwise.
+     *
+     * \param mf
+     *      An optional manifest. If not null, only the messages it lists
+     *      are extracted from the .mo data.
      */
 
     static bool parse_mo_file
     (
         const std::string & filename,
         std::istream & in,
-        dictionary & dict
+        dictionary & dict,
+        bool usefuzzy       = true,
+        const manifest * mf = nullptr
     );
 
 };              // class moparser
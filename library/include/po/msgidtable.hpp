@@ -0,0 +1,242 @@
+#if ! defined POTEXT_PO_MSGIDTABLE_HPP
+#define POTEXT_PO_MSGIDTABLE_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          msgidtable.hpp
+ *
+ *      Integer message-ID lookups via a table indexed by dense IDs.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  The potext-msgids tool scans the application's sources for _(), N_(),
+ *  C_(), and pgettext() calls and writes a header holding a sorted array of
+ *  all the keys:
+ *
+\verbatim
+    namespace po_msgids
+    {
+        inline constexpr const char * keys [] =
+        {
+            "Hello",
+            "console\004Retry",
+            . . .
+        };
+        inline constexpr std::size_t count = 2;
+    }
+\endverbatim
+ *
+ *  The index of a key in this array is its message ID. An application
+ *  that includes this header and defines POTEXT_MSGID_TABLE (e.g. as
+ *  po_msgids::keys) before including po/gettext.hpp gets an _() macro that
+ *  finds the ID at compile time (see msgid_index()) and then simply indexes
+ *  a table holding the translations for the current language. There is no
+ *  hashing or string comparison at run time. The msgid is passed along only
+ *  to be verified in debug builds, and as a fallback if a string is missing
+ *  from a stale generated header.
+ *
+ *  The msgidtable class holds those translations. It is rebuilt (in one
+ *  pass over the keys) whenever the dictionarymgr reports a new generation,
+ *  i.e. a new language or a reloaded catalog.
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <string>                       /* std::string class                */
+#include <vector>                       /* std::vector<> template           */
+
+namespace po
+{
+
+class dictionary;
+
+/**
+ *  The ID of a string not found in the key table.
+ */
+
+constexpr std::size_t msgid_none = static_cast<std::size_t>(-1);
+
+/**
+ *  Compares two C strings like std::string::compare() does, i.e. as
+ *  unsigned characters. Usable at compile time.
+ */
+
+constexpr int
+msgid_compare (const char * a, const char * b)
+{
+    while (*a != 0 && *a == *b)
+    {
+        ++a;
+        ++b;
+    }
+    return
+        int(static_cast<unsigned char>(*a)) -
+        int(static_cast<unsigned char>(*b));
+}
+
+/**
+ *  A binary search of the sorted key table. When used in a constant
+ *  expression (see the POTEXT_MSGID() macro in gettext.hpp), it costs
+ *  nothing at run time.
+ */
+
+template <std::size_t N>
+constexpr std::size_t
+msgid_index (const char * const (& keys) [N], const char * key)
+{
+    std::size_t low = 0;
+    std::size_t high = N;
+    while (low < high)
+    {
+        std::size_t mid = low + (high - low) / 2;
+        int cmp = msgid_compare(keys[mid], key);
+        if (cmp == 0)
+            return mid;
+        else if (cmp < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return msgid_none;
+}
+
+/**
+ *  Holds the translations of a key table for one dictionary.
+ */
+
+class msgidtable
+{
+
+private:
+
+    /**
+     *  The generated key table. Not owned.
+     */
+
+    const char * const * m_keys;
+
+    /**
+     *  The number of keys in the table.
+     */
+
+    std::size_t m_count;
+
+    /**
+     *  The dictionary the translations came from. Null means no dictionary
+     *  is in force, and the translations are the message IDs.
+     */
+
+    const dictionary * m_dict;
+
+    /**
+     *  The dictionarymgr generation the table was built for.
+     */
+
+    unsigned long m_generation;
+
+    /**
+     *  Indicates the table has been built at least once.
+     */
+
+    bool m_built;
+
+    /**
+     *  The translations, indexed by message ID.
+     */
+
+    std::vector<std::string> m_translations;
+
+public:
+
+    msgidtable ();
+    msgidtable (const msgidtable &) = delete;
+    msgidtable (msgidtable &&) = delete;
+    msgidtable & operator = (const msgidtable &) = delete;
+    ~msgidtable () = default;
+
+    void assign (const char * const * keys, std::size_t count);
+    void build
+    (
+        const dictionary * dict,
+        unsigned long generation,
+        const std::string & codeset = ""
+    );
+
+    static std::string key_msgid (const char * key);
+
+    bool current
+    (
+        const char * const * keys,
+        const dictionary * dict,
+        unsigned long generation
+    ) const
+    {
+        return
+        (
+            m_built && keys == m_keys &&
+            dict == m_dict && generation == m_generation
+        );
+    }
+
+    const char * const * keys () const
+    {
+        return m_keys;
+    }
+
+    unsigned long generation () const
+    {
+        return m_generation;
+    }
+
+    std::size_t size () const
+    {
+        return m_translations.size();
+    }
+
+    const char * key (std::size_t id) const
+    {
+        return m_keys[id];
+    }
+
+    const std::string & at (std::size_t id) const
+    {
+        return m_translations[id];
+    }
+
+};              // class msgidtable
+
+}               // namespace po
+
+#endif          // POTEXT_PO_MSGIDTABLE_HPP
+
+/*
+ * msgidtable.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -33,7 +33,7 @@
  * \library       potext
  * \author        gettext; refactoring by Chris Ahlstrom
  * \date          2024-02-20
- * \updates       2024-04-01
+ * \updates       2026-10-17
  * \license       See above.
  *
  *  This module defines set_binding_values() and an nlsbindings class.
@@ -145,6 +145,8 @@ public:
         const std::string & domainname,
         std::string & codeset
     );
+    std::string get_codeset (const std::string & domainname) const;
+    std::string get_dirname (const std::string & domainname) const;
 
 #if defined POTEXT_WIDE_STRING_SUPPORT
     bool set_binding_wide
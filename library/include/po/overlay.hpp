@@ -0,0 +1,243 @@
+#if ! defined POTEXT_PO_OVERLAY_HPP
+#define POTEXT_PO_OVERLAY_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+
+/**
+ * \file          overlay.hpp
+ *
+ *      A dictionary of a few overriding translations in front of a shared,
+ *      read-only base dictionary.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  A server for many tenants may let each of them change a few strings of
+ *  a large catalog. A full dictionary per tenant would copy the whole
+ *  catalog, and dictionary::add() does not replace a message anyway. An
+ *  overlay holds only the overrides, and shares the base dictionary with
+ *  every other overlay of it, so it is made and dropped about as fast as
+ *  its overrides are, and its memory grows with them alone.
+ *
+ *  A lookup first checks a small Bloom filter of the override keys (two
+ *  bits of a 64-bit FNV-1a hash), so the lookups of messages that are not
+ *  overridden, nearly all of them, cost a hash of the msgid and go on to
+ *  the base without allocating. A context key is hashed in pieces, so it
+ *  is not built as a string unless the filter passes it.
+ *
+ *  The overrides are given in UTF-8, like the stored translations, and
+ *  converted to the base dictionary's charset (or the codeset asked for)
+ *  as they are looked up. The base must not be changed while overlays
+ *  use it. An overlay is not changed by lookups, so several threads can
+ *  use it at once, but adding overrides must not overlap with lookups.
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <cstdint>                      /* std::uint64_t                    */
+#include <memory>                       /* std::shared_ptr<> template       */
+#include <string>                       /* std::string class                */
+#include <unordered_map>                /* std::unordered_map<> template    */
+#include <vector>                       /* std::vector<> template           */
+
+#include "po/dictionary.hpp"            /* po::dictionary class             */
+
+namespace po
+{
+
+/**
+ *  Overriding translations over a shared dictionary.
+ */
+
+class overlay
+{
+
+private:
+
+    struct entry
+    {
+        std::string msgid_plural;
+        phraselist phrase_list;
+    };
+
+    /**
+     *  The overrides, keyed by the msgid, or by manifest::make_key() of the
+     *  msgctxt and msgid.
+     */
+
+    using entries = std::unordered_map<std::string, entry>;
+
+    std::shared_ptr<const dictionary> m_base;
+    entries m_overrides;
+
+    /**
+     *  The Bloom filter of the override keys. Its size is a power of two
+     *  of at least sm_filter_bits bits per override, so that few lookups
+     *  of other messages get past it.
+     */
+
+    std::vector<std::uint64_t> m_filter;
+
+public:
+
+    /**
+     *  The filter bits per override; with two bits set per key, about 1.4%
+     *  of the lookups of other messages get past the filter.
+     */
+
+    static constexpr std::size_t sm_filter_bits = 16;
+
+    overlay (std::shared_ptr<const dictionary> base);
+    overlay (const overlay &) = delete;
+    overlay (overlay &&) = default;
+    overlay & operator = (const overlay &) = delete;
+    overlay & operator = (overlay &&) = default;
+    ~overlay () = default;
+
+    const dictionary & base () const
+    {
+        return *m_base;
+    }
+
+    std::size_t size () const
+    {
+        return m_overrides.size();
+    }
+
+    bool empty () const
+    {
+        return m_overrides.empty();
+    }
+
+    void clear ();
+    std::size_t memory_usage () const;
+
+    void add
+    (
+        const std::string & msgid,
+        const std::string & msgstr
+    );
+    void add
+    (
+        const std::string & msgctxt,
+        const std::string & msgid,
+        const std::string & msgstr
+    );
+    void add
+    (
+        const std::string & msgid,
+        const std::string & msgid_plural,
+        const phraselist & msgstrs
+    );
+    void add
+    (
+        const std::string & msgctxt,
+        const std::string & msgid,
+        const std::string & msgid_plural,
+        const phraselist & msgstrs
+    );
+    bool remove (const std::string & msgid);
+    bool remove (const std::string & msgctxt, const std::string & msgid);
+
+    std::string translate
+    (
+        const std::string & msgid,
+        const std::string & codeset = ""
+    ) const;
+    std::string translate_plural
+    (
+        const std::string & msgid,
+        const std::string & msgidplural,
+        int num,
+        const std::string & codeset = ""
+    ) const;
+    std::string translate_ctxt
+    (
+        const std::string & msgctxt,
+        const std::string & msgid,
+        const std::string & codeset = ""
+    ) const;
+    std::string translate_ctxt_plural
+    (
+        const std::string & msgctxt,
+        const std::string & msgid,
+        const std::string & msgidplural,
+        int num,
+        const std::string & codeset = ""
+    ) const;
+    const std::string * find (const std::string & msgid) const;
+    const std::string * find_ctxt
+    (
+        const std::string & msgctxt,
+        const std::string & msgid
+    ) const;
+
+private:
+
+    static std::uint64_t key_hash (const std::string & msgid);
+    static std::uint64_t key_hash
+    (
+        const std::string & msgctxt,
+        const std::string & msgid
+    );
+    void set_override (std::string key, std::uint64_t hash, entry e);
+    void filter_add (std::uint64_t hash);
+    bool filter_test (std::uint64_t hash) const;
+    void rebuild_filter ();
+    const entry * lookup (const std::string & msgid) const;
+    const entry * lookup
+    (
+        const std::string & msgctxt,
+        const std::string & msgid
+    ) const;
+    static const std::string * singular (const entry * e);
+    std::string output
+    (
+        const std::string & msgstr,
+        const std::string & codeset
+    ) const;
+    std::string plural_output
+    (
+        const entry & e,
+        const std::string & msgid,
+        const std::string & msgidplural,
+        int num,
+        const std::string & codeset
+    ) const;
+
+};              // class overlay
+
+}               // namespace po
+
+#endif          // POTEXT_PO_OVERLAY_HPP
+
+/*
+ * overlay.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -33,11 +33,20 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-10
+ * \updates       2026-10-17
  * \license       See above.
  *
+ *  get_plurals() picks the plural forms of many counts at once, e.g. for
+ *  the rows of a report. Each plural function has a batch version, the
+ *  same rule inlined into a loop over the counts, which the compiler can
+ *  vectorize, so there is no indirect call per count. Counts below
+ *  sm_table_size are looked up in a table made when the object is.
  */
 
+#include <array>                        /* std::array<> template            */
+#include <cstddef>                      /* std::size_t                      */
+#include <cstdint>                      /* std::uint8_t                     */
+#include <memory>                       /* std::shared_ptr<> template       */
 #include <string>
 #include <unordered_map>                /* std::unordered_map<> template    */
 
@@ -67,6 +76,27 @@ public:
 
     using function = unsigned (*) (int n);
 
+    /**
+     *  Provides the signature of the batch version of a plural function,
+     *  which sets indices[i] to the plural form of counts[i].
+     */
+
+    using batchfunction = void (*)
+    (
+        const int * counts,
+        std::size_t count,
+        unsigned * indices
+    );
+
+    /**
+     *  The counts from 0 up to this one have their plural forms in a
+     *  table.
+     */
+
+    static constexpr int sm_table_size = 256;
+
+    using table = std::array<std::uint8_t, sm_table_size>;
+
     /**
      *  A list of pluralforms objects keyed by plural-forms descriptors.
      */
@@ -87,6 +117,26 @@ private:
 
     function mf_plural;
 
+    /**
+     *  The batch version of mf_plural, if there is one.
+     */
+
+    batchfunction mf_plurals;
+
+    /**
+     *  The plural forms of the small counts. It is shared by the copies of
+     *  this object, which every dictionary of the language holds.
+     */
+
+    std::shared_ptr<const table> m_table;
+
+    /**
+     *  The Plural-Forms string (without spaces) that selected this object,
+     *  so that it can be saved and looked up again (see flatcatalog).
+     */
+
+    std::string m_descriptor;
+
 public:
 
     static pluralforms from_string (const std::string & str);
@@ -96,7 +146,12 @@ public:
      */
 
     pluralforms ();
-    pluralforms (unsigned nplural, function plural);
+    pluralforms
+    (
+        unsigned nplural,
+        function plural,
+        batchfunction plurals = nullptr
+    );
     pluralforms (const pluralforms &) = default;
     pluralforms (pluralforms &&) = default;
     pluralforms & operator = (const pluralforms &) = default;
@@ -107,11 +162,23 @@ public:
         return m_nplural;
     }
 
+    const std::string & descriptor () const
+    {
+        return m_descriptor;
+    }
+
     unsigned get_plural (int n) const
     {
         return mf_plural ? mf_plural(n) : 0 ;
     }
 
+    void get_plurals
+    (
+        const int * counts,
+        std::size_t count,
+        unsigned * indices
+    ) const;
+
     bool operator == (const pluralforms & other) const
     {
         return m_nplural == other.m_nplural && mf_plural == other.mf_plural;
@@ -0,0 +1,240 @@
+#if ! defined POTEXT_PO_POMERGE_HPP
+#define POTEXT_PO_POMERGE_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          pomerge.hpp
+ *
+ *      Merging the translations of a .po file into a new .pot template, as
+ *      GNU msgmerge does.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  Each message of the template gets the translation of the same message
+ *  in the old catalog. A message that is not there gets the translation
+ *  of the most similar old message, flagged "fuzzy" for the translator to
+ *  review. GNU msgmerge compares each new message with every old one,
+ *  which is what makes it slow on large catalogs. Here the old msgids are
+ *  indexed by their character trigrams. Only the few old messages that
+ *  share the most trigrams with a new one are compared in full, and the
+ *  comparison is the one msgmerge makes (the longest common subsequence
+ *  ratio, with the same 0.6 threshold).
+ *
+ *  A pomerge object is not changed by find(), so several threads can
+ *  match messages at once, each with its own workspace. See the
+ *  potext-msgmerge tool.
+ *
+ *  The entries are read with parse_po_entries(), which keeps the comments,
+ *  references, and flags that a po::dictionary does not. The strings are
+ *  converted to UTF-8.
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <cstdint>                      /* std::uint32_t                    */
+#include <string>                       /* std::string class                */
+#include <unordered_map>                /* std::unordered_map<> template    */
+#include <vector>                       /* std::vector<> template           */
+
+#include "po/powriter.hpp"              /* po::poentry structure            */
+
+namespace po
+{
+
+extern bool parse_po_entries
+(
+    const std::string & text,
+    std::vector<poentry> & entries,
+    int * errorline = nullptr
+);
+
+/**
+ *  Matches the messages of a template to those of an old catalog, and
+ *  writes the merged catalog.
+ */
+
+class pomerge
+{
+
+public:
+
+    /**
+     *  The index of no entry.
+     */
+
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    /**
+     *  The similarity below which msgmerge makes no fuzzy match.
+     */
+
+    static constexpr double sm_default_threshold = 0.6;
+
+    /**
+     *  The old entry matched to a new one. If m_index is npos, there is
+     *  none, and the message is untranslated.
+     */
+
+    struct match
+    {
+        std::size_t m_index;
+        bool m_fuzzy;
+    };
+
+    /**
+     *  The scratch space of find(), one per thread.
+     */
+
+    class workspace
+    {
+        friend class pomerge;
+
+    private:
+
+        std::vector<std::uint32_t> w_counts;
+        std::vector<std::uint32_t> w_touched;
+        std::vector<std::uint32_t> w_grams;
+        std::vector<std::uint32_t> w_row;
+        std::vector<const std::vector<std::uint32_t> *> w_lists;
+    };
+
+private:
+
+    /**
+     *  The entries of the old catalog, converted to UTF-8.
+     */
+
+    std::vector<poentry> m_old;
+
+    /**
+     *  The index of the header of the old catalog, or npos.
+     */
+
+    std::size_t m_header;
+
+    /**
+     *  The number of plural forms of the old catalog, from its header. 2 if
+     *  the header does not say.
+     */
+
+    unsigned m_nplurals;
+
+    /**
+     *  The old entries by msgctxt and msgid, for the exact matches.
+     */
+
+    std::unordered_map<std::string, std::size_t> m_keys;
+
+    /**
+     *  For each trigram, the translated old entries that contain it.
+     */
+
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> m_postings;
+
+    /**
+     *  The number of distinct trigrams of each old msgid.
+     */
+
+    std::vector<std::uint32_t> m_gram_counts;
+
+    double m_threshold;
+    bool m_fuzzy_matching;
+    bool m_keep_obsolete;
+    bool m_previous;
+
+public:
+
+    pomerge (std::vector<poentry> old);
+    pomerge (const pomerge &) = delete;
+    pomerge (pomerge &&) = default;
+    pomerge & operator = (const pomerge &) = delete;
+    pomerge & operator = (pomerge &&) = default;
+    ~pomerge () = default;
+
+    void set_threshold (double t)
+    {
+        m_threshold = t;
+    }
+
+    void set_fuzzy_matching (bool flag)
+    {
+        m_fuzzy_matching = flag;
+    }
+
+    void set_keep_obsolete (bool flag)
+    {
+        m_keep_obsolete = flag;
+    }
+
+    void set_previous (bool flag)
+    {
+        m_previous = flag;
+    }
+
+    const std::vector<poentry> & old_entries () const
+    {
+        return m_old;
+    }
+
+    match find (const poentry & e, workspace & ws) const;
+    std::vector<poentry> merge
+    (
+        const std::vector<poentry> & pot,
+        const std::vector<match> & matches
+    ) const;
+
+    static double similarity
+    (
+        const std::string & a,
+        const std::string & b,
+        std::vector<std::uint32_t> & row
+    );
+
+private:
+
+    static std::string make_key (const poentry & e);
+    static void trigrams
+    (
+        const std::string & s,
+        std::vector<std::uint32_t> & grams
+    );
+    std::size_t find_fuzzy (const poentry & e, workspace & ws) const;
+    poentry merge_entry (const poentry & e, const match & m) const;
+
+};              // class pomerge
+
+}               // namespace po
+
+#endif          // POTEXT_PO_POMERGE_HPP
+
+/*
+ * pomerge.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -27,7 +27,7 @@
  * \library       potext
  * \author        Chris Ahlstrom
  * \date          2024-03-26
- * \updates       2024-04-12
+ * \updates       2026-10-17
  * \license       See above.
  *
  */
@@ -43,6 +43,7 @@ namespace po
 {
 
 class dictionary;
+class manifest;
 
 /**
  *  Purely for catch errors. Doesn't even inherit from std::exception.
@@ -107,10 +108,11 @@ private:
     std::string m_filename;
 
     /**
-     *  The input file stream from which the .po data is to be read.
+     *  The input file stream from which the .po data is to be read. It is
+     *  null for a parser that is given its input in pieces (popushparser).
      */
 
-    std::istream & m_in_stream;
+    std::istream * m_in_stream;
 
     /**
      *  The dictionary to receive the results of the parsing.
@@ -132,6 +134,14 @@ private:
 
     bool m_use_fuzzy;
 
+    /**
+     *  If not null, only the messages listed in this manifest are added to
+     *  the dictionary. The others are skipped before any conversion is
+     *  done. Not owned by the parser.
+     */
+
+    const manifest * m_manifest;
+
 public:
 
     /*
@@ -144,7 +154,15 @@ public:
         const std::string & filename,
         std::istream & in,
         dictionary & dict,
-        bool usefuzzy = true
+        bool usefuzzy = true,
+        const manifest * mf = nullptr
+    );
+    pomoparserbase
+    (
+        const std::string & filename,
+        dictionary & dict,
+        bool usefuzzy = true,
+        const manifest * mf = nullptr
     );
     pomoparserbase (const pomoparserbase &) = delete;
     pomoparserbase (pomoparserbase &&) = delete;
@@ -182,7 +200,7 @@ public:
 
     std::istream & in_stream ()
     {
-        return m_in_stream;
+        return *m_in_stream;
     }
 
     dictionary & dict ()
@@ -195,6 +213,12 @@ public:
         return m_use_fuzzy;
     }
 
+    bool wanted
+    (
+        const std::string & msgctxt,
+        const std::string & msgid
+    ) const;
+
 protected:
 
     iconvert & converter ()
@@ -204,6 +228,8 @@ protected:
 
     phraselist convert_list (const phraselist & source);
     std::string fix_message (const std::string & msg);
+    bool parse_header (const std::string & header, bool & big5);
+    static std::string fix_po_header (const std::string & header);
 
 };              // class pomoparserbase
 
@@ -33,7 +33,7 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-03-31
+ * \updates       2026-10-17
  * \license       See above.
  *
  */
@@ -92,7 +92,8 @@ private:
         const std::string & filename,
         std::istream & in,
         dictionary & dic,
-        bool usefuzzy       = true
+        bool usefuzzy       = true,
+        const manifest * mf = nullptr
     );
     poparser (const poparser &) = delete;
     poparser (poparser &&) = delete;
@@ -101,7 +102,6 @@ private:
 
     virtual bool parse () override;
 
-    bool parse_header (const std::string & header);
     bool next_line ();
     std::string get_string (std::size_t skip);
     void get_string_line (std::ostringstream & str, std::size_t skip);
@@ -140,13 +140,22 @@ public:
      *
      * \param dict
      *      Dictionary to which the translation strings are written.
+     *
+     * \param usefuzzy
+     *      If true (the default), entries flagged "fuzzy" are added too.
+     *
+     * \param mf
+     *      An optional manifest. If not null, only the messages it lists
+     *      are added to the dictionary.
      */
 
     static bool parse_po_file
     (
         const std::string & filename,
         std::istream & in,
-        dictionary & dic
+        dictionary & dic,
+        bool usefuzzy       = true,
+        const manifest * mf = nullptr
     );
 
 };              // class poparser
@@ -0,0 +1,234 @@
+#if ! defined POTEXT_PO_POPUSHPARSER_HPP
+#define POTEXT_PO_POPUSHPARSER_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+
+/**
+ * \file          popushparser.hpp
+ *
+ *      A .po parser that is given its input in pieces, as it arrives.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  The poparser pulls whole lines from a std::istream. The popushparser
+ *  is pushed chunks of any size instead, e.g. the reads of a pipe or the
+ *  blocks of a decompressor, so a catalog can be loaded while it is still
+ *  arriving, without a temporary file and without holding all of it:
+ *
+\verbatim
+    po::dictionary dict;
+    po::popushparser parser("de.po", dict);
+    while ((n = read(fd, buffer, sizeof buffer)) > 0)
+    {
+        if (! parser.feed(buffer, n))
+            break;
+    }
+    bool ok = parser.finish();
+\endverbatim
+ *
+ *  A chunk may end anywhere: inside a keyword, a string, an escape, a
+ *  multibyte character, or a plural block. The parser is a state machine
+ *  over bytes, so it keeps only the entry being read. Each entry is added
+ *  to the dictionary as soon as it is complete, that is, when the next
+ *  entry, a comment, or a blank line begins, or at finish().
+ *
+ *  The entries are added as poparser adds them: the header sets the
+ *  charset and plural forms, fuzzy entries and the manifest are honored,
+ *  and the strings are converted to UTF-8.
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <string>                       /* std::string class                */
+
+#include "po/pomoparserbase.hpp"        /* po::pomoparserbase class         */
+
+namespace po
+{
+
+/**
+ *  Parses a .po catalog pushed to it in chunks.
+ */
+
+class popushparser final : public pomoparserbase
+{
+
+private:
+
+    /**
+     *  Where the parser is in the input.
+     */
+
+    enum class state
+    {
+        line_start,                     /* at the start of a line           */
+        comment_start,                  /* just after a '#'                 */
+        comment,                        /* in a comment, which is skipped   */
+        flags,                          /* in a "#," line, kept in m_token  */
+        keyword,                        /* in a keyword, kept in m_token    */
+        before_string,                  /* between a keyword and its '"'    */
+        in_string,                      /* inside a quoted string           */
+        escape,                         /* just after a '\' in a string     */
+        big5_trail,                     /* after the first byte of a Big5   */
+        after_string,                   /* after the closing '"'            */
+        failed                          /* an error; the rest is ignored    */
+    };
+
+    state m_state;
+
+    /**
+     *  The number of bytes fed so far, and the number of them that match
+     *  the start of a UTF-8 byte-order mark. A mark is skipped; the bytes
+     *  of a partial one are held until it is known not to be one.
+     */
+
+    std::size_t m_byte_count;
+    std::size_t m_bom_count;
+
+    /**
+     *  The line being read, for messages.
+     */
+
+    int m_line_number;
+
+    /**
+     *  Indicates that the header gave the "BIG5" charset.
+     */
+
+    bool m_big5;
+
+    /**
+     *  Indicates that finish() has been called.
+     */
+
+    bool m_finished;
+
+    /**
+     *  The keyword or the "#," flags being read, and the number of spaces
+     *  after a keyword.
+     */
+
+    std::string m_token;
+    std::size_t m_spaces;
+
+    /**
+     *  The entry being read.
+     */
+
+    bool m_fuzzy;
+    bool m_has_ctxt;
+    bool m_has_msgid;
+    bool m_has_plural;
+    bool m_has_msgstr;
+    std::string m_msgctxt;
+    std::string m_msgid;
+    std::string m_msgid_plural;
+    phraselist m_msgstrs;
+
+    /**
+     *  The string that the next quoted text is added to, or null if a
+     *  quoted line cannot continue anything.
+     */
+
+    std::string * m_target;
+
+    /**
+     *  The number of entries completed.
+     */
+
+    std::size_t m_entry_count;
+
+public:
+
+    popushparser () = delete;
+    popushparser
+    (
+        const std::string & filename,
+        dictionary & dict,
+        bool usefuzzy       = true,
+        const manifest * mf = nullptr
+    );
+    popushparser (const popushparser &) = delete;
+    popushparser (popushparser &&) = delete;
+    popushparser & operator = (const popushparser &) = delete;
+    ~popushparser () = default;
+
+    bool feed (const char * data, std::size_t size);
+
+    bool feed (const std::string & data)
+    {
+        return feed(data.data(), data.size());
+    }
+
+    bool finish ();
+
+    /**
+     *  There is no stream to read, so this finishes the input fed so far.
+     */
+
+    virtual bool parse () override
+    {
+        return finish();
+    }
+
+    bool failed () const
+    {
+        return m_state == state::failed;
+    }
+
+    std::size_t entry_count () const
+    {
+        return m_entry_count;
+    }
+
+    int line_number () const
+    {
+        return m_line_number;
+    }
+
+private:
+
+    void check_bom (char c);
+    void step (char c);
+    void end_line ();
+    void start_keyword ();
+    void complete_entry ();
+    void clear_entry ();
+
+};              // class popushparser
+
+}               // namespace po
+
+#endif          // POTEXT_PO_POPUSHPARSER_HPP
+
+/*
+ * popushparser.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,97 @@
+#if ! defined POTEXT_PO_POWRITER_HPP
+#define POTEXT_PO_POWRITER_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          powriter.hpp
+ *
+ *      Functions to write .po and .pot entries.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  The output follows the layout of the GNU gettext tools with the
+ *  --no-wrap option: comments, then msgctxt, msgid, msgid_plural, and the
+ *  msgstr(s). Strings containing embedded newlines are split after each
+ *  newline. Only the "#:" reference lines are wrapped at 79 columns.
+ *  An obsolete entry has its keyword lines prefixed by "#~ ", as msgmerge
+ *  writes them.
+ *
+ *  Unlike xgettext, the .pot header has no POT-Creation-Date, so that
+ *  the output depends only on the input.
+ */
+
+#include <string>                       /* std::string class                */
+#include <vector>                       /* std::vector<> template           */
+
+namespace po
+{
+
+/**
+ *  One entry of a .po or .pot file.
+ */
+
+struct poentry
+{
+    std::vector<std::string> comments;      /* translator comments, "# "    */
+    std::vector<std::string> extracted;     /* extracted comments, "#. "    */
+    std::vector<std::string> references;    /* source references, "#: "     */
+    std::vector<std::string> flags;         /* "fuzzy", "c-format", ...     */
+    bool has_ctxt = false;                  /* a msgctxt is present         */
+    std::string msgctxt;                    /* the context                  */
+    std::string msgid;                      /* the message ID               */
+    bool has_plural = false;                /* a msgid_plural is present    */
+    std::string msgid_plural;               /* the plural message ID        */
+    std::vector<std::string> msgstrs;       /* msgstr, or msgstr[n]         */
+    bool has_previous = false;              /* a "#| msgid" is present      */
+    std::string previous_msgid;             /* the msgid before a merge     */
+    bool obsolete = false;                  /* written as "#~" lines        */
+};
+
+extern std::string po_string
+(
+    const std::string & keyword,
+    const std::string & text
+);
+extern std::string po_entry_text (const poentry & entry);
+extern std::string pot_header_text
+(
+    const std::string & package,
+    bool plurals
+);
+
+}               // namespace po
+
+#endif          // POTEXT_PO_POWRITER_HPP
+
+/*
+ * powriter.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
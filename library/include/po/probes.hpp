@@ -0,0 +1,111 @@
+#if ! defined POTEXT_PO_PROBES_HPP
+#define POTEXT_PO_PROBES_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+
+/**
+ * \file          probes.hpp
+ *
+ *      Static tracepoints (USDT probes) at the key points of the library.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  The probes are compiled in only if the "enable_probes" Meson option is
+ *  set and <sys/sdt.h> (from SystemTap) is found, which defines
+ *  POTEXT_USE_PROBES. Otherwise the macros do nothing and their arguments
+ *  are not even evaluated. A compiled-in probe is a single "nop" until a
+ *  tracer attaches to it, so it can be left in a release build. For
+ *  example:
+ *
+\verbatim
+    $ bpftrace -e 'usdt:/usr/lib/libpotext-0.2.so:potext:lookup__miss
+        { printf("%s %s\n", str(arg0), str(arg1)); }'
+    $ perf probe -x libpotext-0.2.so sdt_potext:parse__end
+\endverbatim
+ *
+ *  The probes of the "potext" provider, with their arguments:
+ *
+ *      -   catalog__open (file, ok). A catalog file was opened, or could
+ *          not be.
+ *      -   parse__begin (file), parse__end (file, ok). The parsing of a
+ *          .po or .mo catalog into a dictionary.
+ *      -   convert__failure (file, fromcode, tocode, offset). iconv() met
+ *          an invalid or incomplete sequence at the byte offset. The file
+ *          is empty if the text is not from a catalog.
+ *      -   lookup__hit (msgctxt, msgid), lookup__miss (msgctxt, msgid),
+ *          lookup__fallback (msgctxt, msgid). A dictionary found the
+ *          message, did not, or passed it on to its fallback dictionary
+ *          (which then fires its own hit or miss). The context is empty
+ *          for a message without one.
+ *      -   language__switch (from, to). The dictionarymgr changed its
+ *          current language.
+ *
+ *  The strings are C strings, valid only while the probe fires.
+ */
+
+#if defined POTEXT_USE_PROBES
+
+#include <sys/sdt.h>                    /* DTRACE_PROBE() macros            */
+
+#define POTEXT_PROBE1(name, a) \
+    DTRACE_PROBE1(potext, name, a)
+
+#define POTEXT_PROBE2(name, a, b) \
+    DTRACE_PROBE2(potext, name, a, b)
+
+#define POTEXT_PROBE4(name, a, b, c, d) \
+    DTRACE_PROBE4(potext, name, a, b, c, d)
+
+#else
+
+/*
+ *  The arguments are only the operands of sizeof, so they count as used
+ *  but are not evaluated. The extra parentheses keep an argument such as
+ *  "int(bool(x))" from being read as a type.
+ */
+
+#define POTEXT_PROBE1(name, a) \
+    ((void) sizeof((a)))
+
+#define POTEXT_PROBE2(name, a, b) \
+    ((void) (sizeof((a)) + sizeof((b))))
+
+#define POTEXT_PROBE4(name, a, b, c, d) \
+    ((void) (sizeof((a)) + sizeof((b)) + sizeof((c)) + sizeof((d))))
+
+#endif          // defined POTEXT_USE_PROBES
+
+#endif          // POTEXT_PO_PROBES_HPP
+
+/*
+ * probes.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,181 @@
+#if ! defined POTEXT_PO_RTCATALOG_HPP
+#define POTEXT_PO_RTCATALOG_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+
+/**
+ * \file          rtcatalog.hpp
+ *
+ *      A catalog handle whose lookups can be made from real-time threads.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  An audio or MIDI thread must not wait for a lock, allocate memory, or
+ *  make a system call. The usual lookups do all of these: dictionary::
+ *  translate() returns a std::string and logs a miss, a codeset view
+ *  calls iconv, and the dictionarymgr loads catalogs when first asked
+ *  for them, under its mutex.
+ *
+ *  An rtcatalog is made from a dictionary outside of the real-time thread.
+ *  It takes the flatcatalog image of the dictionary and of each of its
+ *  fallbacks, compiling one for a dictionary that has none, and touches
+ *  every page of them. After that it does not change. Its lookups:
+ *
+ *      -   Take and return std::string_view, so that they allocate nothing
+ *          (a string literal is passed without a copy).
+ *      -   Take no lock and use no atomic operation, so that any number of
+ *          threads can use one handle at once, none waiting for another.
+ *      -   Do not log, convert, or load anything. The translations are in
+ *          UTF-8, the storage charset.
+ *      -   Take a bounded time: a binary search of the sorted keys of each
+ *          image in the chain, which has at most sm_max_chain links, plus
+ *          the evaluation of the Plural-Forms expression.
+ *
+ *  The results are those of the dictionary: a singular lookup falls back
+ *  as find() and find_ctxt() do, and a plural lookup uses the dictionary
+ *  itself, as translate_plural() does. A miss returns the msgid (or the
+ *  msgid_plural, by the English rule).
+ *
+ *  The views point into the images, which the handle holds, so they stay
+ *  valid as long as the handle does, even if the dictionarymgr drops the
+ *  dictionary. To change the language, make a new handle outside of the
+ *  real-time thread and hand over a pointer to it (e.g. through a
+ *  std::atomic); the old handle must outlive the lookups still using it.
+ *
+ *  A mapped image is paged in when the handle is made, but the system can
+ *  page it out again under memory pressure. An application that cannot
+ *  allow even that should lock its memory with mlockall().
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <memory>                       /* std::shared_ptr<> template       */
+#include <string_view>                  /* std::string_view class           */
+#include <vector>                       /* std::vector<> template           */
+
+#include "po/pluralforms.hpp"           /* po::pluralforms class            */
+
+namespace po
+{
+
+class dictionary;
+class flatcatalog;
+
+/**
+ *  A read-only, real-time-safe view of a dictionary. See the banner above.
+ */
+
+class rtcatalog
+{
+
+public:
+
+    /**
+     *  The most dictionaries in the chain: the dictionary and its
+     *  fallbacks (e.g. de_AT, then de).
+     */
+
+    static constexpr std::size_t sm_max_chain = 4;
+
+private:
+
+    /**
+     *  The images of the dictionary first, then of its fallbacks. It is
+     *  filled by the constructor and then not changed.
+     */
+
+    std::vector<std::shared_ptr<const flatcatalog>> m_chain;
+
+    /**
+     *  The plural forms of the dictionary.
+     */
+
+    pluralforms m_plural_forms;
+
+public:
+
+    rtcatalog ();
+    explicit rtcatalog (const dictionary & dict);
+    rtcatalog (const rtcatalog &) = delete;
+    rtcatalog (rtcatalog &&) = default;
+    rtcatalog & operator = (const rtcatalog &) = delete;
+    rtcatalog & operator = (rtcatalog &&) = default;
+    ~rtcatalog () = default;
+
+    bool valid () const noexcept
+    {
+        return ! m_chain.empty();
+    }
+
+    std::size_t chain_size () const noexcept
+    {
+        return m_chain.size();
+    }
+
+    std::string_view translate (std::string_view msgid) const noexcept;
+    std::string_view translate_ctxt
+    (
+        std::string_view msgctxt,
+        std::string_view msgid
+    ) const noexcept;
+    std::string_view translate_plural
+    (
+        std::string_view msgid,
+        std::string_view msgid_plural,
+        int n
+    ) const noexcept;
+    std::string_view translate_ctxt_plural
+    (
+        std::string_view msgctxt,
+        std::string_view msgid,
+        std::string_view msgid_plural,
+        int n
+    ) const noexcept;
+
+private:
+
+    std::string_view find_plural
+    (
+        const std::string_view * msgctxt,
+        std::string_view msgid,
+        std::string_view msgid_plural,
+        int n
+    ) const noexcept;
+
+};              // class rtcatalog
+
+}               // namespace po
+
+#endif          // POTEXT_PO_RTCATALOG_HPP
+
+/*
+ * rtcatalog.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,238 @@
+#if ! defined POTEXT_PO_SEARCHINDEX_HPP
+#define POTEXT_PO_SEARCHINDEX_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          searchindex.hpp
+ *
+ *      A substring and prefix index of the messages of a dictionary.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Translation tools search catalogs for text in the message IDs and the
+ *  translations. Scanning every message with dictionary::foreach() takes
+ *  time proportional to the size of the catalog. This index copies all of
+ *  the strings into one pool and sorts the positions in it (a suffix
+ *  array), so that a search is two binary searches plus the matches.
+ *  A second array, of the string starts only, serves prefix searches.
+ *  The suffixes are sorted by prefix doubling, in time proportional to
+ *  the size of the pool times the log of its longest string.
+ *
+ *  A search with a limit stops once it has that many messages, so that
+ *  an interactive search of a large catalog takes about the same time
+ *  however common the text is.
+ *
+ *  The index can fold ASCII letters to lower case, for case-insensitive
+ *  searches. Other UTF-8 characters are compared as they are.
+ *
+ *  The index is a snapshot; it does not see later changes to the
+ *  dictionary. See dictionary::search_index() for one that is kept with
+ *  the dictionary.
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <cstdint>                      /* std::uint32_t                    */
+#include <string>                       /* std::string class                */
+#include <vector>                       /* std::vector<> template           */
+
+namespace po
+{
+
+class dictionary;
+
+/**
+ *  A suffix-array index of the strings of a dictionary.
+ */
+
+class searchindex
+{
+
+public:
+
+    /**
+     *  Selects the strings searched, as a bit mask.
+     */
+
+    enum scope : unsigned
+    {
+        msgids  = 0x01,                 /* the msgid and msgid_plural       */
+        msgstrs = 0x02,                 /* the translations                 */
+        all     = 0x03
+    };
+
+    /**
+     *  Identifies a message of the dictionary.
+     */
+
+    struct match
+    {
+        bool has_ctxt;
+        std::string msgctxt;
+        std::string msgid;
+    };
+
+private:
+
+    /**
+     *  One string of the pool: where it starts, whose it is, and whether
+     *  it is a translation.
+     */
+
+    struct segment
+    {
+        std::uint32_t s_offset;
+        std::uint32_t s_entry;
+        bool s_msgstr;
+    };
+
+    /**
+     *  The messages, in the order of dictionary::foreach() and then
+     *  dictionary::foreach_ctxt().
+     */
+
+    std::vector<match> m_entries;
+
+    /**
+     *  The strings, each ended by a null byte, and possibly folded to lower
+     *  case.
+     */
+
+    std::string m_pool;
+
+    /**
+     *  The strings of the pool, in order of their offsets.
+     */
+
+    std::vector<segment> m_segments;
+
+    /**
+     *  The offsets of every byte of every string, sorted by the text from
+     *  there to the end of the string.
+     */
+
+    std::vector<std::uint32_t> m_suffixes;
+
+    /**
+     *  The segment of each suffix, parallel to m_suffixes.
+     */
+
+    std::vector<std::uint32_t> m_suffix_segments;
+
+    /**
+     *  The indexes of the segments, sorted by their text.
+     */
+
+    std::vector<std::uint32_t> m_prefixes;
+
+    /**
+     *  Indicates that ASCII letters are folded to lower case.
+     */
+
+    bool m_fold_case;
+
+public:
+
+    searchindex ();
+    searchindex (const searchindex &) = delete;
+    searchindex (searchindex &&) = default;
+    searchindex & operator = (const searchindex &) = delete;
+    searchindex & operator = (searchindex &&) = default;
+    ~searchindex () = default;
+
+    bool build (const dictionary & dict, bool foldcase = true);
+    void clear ();
+
+    bool empty () const
+    {
+        return m_entries.empty();
+    }
+
+    std::size_t size () const
+    {
+        return m_entries.size();
+    }
+
+    bool fold_case () const
+    {
+        return m_fold_case;
+    }
+
+    const match & at (std::size_t index) const
+    {
+        return m_entries.at(index);
+    }
+
+    std::vector<std::size_t> find
+    (
+        const std::string & text,
+        unsigned where = all,
+        std::size_t limit = 0
+    ) const;
+    std::vector<std::size_t> find_prefix
+    (
+        const std::string & text,
+        unsigned where = all,
+        std::size_t limit = 0
+    ) const;
+
+private:
+
+    void add_string (const std::string & s, std::size_t entry, bool msgstr);
+    std::string fold (const std::string & text) const;
+    bool in_scope (std::uint32_t s, unsigned where) const
+    {
+        unsigned kind = m_segments[s].s_msgstr ? msgstrs : msgids ;
+        return (kind & where) != 0;
+    }
+
+    std::vector<std::size_t> collect
+    (
+        const std::uint32_t * segments,
+        std::size_t count,
+        unsigned where,
+        std::size_t limit
+    ) const;
+    std::vector<std::size_t> first_entries
+    (
+        unsigned where,
+        std::size_t limit
+    ) const;
+
+};              // class searchindex
+
+}               // namespace po
+
+#endif          // POTEXT_PO_SEARCHINDEX_HPP
+
+/*
+ * searchindex.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
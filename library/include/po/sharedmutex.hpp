@@ -0,0 +1,172 @@
+#if ! defined POTEXT_PO_SHAREDMUTEX_HPP
+#define POTEXT_PO_SHAREDMUTEX_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+
+/**
+ * \file          sharedmutex.hpp
+ *
+ *      A readers-writer lock whose exclusive side may be taken again by
+ *      the thread that holds it.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Every gettext lookup locks the dictionarymgr; with a plain mutex, each
+ *  would wait for all the others. But the lookups only read the manager
+ *  and the loaded dictionaries, so they can share the lock; the changes
+ *  (a new language, domain, or search path, a catalog loaded or dropped)
+ *  take it exclusively.
+ *
+ *  The public functions of the manager call one another, so the exclusive
+ *  lock must be recursive, which std::shared_mutex is not. sharedmutex
+ *  keeps the thread that holds it exclusively, which may then lock it
+ *  again, either way, and counts the depth. The usual rules of a
+ *  std::shared_mutex otherwise apply:
+ *
+ *      -   A thread holding the shared lock must not ask for the exclusive
+ *          one, which would wait for itself. A lookup that finds it must
+ *          load a catalog lets go of the shared lock first.
+ *      -   A thread holding the shared lock should not take it again, as
+ *          a waiting writer may then block it.
+ *
+ *  It meets the Lockable and SharedLockable requirements, so it works with
+ *  std::lock_guard<> and std::shared_lock<>.
+ */
+
+#include <atomic>                       /* std::atomic<> template           */
+#include <shared_mutex>                 /* std::shared_mutex                */
+#include <thread>                       /* std::this_thread::get_id()       */
+
+namespace po
+{
+
+/**
+ *  A std::shared_mutex with a recursive exclusive lock.
+ */
+
+class sharedmutex
+{
+
+private:
+
+    std::shared_mutex m_mutex;
+
+    /**
+     *  The thread holding the exclusive lock, if any. Only that thread
+     *  stores its own ID here, and it clears it before unlocking, so no
+     *  other thread can find its own ID in it.
+     */
+
+    std::atomic<std::thread::id> m_owner;
+
+    /**
+     *  The number of times the owner has locked it, either way.
+     */
+
+    unsigned m_depth;
+
+public:
+
+    sharedmutex () :
+        m_mutex     (),
+        m_owner     (std::thread::id()),
+        m_depth     (0)
+    {
+        // no code
+    }
+
+    sharedmutex (const sharedmutex &) = delete;
+    sharedmutex (sharedmutex &&) = delete;
+    sharedmutex & operator = (const sharedmutex &) = delete;
+    sharedmutex & operator = (sharedmutex &&) = delete;
+    ~sharedmutex () = default;
+
+    void lock ()
+    {
+        std::thread::id self = std::this_thread::get_id();
+        if (m_owner.load(std::memory_order_relaxed) != self)
+        {
+            m_mutex.lock();
+            m_owner.store(self, std::memory_order_relaxed);
+        }
+        ++m_depth;
+    }
+
+    void unlock ()
+    {
+        if (--m_depth == 0)
+        {
+            m_owner.store(std::thread::id(), std::memory_order_relaxed);
+            m_mutex.unlock();
+        }
+    }
+
+    /**
+     *  Takes the shared lock, or, for the thread holding the exclusive
+     *  lock, just counts another level of it.
+     */
+
+    void lock_shared ()
+    {
+        if (owned())
+            ++m_depth;
+        else
+            m_mutex.lock_shared();
+    }
+
+    void unlock_shared ()
+    {
+        if (owned())
+            unlock();
+        else
+            m_mutex.unlock_shared();
+    }
+
+    /**
+     *  Indicates if the calling thread holds the exclusive lock.
+     */
+
+    bool owned () const
+    {
+        return m_owner.load(std::memory_order_relaxed) ==
+            std::this_thread::get_id();
+    }
+
+};              // class sharedmutex
+
+}               // namespace po
+
+#endif          // POTEXT_PO_SHAREDMUTEX_HPP
+
+/*
+ * sharedmutex.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,237 @@
+#if ! defined POTEXT_PO_SNAPSHOTRING_HPP
+#define POTEXT_PO_SNAPSHOTRING_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+
+/**
+ * \file          snapshotring.hpp
+ *
+ *      A fixed ring of immutable snapshots, the newest of which is read
+ *      without locking.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Tables of translations that are rebuilt when the dictionarymgr
+ *  generation changes (see labeltable and idgettext()) are read far more
+ *  often than they are rebuilt. A reader loads the newest snapshot with one
+ *  atomic load; a writer, serialized by its own lock, builds a new
+ *  snapshot and publishes it.
+ *
+ *  The ring holds the newest N snapshots, so the memory held is bounded no
+ *  matter how often the language changes. Besides, each thread holds the
+ *  last sm_held snapshots it has read (of any ring), like the held strings
+ *  of coldstore. So a snapshot returned by current(), and anything that
+ *  points into it, stays valid for the calling thread until both:
+ *
+ *      -   N - 1 newer snapshots have been published in its ring, and
+ *      -   the thread has read sm_held newer snapshots.
+ *
+ *  In particular, a thread may use what it got until it next reads the
+ *  ring after a change. A reader that finds its thread already holds the
+ *  newest snapshot takes no lock; otherwise it takes the lock of the ring
+ *  once, to hold the new one. A caller that keeps a translation longer
+ *  must copy it.
+ */
+
+#include <array>                        /* std::array<> template            */
+#include <atomic>                       /* std::atomic<> template           */
+#include <cstddef>                      /* std::size_t                      */
+#include <memory>                       /* std::shared_ptr<> template       */
+#include <mutex>                        /* std::mutex, std::lock_guard<>    */
+
+namespace po
+{
+
+/**
+ *  The snapshots held by the calling thread, the newest last read.
+ */
+
+class snapshotholds
+{
+
+public:
+
+    /**
+     *  The number of snapshots a thread holds.
+     */
+
+    static constexpr std::size_t sm_held = 8;
+
+private:
+
+    struct holds
+    {
+        std::shared_ptr<const void> h_snapshots[sm_held];
+        std::size_t h_next = 0;
+    };
+
+    static holds & thread_holds ()
+    {
+        static thread_local holds s_holds;
+        return s_holds;
+    }
+
+public:
+
+    /**
+     *  Indicates if the calling thread holds a snapshot. If so, the
+     *  snapshot is alive, and no other one can have its address.
+     */
+
+    static bool held (const void * snapshot)
+    {
+        const holds & h = thread_holds();
+        for (const auto & s : h.h_snapshots)
+        {
+            if (s.get() == snapshot)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     *  Holds a snapshot for the calling thread, letting go of the oldest
+     *  one it holds.
+     */
+
+    static void hold (std::shared_ptr<const void> snapshot)
+    {
+        holds & h = thread_holds();
+        h.h_snapshots[h.h_next] = std::move(snapshot);
+        h.h_next = (h.h_next + 1) % sm_held;
+    }
+
+};              // class snapshotholds
+
+/**
+ *  The newest N snapshots of type T.
+ */
+
+template <typename T, std::size_t N = 4>
+class snapshotring
+{
+    static_assert(N > 1, "a snapshotring needs at least two slots");
+
+private:
+
+    /**
+     *  Serializes publish(), and the readers that must hold a new
+     *  snapshot.
+     */
+
+    mutable std::mutex m_mutex;
+    std::array<std::shared_ptr<const T>, N> m_slots;
+    std::size_t m_next;
+    std::atomic<const T *> m_current;
+
+public:
+
+    snapshotring () :
+        m_mutex     (),
+        m_slots     (),
+        m_next      (0),
+        m_current   (nullptr)
+    {
+        // no code
+    }
+
+    snapshotring (const snapshotring &) = delete;
+    snapshotring (snapshotring &&) = delete;
+    snapshotring & operator = (const snapshotring &) = delete;
+    snapshotring & operator = (snapshotring &&) = delete;
+    ~snapshotring () = default;
+
+    static constexpr std::size_t depth ()
+    {
+        return N;
+    }
+
+    /**
+     *  The number of snapshots the ring holds, at most N.
+     */
+
+    std::size_t count () const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::size_t result = 0;
+        for (const auto & s : m_slots)
+        {
+            if (s)
+                ++result;
+        }
+        return result;
+    }
+
+    /**
+     *  Returns the newest snapshot, held for the calling thread, or null
+     *  if none has been published. Needs no lock if the thread already
+     *  holds it.
+     */
+
+    const T * current () const
+    {
+        const T * result = m_current.load(std::memory_order_acquire);
+        if (result == nullptr || snapshotholds::held(result))
+            return result;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto & newest = m_slots[(m_next + N - 1) % N];
+        snapshotholds::hold(newest);
+        return newest.get();
+    }
+
+    /**
+     *  Makes a snapshot the newest, held for the calling thread, and lets
+     *  the ring go of the oldest if it is full.
+     */
+
+    const T * publish (std::unique_ptr<const T> snap)
+    {
+        std::shared_ptr<const T> newest(std::move(snap));
+        snapshotholds::hold(newest);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_slots[m_next] = newest;
+        m_next = (m_next + 1) % N;
+        m_current.store(newest.get(), std::memory_order_release);
+        return newest.get();
+    }
+
+};              // class snapshotring
+
+}               // namespace po
+
+#endif          // POTEXT_PO_SNAPSHOTRING_HPP
+
+/*
+ * snapshotring.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,160 @@
+#if ! defined POTEXT_PO_SOURCESCANNER_HPP
+#define POTEXT_PO_SOURCESCANNER_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          sourcescanner.hpp
+ *
+ *      Finds translatable strings in C and C++ source code.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  The sourcescanner tokenizes C/C++ code just enough to skip comments and
+ *  character literals and to read string literals (including adjacent
+ *  literals, prefixed literals, and raw strings). It then looks for calls
+ *  of the keywords (_, N_, C_, gettext, ngettext, pgettext, ...) whose
+ *  arguments are string literals. Keywords can be added using the format of
+ *  the xgettext --keyword option, e.g. "tr:1c,2".
+ *
+ *  Optionally, a comment block that starts with a tag such as
+ *  "TRANSLATORS:", and that ends on the line of a keyword call or the line
+ *  before it, is attached to the message.
+ *
+ *  Calls whose message argument is not a literal are ignored, as are
+ *  definitions such as "#define _(str) po::gettext (str)".
+ */
+
+#include <string>                       /* std::string class                */
+#include <vector>                       /* std::vector<> template           */
+
+namespace po
+{
+
+/**
+ *  Scans source text for translatable messages.
+ */
+
+class sourcescanner
+{
+
+public:
+
+    /**
+     *  Describes a keyword. The argument numbers start at 1; 0 means the
+     *  keyword has no such argument.
+     */
+
+    using keyword = struct
+    {
+        std::string name;               /* function or macro name           */
+        int msgid_arg;                  /* the argument holding the msgid   */
+        int ctxt_arg;                   /* the argument holding the context */
+        int plural_arg;                 /* the argument holding the plural  */
+    };
+
+    /**
+     *  A message found in the source code.
+     */
+
+    using message = struct
+    {
+        std::string msgctxt;            /* the context, if has_ctxt is true */
+        bool has_ctxt;                  /* a context argument was present   */
+        std::string msgid;              /* the message ID                   */
+        bool has_plural;                /* a plural argument was present    */
+        std::string msgid_plural;       /* the plural message ID            */
+        std::string comment;            /* the translator comment, if any   */
+        std::string filename;           /* the source file                  */
+        int line;                       /* the line of the keyword          */
+    };
+
+    using messages = std::vector<message>;
+
+private:
+
+    /**
+     *  The keywords to look for.
+     */
+
+    std::vector<keyword> m_keywords;
+
+    /**
+     *  The tag that starts an extracted comment. Empty means any comment.
+     */
+
+    std::string m_comment_tag;
+
+    /**
+     *  Indicates that comments are to be extracted.
+     */
+
+    bool m_comments;
+
+public:
+
+    sourcescanner ();
+    sourcescanner (const sourcescanner &) = default;
+    sourcescanner & operator = (const sourcescanner &) = default;
+    ~sourcescanner () = default;
+
+    void add_keyword (const keyword & kw);
+    bool add_keyword (const std::string & spec);
+    void clear_keywords ();
+    void set_comment_tag (const std::string & tag);
+    bool scan_file (const std::string & filename, messages & out) const;
+    void scan
+    (
+        const std::string & text,
+        const std::string & filename,
+        messages & out
+    ) const;
+
+    static std::string make_key (const message & msg);
+
+    const std::vector<keyword> & keywords () const
+    {
+        return m_keywords;
+    }
+
+private:
+
+    const keyword * find_keyword (const std::string & name) const;
+
+};              // class sourcescanner
+
+}               // namespace po
+
+#endif          // POTEXT_PO_SOURCESCANNER_HPP
+
+/*
+ * sourcescanner.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,168 @@
+#if ! defined POTEXT_PO_TRACERECORDER_HPP
+#define POTEXT_PO_TRACERECORDER_HPP
+
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+
+/**
+ * \file          tracerecorder.hpp
+ *
+ *      Recording the lookups of an application, to replay them later.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  A synthetic benchmark guesses at which messages are looked up, how
+ *  often, and how many are missing. A trace of a real run shows it. When
+ *  the recorder is started, each lookup made through the gettext functions
+ *  (see gettext.hpp) is logged: the function, the domain, the context, the
+ *  msgid and plural msgid, the count, the thread, and the time. The
+ *  potext-replay tool runs a trace against a set of catalogs and reports
+ *  the latencies, so that storage modes and releases can be compared on
+ *  the same work.
+ *
+ *  The recorder is off by default; then a lookup costs one more atomic
+ *  load. It is started by tracerecorder::start(), or by setting the
+ *  environment variable POTEXT_TRACE to the name of the trace file before
+ *  the first gettext call. It is stopped by stop(), or at exit.
+ *
+ *  The trace is compact. Each string is written once, the first time it
+ *  is used, and then referred to by its number. Numbers and times are
+ *  written as variable-length integers (7 bits a byte, low bits first):
+ *
+\verbatim
+    "POTXTRC1"                      magic and version, 8 bytes
+    'S' length bytes                a string; the first is number 1, and
+                                    number 0 is the empty string
+    'L' kind thread time domain     a lookup; the time is nanoseconds
+        msgctxt msgid plural count  since the previous lookup, and the
+                                    strings are string numbers
+\endverbatim
+ */
+
+#include <atomic>                       /* std::atomic<>                    */
+#include <cstdint>                      /* std::uint32_t, std::uint64_t     */
+#include <string>                       /* std::string class                */
+#include <vector>                       /* std::vector<> template           */
+
+namespace po
+{
+
+/**
+ *  The gettext function that made a lookup. dcgettext() is recorded as
+ *  dgettext(), and the other "dc" functions as their "d" functions, as
+ *  the category is not used.
+ */
+
+enum class tracekind : std::uint8_t
+{
+    gettext,
+    dgettext,
+    ngettext,
+    dngettext,
+    pgettext,
+    dpgettext,
+    idgettext,                          /* msgctxt is set if the key has one */
+    max
+};
+
+/**
+ *  One lookup read from a trace. The strings are numbers in
+ *  tracedata::td_strings.
+ */
+
+struct tracerecord
+{
+    tracekind tr_kind;
+    std::uint32_t tr_thread;            /* 0 for the first thread, etc.     */
+    std::uint64_t tr_time;              /* nanoseconds since the start      */
+    std::uint32_t tr_domain;
+    std::uint32_t tr_msgctxt;
+    std::uint32_t tr_msgid;
+    std::uint32_t tr_msgid_plural;
+    unsigned long tr_count;
+};
+
+/**
+ *  A trace read by tracerecorder::load().
+ */
+
+struct tracedata
+{
+    std::vector<std::string> td_strings;
+    std::vector<tracerecord> td_records;
+    std::uint32_t td_threads;
+};
+
+/**
+ *  The recorder. There is one for the process, so its functions are all
+ *  static.
+ */
+
+class tracerecorder
+{
+
+private:
+
+    static std::atomic<bool> sm_active;
+
+public:
+
+    tracerecorder () = delete;
+
+    static bool start (const std::string & filename);
+    static bool start_from_environment ();
+    static bool stop ();
+
+    static bool active ()
+    {
+        return sm_active.load(std::memory_order_relaxed);
+    }
+
+    static void record
+    (
+        tracekind kind,
+        const std::string & domain,
+        const std::string & msgctxt,
+        const std::string & msgid,
+        const std::string & msgid_plural = "",
+        unsigned long count = 0
+    );
+    static bool load (const std::string & filename, tracedata & data);
+
+};              // class tracerecorder
+
+}               // namespace po
+
+#endif          // POTEXT_PO_TRACERECORDER_HPP
+
+/*
+ * tracerecorder.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
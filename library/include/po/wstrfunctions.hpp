@@ -27,11 +27,12 @@
  * \library       potext
  * \author        Chris Ahlstrom
  * \date          2024-03-30
- * \updates       2024-04-02
+ * \updates       2026-10-17
  * \license       See above.
  *
  */
 
+#include <cstdint>                      /* std::uint64_t                    */
 #include <string>                       /* std::string & std::wstring       */
 
 #include "po_build_macros.h"            /* POTEXT_WIDE_STRING_SUPPORT       */
@@ -56,6 +57,32 @@ extern bool is_po_path (const std::string & fullpath);
 extern bool is_po_file (const std::string & fullpath);
 extern bool is_mo_or_po_file (const std::string & fullpath);
 extern std::string extract_po_domain (const std::string & fullpath);
+extern std::string unescape_c_string (const std::string & source);
+extern std::string escape_c_string (const std::string & source);
+extern bool read_file (const std::string & filename, std::string & text);
+extern bool write_file_if_changed
+(
+    const std::string & filename,
+    const std::string & text
+);
+
+/**
+ *  The FNV-1a offset basis, the usual seed of fnv1a_hash().
+ */
+
+const std::uint64_t c_fnv1a_seed = 14695981039346656037ULL;
+
+extern std::uint64_t fnv1a_hash
+(
+    const char * data,
+    std::size_t size,
+    std::uint64_t seed = c_fnv1a_seed
+);
+extern std::uint64_t fnv1a_hash
+(
+    const std::string & text,
+    std::uint64_t seed = c_fnv1a_seed
+);
 
 #if defined POTEXT_WIDE_STRING_SUPPORT
 extern std::wstring widen_ascii_string (const std::string & source);
@@ -33,7 +33,7 @@
  * \library       potext
  * \author        Gary P. Scavone; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-13
+ * \updates       2026-10-17
  * \license       See above.
  *
  * Introduction:
@@ -131,6 +131,12 @@
 
 #define POTEXT_WIDE_STRING_SUPPORT
 
+/**
+ *  POTEXT_USE_PROBES is not set here. The "enable_probes" Meson option sets
+ *  it if sys/sdt.h is found, to compile in the static probes of
+ *  po/probes.hpp.
+ */
+
 /**
  *  To do: improve the naming.
  */
@@ -0,0 +1,195 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          acceptlanguage.cpp
+ *
+ *      Parsing of the HTTP Accept-Language header.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  See the banner of acceptlanguage.hpp.
+ */
+
+#include "po/acceptlanguage.hpp"        /* po::parse_accept_language()      */
+
+namespace po
+{
+
+static bool
+is_space (char ch)
+{
+    return ch == ' ' || ch == '\t';
+}
+
+static std::string_view
+trim (std::string_view s)
+{
+    while (! s.empty() && is_space(s.front()))
+        s.remove_prefix(1);
+
+    while (! s.empty() && is_space(s.back()))
+        s.remove_suffix(1);
+
+    return s;
+}
+
+static bool
+is_country (std::string_view s)
+{
+    if (s.size() == 2)
+    {
+        return
+            ((s[0] >= 'A' && s[0] <= 'Z') || (s[0] >= 'a' && s[0] <= 'z')) &&
+            ((s[1] >= 'A' && s[1] <= 'Z') || (s[1] >= 'a' && s[1] <= 'z'));
+    }
+    if (s.size() == 3)
+    {
+        return
+            s[0] >= '0' && s[0] <= '9' && s[1] >= '0' && s[1] <= '9' &&
+            s[2] >= '0' && s[2] <= '9';
+    }
+    return false;
+}
+
+/**
+ *  Parses a q-value such as "0.8", "1", or "0.125", in thousandths. A
+ *  malformed value counts as 1, as if it were missing.
+ */
+
+static int
+parse_quality (std::string_view s)
+{
+    if (s.empty() || (s[0] != '0' && s[0] != '1'))
+        return 1000;
+
+    int result = (s[0] - '0') * 1000;
+    if (s.size() > 1 && s[1] == '.')
+    {
+        int scale = 100;
+        for (std::size_t i = 2; i < s.size() && scale > 0; ++i, scale /= 10)
+        {
+            if (s[i] < '0' || s[i] > '9')
+                break;
+
+            result += (s[i] - '0') * scale;
+        }
+    }
+    return result > 1000 ? 1000 : result ;
+}
+
+/**
+ *  Splits an Accept-Language header into language ranges, sorted by
+ *  q-value. Ranges with q=0 ("not acceptable") are dropped.
+ *
+ * \param header
+ *      The value of the header, e.g. "de-AT,de;q=0.9,en;q=0.5".
+ *
+ * \param [out] ranges
+ *      Receives the ranges, which point into the header.
+ *
+ * \param maxranges
+ *      The size of the ranges array.
+ *
+ * \return
+ *      Returns the number of ranges.
+ */
+
+std::size_t
+parse_accept_language
+(
+    std::string_view header,
+    languagerange * ranges,
+    std::size_t maxranges
+)
+{
+    std::size_t count = 0;
+    while (! header.empty() && count < maxranges)
+    {
+        std::size_t comma = header.find(',');
+        std::string_view item = header.substr(0, comma);
+        header.remove_prefix(comma == std::string_view::npos ?
+            header.size() : comma + 1);
+
+        std::size_t semi = item.find(';');
+        std::string_view tag = trim(item.substr(0, semi));
+        int quality = 1000;
+        while (semi != std::string_view::npos)
+        {
+            item.remove_prefix(semi + 1);
+            semi = item.find(';');
+
+            std::string_view param = trim(item.substr(0, semi));
+            if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') &&
+                param[1] == '=')
+            {
+                quality = parse_quality(param.substr(2));
+            }
+        }
+        if (tag.empty() || quality == 0)
+            continue;
+
+        std::size_t dash = tag.find_first_of("-_");
+        languagerange r{tag.substr(0, dash), std::string_view(), quality};
+        while (dash != std::string_view::npos)
+        {
+            tag.remove_prefix(dash + 1);
+            dash = tag.find_first_of("-_");
+
+            std::string_view subtag = tag.substr(0, dash);
+            if (is_country(subtag))
+            {
+                r.lr_country = subtag;
+                break;
+            }
+        }
+        if (r.lr_language.empty())
+            continue;
+
+        /*
+         * Insert in order of q-value, after any equal ones.
+         */
+
+        std::size_t i = count++;
+        while (i > 0 && ranges[i - 1].lr_quality < r.lr_quality)
+        {
+            ranges[i] = ranges[i - 1];
+            --i;
+        }
+        ranges[i] = r;
+    }
+    return count;
+}
+
+}               // namespace po
+
+/*
+ * acceptlanguage.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
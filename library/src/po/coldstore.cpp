@@ -0,0 +1,541 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          coldstore.cpp
+ *
+ *      Compressed storage for the long, rarely used translations of a
+ *      dictionary.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  See the banner of coldstore.hpp.
+ *
+ *  The compressed format is a series of sequences, each a token byte, a
+ *  run of literal bytes, and a back reference:
+ *
+\verbatim
+    token       the literal count (high nibble) and the match length less
+                4 (low nibble); 15 means more count bytes follow
+    [count]     more of the literal count: bytes of 255, ended by one less
+    literals    the bytes to copy as is
+    offset      2 bytes, little-endian, back from the output position
+    [count]     more of the match length, as for the literal count
+\endverbatim
+ *
+ *  The last sequence has only literals; the input ends after them.
+ */
+
+#include <atomic>                       /* std::atomic<>                    */
+#include <cstring>                      /* std::memcpy()                    */
+#include <functional>                   /* std::less<>                      */
+#include <utility>                      /* std::move()                      */
+
+#include "po/coldstore.hpp"             /* po::coldstore class              */
+
+namespace po
+{
+
+/**
+ *  The shortest back reference, the longest offset, and the size of the
+ *  hash table of the positions of 4-byte sequences.
+ */
+
+static const std::size_t c_min_match = 4;
+static const std::size_t c_max_offset = 65535;
+static const unsigned c_hash_bits = 12;
+
+/**
+ *  The number of decompressed blocks each thread keeps.
+ */
+
+static const std::size_t c_cached_blocks = 4;
+
+static std::uint32_t
+read32 (const char * p)
+{
+    std::uint32_t result;
+    std::memcpy(&result, p, sizeof result);
+    return result;
+}
+
+static std::size_t
+hash32 (std::uint32_t v)
+{
+    return std::size_t((v * 2654435761u) >> (32 - c_hash_bits));
+}
+
+static void
+put_count (std::vector<char> & out, std::size_t count)
+{
+    while (count >= 255)
+    {
+        out.push_back(char(255));
+        count -= 255;
+    }
+    out.push_back(char(count));
+}
+
+/**
+ *  Writes one sequence. If matchlength is 0, it is the last one, with only
+ *  literals.
+ */
+
+static void
+put_sequence
+(
+    std::vector<char> & out,
+    const char * literals,
+    std::size_t literalcount,
+    std::size_t offset,
+    std::size_t matchlength
+)
+{
+    std::size_t m = matchlength > 0 ? matchlength - c_min_match : 0 ;
+    unsigned token = unsigned(literalcount < 15 ? literalcount : 15) << 4;
+    token |= unsigned(m < 15 ? m : 15);
+    out.push_back(char(token));
+    if (literalcount >= 15)
+        put_count(out, literalcount - 15);
+
+    out.insert(out.end(), literals, literals + literalcount);
+    if (matchlength > 0)
+    {
+        out.push_back(char(offset & 0xFF));
+        out.push_back(char(offset >> 8));
+        if (m >= 15)
+            put_count(out, m - 15);
+    }
+}
+
+/**
+ *  Compresses text. Each position is looked up in a hash table of the
+ *  last position of the same four bytes, which finds most of the repeats
+ *  of natural-language text in one pass.
+ *
+ * \param text
+ *      The text to compress.
+ *
+ * \param [out] out
+ *      Receives the compressed bytes.
+ */
+
+void
+lz_compress (std::string_view text, std::vector<char> & out)
+{
+    out.clear();
+
+    const char * src = text.data();
+    std::size_t n = text.size();
+    std::vector<std::uint32_t> table(std::size_t(1) << c_hash_bits, 0);
+    std::size_t anchor = 0;
+    std::size_t i = 0;
+    while (i + c_min_match <= n)
+    {
+        std::uint32_t seq = read32(src + i);
+        std::uint32_t & slot = table[hash32(seq)];
+        std::size_t candidate = slot;               /* position + 1, or 0   */
+        slot = std::uint32_t(i + 1);
+        if
+        (
+            candidate > 0 && i - (candidate - 1) <= c_max_offset &&
+            read32(src + candidate - 1) == seq
+        )
+        {
+            std::size_t m = candidate - 1;
+            std::size_t length = c_min_match;
+            while (i + length < n && src[m + length] == src[i + length])
+                ++length;
+
+            put_sequence(out, src + anchor, i - anchor, i - m, length);
+            i += length;
+            anchor = i;
+        }
+        else
+            ++i;
+    }
+    if (anchor < n)
+        put_sequence(out, src + anchor, n - anchor, 0, 0);
+}
+
+/**
+ *  Reads a count continued in 255-bytes.
+ */
+
+static bool
+get_count (const char * & ip, const char * end, std::size_t & count)
+{
+    for (;;)
+    {
+        if (ip >= end)
+            return false;
+
+        unsigned char b = static_cast<unsigned char>(*ip++);
+        count += b;
+        if (b < 255)
+            return true;
+    }
+}
+
+/**
+ *  Decompresses what lz_compress() made. Malformed input is detected, not
+ *  trusted.
+ *
+ * \param data
+ *      The compressed bytes.
+ *
+ * \param size
+ *      Their count.
+ *
+ * \param [out] out
+ *      Receives the text.
+ *
+ * \param outsize
+ *      The size of the text, which the caller must know.
+ *
+ * \return
+ *      Returns true if the input decoded to exactly outsize bytes.
+ */
+
+bool
+lz_decompress
+(
+    const char * data,
+    std::size_t size,
+    char * out,
+    std::size_t outsize
+)
+{
+    const char * ip = data;
+    const char * end = data + size;
+    std::size_t op = 0;
+    while (ip < end)
+    {
+        unsigned token = static_cast<unsigned char>(*ip++);
+        std::size_t literalcount = token >> 4;
+        if (literalcount == 15 && ! get_count(ip, end, literalcount))
+            return false;
+
+        if (literalcount > std::size_t(end - ip) || literalcount > outsize - op)
+            return false;
+
+        std::memcpy(out + op, ip, literalcount);
+        ip += literalcount;
+        op += literalcount;
+        if (ip == end)
+            break;                                  /* the last sequence    */
+
+        if (end - ip < 2)
+            return false;
+
+        std::size_t offset = static_cast<unsigned char>(ip[0]) |
+            (std::size_t(static_cast<unsigned char>(ip[1])) << 8);
+
+        ip += 2;
+
+        std::size_t length = token & 0x0F;
+        if (length == 15 && ! get_count(ip, end, length))
+            return false;
+
+        length += c_min_match;
+        if (offset == 0 || offset > op || length > outsize - op)
+            return false;
+
+        const char * from = out + op - offset;
+        for (std::size_t k = 0; k < length; ++k)    /* it can overlap       */
+            out[op + k] = from[k];
+
+        op += length;
+    }
+    return op == outsize;
+}
+
+/**
+ *  A block decompressed by get(), and the store it came from.
+ */
+
+struct cachedblock
+{
+    std::uint64_t cb_serial;            /* 0 if unused                      */
+    std::uint32_t cb_block;
+    std::string cb_text;
+};
+
+static thread_local cachedblock t_blocks[c_cached_blocks];
+static thread_local std::size_t t_next_block = 0;
+
+/**
+ *  The ring of strings given out by get_held() and hold().
+ */
+
+static thread_local std::string t_held[coldstore::sm_held_strings];
+static thread_local std::size_t t_next_held = 0;
+
+static std::string &
+next_held ()
+{
+    std::string & result = t_held[t_next_held];
+    t_next_held = (t_next_held + 1) % coldstore::sm_held_strings;
+    return result;
+}
+
+static std::uint64_t
+next_serial ()
+{
+    static std::atomic<std::uint64_t> s_serial{0};
+    return ++s_serial;
+}
+
+coldstore::coldstore () :
+    m_blocks    (),
+    m_strings   (),
+    m_open      (),
+    m_serial    (next_serial())
+{
+    // no code
+}
+
+/**
+ *  Adds a string. It is compressed when its block is full, or when
+ *  seal() is called.
+ *
+ * \return
+ *      Returns the ID of the string, for get() and reference().
+ */
+
+std::uint32_t
+coldstore::add (std::string_view text)
+{
+    if (! m_open.empty() && m_open.size() + text.size() > sm_block_size)
+        seal();
+
+    location loc
+    {
+        std::uint32_t(m_blocks.size()),
+        std::uint32_t(m_open.size()),
+        std::uint32_t(text.size())
+    };
+    m_open.append(text.data(), text.size());
+    m_strings.push_back(loc);
+    return std::uint32_t(m_strings.size() - 1);
+}
+
+/**
+ *  Compresses the strings added since the last block, and frees the
+ *  uncompressed copy. Call it once all the strings are added.
+ */
+
+void
+coldstore::seal ()
+{
+    if (m_open.empty())
+        return;
+
+    block b;
+    lz_compress(m_open, b.b_data);
+    b.b_data.shrink_to_fit();
+    b.b_size = std::uint32_t(m_open.size());
+    m_blocks.push_back(std::move(b));
+    m_open.clear();
+    m_open.shrink_to_fit();
+}
+
+/**
+ *  Gets a string, decompressing its block into the cache of the calling
+ *  thread if it is not there. Several threads may call it at once.
+ *
+ * \param id
+ *      The ID returned by add().
+ *
+ * \param [out] text
+ *      Receives the string.
+ *
+ * \return
+ *      Returns false if the ID is bad or the block is corrupt.
+ */
+
+bool
+coldstore::get (std::uint32_t id, std::string & text) const
+{
+    if (id >= m_strings.size())
+        return false;
+
+    const location & loc = m_strings[id];
+    if (loc.l_block >= m_blocks.size())             /* not sealed yet       */
+    {
+        text.assign(m_open, loc.l_offset, loc.l_size);
+        return true;
+    }
+
+    cachedblock * cb = nullptr;
+    for (auto & c : t_blocks)
+    {
+        if (c.cb_serial == m_serial && c.cb_block == loc.l_block)
+        {
+            cb = &c;
+            break;
+        }
+    }
+    if (cb == nullptr)
+    {
+        const block & b = m_blocks[loc.l_block];
+        cb = &t_blocks[t_next_block];
+        t_next_block = (t_next_block + 1) % c_cached_blocks;
+        cb->cb_serial = 0;
+        cb->cb_text.resize(b.b_size);
+        bool ok = lz_decompress
+        (
+            b.b_data.data(), b.b_data.size(), &cb->cb_text[0], b.b_size
+        );
+        if (! ok)
+            return false;
+
+        cb->cb_serial = m_serial;
+        cb->cb_block = loc.l_block;
+    }
+    text.assign(cb->cb_text, loc.l_offset, loc.l_size);
+    return true;
+}
+
+/**
+ *  Gets a string into the next slot of the ring of the calling thread,
+ *  re-using the memory of the string it replaces.
+ *
+ * \param id
+ *      The ID returned by add().
+ *
+ * \return
+ *      Returns the string, or an empty string if the ID is bad or the
+ *      block is corrupt. The reference is valid until the calling thread
+ *      has taken sm_held_strings more strings from get_held() or hold().
+ */
+
+const std::string &
+coldstore::get_held (std::uint32_t id) const
+{
+    std::string & slot = next_held();
+    if (! get(id, slot))
+        slot.clear();
+
+    return slot;
+}
+
+std::size_t
+coldstore::raw_bytes () const
+{
+    std::size_t result = m_open.size();
+    for (const auto & b : m_blocks)
+        result += b.b_size;
+
+    return result;
+}
+
+std::size_t
+coldstore::compressed_bytes () const
+{
+    std::size_t result = m_open.size();
+    for (const auto & b : m_blocks)
+        result += b.b_data.size();
+
+    return result;
+}
+
+/**
+ *  The memory held by the store, not counting the thread caches.
+ */
+
+std::size_t
+coldstore::memory_usage () const
+{
+    std::size_t result = sizeof *this + m_open.capacity();
+    result += m_blocks.capacity() * sizeof(block);
+    result += m_strings.capacity() * sizeof(location);
+    for (const auto & b : m_blocks)
+        result += b.b_data.capacity();
+
+    return result;
+}
+
+/**
+ *  Makes the stand-in for a stored string: a NUL byte and the ID.
+ */
+
+std::string
+coldstore::reference (std::uint32_t id)
+{
+    std::string result(5, '\0');
+    for (int i = 1; i < 5; ++i, id >>= 8)
+        result[i] = char(id & 0xFF);
+
+    return result;
+}
+
+std::uint32_t
+coldstore::reference_id (const std::string & s)
+{
+    std::uint32_t result = 0;
+    for (int i = 4; i > 0; --i)
+        result = (result << 8) | static_cast<unsigned char>(s[i]);
+
+    return result;
+}
+
+/**
+ *  Puts a string, such as the conversion of a held string, into the next
+ *  slot of the ring of the calling thread. It is valid as long as one
+ *  from get_held().
+ */
+
+const std::string &
+coldstore::hold (std::string text)
+{
+    std::string & slot = next_held();
+    slot = std::move(text);
+    return slot;
+}
+
+/**
+ *  Tells if a string is in the ring of the calling thread, and so must
+ *  not be cached by its address, which will be re-used.
+ */
+
+bool
+coldstore::is_held (const std::string * s)
+{
+    std::less<const std::string *> before;
+    return ! before(s, &t_held[0]) &&
+        before(s, &t_held[0] + coldstore::sm_held_strings);
+}
+
+}               // namespace po
+
+/*
+ * coldstore.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -30,14 +30,22 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-13
+ * \updates       2026-10-18
  * \license       See above.
  *
  */
 
+#include <map>                          /* std::map<> template              */
+#include <memory>                       /* std::unique_ptr<> template       */
+#include <shared_mutex>                 /* std::shared_lock<>               */
+
 #include "po/po_types.hpp"              /* po::phraselist vector            */
+#include "po/coldstore.hpp"             /* po::coldstore class              */
 #include "po/dictionary.hpp"            /* po::dictionary class             */
+#include "po/iconvert.hpp"              /* po::iconvert class               */
 #include "po/logstream.hpp"             /* po::logstream::error(), etc.     */
+#include "po/probes.hpp"                /* POTEXT_PROBE2() etc.             */
+#include "po/searchindex.hpp"           /* po::searchindex class            */
 
 #if defined PLATFORM_DEBUG_TMI
 #include <iostream>                     /* std::cout                        */
@@ -100,35 +108,771 @@ namespace po
 {
 
 /**
- *  Creates an empty dictionary.
- *
- * \param charset
- *      Provides the default character encoding ("codeset") to use.
- *      The default is "UTF-8".
+ *  Creates an empty dictionary.
+ *
+ * \param charset
+ *      Provides the default character encoding ("codeset") to use.
+ *      The default is "UTF-8".
+ */
+
+dictionary::dictionary (const std::string & charset) :
+    m_entries           (),
+    m_ctxt_entries      (),
+    m_flat              (),
+    m_search_index      (),
+    m_cold              (),
+    m_charset           (charset),
+    m_view_mutex        (),
+    m_views             (),
+    m_plural_forms      (),
+    m_file_mode         (mode::none),
+    m_has_fallback      (false),
+    m_has_fuzzy         (false),
+    m_merging           (false),
+    m_shadowed_count    (0),
+    m_fallback          ()
+{
+    // no other code
+}
+
+/**
+ *  Clears the normal message entries and the contextual message entries.
+ */
+
+void
+dictionary::clear ()
+{
+    m_file_mode = mode::none;
+    m_has_fuzzy = false;
+    m_shadowed_count = 0;
+    m_entries.clear();
+    m_ctxt_entries.clear();
+    m_flat.reset();
+    m_search_index.reset();
+    m_cold.reset();
+    clear_views();
+}
+
+/**
+ *  Gets the search index of the messages (see searchindex.hpp), building
+ *  it if the dictionary changed since it was last built. The searches
+ *  ignore the case of ASCII letters. The index returned stays valid even
+ *  if the dictionary is changed later, but it does not see the changes.
+ */
+
+std::shared_ptr<const searchindex>
+dictionary::search_index () const
+{
+    {
+        std::lock_guard<std::shared_mutex> lock(m_view_mutex);
+        if (m_search_index)
+            return m_search_index;
+    }
+
+    auto index = std::make_shared<searchindex>();
+    (void) index->build(*this);
+
+    std::lock_guard<std::shared_mutex> lock(m_view_mutex);
+    if (! m_search_index)
+        m_search_index = index;
+
+    return m_search_index;
+}
+
+/**
+ *  The heap bytes of a string, beyond the string object itself. A short
+ *  string is held in the object (the small-string optimization).
+ */
+
+static std::size_t
+string_usage (const std::string & s)
+{
+    static const std::size_t s_inline = std::string().capacity();
+    return s.capacity() > s_inline ? s.capacity() + 1 : 0 ;
+}
+
+/**
+ *  The bytes of a node of a std::map or std::unordered_map, beyond its
+ *  value: the links, the color or hash, and the allocator's header.
+ */
+
+static const std::size_t c_node_overhead = 4 * sizeof(void *);
+
+/**
+ *  Estimates the memory held by the dictionary: its messages, and the
+ *  translations converted or copied out of a compiled image so far. An
+ *  image counts in full, even if it is mapped and shared with other
+ *  processes. The search index, if built, is not counted. The estimate
+ *  walks every message, so it is meant to be taken once, after loading,
+ *  as dictionarymgr does for its memory budget.
+ *
+ * \return
+ *      Returns the estimated size in bytes.
+ */
+
+std::size_t
+dictionary::memory_usage () const
+{
+    auto entries_usage = [] (const entries & ents)
+    {
+        std::size_t bytes = 0;
+        for (const auto & e : ents)
+        {
+            bytes += c_node_overhead + sizeof e;
+            bytes += string_usage(e.first);
+            bytes += string_usage(e.second.msgid_plural);
+            bytes += e.second.phrase_list.capacity() * sizeof(std::string);
+            for (const auto & phrase : e.second.phrase_list)
+                bytes += string_usage(phrase);
+        }
+        return bytes;
+    };
+
+    std::size_t result = sizeof *this + entries_usage(m_entries);
+    for (const auto & c : m_ctxt_entries)
+    {
+        result += c_node_overhead + sizeof c + string_usage(c.first);
+        result += entries_usage(c.second);
+    }
+    if (m_flat)
+        result += m_flat->size();
+
+    if (m_cold)
+        result += m_cold->memory_usage();
+
+    std::lock_guard<std::shared_mutex> lock(m_view_mutex);
+    for (const auto & v : m_views)
+    {
+        result += c_node_overhead + sizeof v + string_usage(v.first);
+        for (const auto & s : v.second)
+            result += c_node_overhead + sizeof s + string_usage(s.second);
+    }
+    return result;
+}
+
+/**
+ *  Serves the messages from a compiled image instead of the maps. The
+ *  messages already added are dropped. The translations are looked up in
+ *  the image as they are used. Only find() and the like copy them out of
+ *  it (see flat_string()), once each.
+ *
+ * \param flat
+ *      The image, which is shared with the caller.
+ *
+ * \return
+ *      Returns false if the image is null or invalid, in which case the
+ *      dictionary is left empty.
+ */
+
+bool
+dictionary::attach (std::shared_ptr<const flatcatalog> flat)
+{
+    clear();
+
+    bool result = flat && flat->valid();
+    if (result)
+    {
+        m_flat = flat;
+        m_file_mode = mode::flat;
+        m_has_fuzzy = flat->has_fuzzy();
+        m_plural_forms = pluralforms::from_string(flat->plural_forms());
+    }
+    return result;
+}
+
+/**
+ *  Drops the converted translations. This must be done whenever a stored
+ *  translation is replaced, because the views are keyed by its address.
+ */
+
+void
+dictionary::clear_views ()
+{
+    std::lock_guard<std::shared_mutex> lock(m_view_mutex);
+    m_views.clear();
+}
+
+/**
+ *  Indicates if a codeset name is UTF-8, the storage encoding.
+ */
+
+static bool
+is_storage_charset (const std::string & codeset)
+{
+    std::string cs;
+    for (auto ch : codeset)
+    {
+        if (ch != '-' && ch != '_')
+            cs += static_cast<char>(std::toupper(ch));
+    }
+    return cs.empty() || cs == "UTF8";
+}
+
+/**
+ *  Provides the converter from UTF-8 to the given codeset for the calling
+ *  thread. An iconv descriptor has state and cannot be shared between
+ *  threads, and opening one for each lookup would be slow, so each thread
+ *  keeps its own, opened on first use.
+ *
+ * \return
+ *      Returns null if the conversion is not available.
+ */
+
+static const iconvert *
+thread_converter (const std::string & codeset)
+{
+    thread_local std::map<std::string, std::unique_ptr<iconvert>> s_converters;
+    auto it = s_converters.find(codeset);
+    if (it == s_converters.end())
+    {
+        std::unique_ptr<iconvert> cvt(new iconvert());
+        if (! cvt->set_charsets(dictionary::storage_charset(), codeset))
+            cvt.reset();
+
+        it = s_converters.emplace(codeset, std::move(cvt)).first;
+    }
+    return it->second.get();
+}
+
+/**
+ *  Changes the default output codeset. The stored translations are not
+ *  touched; translations in the new codeset are converted as they are
+ *  looked up (see view()), and the views already made for other codesets
+ *  are kept, so switching back and forth costs nothing.
+ *
+ * \return
+ *      Returns false if the conversion to the codeset is not available,
+ *      in which case the codeset is unchanged.
+ */
+
+bool
+dictionary::set_charset (const std::string & charset)
+{
+    bool result = is_storage_charset(charset) ||
+        not_nullptr(thread_converter(charset));
+
+    if (result)
+        m_charset = charset;
+
+    return result;
+}
+
+/**
+ *  Gets a stored translation in the given codeset. The first lookup of a
+ *  translation in a codeset converts it and keeps the result; later
+ *  lookups find it in the view cache.
+ *
+ * \param msgstr
+ *      A translation stored in this dictionary (or in its fallback), which
+ *      is always in UTF-8. It must not be a temporary; its address is the
+ *      key of the cache.
+ *
+ * \param codeset
+ *      The output codeset. If empty, the dictionary's charset is used.
+ *
+ * \return
+ *      Returns the converted translation, or \a msgstr itself if no
+ *      conversion is needed or possible. The reference is valid until the
+ *      dictionary is modified. If \a msgstr is held by the cold store (see
+ *      stored_string()), so is the conversion, which is not cached.
+ */
+
+const std::string &
+dictionary::view
+(
+    const std::string & msgstr,
+    const std::string & codeset
+) const
+{
+    const std::string & cs = codeset.empty() ? m_charset : codeset ;
+    if (msgstr.empty() || is_storage_charset(cs))
+        return msgstr;
+
+    if (coldstore::is_held(&msgstr))                /* address is re-used   */
+        return coldstore::hold(converted(msgstr, cs));
+
+    const std::string * result = cached_view(&msgstr, msgstr, cs);
+    return not_nullptr(result) ? *result : msgstr ;
+}
+
+/**
+ *  Gets the conversion of a stored translation from the view cache,
+ *  converting it and keeping the result on its first lookup.
+ *
+ * \param key
+ *      The address of the translation, which must last until the views
+ *      are cleared (see clear_views()).
+ *
+ * \param msgstr
+ *      The UTF-8 translation.
+ *
+ * \param codeset
+ *      The output codeset, which is not UTF-8.
+ *
+ * 
+eturn
+ *      Returns the conversion, or null if there is no converter to the
+ *      codeset.
+ */
+
+const std::string *
+dictionary::cached_view
+(
+    const void * key,
+    std::string_view msgstr,
+    const std::string & codeset
+) const
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_view_mutex);
+        auto vit = m_views.find(codeset);
+        if (vit != m_views.end())
+        {
+            auto it = vit->second.find(key);
+            if (it != vit->second.end())
+                return &it->second;
+        }
+    }
+
+    const iconvert * cvt = thread_converter(codeset);
+    if (is_nullptr(cvt))
+        return nullptr;
+
+    std::string converted = cvt->convert(std::string(msgstr));
+    std::lock_guard<std::shared_mutex> lock(m_view_mutex);
+    return &m_views[codeset].emplace(key, converted).first->second;
+}
+
+/**
+ *  Gets a translation found by find_view() in a codeset, as a copy. A
+ *  UTF-8 translation is copied as it is, without a lock. One held in the
+ *  compiled image is converted once and the conversion kept, as view()
+ *  does; any other is converted each time, as its address may not last.
+ *
+ * \param msgstr
+ *      The UTF-8 translation.
+ *
+ * \param codeset
+ *      The output codeset. If empty, the dictionary's charset is used.
+ *
+ * 
+eturn
+ *      Returns the translation in the codeset.
+ */
+
+std::string
+dictionary::converted_view
+(
+    std::string_view msgstr,
+    const std::string & codeset
+) const
+{
+    const std::string & cs = codeset.empty() ? m_charset : codeset ;
+    if (msgstr.empty() || is_storage_charset(cs))
+        return std::string(msgstr);
+
+    if (m_flat && m_flat->holds(msgstr.data()))
+    {
+        const std::string * result = cached_view(msgstr.data(), msgstr, cs);
+        return not_nullptr(result) ? *result : std::string(msgstr) ;
+    }
+    return converted(std::string(msgstr), cs);
+}
+
+/**
+ *  Moves the translations longer than a threshold into a compressed store
+ *  (see coldstore.hpp), leaving a short reference in their place. Help
+ *  texts and the like, which hold most of the bytes of a catalog but are
+ *  seldom looked up, are thus kept compressed, while short labels are
+ *  looked up as fast as before. A lookup of a compressed translation
+ *  decompresses its block into a small cache of the calling thread.
+ *
+ *  This is meant to be done once, after the catalog is loaded; strings
+ *  added later are kept as they are. A dictionary serving a compiled
+ *  image is not changed.
+ *
+ * \param threshold
+ *      The length, in bytes, above which a translation is compressed.
+ *
+ * \return
+ *      Returns the number of translations compressed.
+ */
+
+std::size_t
+dictionary::compress_strings (std::size_t threshold)
+{
+    if (m_flat)
+        return 0;
+
+    auto cold = std::make_shared<coldstore>();
+    auto compress = [threshold, &cold] (entries & ents)
+    {
+        for (auto & e : ents)
+        {
+            for (auto & phrase : e.second.phrase_list)
+            {
+                if (phrase.size() > threshold)
+                {
+                    std::uint32_t id = cold->add(phrase);
+                    phrase = coldstore::reference(id);
+                    phrase.shrink_to_fit();
+                }
+            }
+        }
+    };
+    if (m_cold)
+    {
+        /*
+         * Compressing twice would lose the first store; expand first.
+         */
+
+        phraselist scratch;
+        auto restore = [this, &scratch] (entries & ents)
+        {
+            for (auto & e : ents)
+                e.second.phrase_list = expand(e.second.phrase_list, scratch);
+        };
+        restore(m_entries);
+        for (auto & c : m_ctxt_entries)
+            restore(c.second);
+    }
+    compress(m_entries);
+    for (auto & c : m_ctxt_entries)
+        compress(c.second);
+
+    cold->seal();
+    clear_views();
+    m_search_index.reset();
+
+    std::size_t result = cold->count();
+    if (result > 0)
+        m_cold = cold;
+    else
+        m_cold.reset();
+
+    return result;
+}
+
+/**
+ *  Provides a stored translation in a codeset, decompressing it first if
+ *  it is a reference to the cold store. A decompressed translation is
+ *  converted each time, not kept in the views, which would undo the
+ *  compression.
+ */
+
+std::string
+dictionary::stored_view
+(
+    const std::string & msgstr,
+    const std::string & codeset
+) const
+{
+    if (! m_cold || ! coldstore::is_reference(msgstr))
+        return view(msgstr, codeset);
+
+    std::string text;
+    if (! m_cold->get(coldstore::reference_id(msgstr), text))
+        return std::string();
+
+    return converted(text, codeset.empty() ? m_charset : codeset);
+}
+
+/**
+ *  Converts UTF-8 text to a codeset with the converter of the calling
+ *  thread. Unlike view(), the result is not kept, so it suits text that
+ *  the dictionary does not own, or that is seldom looked up.
+ *
+ * \return
+ *      Returns the text as is if the codeset is UTF-8 or cannot be
+ *      converted to.
+ */
+
+std::string
+dictionary::converted (const std::string & text, const std::string & codeset)
+{
+    if (text.empty() || is_storage_charset(codeset))
+        return text;
+
+    const iconvert * cvt = thread_converter(codeset);
+    return is_nullptr(cvt) ? text : cvt->convert(text) ;
+}
+
+/**
+ *  Provides a stored translation as a string, for find() and find_ctxt().
+ *  A compressed one is decompressed into the ring of the calling thread
+ *  (see coldstore::get_held()) on each use, rather than kept for the life
+ *  of the dictionary, which would undo the compression of every string
+ *  ever looked up.
+ *
+ * \return
+ *      Returns \a msgstr itself, valid until the dictionary is modified, or
+ *      the decompressed string, valid until the calling thread has taken
+ *      coldstore::sm_held_strings more compressed strings.
+ */
+
+const std::string &
+dictionary::stored_string (const std::string & msgstr) const
+{
+    if (! m_cold || ! coldstore::is_reference(msgstr))
+        return msgstr;
+
+    return m_cold->get_held(coldstore::reference_id(msgstr));
+}
+
+/**
+ *  Provides the translations of an entry with any compressed ones
+ *  decompressed, for foreach() and the like.
+ *
+ * \param msgstrs
+ *      The stored translations.
+ *
+ * \param scratch
+ *      Holds the decompressed list, if one is needed.
+ *
+ * \return
+ *      Returns msgstrs itself if none is compressed, else scratch.
+ */
+
+const phraselist &
+dictionary::expand (const phraselist & msgstrs, phraselist & scratch) const
+{
+    if (! m_cold)
+        return msgstrs;
+
+    bool cold = false;
+    for (const auto & s : msgstrs)
+    {
+        if (coldstore::is_reference(s))
+        {
+            cold = true;
+            break;
+        }
+    }
+    if (! cold)
+        return msgstrs;
+
+    scratch = msgstrs;
+    for (auto & s : scratch)
+    {
+        if (coldstore::is_reference(s))
+        {
+            std::string text;
+            (void) m_cold->get(coldstore::reference_id(s), text);
+            s = std::move(text);
+        }
+    }
+    return scratch;
+}
+
+/**
+ *  Provides a translation held in the flatcatalog as a string that lives
+ *  as long as the image, for find(), find_ctxt(), and translate_plurals(),
+ *  which return std::string pointers. Only the translations looked up by
+ *  these are copied; translate() and find_view() copy nothing into the
+ *  dictionary.
+ */
+
+const std::string &
+dictionary::flat_string (std::string_view text) const
+{
+    static const std::string s_empty;
+    if (text.empty())                   /* its address is not unique        */
+        return s_empty;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(m_view_mutex);
+        auto vit = m_views.find(std::string());
+        if (vit != m_views.end())
+        {
+            auto it = vit->second.find(text.data());
+            if (it != vit->second.end())
+                return it->second;
+        }
+    }
+
+    std::lock_guard<std::shared_mutex> lock(m_view_mutex);
+    viewcache & cache = m_views[std::string()];
+    return cache.emplace(text.data(), std::string(text)).first->second;
+}
+
+/**
+ *  Copies out an entry of the flatcatalog, for foreach() and
+ *  foreach_ctxt().
+ *
+ * \param msgctxt
+ *      If null, only an entry without a context is wanted. Otherwise only
+ *      an entry with a context is wanted, and this gets the context.
+ *
+ * \return
+ *      Returns true if the entry is of the kind wanted.
+ */
+
+bool
+dictionary::flat_entry
+(
+    std::size_t index,
+    std::string * msgctxt,
+    std::string & msgid,
+    std::string & msgid_plural,
+    phraselist & msgstrs
+) const
+{
+    std::string_view key = m_flat->key(index);
+    std::size_t eot = key.find('\004');
+    if ((eot == std::string_view::npos) != is_nullptr(msgctxt))
+        return false;
+
+    if (not_nullptr(msgctxt))
+    {
+        msgctxt->assign(key.substr(0, eot));
+        key.remove_prefix(eot + 1);
+    }
+    msgid.assign(key);
+    msgid_plural.assign(m_flat->msgid_plural(index));
+    msgstrs.clear();
+    for (std::size_t n = 0; n < m_flat->msgstr_count(index); ++n)
+        msgstrs.emplace_back(m_flat->msgstr(index, n));
+
+    return true;
+}
+
+/**
+ *  Provides the context given to the lookup probes (see probes.hpp), which
+ *  is empty for a message without one.
+ */
+
+static inline const char *
+probe_context (const std::string * msgctxt)
+{
+    return not_nullptr(msgctxt) ? msgctxt->c_str() : "" ;
+}
+
+/**
+ *  The flatcatalog version of translate() and translate_ctxt().
+ *
+ * \param msgctxt
+ *      The context, or null if the message has none.
+ */
+
+std::string
+dictionary::translate_flat
+(
+    const std::string * msgctxt,
+    const std::string & msgid,
+    const std::string & codeset
+) const
+{
+    std::size_t index = not_nullptr(msgctxt) ?
+        m_flat->lookup(*msgctxt, msgid) : m_flat->lookup(msgid) ;
+
+    if (m_flat->msgstr_count(index) > 0)
+    {
+        POTEXT_PROBE2(lookup__hit, probe_context(msgctxt), msgid.c_str());
+        return converted_view(m_flat->msgstr(index, 0), codeset);
+    }
+    if (not_nullptr(msgctxt))
+    {
+        POTEXT_PROBE2(lookup__miss, probe_context(msgctxt), msgid.c_str());
+        logstream::warning()
+            << _("Could not translate in context") <<
+            " '" << *msgctxt << "': '" << msgid
+            << "'" << std::endl
+            ;
+        return msgid;
+    }
+    if (m_has_fallback)
+    {
+        POTEXT_PROBE2(lookup__fallback, probe_context(msgctxt), msgid.c_str());
+        return m_fallback->translate(msgid, codeset);
+    }
+    POTEXT_PROBE2(lookup__miss, probe_context(msgctxt), msgid.c_str());
+    logstream::warning()
+        << _("Could not translate") << ": '" << msgid << "'"
+        << std::endl
+        ;
+    return msgid;
+}
+
+/**
+ *  The flatcatalog version of translate_plural() and
+ *  translate_ctxt_plural().
  */
 
-dictionary::dictionary (const std::string & charset) :
-    m_entries           (),
-    m_ctxt_entries      (),
-    m_charset           (charset),
-    m_plural_forms      (),
-    m_file_mode         (mode::none),
-    m_has_fallback      (false),
-    m_fallback          ()
+std::string
+dictionary::translate_flat_plural
+(
+    const std::string * msgctxt,
+    const std::string & msgid,
+    const std::string & msgid_plural,
+    int N,
+    const std::string & codeset
+) const
 {
-    // no other code
+    std::size_t index = not_nullptr(msgctxt) ?
+        m_flat->lookup(*msgctxt, msgid) : m_flat->lookup(msgid) ;
+
+    if (index != flatcatalog::npos)
+    {
+        unsigned n = m_plural_forms.get_plural(N);
+        unsigned sz = unsigned(m_flat->msgstr_count(index));
+        POTEXT_PROBE2(lookup__hit, probe_context(msgctxt), msgid.c_str());
+        if (n >= sz)
+        {
+            logstream::error()
+                << _("Plural index") << " " << n << " "
+                << _("exceeds translation count")
+                << " " << sz << ": '"
+                << msgid << ", #" << n << std::endl
+                ;
+            return msgid;
+        }
+
+        std::string_view msgstr = m_flat->msgstr(index, n);
+        if (! msgstr.empty())
+            return converted_view(msgstr, codeset);
+    }
+    else
+    {
+        POTEXT_PROBE2(lookup__miss, probe_context(msgctxt), msgid.c_str());
+        logstream::warning()
+            << _("Could not translate plural for") << ": '" << msgid << "'"
+            << std::endl
+            ;
+    }
+    if (N == 1)                         /* default to english rules         */
+        return msgid;
+    else
+        return msgid_plural;
 }
 
 /**
- *  Clears the normal message entries and the contextual message entries.
+ *  The flatcatalog version of find() and find_ctxt().
  */
 
-void
-dictionary::clear ()
+const std::string *
+dictionary::find_flat
+(
+    const std::string * msgctxt,
+    const std::string & msgid
+) const
 {
-    m_file_mode = mode::none;
-    m_entries.clear();
-    m_ctxt_entries.clear();
+    std::size_t index = not_nullptr(msgctxt) ?
+        m_flat->lookup(*msgctxt, msgid) : m_flat->lookup(msgid) ;
+
+    std::string_view msgstr = m_flat->msgstr(index, 0);
+    if (! msgstr.empty())
+    {
+        POTEXT_PROBE2(lookup__hit, probe_context(msgctxt), msgid.c_str());
+        return &flat_string(msgstr);
+    }
+    if (! m_has_fallback)
+    {
+        POTEXT_PROBE2(lookup__miss, probe_context(msgctxt), msgid.c_str());
+        return nullptr;
+    }
+    POTEXT_PROBE2(lookup__fallback, probe_context(msgctxt), msgid.c_str());
+    return not_nullptr(msgctxt) ?
+        m_fallback->find_ctxt(*msgctxt, msgid) : m_fallback->find(msgid) ;
 }
 
 /**
@@ -136,34 +880,55 @@ dictionary::clear ()
  */
 
 std::string
-dictionary::translate (const std::string & msgid) const
+dictionary::translate
+(
+    const std::string & msgid,
+    const std::string & codeset
+) const
 {
-    return translate(m_entries, msgid);
+    if (m_flat)
+        return translate_flat(nullptr, msgid, codeset);
+
+    return translate(m_entries, nullptr, msgid, codeset);
 }
 
 /**
  *  Translate an entry in this dictionary without regard to context or plural
  *  forms.
+ *
+ * \param msgctxt
+ *      The context whose entries are given, or null. It is used only by
+ *      the lookup probes.
  */
 
 std::string
-dictionary::translate (const entries & ents, const std::string & msgid) const
+dictionary::translate
+(
+    const entries & ents,
+    const std::string * msgctxt,
+    const std::string & msgid,
+    const std::string & codeset
+) const
 {
     entries::const_iterator it = ents.find(msgid);
     if (it != ents.end() && ! it->second.phrase_list.empty())
     {
-        return it->second.phrase_list[0];
+        POTEXT_PROBE2(lookup__hit, probe_context(msgctxt), msgid.c_str());
+        return stored_view(it->second.phrase_list[0], codeset);
+    }
+    else if (m_has_fallback)
+    {
+        POTEXT_PROBE2(lookup__fallback, probe_context(msgctxt), msgid.c_str());
+        return m_fallback->translate(msgid, codeset);   /* it logs a miss   */
     }
     else
     {
+        POTEXT_PROBE2(lookup__miss, probe_context(msgctxt), msgid.c_str());
         logstream::warning()
             << _("Could not translate") << ": '" << msgid << "'"
             << std::endl
             ;
-        if (m_has_fallback)
-            return m_fallback->translate(msgid);
-        else
-            return msgid;
+        return msgid;
     }
 }
 
@@ -188,10 +953,17 @@ dictionary::translate_plural
 (
     const std::string & msgid,
     const std::string & msgid_plural,
-    int N
+    int N,
+    const std::string & codeset
 ) const
 {
-    return translate_plural(m_entries, msgid, msgid_plural, N);
+    if (m_flat)
+        return translate_flat_plural(nullptr, msgid, msgid_plural, N, codeset);
+
+    return translate_plural
+    (
+        m_entries, nullptr, msgid, msgid_plural, N, codeset
+    );
 }
 
 /**
@@ -208,6 +980,10 @@ dictionary::translate_plural
  *      The list of phraselists to use to do the lookup. See the
  *      translate_plural() overload above.
  *
+ * \param msgctxt
+ *      The context whose entries are given, or null. It is used only by
+ *      the lookup probes.
+ *
  * \param msgid
  *      Provides the singular form of the message ID.
  *
@@ -224,14 +1000,17 @@ std::string
 dictionary::translate_plural
 (
     const entries & dict,
+    const std::string * msgctxt,
     const std::string & msgid,
     const std::string & msgid_plural,
-    int N
+    int N,
+    const std::string & codeset
 ) const
 {
     entries::const_iterator it = dict.find(msgid);
     if (it != dict.end())
     {
+        POTEXT_PROBE2(lookup__hit, probe_context(msgctxt), msgid.c_str());
         unsigned n = m_plural_forms.get_plural(N);
         const phraselist & msgstrs = it->second.phrase_list;
         unsigned sz = unsigned(msgstrs.size());
@@ -246,7 +1025,7 @@ dictionary::translate_plural
             return msgid;
         }
         if (! msgstrs[n].empty())
-            return msgstrs[n];
+            return stored_view(msgstrs[n], codeset);
         else if (N == 1)                /* default to english rules         */
             return msgid;
         else
@@ -254,13 +1033,11 @@ dictionary::translate_plural
     }
     else
     {
+        POTEXT_PROBE2(lookup__miss, probe_context(msgctxt), msgid.c_str());
         logstream::warning()
-            << _("Could not translate plural for") << ": '" << msgid << "'\n"
-            << _("Candidates") << ":\n"
+            << _("Could not translate plural for") << ": '" << msgid << "'"
+            << std::endl
             ;
-        for (const auto & it : dict)
-            logstream::info() << "'" << it.first << "'" << std::endl;
-
         if (N == 1)                     /* default to english rules         */
             return msgid;
         else
@@ -275,24 +1052,29 @@ dictionary::translate_plural
  *  something or it might refer to a door that leads outside (i.e.
  *  'Ausgang' vs 'Beenden' in German).
  *
- *  In translate(it->second, msgid), the iterator points to a ctxtentry,
- *  and second is an entries map.
+ *  In translate(it->second, &msgctxt, ...), the iterator points to a
+ *  ctxtentry, and second is an entries map.
  */
 
 std::string
 dictionary::translate_ctxt
 (
     const std::string & msgctxt,
-    const std::string & msgid
+    const std::string & msgid,
+    const std::string & codeset
 ) const
 {
+    if (m_flat)
+        return translate_flat(&msgctxt, msgid, codeset);
+
     auto it = m_ctxt_entries.find(msgctxt);
     if (it != m_ctxt_entries.end())
     {
-        return translate(it->second, msgid);
+        return translate(it->second, &msgctxt, msgid, codeset);
     }
     else
     {
+        POTEXT_PROBE2(lookup__miss, msgctxt.c_str(), msgid.c_str());
         logstream::warning()
             << _("Could not translate in context") <<
             " '" << msgctxt << "': '" << msgid
@@ -308,16 +1090,29 @@ dictionary::translate_ctxt_plural
     const std::string & msgctxt,
     const std::string & msgid,
     const std::string & msgidplural,
-    int num
+    int num,
+    const std::string & codeset
 ) const
 {
+    if (m_flat)
+    {
+        return translate_flat_plural
+        (
+            &msgctxt, msgid, msgidplural, num, codeset
+        );
+    }
+
     auto it = m_ctxt_entries.find(msgctxt);
     if (it != m_ctxt_entries.end())
     {
-        return translate_plural(it->second, msgid, msgidplural, num);
+        return translate_plural
+        (
+            it->second, &msgctxt, msgid, msgidplural, num, codeset
+        );
     }
     else
     {
+        POTEXT_PROBE2(lookup__miss, msgctxt.c_str(), msgid.c_str());
         logstream::warning()
             << _("Could not translate in context") << " '"
             << msgctxt << "': '" << msgid
@@ -331,6 +1126,381 @@ dictionary::translate_ctxt_plural
     }
 }
 
+/**
+ *  Translates a message to its plural form for each of an array of counts,
+ *  e.g. for the "N files" column of a report. The message is looked up
+ *  once, its forms are converted once, and the plural forms of the counts
+ *  are picked in batches (see pluralforms::get_plurals()), so the cost per
+ *  count is a few array lookups rather than a lookup and a call each.
+ *
+ * \param msgid
+ *      Provides the singular form of the message ID.
+ *
+ * \param msgidplural
+ *      Provides the plural form of the message ID.
+ *
+ * \param counts
+ *      The counts.
+ *
+ * \param count
+ *      The number of counts.
+ *
+ * \param [out] results
+ *      Receives, for each count, a pointer to what translate_plural()
+ *      would return for it. The strings are valid until the dictionary is
+ *      modified; the untranslated ones are msgid and msgidplural
+ *      themselves. A compressed one (see compress_strings()) is valid
+ *      only until the calling thread looks up another compressed string.
+ *
+ * \param codeset
+ *      The codeset of the results; the default is that of the dictionary.
+ *
+ * \return
+ *      Returns true if the message was found.
+ */
+
+bool
+dictionary::translate_plurals
+(
+    const std::string & msgid,
+    const std::string & msgidplural,
+    const int * counts,
+    std::size_t count,
+    const std::string ** results,
+    const std::string & codeset
+) const
+{
+    return translate_plurals
+    (
+        nullptr, msgid, msgidplural, counts, count, results, codeset
+    );
+}
+
+bool
+dictionary::translate_ctxt_plurals
+(
+    const std::string & msgctxt,
+    const std::string & msgid,
+    const std::string & msgidplural,
+    const int * counts,
+    std::size_t count,
+    const std::string ** results,
+    const std::string & codeset
+) const
+{
+    return translate_plurals
+    (
+        &msgctxt, msgid, msgidplural, counts, count, results, codeset
+    );
+}
+
+/**
+ *  The common part of translate_plurals() and translate_ctxt_plurals().
+ *
+ * \param msgctxt
+ *      The context, or null if the message has none.
+ */
+
+bool
+dictionary::translate_plurals
+(
+    const std::string * msgctxt,
+    const std::string & msgid,
+    const std::string & msgidplural,
+    const int * counts,
+    std::size_t count,
+    const std::string ** results,
+    const std::string & codeset
+) const
+{
+    const std::size_t maxforms = 10;    /* Arabic has the most, 6        */
+    const std::string * forms[maxforms];
+    std::size_t formcount = 0;
+    bool found = false;
+    if (m_flat)
+    {
+        std::size_t index = not_nullptr(msgctxt) ?
+            m_flat->lookup(*msgctxt, msgid) : m_flat->lookup(msgid) ;
+
+        if (index != flatcatalog::npos)
+        {
+            found = true;
+            formcount = m_flat->msgstr_count(index);
+            if (formcount > maxforms)
+                formcount = maxforms;
+
+            /*
+             * A UTF-8 form must be copied out of the image, to be pointed
+             * to; another is converted straight from the image.
+             */
+
+            const std::string & cs = codeset.empty() ? m_charset : codeset ;
+            for (std::size_t n = 0; n < formcount; ++n)
+            {
+                std::string_view msgstr = m_flat->msgstr(index, n);
+                const std::string * form = nullptr;
+                if (! msgstr.empty())
+                {
+                    if (! is_storage_charset(cs))
+                        form = cached_view(msgstr.data(), msgstr, cs);
+
+                    if (is_nullptr(form))
+                        form = &flat_string(msgstr);
+                }
+                forms[n] = form;
+            }
+        }
+    }
+    else
+    {
+        const entries * dict = &m_entries;
+        if (not_nullptr(msgctxt))
+        {
+            auto cit = m_ctxt_entries.find(*msgctxt);
+            dict = cit != m_ctxt_entries.end() ? &cit->second : nullptr ;
+        }
+        if (not_nullptr(dict))
+        {
+            entries::const_iterator it = dict->find(msgid);
+            if (it != dict->end())
+            {
+                const phraselist & msgstrs = it->second.phrase_list;
+                found = true;
+                formcount = msgstrs.size();
+                if (formcount > maxforms)
+                    formcount = maxforms;
+
+                for (std::size_t n = 0; n < formcount; ++n)
+                {
+                    forms[n] = msgstrs[n].empty() ?
+                        nullptr : &view(stored_string(msgstrs[n]), codeset) ;
+                }
+            }
+        }
+    }
+    if (found)
+    {
+        POTEXT_PROBE2(lookup__hit, probe_context(msgctxt), msgid.c_str());
+    }
+    else
+    {
+        POTEXT_PROBE2(lookup__miss, probe_context(msgctxt), msgid.c_str());
+        logstream::warning()
+            << _("Could not translate plural for") << ": '" << msgid << "'"
+            << std::endl
+            ;
+    }
+
+    const std::size_t blocksize = 64;
+    unsigned indices[blocksize];
+    bool exceeded = false;
+    for (std::size_t first = 0; first < count; first += blocksize)
+    {
+        std::size_t size = count - first;
+        if (size > blocksize)
+            size = blocksize;
+
+        m_plural_forms.get_plurals(counts + first, size, indices);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            unsigned n = indices[i];
+            const std::string * s = n < formcount ? forms[n] : nullptr ;
+            if (is_nullptr(s))
+            {
+                if (found && n >= formcount)
+                {
+                    exceeded = true;
+                    s = &msgid;
+                }
+                else                    /* default to english rules         */
+                    s = counts[first + i] == 1 ? &msgid : &msgidplural ;
+            }
+            results[first + i] = s;
+        }
+    }
+    if (exceeded)
+    {
+        logstream::error()
+            << _("Plural index exceeds translation count")
+            << " " << formcount << ": '" << msgid << "'" << std::endl
+            ;
+    }
+    return found;
+}
+
+/**
+ *  Looks up the singular translation of a message, without logging
+ *  anything and without copying the string. The fallback dictionary,
+ *  if any, is consulted as well.
+ *
+ * \return
+ *      Returns a pointer to the stored translation, or null if there is
+ *      none. The pointer is valid until the dictionary is modified, except
+ *      that of a compressed translation (see compress_strings()), which is
+ *      valid until the calling thread has looked up
+ *      coldstore::sm_held_strings more compressed ones. Copy it if it
+ *      must be kept.
+ */
+
+const std::string *
+dictionary::find (const std::string & msgid) const
+{
+    if (m_flat)
+        return find_flat(nullptr, msgid);
+
+    auto it = m_entries.find(msgid);
+    if (it != m_entries.end() && ! it->second.phrase_list.empty())
+    {
+        const std::string & msgstr = it->second.phrase_list[0];
+        if (! msgstr.empty())
+        {
+            POTEXT_PROBE2(lookup__hit, "", msgid.c_str());
+            return &stored_string(msgstr);
+        }
+    }
+    if (! m_has_fallback)
+    {
+        POTEXT_PROBE2(lookup__miss, "", msgid.c_str());
+        return nullptr;
+    }
+    POTEXT_PROBE2(lookup__fallback, "", msgid.c_str());
+    return m_fallback->find(msgid);
+}
+
+/**
+ *  While catalogs are merged (see merging()), tells a parser that a
+ *  message came from a catalog of higher precedence, so that it can skip
+ *  the message before converting it. Only the messages of this dictionary
+ *  count, not those of its fallback.
+ *
+ * \param msgid
+ *      The message ID, of a message without a context.
+ *
+ * \return
+ *      Returns true if merging and the message is already here.
+ */
+
+bool
+dictionary::shadowed (const std::string & msgid)
+{
+    bool result = m_merging && m_entries.find(msgid) != m_entries.end();
+    if (result)
+        ++m_shadowed_count;
+
+    return result;
+}
+
+/**
+ *  The context version of shadowed(). An empty context is a context.
+ */
+
+bool
+dictionary::shadowed (const std::string & msgctxt, const std::string & msgid)
+{
+    bool result = false;
+    if (m_merging)
+    {
+        auto ci = m_ctxt_entries.find(msgctxt);
+        result = ci != m_ctxt_entries.end() &&
+            ci->second.find(msgid) != ci->second.end();
+
+        if (result)
+            ++m_shadowed_count;
+    }
+    return result;
+}
+
+/**
+ *  The context version of find().
+ */
+
+const std::string *
+dictionary::find_ctxt
+(
+    const std::string & msgctxt,
+    const std::string & msgid
+) const
+{
+    if (m_flat)
+        return find_flat(&msgctxt, msgid);
+
+    auto ci = m_ctxt_entries.find(msgctxt);
+    if (ci != m_ctxt_entries.end())
+    {
+        auto it = ci->second.find(msgid);
+        if (it != ci->second.end() && ! it->second.phrase_list.empty())
+        {
+            const std::string & msgstr = it->second.phrase_list[0];
+            if (! msgstr.empty())
+            {
+                POTEXT_PROBE2(lookup__hit, msgctxt.c_str(), msgid.c_str());
+                return &stored_string(msgstr);
+            }
+        }
+    }
+    if (! m_has_fallback)
+    {
+        POTEXT_PROBE2(lookup__miss, msgctxt.c_str(), msgid.c_str());
+        return nullptr;
+    }
+    POTEXT_PROBE2(lookup__fallback, msgctxt.c_str(), msgid.c_str());
+    return m_fallback->find_ctxt(msgctxt, msgid);
+}
+
+/**
+ *  Looks up a translation as find() and find_ctxt() do, but returns a view
+ *  of it. For a dictionary serving a compiled image, the view points into
+ *  the image, so the lookup copies nothing and takes no lock, however many
+ *  threads or processes share the image. Use converted_view() to get it in
+ *  another codeset.
+ *
+ * \param msgctxt
+ *      The context, or null if the message has none.
+ *
+ * eturn
+ *      Returns the UTF-8 translation, or an empty view if there is none.
+ *      It is valid as long as the result of find() would be.
+ */
+
+std::string_view
+dictionary::find_view
+(
+    const std::string * msgctxt,
+    const std::string & msgid
+) const
+{
+    if (m_flat)
+    {
+        std::size_t index = not_nullptr(msgctxt) ?
+            m_flat->lookup(*msgctxt, msgid) : m_flat->lookup(msgid) ;
+
+        std::string_view msgstr = m_flat->msgstr(index, 0);
+        if (! msgstr.empty())
+            return msgstr;
+    }
+    else
+    {
+        const entries * ents = &m_entries;
+        if (not_nullptr(msgctxt))
+        {
+            auto ci = m_ctxt_entries.find(*msgctxt);
+            ents = ci != m_ctxt_entries.end() ? &ci->second : nullptr ;
+        }
+        if (not_nullptr(ents))
+        {
+            auto it = ents->find(msgid);
+            if (it != ents->end() && ! it->second.phrase_list.empty())
+            {
+                const std::string & msgstr = it->second.phrase_list[0];
+                if (! msgstr.empty())
+                    return stored_string(msgstr);
+            }
+        }
+    }
+    return m_has_fallback ?
+        m_fallback->find_view(msgctxt, msgid) : std::string_view() ;
+}
+
 #if defined PLATFORM_DEBUG_TMI
 
 /**
@@ -421,7 +1591,10 @@ enquote_string (const std::string & msg)
  *  Converts a newline to the \n escape sequence, in place. Also prepends
  *  a backslash to each double-quote character.
  *
- *  These changes are needed to match what a pofile should contain.
+ *  These changes are needed to match what a pofile should contain. The
+ *  escaped string is built in a copy; inserting each backslash in place
+ *  moved the rest of the string every time, which is quadratic in the
+ *  number of quotes.
  */
 
 static void
@@ -436,10 +1609,18 @@ fix_escapes (std::string & msg)
         }
 
         auto qpos = msg.find_first_of("\"");
-        while (qpos != std::string::npos)
+        if (qpos != std::string::npos)
         {
-            msg.insert(qpos, 1, '\\');          /* moves the quote up one   */
-            qpos = msg.find_first_of("\"", qpos + 2);
+            std::string escaped = msg.substr(0, qpos);
+            escaped.reserve(msg.size() + 16);
+            for (auto i = qpos; i < msg.size(); ++i)
+            {
+                if (msg[i] == '"')
+                    escaped += '\\';
+
+                escaped += msg[i];
+            }
+            msg.swap(escaped);
         }
     }
 }
@@ -458,7 +1639,8 @@ dictionary::message_entry
 {
     std::string msgid_copy{msgid};
     std::string msgid_plural{ent.msgid_plural};
-    const po::phraselist & msgstrs{ent.phrase_list};
+    po::phraselist scratch;
+    const po::phraselist & msgstrs = expand(ent.phrase_list, scratch);
     std::string result{"msgid \""};
     fix_escapes(msgid_copy);
     result += msgid_copy;
@@ -576,6 +1758,7 @@ dictionary::add
     const std::string & msgstr
 )
 {
+    m_search_index.reset();
     bool result = false;
     auto it = m_entries.find(msgid);
     if (it != m_entries.end())
@@ -638,6 +1821,7 @@ dictionary::add
     const phraselist & msgstrs
 )
 {
+    m_search_index.reset();
     bool result = false;
     auto it = m_entries.find(msgid);
     if (it != m_entries.end())
@@ -674,6 +1858,7 @@ dictionary::add
     const std::string & msgstr
 )
 {
+    m_search_index.reset();
     entry & ent = m_ctxt_entries[msgctxt][msgid];
     phraselist & phrases = ent.phrase_list;
     if (phrases.empty())
@@ -688,6 +1873,7 @@ dictionary::add
             << std::endl
             ;
         phrases[0] = msgstr;
+        clear_views();
     }
     return true;
 }
@@ -728,6 +1914,7 @@ dictionary::add
     const phraselist & msgstrs
 )
 {
+    m_search_index.reset();
     entry & ent = m_ctxt_entries[msgctxt][msgid];
     phraselist & phrases = ent.phrase_list;
     if (phrases.empty())                    /* i.e. a new ctxt/msgid combo  */
@@ -743,6 +1930,7 @@ dictionary::add
             << std::endl
             ;
         phrases = msgstrs;
+        clear_views();
     }
     return true;
 }
@@ -30,19 +30,25 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-02
+ * \updates       2026-10-18
  * \license       See above.
  *
  */
 
 #include <algorithm>
 #include <cctype>
+#include <cstdio>                       /* std::snprintf()                  */
+#include <cstdlib>                      /* std::getenv()                    */
+#include <filesystem>                   /* std::filesystem::file_size() etc */
 #include <fstream>
 
+#include "po/acceptlanguage.hpp"        /* po::parse_accept_language()      */
 #include "po/dictionarymgr.hpp"         /* po::dictionarymgr class          */
+#include "po/flatcatalog.hpp"           /* po::flatcatalog class            */
 #include "po/logstream.hpp"             /* po::logstream::error(), etc.     */
 #include "po/moparser.hpp"              /* po::moparser class               */
 #include "po/poparser.hpp"              /* po::poparser class               */
+#include "po/probes.hpp"                /* POTEXT_PROBE2()                  */
 #include "po/unixfilesystem.hpp"        /* po::unixfilesystem class         */
 #include "po/wstrfunctions.hpp"         /* po::functions for string/wstring */
 
@@ -69,6 +75,15 @@
 namespace po
 {
 
+/**
+ *  The number of Accept-Language headers negotiate_language() remembers,
+ *  and the longest one it remembers. A longer header is negotiated every
+ *  time, so that odd clients cannot fill the cache with large keys.
+ */
+
+static const std::size_t c_negotiation_cache_size = 256;
+static const std::size_t c_max_negotiation_key = 256;
+
 /**
  *  A dictionary to return when none are available.
  */
@@ -98,305 +113,1301 @@ dictionarymgr::dictionarymgr
     fspointer filesys,
     const std::string & charset
 ) :
+    m_mutex             (),
     m_dictionaries      (),                     /* set of shared pointers   */
     m_nlsbindings       (),
     m_current_binding   (),
     m_search_path       (),
     m_charset           (charset),
     m_use_fuzzy         (true),
+    m_manifest          (),
+    m_shared_cache      (),
+    m_cold_threshold    (0),
     m_current_domain    (),
     m_previous_domain   (),
+    m_domain_ids        (),
+    m_domain_names      (1),                    /* the unnamed domain       */
+    m_current_domain_id (sm_default_domain),
     m_current_language  (),
     m_current_dict      (nullptr),              /* a single unique pointer  */
-    m_filesystem        (std::move(filesys))
+    m_domain_dict       (nullptr),
+    m_filesystem        (std::move(filesys)),
+    m_generation        (0),
+    m_available         (),
+    m_available_valid   (false),
+    m_negotiated        (c_negotiation_cache_size),
+    m_memory_budget     (0),
+    m_memory_used       (0),
+    m_use_clock         (0),
+    m_dict_hits         (0),
+    m_dict_misses       (0),
+    m_dict_evictions    (0),
+    m_load_depth        (0)
 {
     // no other code
 }
 
-dictionarymgr::~dictionarymgr ()
-{
-    /*
-     * No code needed with shared (and purely internal) pointers.
-     */
-}
+dictionarymgr::~dictionarymgr ()
+{
+    /*
+     * No code needed with shared (and purely internal) pointers.
+     */
+}
+
+void
+dictionarymgr::clear_cache ()
+{
+    m_dictionaries.clear();             /* destroys all the shared pointers */
+    m_memory_used = 0;
+    m_current_dict = nullptr;           /* nullify this observer_ptr<>      */
+    m_domain_dict = nullptr;
+    ++m_generation;
+}
+
+/**
+ *  Return the currently active dictionary, if none is set, an empty
+ *  dictionary is returned.
+ *
+ *  In effect, this is the "main dictionary". If textdomain() selected a
+ *  domain with its own catalogs, it is that domain's dictionary for the
+ *  current language.
+ */
+
+dictionary &
+dictionarymgr::get_dictionary ()
+{
+    lockguard lock(m_mutex);
+    if (m_current_domain_id != sm_default_domain)
+    {
+        if (is_nullptr(m_domain_dict))
+        {
+            if (! m_current_language)
+                return empty_dictionary();
+
+            m_domain_dict = &get_dictionary
+            (
+                m_current_domain_id, m_current_language
+            );
+        }
+        return *m_domain_dict;
+    }
+    else if (not_nullptr(m_current_dict))
+    {
+        return *m_current_dict;
+    }
+    else
+    {
+        if (m_current_language)
+        {
+            /*
+             * Make sure this is on the heap!!!
+             *
+             * m_current_dict.reset(&get_dictionary(m_current_language));
+             */
+
+            m_current_dict = &get_dictionary(m_current_language);
+            return *m_current_dict;
+        }
+        else
+            return empty_dictionary();
+    }
+}
+
+/**
+ *  Gets the main dictionary (see get_dictionary()) if it is ready to use,
+ *  without loading anything. It is for the lookups that share mutex(),
+ *  which the caller must hold, shared or exclusive, for as long as it uses
+ *  the dictionary.
+ *
+ * \param [out] codeset
+ *      Receives the codeset bound to the current domain, if any (see
+ *      domain_codeset()).
+ *
+ * \return
+ *      Returns null if the dictionary is not loaded yet. The caller must
+ *      then take the lock exclusively and call get_dictionary().
+ */
+
+const dictionary *
+dictionarymgr::find_dictionary (std::string & codeset) const
+{
+    const dictionary * result = m_current_domain_id != sm_default_domain ?
+        m_domain_dict : m_current_dict ;
+
+    if (not_nullptr(result))
+        codeset = get_bindings().get_codeset(m_current_domain);
+
+    return result;
+}
+
+/**
+ *  The find_dictionary() version of get_domain_dictionary(). A hit counts
+ *  as a use of the dictionary, for the memory budget.
+ *
+ * \return
+ *      Returns null if the dictionary of the domain is not loaded yet, or
+ *      if the domain has no ID yet.
+ */
+
+const dictionary *
+dictionarymgr::find_domain_dictionary
+(
+    const std::string & domainname,
+    std::string & codeset
+) const
+{
+    dictkey key{sm_default_domain, language::from_env(domainname)};
+    if (! key.dk_language)
+    {
+        if
+        (
+            domainname.empty() || ! m_current_language ||
+            get_bindings().get_dirname(domainname).empty()
+        )
+        {
+            return &empty_dictionary();
+        }
+
+        auto it = m_domain_ids.find(domainname);
+        if (it == m_domain_ids.end())
+            return nullptr;
+
+        key = dictkey{it->second, m_current_language};
+    }
+
+    auto di = m_dictionaries.find(key);
+    if (di == m_dictionaries.end())
+        return nullptr;
+
+    ++m_dict_hits;
+    di->second.ds_last_use.set(++m_use_clock);
+    codeset = get_bindings().get_codeset(domainname);
+    return di->second.ds_dict.get();
+}
+
+/**
+ *  Get dictionary for language. If one is not found, make one.
+ *
+ *  If a memory budget is set, loading a dictionary can evict others, so
+ *  a reference returned earlier is valid only until the next call.
+ */
+
+dictionary &
+dictionarymgr::get_dictionary (const language & lang)
+{
+    lockguard lock(m_mutex);
+    dictkey key{sm_default_domain, lang};
+    auto di = m_dictionaries.find(key);
+    if (di != m_dictionaries.end())
+    {
+        ++m_dict_hits;
+        di->second.ds_last_use = ++m_use_clock;
+        return *di->second.ds_dict;
+    }
+    else                /* lang dictionary isn't loaded, so load it     */
+    {
+        /*
+         * Had to refactor this code in order to make the change to a
+         * shared pointer work. We also need the semantics of lookup or
+         * insert and return the entity in the map.
+         *
+         *  dictpointer dict.reset(new (std::nothrow) dictionary(m_charset));
+         *  m_dictionaries[lang] = dict;
+         */
+
+        ++m_dict_misses;
+
+        dictpointer dict = std::make_shared<dictionary>(m_charset);
+        dictslot slot{dict, 0, ++m_use_clock, true};
+        if (! m_dictionaries.insert(std::make_pair(key, slot)).second)
+            return empty_dictionary();
+
+        ++m_load_depth;
+
+        (void) load_catalogs(find_catalogs(lang), *dict);
+        if (! lang.get_country().empty())
+        {
+            (void) dict->add_fallback_dictionary
+            (
+                &get_dictionary(language::from_spec(lang.get_language()))
+            );
+        }
+        --m_load_depth;
+        note_loaded(key, *dict);
+        return *dict;
+    }
+}
+
+/**
+ *  We might need to pull out country and modifier from the domainname
+ *  parameter.
+ *
+ *      dictionary & result = get_dictionary(lobj);
+ *
+ *  Note that this function assumes all dictionaries already have been
+ *  loaded.
+ */
+
+const dictionary &
+dictionarymgr::get_dictionary (const std::string & domainname) const
+{
+    readlock lock(m_mutex);
+    std::string lang = domainname;
+    std::string country;
+    std::string modifier;
+    language /*&*/ lobj = language::from_spec(lang, country, modifier);
+    const auto di = m_dictionaries.find(dictkey{sm_default_domain, lobj});
+    return di != m_dictionaries.end() ? *di->second.ds_dict : empty_dictionary() ;
+}
+
+/**
+ *  Gets the dictionary of a domain for a language, loading it from the
+ *  domain's catalog if it is not loaded yet. It then stays loaded, so that
+ *  switching between domains does not re-read anything.
+ *
+ * \param domain
+ *      The domain ID (see intern_domain()). The unnamed domain gets the
+ *      dictionary from the search path, as get_dictionary(lang) does.
+ *
+ * \param lang
+ *      The language. If it has a country, the dictionary of the domain for
+ *      the bare language is its fallback, as for the unnamed domain.
+ */
+
+dictionary &
+dictionarymgr::get_dictionary (domainid domain, const language & lang)
+{
+    lockguard lock(m_mutex);
+    if (domain == sm_default_domain)
+        return get_dictionary(lang);
+
+    if (! lang || domain >= m_domain_names.size())
+        return empty_dictionary();
+
+    dictkey key{domain, lang};
+    auto di = m_dictionaries.find(key);
+    if (di != m_dictionaries.end())
+    {
+        ++m_dict_hits;
+        di->second.ds_last_use = ++m_use_clock;
+        return *di->second.ds_dict;
+    }
+
+    ++m_dict_misses;
+
+    dictpointer dict = std::make_shared<dictionary>(m_charset);
+    dictslot slot{dict, 0, ++m_use_clock, true};
+    if (! m_dictionaries.insert(std::make_pair(key, slot)).second)
+        return empty_dictionary();
+
+    ++m_load_depth;
+    (void) load_domain_catalog(m_domain_names[domain], lang, *dict);
+    if (! lang.get_country().empty())
+    {
+        (void) dict->add_fallback_dictionary
+        (
+            &get_dictionary(domain, language::from_spec(lang.get_language()))
+        );
+    }
+    --m_load_depth;
+    note_loaded(key, *dict);
+    return *dict;
+}
+
+/**
+ *  Gets the dictionary for the domain given to dgettext() and friends.
+ *  A domain with its own catalogs (see is_catalog_domain()) gets its
+ *  dictionary for the current language. Otherwise the domain is taken to
+ *  be a language name (e.g. "fr" or "de_AT"), as before domains were
+ *  supported, and the dictionary of that language is loaded if needed, so
+ *  one dropped to keep the memory budget is read again.
+ */
+
+const dictionary &
+dictionarymgr::get_domain_dictionary (const std::string & domainname)
+{
+    lockguard lock(m_mutex);
+    if (is_catalog_domain(domainname))
+    {
+        return get_dictionary(intern_domain(domainname), m_current_language);
+    }
+    else
+    {
+        language lang = language::from_env(domainname);
+        return lang ? get_dictionary(lang) : empty_dictionary() ;
+    }
+}
+
+/**
+ *  Gets the ID of a domain name, adding it if it is new. IDs are never
+ *  re-used, so a caller may keep one.
+ */
+
+dictionarymgr::domainid
+dictionarymgr::intern_domain (const std::string & domainname)
+{
+    lockguard lock(m_mutex);
+    if (domainname.empty())
+        return sm_default_domain;
+
+    auto it = m_domain_ids.find(domainname);
+    if (it != m_domain_ids.end())
+        return it->second;
+
+    domainid result = m_domain_names.size();
+    m_domain_names.push_back(domainname);
+    (void) m_domain_ids.emplace(domainname, result);
+    return result;
+}
+
+/**
+ *  Indicates if the domain has catalogs of its own: it has been bound to
+ *  a directory by bindtextdomain(), and it is not a language name. The
+ *  latter check keeps the older usage, where the "domain" names the
+ *  language of a catalog in the search path, working as before.
+ */
+
+bool
+dictionarymgr::is_catalog_domain (const std::string & domainname) const
+{
+    readlock lock(m_mutex);
+    return ! domainname.empty() &&
+        ! language::from_env(domainname) &&
+        ! get_bindings().get_dirname(domainname).empty();
+}
+
+/**
+ *  Loads the catalog of a domain for a language. The layouts tried, in
+ *  order, are the GNU one, a language directory, and a flat directory of
+ *  catalogs named for their language:
+ *
+ *      dirname/de_AT/LC_MESSAGES/domain.mo (or .po)
+ *      dirname/de_AT/domain.mo (or .po)
+ *      dirname/de_AT.mo (or .po)
+ *
+ * \return
+ *      Returns true if a catalog was found and parsed.
+ */
+
+bool
+dictionarymgr::load_domain_catalog
+(
+    const std::string & domainname,
+    const language & lang,
+    dictionary & dict
+)
+{
+    std::string dirname = get_bindings().get_dirname(domainname);
+    std::string spec = lang.to_string();
+    if (dirname.empty() || spec.empty())
+        return false;
+
+    std::string langdir = dirname + "/" + spec + "/";
+    const std::string candidates [] =
+    {
+        langdir + "LC_MESSAGES/" + domainname + ".mo",
+        langdir + "LC_MESSAGES/" + domainname + ".po",
+        langdir + domainname + ".mo",
+        langdir + domainname + ".po",
+        dirname + "/" + spec + ".mo",
+        dirname + "/" + spec + ".po"
+    };
+    for (const auto & pomofile : candidates)
+    {
+        uistream_ptr in = m_filesystem->open_file(pomofile);
+        if (in && *in)
+            return load_catalogs(phraselist{pomofile}, dict);
+    }
+    return false;
+}
+
+/**
+ *  Finds the catalog of a language in each directory of the search path,
+ *  the one whose name best matches the language.
+ *
+ * \param lang
+ *      The language wanted.
+ *
+ * \return
+ *      Returns the paths of the catalogs in order of precedence, the first
+ *      directory of the search path first. See load_catalogs().
+ */
+
+phraselist
+dictionarymgr::find_catalogs (const language & lang)
+{
+    phraselist catalogs;
+    for (auto p = m_search_path.begin(); p != m_search_path.end(); ++p)
+    {
+        phraselist files = m_filesystem->open_directory(*p);
+        std::string best_filename;
+        int best_score = 0;
+        bool has_po = false;
+        bool has_mo = false;
+        for (const auto & fname : files)
+        {
+            /*
+             * Check if fname matches requested lang; ignore anything that
+             * isn't a .po file or an .mo file.
+             */
+
+            has_po = has_suffix(fname, ".po");
+            has_mo = has_suffix(fname, ".mo");
+            if (has_po || has_mo)
+            {
+                language po_lang = language::from_env
+                (
+                    filename_to_language(fname)
+                );
+                if (! po_lang)
+                {
+                    logstream::warning()
+                        << fname << ": "
+                        << _("ignoring unknown language") << std::endl
+                        ;
+                }
+                else
+                {
+                    int score = language::match(lang, po_lang);
+                    if (score > best_score)
+                    {
+                        best_score = score;
+                        best_filename = fname;
+                    }
+                }
+            }
+        }
+        if (! best_filename.empty())
+        {
+            std::string pofile = *p;        /* now can be .mo file too  */
+            pofile += "/";
+            pofile += best_filename;
+            catalogs.push_back(pofile);
+        }
+    }
+    return catalogs;
+}
+
+/**
+ *  Loads catalogs into a dictionary, in order. If a shared cache directory
+ *  is set (see set_shared_cache()), the compiled image of the same
+ *  catalogs is mapped from it instead, if it is there, valid, and made
+ *  from the catalogs as they are now (see source_key()). If not, the
+ *  catalogs are parsed, and the image is compiled and published for the
+ *  other processes and later runs, and then used by this one as well, so
+ *  that the parsed copy is freed. Otherwise, if a cold threshold is set
+ *  (see set_cold_threshold()), the long translations are compressed.
+ *
+ *  Several catalogs are merged in order of precedence. A message that is
+ *  already loaded shadows the same message of the later catalogs, which
+ *  the parsers skip as soon as its ID is read, without converting it
+ *  (see dictionary::shadowed()). So the lower-precedence catalogs cost
+ *  little more than their parsing, and the one dictionary is the index of
+ *  all of them.
+ *
+ * \param files
+ *      The paths of the .po or .mo files; later ones add the messages not
+ *      in earlier ones.
+ *
+ * \return
+ *      Returns true if a catalog was parsed or mapped.
+ */
+
+bool
+dictionarymgr::load_catalogs (const phraselist & files, dictionary & dict)
+{
+    std::string cachename = shared_cache_name(files);
+    std::uint64_t sourcekey = cachename.empty() ? 0 : source_key(files) ;
+    if (sourcekey == 0)
+        cachename.clear();
+
+    if (! cachename.empty())
+    {
+        auto flat = std::make_shared<flatcatalog>();
+        if
+        (
+            flat->map_file(cachename) &&
+            flat->source_key() == sourcekey && dict.attach(flat)
+        )
+        {
+            return true;
+        }
+    }
+
+    bool result = false;
+    dict.merging(files.size() > 1);
+    for (const auto & pomofile : files)
+    {
+        if (parse_catalog(pomofile, dict))
+            result = true;
+    }
+    dict.merging(false);
+    if (result && ! cachename.empty() && ! dict.empty())
+    {
+        std::string image = flatcatalog::compile(dict, sourcekey);
+        if (flatcatalog::publish(cachename, image))
+        {
+            auto flat = std::make_shared<flatcatalog>();
+            if (flat->map_file(cachename))
+                (void) dict.attach(flat);
+        }
+        else
+        {
+            logstream::warning()
+                << _("cannot write catalog cache") << ": " << cachename
+                << std::endl
+                ;
+        }
+    }
+    if (result && m_cold_threshold > 0 && is_nullptr(dict.flat()))
+        (void) dict.compress_strings(m_cold_threshold);
+
+    return result;
+}
+
+/**
+ *  Opens and parses one catalog, logging any failure.
+ */
+
+bool
+dictionarymgr::parse_catalog (const std::string & pomofile, dictionary & dict)
+{
+    bool result = false;
+    try
+    {
+        uistream_ptr in = m_filesystem->open_file(pomofile);
+        POTEXT_PROBE2(catalog__open, pomofile.c_str(), int(bool(in)));
+        if (! in)
+        {
+            logstream::error()
+                << _("error") << ": " << _("failure opening")
+                << ": " << pomofile << std::endl
+                ;
+        }
+        else
+            result = parse_file(pomofile, *in, dict);
+    }
+    catch (const std::exception & e)
+    {
+        logstream::error()
+            << _("error") << ": " << _("failure parsing")
+            << ": " << pomofile << "\n"
+            << e.what() << "" << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Makes the name of the cached image of a set of catalogs. It is a hash
+ *  of the paths of the catalogs, the use-fuzzy setting, and the manifest,
+ *  but not of their contents, so that the image of a changed catalog
+ *  replaces the stale one instead of piling up beside it. The contents
+ *  are checked by source_key().
+ *
+ * \return
+ *      Returns an empty string if there is no cache directory, or if a
+ *      catalog is not a real file (e.g. with a custom filesystem).
+ */
+
+std::string
+dictionarymgr::shared_cache_name (const phraselist & files) const
+{
+    if (m_shared_cache.empty() || files.empty())
+        return std::string();
+
+    std::uint64_t h = fnv1a_hash(std::string("POTEXTFC"));
+    h = fnv1a_hash(std::to_string(flatcatalog::sm_version), h);
+    for (const auto & f : files)
+    {
+        std::error_code ec;
+        std::filesystem::path path = std::filesystem::absolute(f, ec);
+        if (ec)
+            return std::string();
+
+        if (! std::filesystem::is_regular_file(path, ec))
+            return std::string();
+
+        h = fnv1a_hash(path.string(), h);
+    }
+    h = fnv1a_hash(std::string(m_use_fuzzy ? "fuzzy" : ""), h);
+    h = fnv1a_hash(std::to_string(m_manifest.digest()), h);
+
+    char hex[24];
+    (void) std::snprintf(hex, sizeof hex, "%016llx", (unsigned long long) h);
+    return m_shared_cache + "/potext-" + hex + ".cat";
+}
+
+/**
+ *  Makes the key of the current state of a set of catalogs: the size,
+ *  time, and contents of each. The image of the catalogs holds the key it
+ *  was compiled with, and is used only if the key still matches. The
+ *  contents are hashed as well because the time of a file can be too
+ *  coarse to show a change, or be restored by a copy; hashing a catalog
+ *  still costs much less than parsing it.
+ *
+ * \return
+ *      Returns 0 if a catalog cannot be read.
+ */
+
+std::uint64_t
+dictionarymgr::source_key (const phraselist & files) const
+{
+    std::uint64_t h = fnv1a_hash(std::string("POTEXTSK"));
+    for (const auto & f : files)
+    {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(f, ec);
+        if (ec)
+            return 0;
+
+        auto stamp = std::filesystem::last_write_time(f, ec);
+        if (ec)
+            return 0;
+
+        std::string text;
+        if (! read_file(f, text))
+            return 0;
+
+        h = fnv1a_hash(std::to_string(size), h);
+        h = fnv1a_hash(std::to_string(stamp.time_since_epoch().count()), h);
+        h = fnv1a_hash(text, h);
+    }
+    return h != 0 ? h : 1 ;
+}
+
+/**
+ *  Provides the usual per-user cache directory for catalog images:
+ *  $XDG_CACHE_HOME/potext, or ~/.cache/potext (%LOCALAPPDATA%\potext on
+ *  Windows). The cache is opt-in; pass this to set_shared_cache() to use
+ *  it.
+ *
+ * \return
+ *      Returns an empty string if the environment names no such directory.
+ */
+
+std::string
+dictionarymgr::user_cache_directory ()
+{
+    std::filesystem::path result;
+#if defined PLATFORM_WINDOWS
+    const char * appdata = std::getenv("LOCALAPPDATA");
+    if (not_nullptr(appdata) && appdata[0] != 0)
+        result = std::filesystem::path(appdata) / "potext";
+#else
+    const char * xdg = std::getenv("XDG_CACHE_HOME");
+    const char * home = std::getenv("HOME");
+    if (not_nullptr(xdg) && xdg[0] == '/')
+        result = std::filesystem::path(xdg) / "potext";
+    else if (not_nullptr(home) && home[0] != 0)
+        result = std::filesystem::path(home) / ".cache" / "potext";
+#endif
+    return result.string();
+}
+
+/**
+ *  Return a set of the available languages in their country code.
+ */
+
+std::set<language>
+dictionarymgr::get_languages ()
+{
+    lockguard lock(m_mutex);
+    std::set<language> langs;
+    for
+    (
+        searchpath::iterator p = m_search_path.begin();
+        p != m_search_path.end(); ++p
+    )
+    {
+        phraselist files = m_filesystem->open_directory(*p);
+        for (const auto & file : files)
+        {
+            if (has_suffix(file, ".po") || has_suffix(file, ".mo"))
+            {
+                std::string basename = file.substr(0, file.size() - 3);
+                if (basename.empty())
+                {
+                    logstream::warning()
+                        << _("empty language base-name") << std::endl
+                        ;
+                }
+                else
+                {
+                    langs.insert(language::from_env(basename));
+
+                    /*
+                     * TODO? Add dictionary.
+                     */
+                }
+            }
+        }
+    }
+    return langs;
+}
+
+/**
+ *  Case-insensitive comparison of a subtag of a header with a code, which
+ *  is already in lower or upper case.
+ */
+
+static bool
+same_code (std::string_view subtag, const std::string & code)
+{
+    if (subtag.size() != code.size())
+        return false;
+
+    for (std::size_t i = 0; i < code.size(); ++i)
+    {
+        char ch = subtag[i];
+        if (ch != code[i] && char(std::tolower(ch)) != code[i] &&
+            char(std::toupper(ch)) != code[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ *  Picks the language of the catalogs in the search path that best serves
+ *  an HTTP Accept-Language header. The ranges are tried in order of
+ *  q-value; the first one that matches any catalog language picks, of
+ *  those, the closest:
+ *
+ *      -#  The same language and country ("de-AT" and de_AT).
+ *      -#  Both without a country ("de" and de).
+ *      -#  The catalog without a country ("de-AT" and de).
+ *      -#  The range without a country ("de" and de_AT).
+ *      -#  Another country ("de-AT" and de_CH).
+ *
+ *  The header is parsed without allocating, and the catalog languages are
+ *  gathered once, not per call. The answers for the last
+ *  c_negotiation_cache_size distinct headers are kept in an LRU cache,
+ *  since real traffic sends few distinct values. A hit in that cache does
+ *  not lock the manager.
+ *
+ * \param acceptlanguage
+ *      The value of the Accept-Language header.
+ *
+ * \return
+ *      Returns the language, or an invalid language (false in a boolean
+ *      context) if no catalog language is acceptable. The caller then uses
+ *      its default language.
+ */
+
+language
+dictionarymgr::negotiate_language (const std::string & acceptlanguage)
+{
+    language result;
+    bool cacheable = acceptlanguage.size() <= c_max_negotiation_key;
+    if (cacheable && m_negotiated.get(acceptlanguage, result))
+        return result;
+
+    languagerange ranges[c_max_language_ranges];
+    std::size_t count = parse_accept_language(acceptlanguage, ranges);
+    {
+        lockguard lock(m_mutex);
+        if (! m_available_valid)
+        {
+            m_available.clear();
+            for (const auto & lang : get_languages())
+            {
+                if (! lang)
+                    continue;
+
+                std::string code = lang.get_language();
+                std::string country = lang.get_country();
+                for (auto & ch : code)
+                    ch = char(std::tolower(ch));
+
+                for (auto & ch : country)
+                    ch = char(std::toupper(ch));
+
+                m_available.push_back(availlang{lang, code, country});
+            }
+            m_available_valid = true;
+        }
+        for (std::size_t r = 0; r < count && ! result; ++r)
+        {
+            const languagerange & range = ranges[r];
+            int best = 0;
+            for (const auto & a : m_available)
+            {
+                if (! same_code(range.lr_language, a.al_code))
+                    continue;
+
+                int score;
+                if (range.lr_country.empty())
+                    score = a.al_country.empty() ? 4 : 2 ;
+                else if (a.al_country.empty())
+                    score = 3;
+                else
+                    score = same_code(range.lr_country, a.al_country) ? 5 : 1 ;
+
+                if (score > best)
+                {
+                    best = score;
+                    result = a.al_language;
+                }
+            }
+        }
+        if (cacheable)                          /* not stale: still locked  */
+            m_negotiated.put(acceptlanguage, result);
+    }
+    return result;
+}
+
+/**
+ *  Sets how many distinct Accept-Language headers negotiate_language()
+ *  remembers.
+ */
+
+void
+dictionarymgr::set_negotiation_cache_size (std::size_t count)
+{
+    m_negotiated.set_capacity(count);
+}
+
+/**
+ *  Forgets the catalog languages and the negotiated ones, when the search
+ *  path changes.
+ */
+
+void
+dictionarymgr::invalidate_negotiation ()
+{
+    m_available_valid = false;
+    m_negotiated.clear();
+}
+
+/**
+ *  Why nullify the current dict?
+ */
+
+void
+dictionarymgr::set_language (const language & lang)
+{
+    lockguard lock(m_mutex);
+    if (m_current_language != lang)
+    {
+        POTEXT_PROBE2
+        (
+            language__switch,
+            m_current_language.to_string().c_str(), lang.to_string().c_str()
+        );
+        m_current_language = lang;
+        m_current_dict = nullptr;
+        m_domain_dict = nullptr;
+        ++m_generation;
+    }
+}
+
+/**
+ *  Add a directory to the search path for dictionaries, earlier added
+ *  directories have higher priority then later added ones.  Set
+ *  precedence to true to invert this for a single addition.
+ */
+
+void
+dictionarymgr::add_directory
+(
+    const std::string & pathname,
+    bool precedence
+)
+{
+    lockguard lock(m_mutex);
+    auto p = std::find(m_search_path.begin(), m_search_path.end(), pathname);
+    if (p == m_search_path.end())
+    {
+        std::set<std::string> codes;
+        (void) directory_languages(pathname, codes);
+        if (precedence)
+            m_search_path.push_front(pathname);
+        else
+            m_search_path.push_back(pathname);
+
+        invalidate_negotiation();
+
+        if (! codes.empty())
+        {
+            (void) drop_dictionaries
+            (
+                [&codes] (dictionary &, const dictkey & k)
+                {
+                    return k.dk_domain == sm_default_domain &&
+                        codes.count(k.dk_language.get_language()) > 0;
+                }
+            );
+        }
+    }
+}
+
+/**
+ *  Remove a directory from the search path. If the directory can no
+ *  longer be read, we cannot tell what was loaded from it, so all the
+ *  dictionaries are dropped.
+ */
+
+void
+dictionarymgr::remove_directory (const std::string & pathname)
+{
+    lockguard lock(m_mutex);
+    searchpath::iterator it = find
+    (
+        m_search_path.begin(), m_search_path.end(), pathname
+    );
+    if (it != m_search_path.end())
+    {
+        std::set<std::string> codes;
+        bool readable = directory_languages(pathname, codes);
+        m_search_path.erase(it);
+        invalidate_negotiation();
+        if (! readable)
+        {
+            clear_cache();
+        }
+        else if (! codes.empty())
+        {
+            (void) drop_dictionaries
+            (
+                [&codes] (dictionary &, const dictkey & k)
+                {
+                    return k.dk_domain == sm_default_domain &&
+                        codes.count(k.dk_language.get_language()) > 0;
+                }
+            );
+        }
+    }
+}
+
+/**
+ *  Only a catalog with fuzzy entries changes when the setting changes, so
+ *  only the dictionaries created from such catalogs are dropped.
+ */
+
+void
+dictionarymgr::set_use_fuzzy (bool t)
+{
+    lockguard lock(m_mutex);
+    if (t != m_use_fuzzy)
+    {
+        m_use_fuzzy = t;
+        (void) drop_dictionaries
+        (
+            [] (dictionary & d, const dictkey &)
+            {
+                return d.has_fuzzy();
+            }
+        );
+    }
+}
+
+/**
+ *  Sets the charset of the dictionaries. Since the dictionaries store
+ *  their translations in UTF-8, this just switches the view of the loaded
+ *  ones (see dictionary::set_charset()). Nothing is re-read, and a switch
+ *  back to a charset used before re-uses the conversions already made.
+ */
 
 void
-dictionarymgr::clear_cache ()
+dictionarymgr::set_charset (const std::string & charset)
 {
-    m_dictionaries.clear();             /* destroys all the shared pointers */
-    m_current_dict = nullptr;           /* nullify this observer_ptr<>      */
+    lockguard lock(m_mutex);
+    if (charset == m_charset)
+        return;
+
+    m_charset = charset;
+    for (auto & d : m_dictionaries)
+    {
+        if (d.second.ds_dict)
+            (void) d.second.ds_dict->set_charset(charset);
+    }
+    ++m_generation;                     /* the translations have changed    */
 }
 
 /**
- *  Return the currently active dictionary, if none is set, an empty
- *  dictionary is returned.
+ *  Gets the language codes (e.g. "de" for de_AT.po) of the catalogs in a
+ *  directory.
  *
- *  In effect, this is the "main dictionary".
+ * \return
+ *      Returns false if the directory has no files (or cannot be read).
  */
 
-dictionary &
-dictionarymgr::get_dictionary ()
+bool
+dictionarymgr::directory_languages
+(
+    const std::string & dirname,
+    std::set<std::string> & codes
+)
 {
-    if (not_nullptr(m_current_dict))
-    {
-        return *m_current_dict;
-    }
-    else
+    phraselist files = m_filesystem->open_directory(dirname);
+    for (const auto & fname : files)
     {
-        if (m_current_language)
+        if (has_suffix(fname, ".po") || has_suffix(fname, ".mo"))
         {
-            /*
-             * Make sure this is on the heap!!!
-             *
-             * m_current_dict.reset(&get_dictionary(m_current_language));
-             */
-
-            m_current_dict = &get_dictionary(m_current_language);
-            return *m_current_dict;
+            language lang = language::from_env(filename_to_language(fname));
+            if (lang)
+                (void) codes.insert(lang.get_language());
         }
-        else
-            return empty_dictionary();
     }
+    return ! files.empty();
 }
 
 /**
- *  Get dictionary for language. If one is not found, make one.
+ *  Drops the dictionaries for which the function returns true. A
+ *  dictionary whose fallback (e.g. "de" for "de_AT") is dropped must go
+ *  as well, since it points to it. Dictionaries not dropped are kept
+ *  as is, and need not be parsed again.
+ *
+ * \param f
+ *      Selects the dictionaries to drop.
+ *
+ * \param newgeneration
+ *      If false, the generation is not incremented. Only evictions, which
+ *      never drop the main dictionary, pass false.
+ *
+ * \return
+ *      Returns the number of dictionaries dropped.
  */
 
-dictionary &
-dictionarymgr::get_dictionary (const language & lang)
+std::size_t
+dictionarymgr::drop_dictionaries
+(
+    const std::function<bool (dictionary &, const dictkey &)> & f,
+    bool newgeneration
+)
 {
-    auto di = m_dictionaries.find(lang);
-    if (di != m_dictionaries.end())
+    std::set<const dictionary *> dropped;
+    for (const auto & d : m_dictionaries)
     {
-        return *di->second;
+        if (f(*d.second.ds_dict, d.first))
+            (void) dropped.insert(d.second.ds_dict.get());
     }
-    else                /* lang dictionary isn't loaded, so load it     */
-    {
-        /*
-         * Had to refactor this code in order to make the change to a
-         * shared pointer work. We also need the semantics of lookup or
-         * insert and return the entity in the map.
-         *
-         *  dictpointer dict.reset(new (std::nothrow) dictionary(m_charset));
-         *  m_dictionaries[lang] = dict;
-         */
 
-        dictpointer d = std::make_shared<dictionary>();
-        auto ldp = std::make_pair(lang, std::move(d));
-        auto inserted_item = m_dictionaries.insert(ldp);
-        dictpointer dict;
-        if (inserted_item.second)
+    bool more = ! dropped.empty();
+    while (more)
+    {
+        more = false;
+        for (const auto & d : m_dictionaries)
         {
-            auto di = m_dictionaries.find(lang);
-            dict = di->second;
+            const dictionary * fb = d.second.ds_dict->fallback();
+            if (not_nullptr(fb) && dropped.count(fb) > 0)
+            {
+                if (dropped.insert(d.second.ds_dict.get()).second)
+                    more = true;
+            }
         }
-        else
-            return empty_dictionary();
+    }
 
-        for (auto p = m_search_path.rbegin(); p != m_search_path.rend(); ++p)
-        {
-            /*
-             * Could replace this with a helper function TBD.
-             */
+    std::size_t result = dropped.size();
+    if (result > 0)
+    {
+        if (dropped.count(m_current_dict) > 0)
+            m_current_dict = nullptr;
 
-            phraselist files = m_filesystem->open_directory(*p);
-            std::string best_filename;
-            int best_score = 0;
-            bool has_po = false;
-            bool has_mo = false;
-            for (const auto & fname : files)
-            {
-                /*
-                 * Check if fname matches requested lang; ignore anything that
-                 * isn't a .po file or an .mo file.
-                 */
-
-                has_po = has_suffix(fname, ".po");
-                has_mo = has_suffix(fname, ".mo");
-                if (has_po || has_mo)
-                {
-                    language po_lang = language::from_env
-                    (
-                        filename_to_language(fname)
-                    );
-                    if (! po_lang)
-                    {
-                        logstream::warning()
-                            << fname << ": "
-                            << _("ignoring unknown language") << std::endl
-                            ;
-                    }
-                    else
-                    {
-                        int score = language::match(lang, po_lang);
-                        if (score > best_score)
-                        {
-                            best_score = score;
-                            best_filename = fname;
-                        }
-                    }
-                }
-            }
-            if (! best_filename.empty())
+        if (dropped.count(m_domain_dict) > 0)
+            m_domain_dict = nullptr;
+
+        for (auto di = m_dictionaries.begin(); di != m_dictionaries.end(); )
+        {
+            if (dropped.count(di->second.ds_dict.get()) > 0)
             {
-                std::string pofile = *p;        /* now can be .mo file too  */
-                pofile += "/";
-                pofile += best_filename;
-                try
-                {
-                    uistream_ptr in = m_filesystem->open_file(pofile);
-                    if (! in)
-                    {
-                        logstream::error()
-                            << _("error") << ": " << _("failure opening")
-                            << ": " << pofile << std::endl
-                            ;
-                    }
-                    else
-                    {
-                        if (has_po)
-                            (void) poparser::parse_po_file(pofile, *in, *dict);
-                        else if (has_po)
-                            (void) moparser::parse_mo_file(pofile, *in, *dict);
-                    }
-                }
-                catch (const std::exception & e)
-                {
-                    logstream::error()
-                        << _("error") << ": " << _("failure parsing")
-                        << ": " << pofile << "\n"
-                        << e.what() << "" << std::endl
-                        ;
-                }
+                m_memory_used -= di->second.ds_bytes;
+                di = m_dictionaries.erase(di);
             }
+            else
+                ++di;
         }
-        if (! lang.get_country().empty())
-        {
-            (void) dict->add_fallback_dictionary
-            (
-                &get_dictionary(language::from_spec(lang.get_language()))
-            );
-        }
-        return *dict;
+        if (newgeneration)
+            ++m_generation;
     }
+    return result;
 }
 
 /**
- *  We might need to pull out country and modifier from the domainname
- *  parameter.
- *
- *      dictionary & result = get_dictionary(lobj);
- *
- *  Note that this function assumes all dictionaries already have been
- *  loaded.
+ *  Records the memory of a dictionary just loaded, and then keeps to the
+ *  memory budget, unless the dictionary is the fallback of one still
+ *  being loaded.
  */
 
-const dictionary &
-dictionarymgr::get_dictionary (const std::string & domainname) const
+void
+dictionarymgr::note_loaded (const dictkey & key, const dictionary & dict)
 {
-    std::string lang = domainname;
-    std::string country;
-    std::string modifier;
-    language /*&*/ lobj = language::from_spec(lang, country, modifier);
-    const auto di = m_dictionaries.find(lobj);
-    return di != m_dictionaries.end() ? *di->second : empty_dictionary() ;
+    auto di = m_dictionaries.find(key);
+    if (di != m_dictionaries.end())
+    {
+        di->second.ds_bytes = dict.memory_usage();
+        m_memory_used += di->second.ds_bytes;
+    }
+    if (m_load_depth == 0)
+        (void) evict_dictionaries(&dict);
 }
 
 /**
- *  Return a set of the available languages in their country code.
+ *  Drops the least recently used dictionaries until the memory budget is
+ *  met. The dictionaries of the current language, in the unnamed and the
+ *  current domain, are pinned, as is the one just loaded, along with
+ *  their fallbacks. So are the dictionaries added by add_dictionary_file()
+ *  and add_dictionaries(), which get_dictionary() would not find again.
+ *  The others are loaded again if they are looked up again.
+ *
+ * \param keep
+ *      A dictionary to pin as well, or null.
+ *
+ * \return
+ *      Returns the number of dictionaries dropped.
  */
 
-std::set<language>
-dictionarymgr::get_languages ()
+std::size_t
+dictionarymgr::evict_dictionaries (const dictionary * keep)
 {
-    std::set<language> langs;
-    for
-    (
-        searchpath::iterator p = m_search_path.begin();
-        p != m_search_path.end(); ++p
-    )
+    if (m_memory_budget == 0 || m_memory_used <= m_memory_budget)
+        return 0;
+
+    std::set<const dictionary *> pinned;
+    auto pin = [&pinned] (const dictionary * d)
     {
-        phraselist files = m_filesystem->open_directory(*p);
-        for (const auto & file : files)
+        for ( ; not_nullptr(d) && pinned.insert(d).second; d = d->fallback())
+            ;
+    };
+    pin(keep);
+    pin(m_current_dict);
+    pin(m_domain_dict);
+    if (m_current_language)
+    {
+        for (domainid id : { sm_default_domain, m_current_domain_id })
         {
-            if (has_suffix(file, ".po") || has_suffix(file, ".mo"))
-            {
-                std::string basename = file.substr(0, file.size() - 3);
-                if (basename.empty())
-                {
-                    logstream::warning()
-                        << _("empty language base-name") << std::endl
-                        ;
-                }
-                else
-                {
-                    langs.insert(language::from_env(basename));
+            auto di = m_dictionaries.find(dictkey{id, m_current_language});
+            if (di != m_dictionaries.end())
+                pin(di->second.ds_dict.get());
+        }
+    }
 
-                    /*
-                     * TODO? Add dictionary.
-                     */
-                }
+    std::size_t result = 0;
+    while (m_memory_used > m_memory_budget)
+    {
+        const dictionary * victim = nullptr;
+        unsigned long oldest = 0;
+        for (const auto & d : m_dictionaries)
+        {
+            const dictslot & s = d.second;
+            if (! s.ds_reloadable || pinned.count(s.ds_dict.get()) > 0)
+                continue;
+
+            if (is_nullptr(victim) || s.ds_last_use.get() < oldest)
+            {
+                victim = s.ds_dict.get();
+                oldest = s.ds_last_use.get();
             }
         }
+        if (is_nullptr(victim))
+            break;                      /* all that is left is pinned       */
+
+        result += drop_dictionaries
+        (
+            [victim] (dictionary & d, const dictkey &)
+            {
+                return &d == victim;
+            },
+            false
+        );
     }
-    return langs;
+    m_dict_evictions += result;
+    return result;
 }
 
 /**
- *  Why nullify the current dict?
+ *  Sets the most memory, as estimated by dictionary::memory_usage(), that
+ *  the loaded dictionaries may hold. When a dictionary is loaded past
+ *  this budget, the least recently used ones are dropped (see
+ *  evict_dictionaries()). A translation server that serves many languages
+ *  can thus keep the busy ones loaded without holding all of them.
+ *
+ * \param bytes
+ *      The budget, or 0 (the default) for no limit. A lower budget takes
+ *      effect at once.
  */
 
 void
-dictionarymgr::set_language (const language & lang)
+dictionarymgr::set_memory_budget (std::size_t bytes)
 {
-    if (m_current_language != lang)
-    {
-        m_current_language = lang;
-        m_current_dict = nullptr;
-    }
+    lockguard lock(m_mutex);
+    m_memory_budget = bytes;
+    (void) evict_dictionaries();
 }
 
 /**
- *  Add a directory to the search path for dictionaries, earlier added
- *  directories have higher priority then later added ones.  Set
- *  precedence to true to invert this for a single addition.
+ *  Loads a manifest (a .pot file or a key list; see manifest.hpp) of the
+ *  message IDs the application uses. Dictionaries loaded from now on
+ *  hold only those messages. The dictionaries already loaded were not
+ *  filtered by this manifest, so they are dropped.
+ *
+ * \return
+ *      Returns true if the manifest was loaded. Otherwise the previous
+ *      manifest is kept.
  */
 
+bool
+dictionarymgr::load_manifest (const std::string & filename)
+{
+    lockguard lock(m_mutex);
+    manifest mf;
+    bool result = mf.load(filename);
+    if (result)
+        set_manifest(mf);
+
+    return result;
+}
+
 void
-dictionarymgr::add_directory
-(
-    const std::string & pathname,
-    bool precedence
-)
+dictionarymgr::set_manifest (const manifest & mf)
 {
-    auto p = std::find(m_search_path.begin(), m_search_path.end(), pathname);
-    if (p == m_search_path.end())
+    lockguard lock(m_mutex);
+    clear_cache();              /* loaded dictionaries used the old one     */
+    m_manifest = mf;
+}
+
+void
+dictionarymgr::clear_manifest ()
+{
+    lockguard lock(m_mutex);
+    if (! m_manifest.empty())
     {
-        clear_cache();          // adding directories invalidates cache
-        if (precedence)
-            m_search_path.push_front(pathname);
-        else
-            m_search_path.push_back(pathname);
+        clear_cache();
+        m_manifest.clear();
     }
 }
 
 /**
- *  Remove a directory from the search path.
+ *  Parses a .po or .mo file into the given dictionary, applying the
+ *  manifest, if any.
  */
 
-void
-dictionarymgr::remove_directory (const std::string & pathname)
+bool
+dictionarymgr::parse_file
+(
+    const std::string & pomofile,
+    std::istream & in,
+    dictionary & dict
+)
 {
-    searchpath::iterator it = find
-    (
-        m_search_path.begin(), m_search_path.end(), pathname
-    );
-    if (it != m_search_path.end())
+    const manifest * mf = m_manifest.empty() ? nullptr : &m_manifest ;
+    bool has_po = has_suffix(pomofile, ".po");
+    bool has_mo = has_suffix(pomofile, ".mo");
+    if (! has_po && ! has_mo)
     {
-        clear_cache();          // removing directories invalidates cache
-        m_search_path.erase(it);
+        has_po = is_po_path(pomofile);
+        has_mo = ! has_po && is_mo_path(pomofile);
     }
+
+    bool result = false;
+    if (has_po)
+        result = poparser::parse_po_file(pomofile, in, dict, m_use_fuzzy, mf);
+    else if (has_mo)
+        result = moparser::parse_mo_file(pomofile, in, dict, m_use_fuzzy, mf);
+
+    return result;
 }
 
 /**
@@ -456,6 +1467,7 @@ dictionarymgr::make_dictionary
     try
     {
         uistream_ptr in = m_filesystem->open_file(pomofile);
+        POTEXT_PROBE2(catalog__open, pomofile.c_str(), int(bool(in)));
         if (! in)
         {
             logstream::error()
@@ -465,25 +1477,22 @@ dictionarymgr::make_dictionary
         }
         else
         {
-            dictpointer d = std::make_shared<dictionary>();
-            auto pdp = std::make_pair(polang, std::move(d));
+            dictpointer d = std::make_shared<dictionary>(m_charset);
+            dictkey key{sm_default_domain, polang};
+            dictslot slot{std::move(d), 0, ++m_use_clock, false};
+            auto pdp = std::make_pair(key, std::move(slot));
             auto inserted_item = m_dictionaries.insert(pdp);
             bool ok = inserted_item.second;
             if (ok)
             {
                 auto iter = inserted_item.first;
-                auto dp = iter->second;
+                auto dp = iter->second.ds_dict;
                 std::string name = polang.get_language();
-                bool has_po = is_po_path(pomofile);
-                bool has_mo = is_mo_path(pomofile);
-                bool ok = false;
-                if (has_po)
-                    ok = poparser::parse_po_file(pomofile, *in, *dp);
-                else if (has_mo)
-                    ok = moparser::parse_mo_file(pomofile, *in, *dp);
-
+                bool ok = load_catalogs(phraselist{pomofile}, *dp);
                 if (ok)
                 {
+                    iter->second.ds_bytes = dp->memory_usage();
+                    m_memory_used += iter->second.ds_bytes;
                     std::string ncname = dirname;
                     if (get_bindings().set_binding_values(name, ncname))
                         result = dp;
@@ -521,6 +1530,7 @@ dictionarymgr::make_dictionary
 bool
 dictionarymgr::add_dictionary_file (const std::string & fname)
 {
+    lockguard lock(m_mutex);
     language polang = language::from_env(filename_to_language(fname));
     bool result = bool(polang);
     if (result)
@@ -537,6 +1547,7 @@ dictionarymgr::add_dictionary_file (const std::string & fname)
             (void) textdomain(domain);
             set_language(polang);
             m_current_dict = d.get();           /* replace observer pointer */
+            ++m_generation;
         }
     }
     else
@@ -585,6 +1596,7 @@ dictionarymgr::add_dictionaries
     const std::string & defaultdomain
 )
 {
+    lockguard lock(m_mutex);
     phraselist files = m_filesystem->open_directory(dirname);   /* vector   */
     bool result = files.size() > 0;
     if (! result)
@@ -608,15 +1620,11 @@ dictionarymgr::add_dictionaries
                     if (is_nullptr(m_current_dict))
                     {
                         std::string name = polang.get_language();
-                        if (defaultdomain.empty())
-                        {
-                            m_current_dict = d.get();
-                            logged_current_dict = true;
-                        }
-                        else if (name == defaultdomain)
+                        if (defaultdomain.empty() || name == defaultdomain)
                         {
                             m_current_dict = d.get();
                             logged_current_dict = true;
+                            ++m_generation;
                         }
                     }
                 }
@@ -680,6 +1688,7 @@ dictionarymgr::add_dictionaries
 std::string
 dictionarymgr::textdomain (const std::string & domainname)
 {
+    lockguard lock(m_mutex);
     if (! domainname.empty())
     {
         if (domainname == previous_domain())    /* could signal env change  */
@@ -694,10 +1703,30 @@ dictionarymgr::textdomain (const std::string & domainname)
             else
                 m_current_domain = domainname;
         }
+        update_current_domain();
     }
     return current_domain();
 }
 
+/**
+ *  Sets the ID of the current domain from its name. The dictionaries of
+ *  the previous domain stay loaded.
+ */
+
+void
+dictionarymgr::update_current_domain ()
+{
+    domainid id = is_catalog_domain(current_domain()) ?
+        intern_domain(current_domain()) : sm_default_domain ;
+
+    if (id != m_current_domain_id)
+    {
+        m_current_domain_id = id;
+        m_domain_dict = nullptr;
+        ++m_generation;
+    }
+}
+
 /**
  *  This is a reimplementation of GNU's ::bindtextdomain() for C++.
  *  That function allows one to change the file location of a message domain,
@@ -734,6 +1763,7 @@ dictionarymgr::bindtextdomain
     const std::string & dirname
 )
 {
+    lockguard lock(m_mutex);
     std::string result;
     std::string saved_dirname = dirname;
     if (dirname[0] == '/' || dirname[0] == '\\')
@@ -755,13 +1785,44 @@ dictionarymgr::bindtextdomain
         }
     }
     if (get_bindings().set_binding_values(domainname, saved_dirname))
+    {
         result = saved_dirname;
+        auto it = m_domain_ids.find(domainname);
+        if (it != m_domain_ids.end())           /* catalogs have moved      */
+        {
+            domainid id = it->second;
+            (void) drop_dictionaries
+            (
+                [id] (dictionary &, const dictkey & k)
+                {
+                    return k.dk_domain == id;
+                }
+            );
+        }
+        update_current_domain();
+    }
     else
         result = dirname;
 
     return result;
 }
 
+/**
+ *  This is a reimplementation of GNU's ::bind_textdomain_codeset() for C++.
+ *  The catalogs are not touched; the codeset only selects which view of
+ *  them the lookups in the domain return (see domain_codeset()).
+ *
+ * \param domainname
+ *      The domain to which to bind the codeset.
+ *
+ * \param codeset
+ *      The output codeset. If empty, the current codeset is returned.
+ *
+ * \return
+ *      Returns the codeset of the domain, which is empty if none has been
+ *      bound.
+ */
+
 std::string
 dictionarymgr::bind_textdomain_codeset
 (
@@ -769,13 +1830,34 @@ dictionarymgr::bind_textdomain_codeset
     const std::string & codeset
 )
 {
+    lockguard lock(m_mutex);
     std::string result = codeset;
     if (get_bindings().set_binding_codeset(domainname, result))
+    {
+        if (! codeset.empty())
+            ++m_generation;             /* the translations have changed    */
+
         return result;
+    }
     else
         return std::string("");
 }
 
+/**
+ *  Gets the output codeset for lookups in a domain.
+ *
+ * \return
+ *      Returns the codeset bound to the domain, or an empty string, which
+ *      selects the charset of the dictionary.
+ */
+
+std::string
+dictionarymgr::domain_codeset (const std::string & domainname) const
+{
+    readlock lock(m_mutex);
+    return get_bindings().get_codeset(domainname);
+}
+
 }           // namespace po
 
 /*
@@ -32,7 +32,7 @@
  * \library       potext
  * \author        Chris Ahlstrom
  * \date          2024-03-24
- * \updates       2024-04-11
+ * \updates       2026-10-17
  * \license       See above.
  *
  *      This class is actually more generally useful than just its usage
@@ -48,20 +48,6 @@
 namespace po
 {
 
-/**
- *  Static functions defined later in this module.
- */
-
-static int brute_force
-(
-    const std::string & text,
-    const std::string & pattern
-);
-
-#if defined TEST_BRUTE_FORCE
-static bool brute_force_test ();
-#endif
-
 /**
  *  Principal constructor
  */
@@ -75,10 +61,10 @@ extractor::extractor (const std::string & source) :
 }
 
 /**
- *  This function looks for a specific string in the binary data.
- *  Currently brute force. See the static function brute_force().
- *  We don't want a recursive solution, because the binary file might be
- *  large enough to induce a stack overflow. Too paranoid?
+ *  This function looks for a specific string in the binary data. It used
+ *  to compare the target at every offset with a loop of our own; now
+ *  std::string::find() does it, which skips ahead to each occurrence of
+ *  the first character with memchr().
  *
  * \param target
  *      Provides the string to look for. The whole string length must be
@@ -86,7 +72,6 @@ extractor::extractor (const std::string & source) :
  *
  * \param start
  *      Provides the offset at which to start looking. Defaults to 0.
- *      Not yet used, but still checked.
  *
  * \return
  *      Returns a null pointer or a pointer to the data.
@@ -98,8 +83,8 @@ extractor::find (const std::string & target, std::size_t start) const
     const char * result = nullptr;
     if (valid_offset(start + target.length()))
     {
-        int index = brute_force(m_data, target);
-        if (index >= 0)
+        std::string::size_type index = m_data.find(target, start);
+        if (index != std::string::npos)
             result = m_data.data() + index;
     }
     return result;
@@ -133,7 +118,10 @@ extractor::find_offset (const std::string & target, std::size_t start) const
  *      The offset of the start of the search range.
  *
  * \param len
- *      The length of the search range.
+ *      The length of the search range. The byte just past the range is
+ *      checked too, since it is where the NUL terminating a string is.
+ *      Nothing beyond it is searched, so that looking for a character in
+ *      each string of a large file is not quadratic.
  *
  * \return
  *      Returns a valid offset to the first instance of the character,
@@ -147,20 +135,34 @@ extractor::find_character
 ) const
 {
     std::size_t result = std::numeric_limits<std::size_t>::max();
-    std::size_t rangelength = start + len;
-    if (valid_offset(rangelength))
+    if (valid_range(start, len) && valid_offset(start + len))
     {
-        std::string::size_type pos = m_data.find(target, start);
-        if (pos != std::string::npos)
-        {
-            if (pos <= rangelength)
-                result = std::size_t(pos);
-        }
+        const void * pos = std::memchr(m_data.data() + start, target, len + 1);
+        if (not_nullptr(pos))
+            result = std::size_t(static_cast<const char *>(pos) - m_data.data());
     }
     return result;
 }
 
 
+/**
+ *  Copies the offset structure at the given position. It is copied, not
+ *  cast, because a damaged file can put it at an odd position.
+ *
+ * \return
+ *      Returns false if the structure does not fit in the data.
+ */
+
+bool
+extractor::get_offset (std::size_t pos, offset & result) const
+{
+    bool ok = valid_range(pos, sizeof(offset));
+    if (ok)
+        std::memcpy(&result, m_data.data() + pos, sizeof(offset));
+
+    return ok;
+}
+
 /**
  *  This function is akin to find(), but checks for the string at the
  *  current position in the binary data.
@@ -222,100 +224,6 @@ extractor::get_delimited
     return result;
 }
 
-/**
- *  Finds a pattern in a string by comparing the pattern to every substring.
- *  Adapted from:
- *
- *      https://github.com/TheAlgorithms/C-Plus-Plus/tree/master/strings
- *
- * \param text
- *      Any string that might contain the pattern.
- *
- * \param pattern
- *      String that we are searching for.
- *
- * \return
- *      Index where the pattern starts in the text. Or -1 if the
- *      pattern was not found.
- */
-
-static int
-brute_force (const std::string & text, const std::string & pattern)
-{
-    std::size_t pat_length = pattern.length();
-    std::size_t txt_length = text.length();
-    int index = -1;
-    if (pat_length <= txt_length)
-    {
-        for (std::size_t i = 0; i < txt_length - pat_length + 1; ++i)
-        {
-            /*
-             * Why make a string just to compare it?
-             *
-             *      std::string s = text.substr(i, pat_length);
-             *      if (s == pattern)
-             */
-
-            bool match = true;
-            std::size_t i_index = i;
-            for (auto ch : pattern)
-            {
-                if (text[i_index] != ch)
-                {
-                    match = false;
-                    break;
-                }
-                ++i_index;
-            }
-            if (match)
-            {
-                index = i;
-                break;
-            }
-        }
-    }
-    return index;
-}
-
-#if defined TEST_BRUTE_FORCE
-
-/**
- *  Set of brute_force() test cases.
- */
-
-static bool
-brute_force_test ()
-{
-    static const std::vector<std::vector<std::string>> s_test_set
-    {
-        /* text, pattern, expected output   */
-
-        { "a",    "aa", "-1"    },
-        { "a",    "a",  "0"     },
-        { "ba",   "b",  "0"     },
-        { "bba",  "bb", "0"     },
-        { "bbca", "c",  "2"     },
-        { "ab",   "b",  "1"     }
-    };
-    bool result = true;
-    for (const auto & i : s_test_set)
-    {
-        int output = brute_force(i[0], i[1]);
-        if (std::to_string(output) == i[2])
-        {
-            printf("success\n");
-        }
-        else
-        {
-            printf("failure\n");
-            result = false;
-        }
-    }
-    return result;
-}
-
-#endif      // TEST_BRUTE_FORCE
-
 /**
  *  Conditionally reverses the bytes in a word.
  */
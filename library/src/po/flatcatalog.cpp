@@ -0,0 +1,619 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          flatcatalog.cpp
+ *
+ *      A compiled, pointer-free catalog image that can be shared between
+ *      processes by mapping it from a file.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  See the banner of flatcatalog.hpp.
+ */
+
+#include <algorithm>                    /* std::sort()                      */
+#include <cstdio>                       /* std::rename(), std::remove()     */
+#include <cstring>                      /* std::memcpy(), std::memcmp()     */
+#include <filesystem>                   /* std::filesystem::create_dir...() */
+#include <fstream>                      /* std::ofstream                    */
+#include <functional>                   /* std::less<>                      */
+#include <vector>                       /* std::vector<> template           */
+
+#include "platform_macros.h"            /* PLATFORM_UNIX macro              */
+#include "po/dictionary.hpp"            /* po::dictionary class             */
+#include "po/flatcatalog.hpp"           /* po::flatcatalog class            */
+#include "po/manifest.hpp"              /* po::manifest::make_key()         */
+#include "po/wstrfunctions.hpp"         /* po::fnv1a_hash(), read_file()    */
+
+#if defined PLATFORM_UNIX
+#include <fcntl.h>                      /* ::open()                         */
+#include <sys/mman.h>                   /* ::mmap(), ::munmap()             */
+#include <sys/stat.h>                   /* ::fstat()                        */
+#include <unistd.h>                     /* ::close(), ::getpid()            */
+#endif
+
+namespace po
+{
+
+/**
+ *  The first bytes of every image.
+ */
+
+static const char c_magic [8] = { 'P', 'O', 'T', 'E', 'X', 'T', 'F', 'C' };
+
+/**
+ *  Written in native order; an image from a machine of the other byte
+ *  order does not match it.
+ */
+
+static const std::uint32_t c_byte_order = 0x01020304;
+
+/**
+ *  Header flags.
+ */
+
+static const std::uint32_t c_flag_fuzzy = 0x01;
+
+/**
+ *  The msgctxt/msgid separator of the keys, as in manifest::make_key().
+ */
+
+static const unsigned char c_ctxt_separator = '\004';
+
+flatcatalog::flatcatalog () :
+    m_image         (),
+    m_mapping       (nullptr),
+    m_mapping_size  (0),
+    m_data          (nullptr),
+    m_header        (nullptr),
+    m_entries       (nullptr),
+    m_strings       (nullptr)
+{
+    // no code
+}
+
+flatcatalog::~flatcatalog ()
+{
+    clear();
+}
+
+void
+flatcatalog::clear ()
+{
+#if defined PLATFORM_UNIX
+    if (not_nullptr(m_mapping))
+        (void) ::munmap(m_mapping, m_mapping_size);
+#endif
+
+    m_image.clear();
+    m_mapping = nullptr;
+    m_mapping_size = 0;
+    m_data = nullptr;
+    m_header = nullptr;
+    m_entries = nullptr;
+    m_strings = nullptr;
+}
+
+/**
+ *  Creates the image of a dictionary. The translations are stored as they
+ *  are held, in UTF-8.
+ *
+ * \param dict
+ *      The dictionary to compile.
+ *
+ * \param sourcekey
+ *      A value that identifies the state of the catalogs the dictionary was
+ *      loaded from. It is stored in the header, for source_key().
+ *
+ * \return
+ *      Returns the image, or an empty string if the catalog is too large
+ *      for 32-bit offsets.
+ */
+
+std::string
+flatcatalog::compile (const dictionary & dict, std::uint64_t sourcekey)
+{
+    struct record
+    {
+        std::string key;
+        std::string plural;
+        phraselist msgstrs;
+    };
+    std::vector<record> records;
+    dict.foreach
+    (
+        [&records]
+        (
+            const std::string & msgid,
+            const std::string & msgid_plural,
+            const phraselist & msgstrs
+        )
+        {
+            records.push_back(record{msgid, msgid_plural, msgstrs});
+        }
+    );
+    dict.foreach_ctxt
+    (
+        [&records]
+        (
+            const std::string & ctxt,
+            const std::string & msgid,
+            const std::string & msgid_plural,
+            const phraselist & msgstrs
+        )
+        {
+            records.push_back
+            (
+                record{manifest::make_key(ctxt, msgid), msgid_plural, msgstrs}
+            );
+        }
+    );
+    std::sort
+    (
+        records.begin(), records.end(),
+        [] (const record & a, const record & b)
+        {
+            return a.key < b.key;
+        }
+    );
+
+    std::size_t stringcount = 0;
+    std::size_t textsize = 0;
+    std::string pf = dict.get_plural_forms().descriptor();
+    textsize += pf.size();
+    for (const auto & r : records)
+    {
+        textsize += r.key.size() + r.plural.size();
+        stringcount += r.msgstrs.size();
+        for (const auto & s : r.msgstrs)
+            textsize += s.size();
+    }
+
+    std::size_t entriesoffset = sizeof(header);
+    std::size_t stringsoffset = entriesoffset + records.size() * sizeof(entry);
+    std::size_t textoffset = stringsoffset + stringcount * sizeof(span);
+    std::size_t imagesize = textoffset + textsize;
+    if (imagesize > std::size_t(UINT32_MAX))
+        return std::string();
+
+    std::string result(imagesize, '\0');
+    char * base = &result[0];
+    std::size_t next = textoffset;
+    auto put = [base, &next] (const std::string & s) -> span
+    {
+        span result{std::uint32_t(next), std::uint32_t(s.size())};
+        if (! s.empty())
+            std::memcpy(base + next, s.data(), s.size());
+
+        next += s.size();
+        return result;
+    };
+
+    header h;
+    std::memset(&h, 0, sizeof h);
+    std::memcpy(h.h_magic, c_magic, sizeof c_magic);
+    h.h_version = sm_version;
+    h.h_byte_order = c_byte_order;
+    h.h_size = imagesize;
+    h.h_source_key = sourcekey;
+    h.h_flags = dict.has_fuzzy() ? c_flag_fuzzy : 0 ;
+    h.h_entry_count = std::uint32_t(records.size());
+    h.h_string_count = std::uint32_t(stringcount);
+    h.h_entries = std::uint32_t(entriesoffset);
+    h.h_strings = std::uint32_t(stringsoffset);
+    h.h_plural_forms = put(pf);
+
+    std::size_t stringindex = 0;
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        const record & r = records[i];
+        entry e;
+        e.e_key = put(r.key);
+        e.e_plural = put(r.plural);
+        e.e_first = std::uint32_t(stringindex);
+        e.e_count = std::uint32_t(r.msgstrs.size());
+        for (const auto & s : r.msgstrs)
+        {
+            span sp = put(s);
+            std::memcpy
+            (
+                base + stringsoffset + stringindex * sizeof(span),
+                &sp, sizeof sp
+            );
+            ++stringindex;
+        }
+        std::memcpy(base + entriesoffset + i * sizeof(entry), &e, sizeof e);
+    }
+    h.h_checksum = fnv1a_hash(base + sizeof(header), imagesize - sizeof(header));
+    std::memcpy(base, &h, sizeof h);
+    return result;
+}
+
+/**
+ *  Writes an image so that no reader sees it half-written: it is written to
+ *  a temporary file in the same directory, which is then renamed. If
+ *  several processes publish the same catalog at once, the last rename
+ *  wins, and all of the images are the same anyway. The directory is
+ *  created if needed.
+ */
+
+bool
+flatcatalog::publish
+(
+    const std::string & filename,
+    const std::string & image
+)
+{
+    bool result = ! filename.empty() && ! image.empty();
+    if (result)
+    {
+        std::error_code ec;
+        std::filesystem::path dir = std::filesystem::path(filename).parent_path();
+        if (! dir.empty())
+            (void) std::filesystem::create_directories(dir, ec);
+
+        std::string tmpname = filename + ".tmp";
+#if defined PLATFORM_UNIX
+        tmpname += std::to_string(long(::getpid()));
+#endif
+        std::ofstream out(tmpname, std::ios::binary | std::ios::trunc);
+        result = bool(out);
+        if (result)
+        {
+            (void) out.write(image.data(), std::streamsize(image.size()));
+            out.close();
+            result = bool(out);
+        }
+        if (result)
+            result = std::rename(tmpname.c_str(), filename.c_str()) == 0;
+
+        if (! result)
+            (void) std::remove(tmpname.c_str());
+    }
+    return result;
+}
+
+/**
+ *  Takes a copy of an image, and checks it.
+ *
+ * \return
+ *      Returns true if the image is valid. Otherwise this object is left
+ *      empty.
+ */
+
+bool
+flatcatalog::assign (const std::string & image)
+{
+    clear();
+    m_image = image;
+    bool result = validate(m_image.data(), m_image.size());
+    if (! result)
+        clear();
+
+    return result;
+}
+
+/**
+ *  Maps an image file read-only, and checks it. Where mmap() is not
+ *  available, the file is read into memory instead.
+ */
+
+bool
+flatcatalog::map_file (const std::string & filename)
+{
+    clear();
+
+    bool result = false;
+#if defined PLATFORM_UNIX
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size >= off_t(sizeof(header)))
+        {
+            std::size_t size = std::size_t(st.st_size);
+            void * p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                m_mapping = p;
+                m_mapping_size = size;
+                result = validate(static_cast<const char *>(p), size);
+            }
+        }
+        (void) ::close(fd);
+    }
+#else
+    std::string image;
+    if (read_file(filename, image))
+    {
+        m_image = std::move(image);
+        result = validate(m_image.data(), m_image.size());
+    }
+#endif
+    if (! result)
+        clear();
+
+    return result;
+}
+
+/**
+ *  Checks an image before any of it is used: the magic, version, byte
+ *  order, size, checksum, and the bounds of every table and string. If it
+ *  passes, the table pointers are set.
+ */
+
+bool
+flatcatalog::validate (const char * data, std::size_t size)
+{
+    if (is_nullptr(data) || size < sizeof(header))
+        return false;
+
+    header h;
+    std::memcpy(&h, data, sizeof h);
+    if (std::memcmp(h.h_magic, c_magic, sizeof c_magic) != 0)
+        return false;
+
+    if (h.h_version != sm_version || h.h_byte_order != c_byte_order)
+        return false;
+
+    if (h.h_size != size)
+        return false;
+
+    std::uint64_t entriesend =
+        std::uint64_t(h.h_entries) + std::uint64_t(h.h_entry_count) * sizeof(entry);
+
+    std::uint64_t stringsend =
+        std::uint64_t(h.h_strings) + std::uint64_t(h.h_string_count) * sizeof(span);
+
+    if (h.h_entries < sizeof(header) || entriesend > size)
+        return false;
+
+    if (h.h_strings < sizeof(header) || stringsend > size)
+        return false;
+
+    if ((h.h_entries % alignof(entry)) != 0 || (h.h_strings % alignof(span)) != 0)
+        return false;
+
+    auto inbounds = [size] (const span & s)
+    {
+        return std::uint64_t(s.s_offset) + s.s_size <= size;
+    };
+    if (! inbounds(h.h_plural_forms))
+        return false;
+
+    if (fnv1a_hash(data + sizeof(header), size - sizeof(header)) != h.h_checksum)
+        return false;
+
+    const entry * entries = reinterpret_cast<const entry *>(data + h.h_entries);
+    const span * strings = reinterpret_cast<const span *>(data + h.h_strings);
+    for (std::uint32_t i = 0; i < h.h_entry_count; ++i)
+    {
+        const entry & e = entries[i];
+        if (! inbounds(e.e_key) || ! inbounds(e.e_plural))
+            return false;
+
+        if (std::uint64_t(e.e_first) + e.e_count > h.h_string_count)
+            return false;
+    }
+    for (std::uint32_t i = 0; i < h.h_string_count; ++i)
+    {
+        if (! inbounds(strings[i]))
+            return false;
+    }
+    m_data = data;
+    m_header = reinterpret_cast<const header *>(data);
+    m_entries = entries;
+    m_strings = strings;
+    return true;
+}
+
+/**
+ *  Indicates if some text lies in the image, as the strings returned by
+ *  msgstr() do.
+ */
+
+bool
+flatcatalog::holds (const char * text) const
+{
+    std::less<const char *> before;
+    return valid() && ! before(text, m_data) && before(text, m_data + size());
+}
+
+bool
+flatcatalog::has_fuzzy () const
+{
+    return valid() && (m_header->h_flags & c_flag_fuzzy) != 0;
+}
+
+std::string
+flatcatalog::plural_forms () const
+{
+    return valid() ? std::string(text(m_header->h_plural_forms)) : std::string() ;
+}
+
+/**
+ *  Reads a byte of each page of the image, so that the pages of a mapped
+ *  image are in memory before a lookup needs them. The system may still
+ *  page them out later, unless they are locked with mlock().
+ *
+ * \return
+ *      Returns the number of pages read.
+ */
+
+std::size_t
+flatcatalog::prefault () const
+{
+    const std::size_t pagesize = 4096;
+    std::size_t pages = 0;
+    volatile char sink = 0;
+    for (std::size_t offset = 0; offset < size(); offset += pagesize)
+    {
+        sink = sink + m_data[offset];
+        ++pages;
+    }
+    return pages;
+}
+
+/**
+ *  Compares a key of the image to the key of a lookup, without building
+ *  the latter (msgctxt, EOT, msgid) as a string.
+ *
+ * \return
+ *      Returns a value less than, equal to, or greater than 0, as
+ *      std::string::compare() does.
+ */
+
+static int
+compare_key
+(
+    std::string_view key,
+    std::string_view msgctxt,
+    bool has_ctxt,
+    std::string_view msgid
+)
+{
+    if (has_ctxt)
+    {
+        int c = key.compare(0, msgctxt.size(), msgctxt);
+        if (c != 0)
+            return c;
+
+        if (key.size() == msgctxt.size())
+            return -1;
+
+        unsigned char sep = static_cast<unsigned char>(key[msgctxt.size()]);
+        if (sep != c_ctxt_separator)
+            return sep < c_ctxt_separator ? -1 : 1 ;
+
+        key.remove_prefix(msgctxt.size() + 1);
+    }
+    return key.compare(msgid);
+}
+
+std::size_t
+flatcatalog::find_key
+(
+    std::string_view msgctxt,
+    bool has_ctxt,
+    std::string_view msgid
+) const
+{
+    if (! valid())
+        return npos;
+
+    std::size_t low = 0;
+    std::size_t high = std::size_t(m_header->h_entry_count);
+    while (low < high)
+    {
+        std::size_t mid = low + (high - low) / 2;
+        int c = compare_key(text(m_entries[mid].e_key), msgctxt, has_ctxt, msgid);
+        if (c == 0)
+            return mid;
+        else if (c < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return npos;
+}
+
+/**
+ *  Finds a message by binary search of the sorted keys. No memory is
+ *  allocated.
+ *
+ * \return
+ *      Returns the index of the entry, or npos if it is not found.
+ */
+
+std::size_t
+flatcatalog::lookup (std::string_view msgid) const
+{
+    return find_key(std::string_view(), false, msgid);
+}
+
+std::size_t
+flatcatalog::lookup
+(
+    std::string_view msgctxt,
+    std::string_view msgid
+) const
+{
+    return find_key(msgctxt, true, msgid);
+}
+
+std::size_t
+flatcatalog::msgstr_count (std::size_t index) const
+{
+    return index < entry_count() ? std::size_t(m_entries[index].e_count) : 0 ;
+}
+
+/**
+ *  Gets translation \a n of an entry; an empty view if there is none.
+ */
+
+std::string_view
+flatcatalog::msgstr (std::size_t index, std::size_t n) const
+{
+    if (n < msgstr_count(index))
+        return text(m_strings[m_entries[index].e_first + n]);
+
+    return std::string_view();
+}
+
+/**
+ *  Gets the key of an entry: the msgid, or the msgctxt, an EOT, and the
+ *  msgid. The keys are in sorted order, so this can be used to iterate
+ *  over the messages.
+ */
+
+std::string_view
+flatcatalog::key (std::size_t index) const
+{
+    if (index < entry_count())
+        return text(m_entries[index].e_key);
+
+    return std::string_view();
+}
+
+std::string_view
+flatcatalog::msgid_plural (std::size_t index) const
+{
+    if (index < entry_count())
+        return text(m_entries[index].e_plural);
+
+    return std::string_view();
+}
+
+}               // namespace po
+
+/*
+ * flatcatalog.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -31,7 +31,7 @@
  * \library       potext
  * \author        Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-05
+ * \updates       2026-10-18
  * \license       See above.
  *
  *  https://www.gnu.org/software/gettext/manual/ provides a 300-page manual in
@@ -97,18 +97,24 @@
 
 #include <cerrno>                       /* errno                            */
 #include <climits>                      /* PATH_MAX                         */
+#include <atomic>                       /* std::atomic<>                    */
 #include <clocale>                      /* std::setlocale()                 */
 #include <codecvt>                      /* std::codecvt()                   */
 #include <cstdlib>                      /* std::getenv()                    */
 #include <cstring>                      /* std::strerror()                  */
 #include <locale>                       /* std::wstring_convert<>           */
 #include <map>                          /* std::map<>                       */
+#include <mutex>                        /* std::lock_guard<>                */
+#include <shared_mutex>                 /* std::shared_lock<>               */
 
 #include "c_macros.h"                   /* not_nullptr(), etc.              */
 #include "po/dictionarymgr.hpp"         /* po::dictionary, mgr, etc.        */
 #include "po/gettext.hpp"               /* external gettext-related funcs   */
 #include "po/logstream.hpp"             /* po::logstream::info(), etc.      */
+#include "po/msgidtable.hpp"            /* po::msgidtable class             */
 #include "po/nlsbindings.hpp"           /* po::nlsbindings class            */
+#include "po/snapshotring.hpp"          /* po::snapshotring<> template      */
+#include "po/tracerecorder.hpp"         /* po::tracerecorder class          */
 #include "po/wstrfunctions.hpp"         /* po::wide-to-narrow functions     */
 
 /**
@@ -216,7 +222,6 @@ category_to_name (LC lc)
  *  These are being modified to use the dictionarymgr as much as possible.
  */
 
-static dictionarymgr & dictionary_manager (const std::string & chset = "");
 static dir_type directory_type (dir_type dt = dir_type::none);
 static dir_type analyze_directory_type (const std::string & dirname);
 static std::string installed_prefix (const std::string & arg0);
@@ -266,11 +271,11 @@ static bool use_mo_mode ()
 static dir_type
 directory_type (dir_type dt)
 {
-    static dir_type s_dir_type = dir_type::none;
+    static std::atomic<dir_type> s_dir_type{dir_type::none};
     if (dt != dir_type::none)
-        s_dir_type = dt;
+        s_dir_type.store(dt);
 
-    return s_dir_type;
+    return s_dir_type.load();
 }
 
 /**
@@ -465,24 +470,116 @@ installed_po_path
 /**
  *  Provides a single dictionary for basic and simple usage of po::gettext().
  *  Uses the default character set, UTF-8.
+ *
+ *  It is public so that an application can change the language, the
+ *  search path, and the like while other threads call the functions
+ *  below. They hold its mutex(), shared, while they look up and translate.
  */
 
-static dictionarymgr &
+dictionarymgr &
 dictionary_manager (const std::string & chset)
 {
     static dictionarymgr s_dictionarymgr;
+    static bool s_traced = tracerecorder::start_from_environment();
+    (void) s_traced;
     if (! chset.empty())
         s_dictionarymgr.set_charset(chset);
 
     return s_dictionarymgr;
 }
 
+/**
+ *  The locks the public functions of this module hold, so that the
+ *  dictionary they get stays valid until they are done with it. The
+ *  lookups share the lock, and take it exclusively only to load a catalog.
+ */
+
+using modulelock = std::lock_guard<sharedmutex>;
+using sharedlock = std::shared_lock<sharedmutex>;
+
 static dictionary &
 main_dictionary ()
 {
     return dictionary_manager().get_dictionary();
 }
 
+/**
+ *  Gets the codeset bound to a domain, or to the current domain. An empty
+ *  result selects the charset of the dictionary manager.
+ */
+
+static std::string
+domain_codeset (const std::string & domainname)
+{
+    return dictionary_manager().domain_codeset(domainname);
+}
+
+static std::string
+main_codeset ()
+{
+    dictionarymgr & dm = dictionary_manager();
+    return dm.domain_codeset(dm.current_domain());
+}
+
+/**
+ *  Translates with the main dictionary and its codeset. If the dictionary
+ *  is loaded, which is nearly always so, the lookup shares the lock with
+ *  the others, and they run in parallel. Otherwise the lock is taken
+ *  exclusively, and the dictionary is loaded.
+ *
+ * \param translate
+ *      Called with the dictionary and the codeset.
+ */
+
+template <typename TRANSLATE>
+static std::string
+translate_main (TRANSLATE translate)
+{
+    dictionarymgr & dm = dictionary_manager();
+    {
+        std::string codeset;
+        sharedlock lock(dm.mutex());
+        const dictionary * dict = dm.find_dictionary(codeset);
+        if (not_nullptr(dict))
+            return translate(*dict, codeset);
+    }
+    modulelock lock(dm.mutex());
+    return translate(main_dictionary(), main_codeset());
+}
+
+/**
+ *  The translate_main() of the functions given a domain. See
+ *  dictionarymgr::get_domain_dictionary().
+ *
+ * \return
+ *      Returns \a msgid if the domain has no dictionary.
+ */
+
+template <typename TRANSLATE>
+static std::string
+translate_domain
+(
+    const std::string & domainname,
+    const std::string & msgid,
+    TRANSLATE translate
+)
+{
+    dictionarymgr & dm = dictionary_manager();
+    {
+        std::string codeset;
+        sharedlock lock(dm.mutex());
+        const dictionary * dict =
+            dm.find_domain_dictionary(domainname, codeset);
+
+        if (not_nullptr(dict))
+            return dict->empty() ? msgid : translate(*dict, codeset) ;
+    }
+    modulelock lock(dm.mutex());
+    const dictionary & dict = dm.get_domain_dictionary(domainname);
+    return dict.empty() ?
+        msgid : translate(dict, domain_codeset(domainname)) ;
+}
+
 /**
  *  Gets the user's $HOME (Linux) or $LOCALAPPDAT (Windows) directory from the
  *  current environment.
@@ -688,18 +785,22 @@ set_locale_info
 std::string
 gettext (const std::string & msgid)
 {
+    if (tracerecorder::active())
+        tracerecorder::record(tracekind::gettext, "", "", msgid);
+
     if (directory_type() == dir_type::none)
     {
         return msgid;
     }
     else
     {
-        /*
-         * dictionary_manager().get_dictionary();
-         */
-
-        const dictionary & dict = main_dictionary();
-        return dict.translate(msgid);
+        return translate_main
+        (
+            [&msgid] (const dictionary & dict, const std::string & codeset)
+            {
+                return dict.translate(msgid, codeset);
+            }
+        );
     }
 }
 
@@ -717,10 +818,8 @@ gettext (const std::string & msgid)
 
 /**
  *  This function looks up a message in a different domain from the current
- *  one set by textdomain().
- *
- *  We need a dictionarymgr function that looks up a dictionary matching
- *  the domainname.
+ *  one set by textdomain(). See dictionarymgr::get_domain_dictionary() for
+ *  how the domain name is resolved.
  */
 
 std::string
@@ -730,16 +829,23 @@ dgettext
     const std::string & msgid
 )
 {
+    if (tracerecorder::active())
+        tracerecorder::record(tracekind::dgettext, domainname, "", msgid);
+
     if (directory_type() == dir_type::none)
     {
         return msgid;
     }
     else
     {
-        const dictionary & dict =
-            dictionary_manager().get_dictionary(domainname);
-
-        return dict.empty() ? msgid : dict.translate(msgid) ;
+        return translate_domain
+        (
+            domainname, msgid,
+            [&msgid] (const dictionary & dict, const std::string & codeset)
+            {
+                return dict.translate(msgid, codeset);
+            }
+        );
     }
 }
 
@@ -793,14 +899,22 @@ ngettext
    unsigned long N
 )
 {
+    if (tracerecorder::active())
+        tracerecorder::record(tracekind::ngettext, "", "", msgid, msgid2, N);
+
     if (directory_type() == dir_type::none)
     {
         return msgid;
     }
     else
     {
-        const dictionary & dict = main_dictionary();
-        return dict.translate_plural(msgid, msgid2, N);
+        return translate_main
+        (
+            [&] (const dictionary & dict, const std::string & codeset)
+            {
+                return dict.translate_plural(msgid, msgid2, N, codeset);
+            }
+        );
     }
 }
 
@@ -819,16 +933,28 @@ dngettext
    unsigned long n
 )
 {
+    if (tracerecorder::active())
+    {
+        tracerecorder::record
+        (
+            tracekind::dngettext, domainname, "", msgid, msgid2, n
+        );
+    }
+
     if (directory_type() == dir_type::none)
     {
         return msgid;
     }
     else
     {
-        const dictionary & dict =
-            dictionary_manager().get_dictionary(domainname);
-
-        return dict.empty() ? msgid : dict.translate_plural(msgid, msgid2, n);
+        return translate_domain
+        (
+            domainname, msgid,
+            [&] (const dictionary & dict, const std::string & codeset)
+            {
+                return dict.translate_plural(msgid, msgid2, n, codeset);
+            }
+        );
     }
 }
 
@@ -847,16 +973,28 @@ dcngettext
    int /* category */                   /* TODO */
 )
 {
+    if (tracerecorder::active())
+    {
+        tracerecorder::record
+        (
+            tracekind::dngettext, domainname, "", msgid, msgid2, n
+        );
+    }
+
     if (directory_type() == dir_type::none)
     {
         return msgid;
     }
     else
     {
-        const dictionary & dict =
-            dictionary_manager().get_dictionary(domainname);
-
-        return dict.empty() ? msgid : dict.translate_plural(msgid, msgid2, n);
+        return translate_domain
+        (
+            domainname, msgid,
+            [&] (const dictionary & dict, const std::string & codeset)
+            {
+                return dict.translate_plural(msgid, msgid2, n, codeset);
+            }
+        );
     }
 }
 
@@ -887,14 +1025,22 @@ pgettext
    const std::string & msgid
 )
 {
+    if (tracerecorder::active())
+        tracerecorder::record(tracekind::pgettext, "", msgctxt, msgid);
+
     if (directory_type() == dir_type::none)
     {
         return msgid;
     }
     else
     {
-        const dictionary & dict = main_dictionary();
-        return dict.translate_ctxt(msgctxt, msgid);
+        return translate_main
+        (
+            [&] (const dictionary & dict, const std::string & codeset)
+            {
+                return dict.translate_ctxt(msgctxt, msgid, codeset);
+            }
+        );
     }
 }
 
@@ -910,16 +1056,28 @@ dpgettext
    const std::string & msgid
 )
 {
+    if (tracerecorder::active())
+    {
+        tracerecorder::record
+        (
+            tracekind::dpgettext, domainname, msgctxt, msgid
+        );
+    }
+
     if (directory_type() == dir_type::none)
     {
         return msgid;
     }
     else
     {
-        const dictionary & dict =
-            dictionary_manager().get_dictionary(domainname);
-
-        return dict.empty() ? msgid : dict.translate_ctxt(msgctxt, msgid);
+        return translate_domain
+        (
+            domainname, msgid,
+            [&] (const dictionary & dict, const std::string & codeset)
+            {
+                return dict.translate_ctxt(msgctxt, msgid, codeset);
+            }
+        );
     }
 }
 
@@ -937,16 +1095,28 @@ dcpgettext
    int /* category */
 )
 {
+    if (tracerecorder::active())
+    {
+        tracerecorder::record
+        (
+            tracekind::dpgettext, domainname, msgctxt, msgid
+        );
+    }
+
     if (directory_type() == dir_type::none)
     {
         return msgid;
     }
     else
     {
-        const dictionary & dict =
-            dictionary_manager().get_dictionary(domainname);
-
-        return dict.empty() ? msgid : dict.translate_ctxt(msgctxt, msgid);
+        return translate_domain
+        (
+            domainname, msgid,
+            [&] (const dictionary & dict, const std::string & codeset)
+            {
+                return dict.translate_ctxt(msgctxt, msgid, codeset);
+            }
+        );
     }
 }
 
@@ -1033,6 +1203,226 @@ init_gettext ()
 
 #if defined POTEXT_ENABLE_I18N
 
+/**
+ *  The number of generated key tables (say, of an application and of the
+ *  libraries it uses) that idgettext() keeps translations of. Each has a
+ *  ring of its own, so they do not evict each other. Any more share the
+ *  last ring, and rebuild their tables when they take turns.
+ */
+
+static const std::size_t c_key_tables = 8;
+
+/**
+ *  The translations of a key table used by idgettext(). A rebuild makes
+ *  a new table, so a reference into an older one stays valid until the
+ *  ring frees it (see snapshotring.hpp). The key table is set once, under
+ *  the exclusive lock of the dictionary manager, and then read without
+ *  locking.
+ */
+
+struct msgidslot
+{
+    std::atomic<const char * const *> ms_keys{nullptr};
+    snapshotring<msgidtable> ms_snapshots;
+};
+
+static msgidslot *
+msgid_slots ()
+{
+    static msgidslot s_slots[c_key_tables];
+    return s_slots;
+}
+
+/**
+ *  Finds the translations of a key table, without locking.
+ *
+ * \return
+ *      Returns null if the key table has no slot yet, or has to share
+ *      the last one.
+ */
+
+static const snapshotring<msgidtable> *
+find_msgid_snapshots (const char * const * keys)
+{
+    msgidslot * slots = msgid_slots();
+    for (std::size_t i = 0; i < c_key_tables; ++i)
+    {
+        const char * const * k = slots[i].ms_keys.load
+        (
+            std::memory_order_acquire
+        );
+        if (k == keys)
+            return &slots[i].ms_snapshots;
+        else if (is_nullptr(k))
+            break;
+    }
+    return nullptr;
+}
+
+/**
+ *  Gets the translations of a key table, taking a free slot for it if it
+ *  has none. The caller holds the exclusive lock of the manager.
+ */
+
+static snapshotring<msgidtable> &
+msgid_snapshots (const char * const * keys)
+{
+    msgidslot * slots = msgid_slots();
+    for (std::size_t i = 0; i < c_key_tables; ++i)
+    {
+        const char * const * k = slots[i].ms_keys.load
+        (
+            std::memory_order_relaxed
+        );
+        if (is_nullptr(k))
+            slots[i].ms_keys.store(keys, std::memory_order_release);
+        else if (k != keys)
+            continue;
+
+        return slots[i].ms_snapshots;
+    }
+    return slots[c_key_tables - 1].ms_snapshots;
+}
+
+/**
+ *  Builds the translations of a key table for the current state of the
+ *  dictionary manager, unless another thread has just done so.
+ */
+
+static const msgidtable *
+rebuild_msgid_table (const char * const * keys, std::size_t count)
+{
+    dictionarymgr & dm = dictionary_manager();
+    modulelock lock(dm.mutex());
+    const dictionary * dict = directory_type() == dir_type::none ?
+        nullptr : &main_dictionary() ;
+
+    unsigned long generation = dm.generation();     /* after any loading    */
+    snapshotring<msgidtable> & ring = msgid_snapshots(keys);
+    const msgidtable * current = ring.current();
+    if
+    (
+        not_nullptr(current) && current->keys() == keys &&
+        current->generation() == generation
+    )
+    {
+        return current;
+    }
+
+    std::unique_ptr<msgidtable> table(new msgidtable());
+    table->assign(keys, count);
+    table->build(dict, generation, main_codeset());
+    return ring.publish(std::move(table));
+}
+
+/**
+ *  Looks up a key missing from a stale generated header. Each key has a
+ *  string of its own in the calling thread, so that two such lookups in
+ *  one expression do not share one. The string is changed only when the
+ *  translation does.
+ */
+
+static const std::string &
+fallback_gettext (const char * key)
+{
+    static thread_local std::map<std::string, std::string> s_fallbacks;
+    std::string tr;
+    const char * eot = std::strchr(key, '\004');
+    if (not_nullptr(eot))
+    {
+        std::string ctxt(key, std::size_t(eot - key));
+        tr = pgettext(ctxt, std::string(eot + 1));
+    }
+    else
+        tr = gettext(std::string(key));
+
+    std::string & result = s_fallbacks[key];
+    if (result != tr)
+        result = tr;
+
+    return result;
+}
+
+/**
+ *  The lookup behind the _() and C_() macros in integer message-ID mode
+ *  (see msgidtable.hpp). The translations are kept in an immutable table
+ *  for each key table and dictionary manager generation, reached through
+ *  atomic pointers, so a lookup takes no lock: it is a scan of the few key
+ *  tables, an atomic load, a comparison with the generation, and an array
+ *  access. Only the first lookup after a change of language or catalogs
+ *  builds a new table.
+ *
+ *  The returned reference points into that table, which the calling thread
+ *  holds (see snapshotring.hpp). It stays valid until the ring has had
+ *  depth() - 1 newer tables and the thread has read snapshotholds::sm_held
+ *  newer ones; so at least until the thread calls idgettext() again after
+ *  a change of language or catalogs. Keep a copy if it has to live longer.
+ *  For a key missing from a stale header, it is a string the calling thread
+ *  keeps for that key (see fallback_gettext()).
+ *
+ * \param keys
+ *      The generated key table.
+ *
+ * \param count
+ *      The number of keys in the table.
+ *
+ * \param id
+ *      The compile-time ID of the key, or msgid_none if the generated
+ *      header is out of date and lacks it.
+ *
+ * \param key
+ *      The message ID, or the context, "\004", and the message ID.
+ *
+ * \return
+ *      Returns the translation (or the message ID if not translated).
+ */
+
+const std::string &
+idgettext
+(
+    const char * const * keys,
+    std::size_t count,
+    std::size_t id,
+    const char * key
+)
+{
+    if (id >= count)                            /* stale generated header   */
+        return fallback_gettext(key);
+
+    if (tracerecorder::active())
+    {
+        const char * eot = std::strchr(key, '\004');
+        if (not_nullptr(eot))
+        {
+            std::string ctxt(key, std::size_t(eot - key));
+            tracerecorder::record(tracekind::idgettext, "", ctxt, eot + 1);
+        }
+        else
+            tracerecorder::record(tracekind::idgettext, "", "", key);
+    }
+
+    const snapshotring<msgidtable> * ring = find_msgid_snapshots(keys);
+    const msgidtable * table = not_nullptr(ring) ? ring->current() : nullptr ;
+    if
+    (
+        is_nullptr(table) || table->keys() != keys ||
+        table->generation() != dictionary_manager().generation()
+    )
+    {
+        table = rebuild_msgid_table(keys, count);
+    }
+#if defined PLATFORM_DEBUG
+    if (msgid_compare(table->key(id), key) != 0)
+    {
+        logstream::error()
+            << "idgettext(): ID " << id << " is '" << table->key(id)
+            << "', not '" << key << "'" << std::endl
+            ;
+    }
+#endif
+    return table->at(id);
+}
+
 /**
  *  See dictionarymgr::textdomain().
  */
@@ -1040,6 +1430,7 @@ init_gettext ()
 std::string
 textdomain (const std::string & domainname)
 {
+    modulelock lock(dictionary_manager().mutex());
     return dictionary_manager().textdomain(domainname);
 }
 
@@ -1054,6 +1445,7 @@ bindtextdomain
     const std::string & dirname
 )
 {
+    modulelock lock(dictionary_manager().mutex());
     return dictionary_manager().bindtextdomain(domainname, dirname);
 }
 
@@ -1064,6 +1456,7 @@ bind_textdomain_codeset
     const std::string & codeset
 )
 {
+    modulelock lock(dictionary_manager().mutex());
     return dictionary_manager().bind_textdomain_codeset(domainname, codeset);
 }
 
@@ -1139,6 +1532,7 @@ init_lib_locale
     const std::wstring & wdirname       /* optional wide-string format      */
 )
 {
+    modulelock lock(dictionary_manager().mutex());
     std::string result;
     bool ok = ! domainname.empty();
     if (ok)
@@ -1271,6 +1665,7 @@ init_app_locale
     int category                        /* optional locale category (LC)    */
 )
 {
+    modulelock lock(dictionary_manager().mutex());
     std::string result;
 #if defined USE_INIT_GETTEXT
     (void) init_gettext();              /* guarantee the static defaults    */
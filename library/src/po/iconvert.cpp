@@ -53,6 +53,7 @@
 #include "c_macros.h"                   /* is_nullptr() macro               */
 #include "po/iconvert.hpp"              /* po::iconvert (iconv) class       */
 #include "po/logstream.hpp"             /* po::logstream::error() etc.      */
+#include "po/probes.hpp"                /* POTEXT_PROBE4()                  */
 
 #if defined POTEXT_FLUXBOX_RECODE_FUNCTION
 #include <vector>                       /* std::vector for output array     */
@@ -105,14 +106,16 @@ iconv_error ()
 }
 
 /**
- *  Constructors and destructor.
+ *  Constructors and destructor. Until set_charsets() is called, there is
+ *  no descriptor, so conversion is disabled; a catalog without a header
+ *  used to pass a null descriptor to iconv().
  */
 
 iconvert::iconvert (const std::string & filename) :
     m_filename              (filename),
     m_to_charset            (),
     m_from_charset          (),
-    m_conversion_disabled   (false),
+    m_conversion_disabled   (true),
     m_conversion_descriptor (nullptr)
 {
     // no code
@@ -182,9 +185,11 @@ iconvert::set_charsets
         (
             m_to_charset.c_str(), m_from_charset.c_str()
         );
+        m_conversion_disabled = false;
         if (m_conversion_descriptor == reinterpret_cast<iconv_t>(-1))
         {
             result = false;
+            m_conversion_descriptor = nullptr;      /* nothing to close     */
             m_conversion_disabled = true;
             if (errno == EINVAL)
             {
@@ -281,6 +286,12 @@ iconvert::convert (const std::string & text) const
                 std::string location = m_filename.empty() ?
                     "convert()" : m_filename ;
 
+                POTEXT_PROBE4
+                (
+                    convert__failure, m_filename.c_str(),
+                    m_from_charset.c_str(), m_to_charset.c_str(),
+                    std::size_t(inbuf - text.data())
+                );
                 po::iconv
                 (
                     m_conversion_descriptor, nullptr, nullptr,
@@ -406,6 +417,10 @@ iconv_close (iconv_t cd)
  *  then you need to set your locale to something UTF-8 or something
  *  ISO8859-1.
  *
+ *  Invalid bytes are skipped. Only the first is reported, since each
+ *  report holds the whole string, and reporting every byte of a binary
+ *  string made the log grow with the square of its length.
+ *
  * \param cd
  *      Provides the iconv type code descriptor.
  *
@@ -437,6 +452,7 @@ iconvert::recode (iconv_t cd, const std::string & in) const
             const char * in_ptr = in.data();
             char * out_ptr = &out[0];
             size_t rc = iconv_error();
+            size_t badcount = 0;            /* report the first one only    */
             bool again = true;
             while (again)
             {
@@ -469,26 +485,46 @@ iconvert::recode (iconv_t cd, const std::string & in) const
 
                     case EILSEQ:                /* try skipping a byte      */
 
+                        POTEXT_PROBE4
+                        (
+                            convert__failure, m_filename.c_str(),
+                            m_from_charset.c_str(), m_to_charset.c_str(),
+                            errindex
+                        );
                         ++in_ptr;
                         --inbytesleft;
                         again = true;
-                        po::logstream::error()
-                            << _("error") << ": " << location << ":\n"
-                            << _("invalid multibyte sequence in") << ": \""
-                            << in << "\" @" << errindex << std::endl
-                            ;
+                        if (badcount++ == 0)
+                        {
+                            po::logstream::error()
+                                << _("error") << ": " << location << ":\n"
+                                << _("invalid multibyte sequence in")
+                                << ": \"" << in << "\" @" << errindex
+                                << std::endl
+                                ;
+                        }
                         break;
 
                     case EINVAL:
 
+                        POTEXT_PROBE4
+                        (
+                            convert__failure, m_filename.c_str(),
+                            m_from_charset.c_str(), m_to_charset.c_str(),
+                            errindex
+                        );
                         ++in_ptr;
                         --inbytesleft;
                         again = true;
-                        po::logstream::error()
-                            << _("error") << ": " << location << ":\n"
-                            << _("incomplete multibyte sequence in") << ": \""
-                            << in << "\" @" << errindex << std::endl
-                            ;
+                        if (badcount++ == 0)
+                        {
+                            po::logstream::error()
+                                << _("error") << ": " << location << ":\n"
+                                << _("incomplete multibyte sequence in")
+                                << ": \"" << in << "\" @" << errindex
+                                << std::endl
+                                ;
+                        }
                         break;
 
                     case E2BIG:                 /* need more space!         */
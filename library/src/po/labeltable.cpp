@@ -0,0 +1,192 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          labeltable.cpp
+ *
+ *      Translated copies of static tables of N_() strings.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  See the banner of labeltable.hpp.
+ */
+
+#include "c_macros.h"                   /* not_nullptr() macro              */
+#include "po/dictionarymgr.hpp"         /* po::dictionarymgr class          */
+#include "po/labeltable.hpp"            /* po::labeltable class             */
+
+namespace po
+{
+
+/**
+ *  Registers a table and translates it for the current state of the
+ *  dictionarymgr.
+ *
+ * \param mgr
+ *      The manager to get the translations from. It must outlive this
+ *      object.
+ *
+ * \param msgids
+ *      The table of message IDs, usually marked with N_(). It must outlive
+ *      this object.
+ *
+ * \param count
+ *      The number of message IDs in the table.
+ *
+ * \param msgctxt
+ *      The context of all the message IDs, or empty for none.
+ *
+ * \param domain
+ *      The text domain to translate in. If empty, the current domain is
+ *      used, and a change of domain translates the table again.
+ */
+
+labeltable::labeltable
+(
+    dictionarymgr & mgr,
+    const char * const * msgids,
+    std::size_t count,
+    const std::string & msgctxt,
+    const std::string & domain
+) :
+    m_manager   (mgr),
+    m_msgids    (msgids),
+    m_count     (count),
+    m_msgctxt   (msgctxt),
+    m_domain    (domain),
+    m_mutex     (),
+    m_snapshots ()
+{
+    refresh();
+}
+
+/**
+ *  Returns the current snapshot, refreshing it first if the dictionarymgr
+ *  generation has moved on. In the usual case this is two atomic loads
+ *  and a check that the thread holds the snapshot; no lock is taken.
+ */
+
+const labeltable::snapshot *
+labeltable::current ()
+{
+    const snapshot * result = m_snapshots.current();
+    if (result->s_generation != m_manager.generation())
+    {
+        refresh();
+        result = m_snapshots.current();
+    }
+    return result;
+}
+
+/**
+ *  Translates the table again, if the dictionarymgr generation differs
+ *  from that of the current snapshot. The manager's mutex is taken first,
+ *  so that a thread already holding it (e.g. in a gettext function) does
+ *  not take the two locks in the other order.
+ */
+
+void
+labeltable::refresh ()
+{
+    std::lock_guard<sharedmutex> mgrlock(m_manager.mutex());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const dictionary & dict = m_domain.empty() ?
+        m_manager.get_dictionary() :
+        m_manager.get_domain_dictionary(m_domain) ;
+
+    /*
+     * Getting the dictionary can load catalogs, and so bump the generation;
+     * read it afterward.
+     */
+
+    unsigned long generation = m_manager.generation();
+    const snapshot * old = m_snapshots.current();
+    if (not_nullptr(old) && old->s_generation == generation)
+        return;                             /* another thread did it    */
+
+    const std::string & domainname = m_domain.empty() ?
+        m_manager.current_domain() : m_domain ;
+
+    std::string codeset = m_manager.domain_codeset(domainname);
+    (void) m_snapshots.publish(translate(dict, codeset, generation));
+}
+
+/**
+ *  Looks up every message ID once, and packs the translations into one
+ *  string. The views are made only after the string is complete, since
+ *  appending to it can move it.
+ */
+
+std::unique_ptr<labeltable::snapshot>
+labeltable::translate
+(
+    const dictionary & dict,
+    const std::string & codeset,
+    unsigned long generation
+) const
+{
+    std::unique_ptr<snapshot> result(new snapshot);
+    std::vector<std::size_t> ends;
+    ends.reserve(m_count);
+    result->s_generation = generation;
+    for (std::size_t i = 0; i < m_count; ++i)
+    {
+        const char * msgid = m_msgids[i];
+        std::string_view msgstr;
+        if (not_nullptr(msgid) && msgid[0] != 0)    /* "" is the header */
+        {
+            msgstr = m_msgctxt.empty() ?
+                dict.find_view(std::string(msgid)) :
+                dict.find_ctxt_view(m_msgctxt, std::string(msgid)) ;
+        }
+        if (! msgstr.empty())
+            result->s_text += dict.converted_view(msgstr, codeset);
+        else if (not_nullptr(msgid))
+            result->s_text += msgid;
+
+        ends.push_back(result->s_text.size());
+    }
+    result->s_labels.reserve(m_count);
+
+    std::string_view text = result->s_text;
+    std::size_t start = 0;
+    for (std::size_t end : ends)
+    {
+        result->s_labels.push_back(text.substr(start, end - start));
+        start = end;
+    }
+    return result;
+}
+
+}               // namespace po
+
+/*
+ * labeltable.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -30,7 +30,7 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-03-04
+ * \updates       2026-10-18
  * \license       See above.
  *
  */
@@ -83,17 +83,19 @@ language::from_spec
     using languagespeclist = std::vector<const languagespec *>;
     using languagespecmap = std::unordered_map<std::string, languagespeclist>;
 
-    static languagespecmap s_language_map;
-    if (s_language_map.empty())               /* initialize s_language_map  */
+    static const languagespecmap s_language_map = [] ()
     {
+        languagespecmap result;             /* built once, by one thread    */
         for (int i = 0; ! s_languages[i].language.empty(); ++i)
-            s_language_map[s_languages[i].language].push_back(&s_languages[i]);
-    }
+            result[s_languages[i].language].push_back(&s_languages[i]);
+
+        return result;
+    }();
 
-    languagespecmap::iterator i = s_language_map.find(lang);
+    languagespecmap::const_iterator i = s_language_map.find(lang);
     if (i != s_language_map.end())
     {
-        languagespeclist & lst = i->second;
+        const languagespeclist & lst = i->second;
         languagespec tmpspec;
         tmpspec.language = lang;
         tmpspec.country  = country;
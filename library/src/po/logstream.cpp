@@ -30,7 +30,7 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-03-16
+ * \updates       2026-10-18
  * \license       See above.
  *
  */
@@ -223,19 +223,23 @@ logstream::callbacks_reset ()
  *
  *  Interestingly, all the std::cout and std::cerr output is shown to the
  *  console before all of the logstream output is shown.
+ *
+ *  Each thread has its own streams, as lookups in several threads at once
+ *  can log their misses; a thread's output is passed to the callback when
+ *  the thread ends.
  */
 
 std::ostream &
 logstream::info ()
 {
-    static logstream s_stream(logstream::sm_info_callback);
+    static thread_local logstream s_stream(logstream::sm_info_callback);
     return s_stream.get();
 }
 
 std::ostream &
 logstream::warning ()
 {
-    static logstream s_stream(logstream::sm_warning_callback);
+    static thread_local logstream s_stream(logstream::sm_warning_callback);
     return s_stream.get();
 }
 
@@ -256,7 +260,7 @@ logstream::error ()
     }
     else
     {
-        static logstream s_stream(logstream::sm_error_callback);
+        static thread_local logstream s_stream(logstream::sm_error_callback);
         return s_stream.get();
     }
 }
@@ -0,0 +1,338 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          manifest.cpp
+ *
+ *      Provides the set of message IDs that an application actually uses.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  See the banner in manifest.hpp for the supported file formats.
+ */
+
+#include <fstream>                      /* std::ifstream                    */
+
+#include "po/logstream.hpp"             /* po::logstream::error(), etc.     */
+#include "po/manifest.hpp"              /* po::manifest class               */
+#include "po/wstrfunctions.hpp"         /* po::has_suffix(), etc.           */
+
+/**
+ *  We cannot enable translation in this module, because it leads to
+ *  recursion and a stack overflow.
+ */
+
+#if ! defined PO_HAVE_GETTEXT_RECURSIVE
+#define _(str)      str
+#endif
+
+namespace po
+{
+
+/**
+ *  The separator between the context and the message ID, as used in
+ *  .mo files.
+ */
+
+static const char c_ctxt_separator = '\004';
+
+/**
+ *  Returns the text between the first and the last double quote of a
+ *  .pot line, with the escapes converted. Returns an empty string if
+ *  there are no quotes.
+ */
+
+static std::string
+quoted_string (const std::string & line)
+{
+    std::string result;
+    auto first = line.find_first_of('"');
+    auto last = line.find_last_of('"');
+    if (first != std::string::npos && last > first)
+        result = unescape_c_string(line.substr(first + 1, last - first - 1));
+
+    return result;
+}
+
+/**
+ *  Tests for a keyword at the start of a line, after any indentation
+ *  (pos is the first character that is not white space). The keyword must
+ *  be followed by white space or a quote, so that "msgid" does not match
+ *  "msgid_plural".
+ */
+
+static bool
+keyword_match
+(
+    const std::string & line,
+    std::size_t pos,
+    const std::string & keyword
+)
+{
+    bool result = line.compare(pos, keyword.length(), keyword) == 0;
+    std::size_t end = pos + keyword.length();
+    if (result && line.length() > end)
+    {
+        char c = line[end];
+        result = c == ' ' || c == '\t' || c == '"';
+    }
+    return result;
+}
+
+manifest::manifest () :
+    m_keys      (),
+    m_filename  ()
+{
+    // no code
+}
+
+/**
+ *  Creates the key for a message with a context, the same way the .mo
+ *  format stores it.
+ */
+
+std::string
+manifest::make_key
+(
+    const std::string & msgctxt,
+    const std::string & msgid
+)
+{
+    std::string result = msgctxt;
+    result += c_ctxt_separator;
+    result += msgid;
+    return result;
+}
+
+void
+manifest::add (const std::string & msgid)
+{
+    if (! msgid.empty())
+        (void) m_keys.insert(msgid);
+}
+
+void
+manifest::add (const std::string & msgctxt, const std::string & msgid)
+{
+    if (! msgid.empty())
+        (void) m_keys.insert(make_key(msgctxt, msgid));
+}
+
+/**
+ *  Computes a hash of the set of keys that does not depend on their
+ *  order, for naming caches of catalogs pruned by this manifest.
+ */
+
+std::uint64_t
+manifest::digest () const
+{
+    std::uint64_t result = m_keys.size();
+    for (const auto & k : m_keys)
+        result += fnv1a_hash(k);
+
+    return result;
+}
+
+/**
+ *  The empty message ID holds the catalog header, which is needed for
+ *  the character set and the plural forms, so it is always kept. An
+ *  empty manifest keeps everything.
+ */
+
+bool
+manifest::contains (const std::string & msgid) const
+{
+    if (msgid.empty() || m_keys.empty())
+        return true;
+
+    return m_keys.find(msgid) != m_keys.end();
+}
+
+bool
+manifest::contains
+(
+    const std::string & msgctxt,
+    const std::string & msgid
+) const
+{
+    if (msgid.empty() || m_keys.empty())
+        return true;
+
+    return m_keys.find(make_key(msgctxt, msgid)) != m_keys.end();
+}
+
+/**
+ *  Loads a manifest, replacing the current keys. A file ending in ".pot"
+ *  or ".po" is read as a PO template, anything else as a key list.
+ *
+ * \return
+ *      Returns true if the file could be read and yielded at least one key.
+ */
+
+bool
+manifest::load (const std::string & filename)
+{
+    clear();
+
+    std::ifstream in(filename);
+    bool result = bool(in);
+    if (result)
+    {
+        bool is_pot =
+            has_suffix(filename, ".pot") || has_suffix(filename, ".po");
+
+        result = is_pot ? load_pot(in) : load_key_list(in);
+        if (result)
+        {
+            m_filename = filename;
+        }
+        else
+        {
+            logstream::error()
+                << _("no message IDs in manifest") << ": " << filename
+                << std::endl
+                ;
+        }
+    }
+    else
+    {
+        logstream::error()
+            << _("error") << ": " << _("failure opening")
+            << ": " << filename << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  A minimal .pot reader. Only the msgctxt and msgid strings (including
+ *  their continuation lines) matter; comments, msgid_plural, and msgstr
+ *  lines are skipped. Obsolete "#~" entries are comments, and so are
+ *  ignored as well.
+ */
+
+bool
+manifest::load_pot (std::istream & in)
+{
+    enum class field { none, ctxt, msgid };
+
+    std::string line;
+    std::string msgctxt;
+    std::string msgid;
+    bool has_ctxt = false;
+    bool has_msgid = false;
+    field current = field::none;
+    auto flush = [&] ()
+    {
+        if (has_msgid)
+        {
+            if (has_ctxt)
+                add(msgctxt, msgid);
+            else
+                add(msgid);
+        }
+        msgctxt.clear();
+        msgid.clear();
+        has_ctxt = has_msgid = false;
+        current = field::none;
+    };
+    while (std::getline(in, line))
+    {
+        if (! line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        auto pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] == '#')
+        {
+            if (has_msgid)
+                flush();
+        }
+        else if (line[pos] == '"')
+        {
+            if (current == field::ctxt)
+                msgctxt += quoted_string(line);
+            else if (current == field::msgid)
+                msgid += quoted_string(line);
+        }
+        else if (keyword_match(line, pos, "msgctxt"))
+        {
+            flush();
+            msgctxt = quoted_string(line);
+            has_ctxt = true;
+            current = field::ctxt;
+        }
+        else if (keyword_match(line, pos, "msgid"))
+        {
+            if (has_msgid)
+                flush();
+
+            msgid = quoted_string(line);
+            has_msgid = true;
+            current = field::msgid;
+        }
+        else
+            current = field::none;      /* msgid_plural, msgstr, msgstr[n]  */
+    }
+    flush();
+    return ! empty();
+}
+
+/**
+ *  Reads one key per line. The first EOT character (usually written as
+ *  "\004") separates a context from the message ID.
+ */
+
+bool
+manifest::load_key_list (std::istream & in)
+{
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (! line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::string key = unescape_c_string(line);
+        auto eotpos = key.find(c_ctxt_separator);
+        if (eotpos != std::string::npos)
+            add(key.substr(0, eotpos), key.substr(eotpos + 1));
+        else
+            add(key);
+    }
+    return ! empty();
+}
+
+}               // namespace po
+
+/*
+ * manifest.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -29,7 +29,7 @@
  * \library       potext
  * \author        simple-gettext; refactoring by Chris Ahlstrom
  * \date          2024-03-25
- * \updates       2024-04-13
+ * \updates       2026-10-17
  * \license       See above.
  *
  * Format of the .mo File:
@@ -130,6 +130,7 @@
 #include "po/logstream.hpp"             /* po::logstream log-access funcs   */
 #include "po/pluralforms.hpp"           /* po::pluralforms class            */
 #include "po/moparser.hpp"              /* po::moparser class               */
+#include "po/probes.hpp"                /* POTEXT_PROBE1() etc.             */
 
 #if defined _MSC_VER_DISABLED           /* someone else can try this        */
 
@@ -183,9 +184,10 @@ moparser::moparser
     const std::string & filename,
     std::istream & in,
     dictionary & dic,
-    bool usefuzzy
+    bool usefuzzy,
+    const manifest * mf
 ) :
-    pomoparserbase          (filename, in, dic, usefuzzy),
+    pomoparserbase          (filename, in, dic, usefuzzy, mf),
     m_swapped_bytes         (false),
     m_mo_header             (),
     m_mo_data               (),
@@ -259,10 +261,13 @@ moparser::parse_mo_file
 (
     const std::string & filename,
     std::istream & in,
-    dictionary & dic
+    dictionary & dic,
+    bool usefuzzy,
+    const manifest * mf
 )
 {
-    moparser parser(filename, in, dic);
+    POTEXT_PROBE1(parse__begin, filename.c_str());
+    moparser parser(filename, in, dic, usefuzzy, mf);
     bool result = parser.parse_file(filename);      /* fills m_translations */
     if (result)
     {
@@ -319,6 +324,7 @@ moparser::parse_mo_file
     if (result)
         dic.file_mode(dictionary::mode::mo);
 
+    POTEXT_PROBE2(parse__end, filename.c_str(), int(result));
     return result;
 }
 
@@ -460,7 +466,10 @@ moparser::load_charset_name ()
                  */
 
                 result = m_charset;
-                (void) converter().set_charsets(m_charset, dict().get_charset());
+                (void) converter().set_charsets
+                (
+                    m_charset, dictionary::storage_charset()
+                );
             }
         }
     }
@@ -589,6 +598,9 @@ moparser::find (const std::string & target)
  *  with the original, but is not used for lookup. Also note that a context
  *  string plus an EOT character comes before the original string, if
  *  present.
+ *
+ *  Messages not listed in the manifest (if any) are skipped as soon as
+ *  the original string is known.
  */
 
 bool
@@ -596,20 +608,38 @@ moparser::load_translations ()
 {
     static const char s_NUL = 0x00;                 /* NUL character        */
     static const char s_EOT = 0x04;                 /* EOT character        */
-    static std::string s_str_NUL{1, s_NUL};         /* NUL, string version  */
-    bool result = true;
     extractor xtract(m_mo_data);                    /* translation data     */
     if (m_swapped_bytes)
         xtract.set_swapped_bytes();
 
-    extractor::offset * orig =                      /* msg table start      */
-        xtract.offset_ptr(m_mo_header.offset_original);
+    /*
+     * The tables and strings of a damaged or hostile file can point
+     * anywhere, so each one is checked before it is read.
+     */
 
-    extractor::offset * tran =                      /* translation start    */
-        xtract.offset_ptr(m_mo_header.offset_translated);
+    if
+    (
+        m_mo_header.string_count < 0 ||
+        m_mo_header.offset_original < 0 || m_mo_header.offset_translated < 0
+    )
+    {
+        return false;
+    }
 
-    int count = int(m_mo_header.string_count);
-    for (int index = 0; index < count; ++index, ++orig, ++tran)
+    std::size_t count = std::size_t(m_mo_header.string_count);
+    std::size_t tablesize = count * sizeof(extractor::offset);
+    std::size_t origtable = std::size_t(m_mo_header.offset_original);
+    std::size_t trantable = std::size_t(m_mo_header.offset_translated);
+    if
+    (
+        count > m_mo_data.size() / sizeof(extractor::offset) ||
+        ! xtract.valid_range(origtable, tablesize) ||
+        ! xtract.valid_range(trantable, tablesize)
+    )
+    {
+        return false;
+    }
+    for (std::size_t index = 0; index < count; ++index)
     {
         /*
          * The full original length and offset, which can start with a context
@@ -617,12 +647,33 @@ moparser::load_translations ()
          * in order to avoid bleeding into the next original string.
          */
 
-        word ooffset = swap(orig->o_offset);        /* see extractor.hpp    */
-        word olength = swap(orig->o_length);
-        std::size_t omax = std::size_t(ooffset + olength);
+        extractor::offset orig;
+        extractor::offset tran;
+        std::size_t position = index * sizeof(extractor::offset);
+        if
+        (
+            ! xtract.get_offset(origtable + position, orig) ||
+            ! xtract.get_offset(trantable + position, tran)
+        )
+        {
+            return false;
+        }
+
+        word ooffset = swap(orig.o_offset);         /* see extractor.hpp    */
+        word olength = swap(orig.o_length);
+        word toffset = swap(tran.o_offset);
+        word tlength = swap(tran.o_length);
+        if
+        (
+            ooffset < 0 || olength < 0 || toffset < 0 || tlength < 0 ||
+            ! xtract.valid_range(std::size_t(ooffset), std::size_t(olength)) ||
+            ! xtract.valid_range(std::size_t(toffset), std::size_t(tlength))
+        )
+        {
+            return false;
+        }
 
-        word toffset = swap(tran->o_offset);
-        word tlength = swap(tran->o_length);
+        std::size_t omax = std::size_t(ooffset) + std::size_t(olength);
         translation tranquad;
 
         /*
@@ -636,7 +687,7 @@ moparser::load_translations ()
             std::size_t ctxtlength = eotpos - ooffset;
             tranquad.context = xtract.get(ooffset, ctxtlength);
             ooffset = word(eotpos) + 1;
-            olength -= word(ctxtlength);
+            olength -= word(ctxtlength) + 1;
         }
 
         /*
@@ -645,70 +696,61 @@ moparser::load_translations ()
          */
 
         std::size_t nulpos = xtract.find_character(s_NUL, ooffset, olength);
-        if (nulpos < std::size_t(ooffset + olength - 1))
+        if (xtract.checked_offset(nulpos + 1, omax))
         {
             std::size_t len1 = nulpos - ooffset;
             tranquad.original = xtract.get(ooffset, len1);   /* original */
-            ooffset = nulpos + 1;
-            olength -= len1 + 1;
+            ooffset = word(nulpos) + 1;
+            olength -= word(len1) + 1;
             tranquad.original_plural = xtract.get(ooffset, olength);
         }
         else
             tranquad.original = xtract.get(ooffset, olength);   /* original */
 
         /*
-         *  Get the original string and the first (singular) translation.
-         *  If the length of the translation is less than the specified
-         *  length of the translation, then get the plural-forms. The
-         *  following will grab text beyond the singular translated message.
-         *
-         *      std::string translated = xtract.get(toffset, tlength);
-         *
-         *  The default delimiter is a newline, so we need to specify a null
-         *  here to get only the first translation, which is singular.
+         *  If there is a manifest and it does not list this message, do not
+         *  bother extracting the translation.
+         */
+
+        if (! wanted(tranquad.context, tranquad.original))
+            continue;
+
+        /*
+         *  Get the translation. If it holds NULs, it is the singular
+         *  followed by the plurals; an empty plural ends the list. Only
+         *  the range of the translation is read, not whatever follows it.
          */
 
-        std::string translated = xtract.get_delimited(toffset, s_str_NUL);
-        int translength = int(translated.length());
-        if (translength > 0)
+        std::string translated = xtract.get(toffset, tlength);
+        if (! translated.empty())
         {
-            if (translength < tlength)
+            std::string::size_type nul = translated.find(s_NUL);
+            if (nul == std::string::npos)
+            {
+                tranquad.translated = translated;
+            }
+            else if (nul > 0)
             {
                 phraselist & plist{tranquad.plurals};
-                plist.push_back(translated);
-                ++translength;                      /* count the NUL char   */
-                toffset += translength;             /* skip the singular    */
-                tlength -= translength;
+                std::string::size_type start = 0;
                 for (;;)
                 {
-                    std::size_t range_end = std::size_t(toffset + tlength);
-                    std::size_t nulpos = xtract.find_character
-                    (
-                        s_NUL, toffset, tlength
-                    );
-                    if (nulpos <= range_end)
-                    {
-                        std::size_t len = nulpos - toffset;
-                        std::string plural = xtract.get(toffset, len);
-                        if (plural.empty())
-                            break;
-                        else
-                            plist.push_back(plural);
-
-                        translength = int(plural.length() + 1); /* plus NUL */
-                        toffset += translength;
-                        tlength -= translength;
-                    }
-                    else
+                    plist.push_back(translated.substr(start, nul - start));
+                    start = nul + 1;
+                    if (start >= translated.size())
+                        break;
+
+                    nul = translated.find(s_NUL, start);
+                    if (nul == std::string::npos)
+                        nul = translated.size();
+                    else if (nul == start)
                         break;
                 }
             }
-            else
-                tranquad.translated = translated;
         }
         m_translations.push_back(tranquad);
     }
-    return result;
+    return true;
 }
 
 /**
@@ -0,0 +1,146 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          msgidtable.cpp
+ *
+ *      Integer message-ID lookups via a table indexed by dense IDs.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  See the banner of msgidtable.hpp.
+ */
+
+#include <cstring>                      /* std::strchr()                    */
+
+#include "c_macros.h"                   /* not_nullptr() macro              */
+#include "po/dictionary.hpp"            /* po::dictionary class             */
+#include "po/msgidtable.hpp"            /* po::msgidtable class             */
+
+namespace po
+{
+
+/**
+ *  The separator between a context and a message ID in a key.
+ */
+
+static const char c_ctxt_separator = '\004';
+
+msgidtable::msgidtable () :
+    m_keys          (nullptr),
+    m_count         (0),
+    m_dict          (nullptr),
+    m_generation    (0),
+    m_built         (false),
+    m_translations  ()
+{
+    // no code
+}
+
+/**
+ *  Registers a (generated) key table. The table must outlive this object.
+ */
+
+void
+msgidtable::assign (const char * const * keys, std::size_t count)
+{
+    m_keys = keys;
+    m_count = count;
+    m_built = false;
+    m_translations.clear();
+}
+
+/**
+ *  Returns the message ID part of a key, i.e. the part after the context
+ *  separator, if any.
+ */
+
+std::string
+msgidtable::key_msgid (const char * key)
+{
+    const char * eot = std::strchr(key, c_ctxt_separator);
+    return std::string(not_nullptr(eot) ? eot + 1 : key);
+}
+
+/**
+ *  Looks up every key once and stores the result by ID. Untranslated
+ *  messages get their message ID, as gettext() would return.
+ *
+ * \param dict
+ *      The dictionary to use. If null, the table holds the message IDs.
+ *
+ * \param generation
+ *      The dictionarymgr generation, saved for current().
+ *
+ * \param codeset
+ *      The output codeset of the translations (see dictionary::view()).
+ *      If empty, the charset of the dictionary is used.
+ */
+
+void
+msgidtable::build
+(
+    const dictionary * dict,
+    unsigned long generation,
+    const std::string & codeset
+)
+{
+    m_translations.clear();
+    m_translations.reserve(m_count);
+    for (std::size_t id = 0; id < m_count; ++id)
+    {
+        const char * key = m_keys[id];
+        std::string_view msgstr;
+        const char * eot = std::strchr(key, c_ctxt_separator);
+        if (not_nullptr(dict) && key[0] != 0)   /* "" is the header    */
+        {
+            if (not_nullptr(eot))
+            {
+                std::string ctxt(key, std::size_t(eot - key));
+                msgstr = dict->find_ctxt_view(ctxt, std::string(eot + 1));
+            }
+            else
+                msgstr = dict->find_view(std::string(key));
+        }
+        if (! msgstr.empty())
+            m_translations.push_back(dict->converted_view(msgstr, codeset));
+        else
+            m_translations.emplace_back(not_nullptr(eot) ? eot + 1 : key);
+    }
+    m_dict = dict;
+    m_generation = generation;
+    m_built = true;
+}
+
+}               // namespace po
+
+/*
+ * msgidtable.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
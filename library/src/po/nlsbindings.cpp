@@ -30,7 +30,7 @@
  * \library       potext
  * \author        gettext; refactoring by Chris Ahlstrom
  * \date          2024-02-20
- * \updates       2024-04-01
+ * \updates       2026-10-17
  * \license       See above.
  *
  *  Defines setbinding(), a replacement for set_binding_values in the
@@ -260,7 +260,7 @@ nlsbindings::set_binding_values
             std::string current = bit->b_dirname;
             if (dirname != current)
             {
-                bit->b_dirname = current;
+                bit->b_dirname = dirname;
                 result = true;
             }
         }
@@ -291,6 +291,11 @@ nlsbindings::set_binding_values
  *  bind_textdomain_codeset():
  *
  *      set_binding_values (domainname, NULL, NULL, &codeset);
+ *
+ *  As in GNU gettext, binding a codeset to a domain that has no binding yet
+ *  creates one with the default directory. The codeset only selects the
+ *  view of the (UTF-8) translations that the domain's lookups return; no
+ *  catalog is re-read.
  */
 
 bool
@@ -305,29 +310,69 @@ nlsbindings::set_binding_codeset
     if (bit != m_container.end())
     {
         if (codeset.empty())
-        {
             codeset = bit->b_codeset;
-            result = true;
-        }
         else
+            bit->b_codeset = codeset;
+
+        result = true;
+    }
+    else if (! codeset.empty())                     /* create a new binding */
+    {
+        binding * new_binding = create_binding(domainname, "");
+        if (not_nullptr(new_binding))
         {
-	        /*
-             * The domain is already bound. If the new value and the old one
-             * are equal we simply do nothing. Otherwise replace the old
-             * binding.
-             */
+            new_binding->b_codeset = codeset;
+            auto start = m_last_binding;
+            if (start == m_container.end())
+                m_container.push_front(*new_binding);
+            else
+                m_last_binding = m_container.insert_after(start, *new_binding);
 
-            std::string current = bit->b_codeset;
-            if (codeset != current)
-            {
-                bit->b_codeset = current;
-                result = true;
-            }
+            delete new_binding;
+            ++m_count;
+            result = true;
         }
     }
     return result;
 }
 
+/**
+ *  Gets the output codeset bound to a domain by bind_textdomain_codeset().
+ *
+ * \return
+ *      Returns an empty string if no codeset is bound to the domain.
+ */
+
+std::string
+nlsbindings::get_codeset (const std::string & domainname) const
+{
+    for (const auto & b : m_container)
+    {
+        if (domainname == b.b_domainname)
+            return b.b_codeset;
+    }
+    return std::string("");
+}
+
+/**
+ *  Gets the directory bound to a domain by bindtextdomain() (or the default
+ *  directory, if only a codeset was bound).
+ *
+ * \return
+ *      Returns an empty string if the domain has no binding.
+ */
+
+std::string
+nlsbindings::get_dirname (const std::string & domainname) const
+{
+    for (const auto & b : m_container)
+    {
+        if (domainname == b.b_domainname)
+            return b.b_dirname;
+    }
+    return std::string("");
+}
+
 #if defined POTEXT_WIDE_STRING_SUPPORT
 
 /**
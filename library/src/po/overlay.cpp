@@ -0,0 +1,448 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          overlay.cpp
+ *
+ *      Overriding translations over a shared dictionary.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  See the banner of overlay.hpp.
+ */
+
+#include <stdexcept>                    /* std::invalid_argument            */
+
+#include "po/manifest.hpp"              /* po::manifest::make_key()         */
+#include "po/overlay.hpp"               /* po::overlay class                */
+#include "po/wstrfunctions.hpp"         /* po::fnv1a_hash()                 */
+
+namespace po
+{
+
+/**
+ *  The msgctxt/msgid separator of the keys, as in manifest::make_key().
+ */
+
+static const char c_ctxt_separator = '\004';
+
+/**
+ *  Makes an overlay with no overrides.
+ *
+ * \param base
+ *      The shared dictionary. It must not be null. A dictionary that is
+ *      owned elsewhere, and outlives the overlay, can be passed with a
+ *      shared pointer that does not own it.
+ */
+
+overlay::overlay (std::shared_ptr<const dictionary> base) :
+    m_base      (std::move(base)),
+    m_overrides (),
+    m_filter    ()
+{
+    if (! m_base)
+        throw std::invalid_argument("overlay needs a base dictionary");
+}
+
+void
+overlay::clear ()
+{
+    m_overrides.clear();
+    m_filter.clear();
+}
+
+/**
+ *  Estimates the memory of the overrides, not counting the base, in the
+ *  manner of dictionary::memory_usage().
+ */
+
+std::size_t
+overlay::memory_usage () const
+{
+    const std::size_t nodeoverhead = 4 * sizeof(void *);
+    const std::size_t inlinesize = std::string().capacity();
+    auto string_usage = [inlinesize] (const std::string & s)
+    {
+        return s.capacity() > inlinesize ? s.capacity() + 1 : 0 ;
+    };
+    std::size_t result = sizeof *this;
+    result += m_overrides.bucket_count() * sizeof(void *);
+    result += m_filter.capacity() * sizeof(std::uint64_t);
+    for (const auto & o : m_overrides)
+    {
+        result += nodeoverhead + sizeof o + string_usage(o.first);
+        result += string_usage(o.second.msgid_plural);
+        result += o.second.phrase_list.capacity() * sizeof(std::string);
+        for (const auto & phrase : o.second.phrase_list)
+            result += string_usage(phrase);
+    }
+    return result;
+}
+
+/**
+ *  Adds or replaces the override of a message. Unlike dictionary::add(),
+ *  a message already overridden gets the new translation.
+ */
+
+void
+overlay::add (const std::string & msgid, const std::string & msgstr)
+{
+    set_override(msgid, key_hash(msgid), entry{std::string(), {msgstr}});
+}
+
+void
+overlay::add
+(
+    const std::string & msgctxt,
+    const std::string & msgid,
+    const std::string & msgstr
+)
+{
+    set_override
+    (
+        manifest::make_key(msgctxt, msgid), key_hash(msgctxt, msgid),
+        entry{std::string(), {msgstr}}
+    );
+}
+
+void
+overlay::add
+(
+    const std::string & msgid,
+    const std::string & msgid_plural,
+    const phraselist & msgstrs
+)
+{
+    set_override(msgid, key_hash(msgid), entry{msgid_plural, msgstrs});
+}
+
+void
+overlay::add
+(
+    const std::string & msgctxt,
+    const std::string & msgid,
+    const std::string & msgid_plural,
+    const phraselist & msgstrs
+)
+{
+    set_override
+    (
+        manifest::make_key(msgctxt, msgid), key_hash(msgctxt, msgid),
+        entry{msgid_plural, msgstrs}
+    );
+}
+
+/**
+ *  Drops the override of a message, so that the base translation shows
+ *  through again. A Bloom filter cannot forget a key, so it is rebuilt.
+ *
+ * \return
+ *      Returns false if the message was not overridden.
+ */
+
+bool
+overlay::remove (const std::string & msgid)
+{
+    bool result = m_overrides.erase(msgid) > 0;
+    if (result)
+        rebuild_filter();
+
+    return result;
+}
+
+bool
+overlay::remove (const std::string & msgctxt, const std::string & msgid)
+{
+    bool result = m_overrides.erase(manifest::make_key(msgctxt, msgid)) > 0;
+    if (result)
+        rebuild_filter();
+
+    return result;
+}
+
+std::uint64_t
+overlay::key_hash (const std::string & msgid)
+{
+    return fnv1a_hash(msgid);
+}
+
+/**
+ *  Hashes the key of a context message as manifest::make_key() would
+ *  make it, without making it.
+ */
+
+std::uint64_t
+overlay::key_hash (const std::string & msgctxt, const std::string & msgid)
+{
+    std::uint64_t h = fnv1a_hash(msgctxt);
+    h = fnv1a_hash(&c_ctxt_separator, 1, h);
+    return fnv1a_hash(msgid, h);
+}
+
+void
+overlay::set_override (std::string key, std::uint64_t hash, entry e)
+{
+    m_overrides[std::move(key)] = std::move(e);
+    if (m_filter.size() * 64 < m_overrides.size() * sm_filter_bits)
+        rebuild_filter();                   /* grow it, rehashing all keys  */
+    else
+        filter_add(hash);
+}
+
+/**
+ *  Sets the two bits of a key. The bit numbers are taken from the low and
+ *  high halves of the hash.
+ */
+
+void
+overlay::filter_add (std::uint64_t hash)
+{
+    std::size_t mask = m_filter.size() * 64 - 1;
+    std::size_t b1 = std::size_t(hash) & mask;
+    std::size_t b2 = std::size_t(hash >> 32) & mask;
+    m_filter[b1 / 64] |= std::uint64_t(1) << (b1 % 64);
+    m_filter[b2 / 64] |= std::uint64_t(1) << (b2 % 64);
+}
+
+bool
+overlay::filter_test (std::uint64_t hash) const
+{
+    if (m_filter.empty())
+        return false;
+
+    std::size_t mask = m_filter.size() * 64 - 1;
+    std::size_t b1 = std::size_t(hash) & mask;
+    std::size_t b2 = std::size_t(hash >> 32) & mask;
+    return
+        (m_filter[b1 / 64] & (std::uint64_t(1) << (b1 % 64))) != 0 &&
+        (m_filter[b2 / 64] & (std::uint64_t(1) << (b2 % 64))) != 0;
+}
+
+/**
+ *  Sizes the filter for the overrides, a power of two of 64-bit words,
+ *  and sets the bits of every key.
+ */
+
+void
+overlay::rebuild_filter ()
+{
+    m_filter.clear();
+    if (m_overrides.empty())
+        return;
+
+    std::size_t words = 1;
+    while (words * 64 < m_overrides.size() * sm_filter_bits)
+        words *= 2;
+
+    m_filter.assign(words, 0);
+    for (const auto & o : m_overrides)
+    {
+        const std::string & key = o.first;
+        std::size_t sep = key.find(c_ctxt_separator);
+        if (sep == std::string::npos)
+            filter_add(key_hash(key));
+        else
+            filter_add(key_hash(key.substr(0, sep), key.substr(sep + 1)));
+    }
+}
+
+const overlay::entry *
+overlay::lookup (const std::string & msgid) const
+{
+    if (! filter_test(key_hash(msgid)))
+        return nullptr;
+
+    auto it = m_overrides.find(msgid);
+    return it != m_overrides.end() ? &it->second : nullptr ;
+}
+
+const overlay::entry *
+overlay::lookup (const std::string & msgctxt, const std::string & msgid) const
+{
+    if (! filter_test(key_hash(msgctxt, msgid)))
+        return nullptr;
+
+    auto it = m_overrides.find(manifest::make_key(msgctxt, msgid));
+    return it != m_overrides.end() ? &it->second : nullptr ;
+}
+
+/**
+ *  Provides the singular translation of an override, or null if there is
+ *  no override or it is empty, in which case the base translation shows.
+ */
+
+const std::string *
+overlay::singular (const entry * e)
+{
+    if (is_nullptr(e) || e->phrase_list.empty() || e->phrase_list[0].empty())
+        return nullptr;
+
+    return &e->phrase_list[0];
+}
+
+/**
+ *  Converts an override to the codeset, or to the charset of the base.
+ */
+
+std::string
+overlay::output (const std::string & msgstr, const std::string & codeset) const
+{
+    return dictionary::converted
+    (
+        msgstr, codeset.empty() ? m_base->get_charset() : codeset
+    );
+}
+
+/**
+ *  Picks the plural form of an override by the Plural-Forms of the base,
+ *  falling back to the English rule as the dictionary does.
+ */
+
+std::string
+overlay::plural_output
+(
+    const entry & e,
+    const std::string & msgid,
+    const std::string & msgidplural,
+    int num,
+    const std::string & codeset
+) const
+{
+    unsigned n = m_base->get_plural_forms().get_plural(num);
+    if (n < e.phrase_list.size() && ! e.phrase_list[n].empty())
+        return output(e.phrase_list[n], codeset);
+
+    return num == 1 ? msgid : msgidplural ;
+}
+
+std::string
+overlay::translate
+(
+    const std::string & msgid,
+    const std::string & codeset
+) const
+{
+    const std::string * msgstr = singular(lookup(msgid));
+    if (not_nullptr(msgstr))
+        return output(*msgstr, codeset);
+
+    return m_base->translate(msgid, codeset);
+}
+
+std::string
+overlay::translate_plural
+(
+    const std::string & msgid,
+    const std::string & msgidplural,
+    int num,
+    const std::string & codeset
+) const
+{
+    const entry * e = lookup(msgid);
+    if (not_nullptr(e))
+        return plural_output(*e, msgid, msgidplural, num, codeset);
+
+    return m_base->translate_plural(msgid, msgidplural, num, codeset);
+}
+
+std::string
+overlay::translate_ctxt
+(
+    const std::string & msgctxt,
+    const std::string & msgid,
+    const std::string & codeset
+) const
+{
+    const std::string * msgstr = singular(lookup(msgctxt, msgid));
+    if (not_nullptr(msgstr))
+        return output(*msgstr, codeset);
+
+    return m_base->translate_ctxt(msgctxt, msgid, codeset);
+}
+
+std::string
+overlay::translate_ctxt_plural
+(
+    const std::string & msgctxt,
+    const std::string & msgid,
+    const std::string & msgidplural,
+    int num,
+    const std::string & codeset
+) const
+{
+    const entry * e = lookup(msgctxt, msgid);
+    if (not_nullptr(e))
+        return plural_output(*e, msgid, msgidplural, num, codeset);
+
+    return m_base->translate_ctxt_plural
+    (
+        msgctxt, msgid, msgidplural, num, codeset
+    );
+}
+
+/**
+ *  Looks up the singular translation of a message, in UTF-8, as
+ *  dictionary::find() does.
+ *
+ * \return
+ *      Returns a pointer to the override or to the base translation, or
+ *      null if there is neither. The pointer is valid until the message is
+ *      overridden again or removed.
+ */
+
+const std::string *
+overlay::find (const std::string & msgid) const
+{
+    const std::string * msgstr = singular(lookup(msgid));
+    if (not_nullptr(msgstr))
+        return msgstr;
+
+    return m_base->find(msgid);
+}
+
+const std::string *
+overlay::find_ctxt
+(
+    const std::string & msgctxt,
+    const std::string & msgid
+) const
+{
+    const std::string * msgstr = singular(lookup(msgctxt, msgid));
+    if (not_nullptr(msgstr))
+        return msgstr;
+
+    return m_base->find_ctxt(msgctxt, msgid);
+}
+
+}               // namespace po
+
+/*
+ * overlay.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -30,7 +30,7 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-12
+ * \updates       2026-10-17
  * \license       See above.
  *
  *  https://www.gnu.org/software/gettext/manual/
@@ -326,6 +326,36 @@ plural6_ar (int n)
             3 : n % 100 >= 11 ? 4 : 5 ;
 }
 
+/**
+ *  The batch version of a plural function. The function is a template
+ *  argument, so it is inlined, and the loop has no calls in it. The inner
+ *  loop has a fixed length, which lets even the cheap vectorizer of -O2
+ *  turn the comparisons and modulos of the rule into vector code.
+ */
+
+template <unsigned (*F) (int)>
+void
+batch (const int * counts, std::size_t count, unsigned * indices)
+{
+    const std::size_t width = 16;
+    std::size_t i = 0;
+    for ( ; i + width <= count; i += width)
+    {
+        int n[width];
+        unsigned result[width];
+        for (std::size_t j = 0; j < width; ++j)
+            n[j] = counts[i + j];
+
+        for (std::size_t j = 0; j < width; ++j)
+            result[j] = F(n[j]);
+
+        for (std::size_t j = 0; j < width; ++j)
+            indices[i + j] = result[j];
+    }
+    for ( ; i < count; ++i)
+        indices[i] = F(counts[i]);
+}
+
 }           // anonymous namespace
 
 namespace po
@@ -336,17 +366,97 @@ namespace po
  */
 
 pluralforms::pluralforms () :
-    m_nplural   (),
-    mf_plural   ()
+    m_nplural       (),
+    mf_plural       (),
+    mf_plurals      (),
+    m_table         (),
+    m_descriptor    ()
 {
     // no code
 }
 
-pluralforms::pluralforms (unsigned nplural, function plural) :
-    m_nplural   (nplural),
-    mf_plural   (plural)
+/**
+ *  Also makes the table of the plural forms of the small counts.
+ */
+
+pluralforms::pluralforms
+(
+    unsigned nplural,
+    function plural,
+    batchfunction plurals
+) :
+    m_nplural       (nplural),
+    mf_plural       (plural),
+    mf_plurals      (plurals),
+    m_table         (),
+    m_descriptor    ()
 {
-    // no code
+    if (plural)
+    {
+        auto t = std::make_shared<table>();
+        for (int n = 0; n < sm_table_size; ++n)
+            (*t)[std::size_t(n)] = std::uint8_t(plural(n));
+
+        m_table = t;
+    }
+}
+
+/**
+ *  Picks the plural forms of an array of counts. The counts are taken in
+ *  blocks; a block of small counts is looked up in the table, and any
+ *  other block is given to the batch function.
+ *
+ * \param counts
+ *      The counts, e.g. the numbers of files of the rows of a table.
+ *
+ * \param count
+ *      The number of counts.
+ *
+ * \param [out] indices
+ *      Receives the plural form of each count, as get_plural() would
+ *      give it.
+ */
+
+void
+pluralforms::get_plurals
+(
+    const int * counts,
+    std::size_t count,
+    unsigned * indices
+) const
+{
+    const std::size_t blocksize = 64;
+    for (std::size_t first = 0; first < count; first += blocksize)
+    {
+        std::size_t size = count - first;
+        if (size > blocksize)
+            size = blocksize;
+
+        const int * c = counts + first;
+        unsigned * out = indices + first;
+        unsigned outside = 0;
+        for (std::size_t i = 0; i < size; ++i)
+            outside |= unsigned(unsigned(c[i]) >= unsigned(sm_table_size));
+
+        if (! mf_plural)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+                out[i] = 0;
+        }
+        else if (outside == 0 && m_table)
+        {
+            const table & t = *m_table;
+            for (std::size_t i = 0; i < size; ++i)
+                out[i] = t[unsigned(c[i])];
+        }
+        else if (mf_plurals)
+            mf_plurals(c, size, out);
+        else
+        {
+            for (std::size_t i = 0; i < size; ++i)
+                out[i] = mf_plural(c[i]);
+        }
+    }
 }
 
 /**
@@ -378,27 +488,27 @@ pluralforms::from_string (const std::string & str)
     {
         {
             PF "1" PE "0;",
-            pluralforms(1, plural1)
+            pluralforms(1, plural1, batch<plural1>)
         },
         {
             PF "2" PE "(n!=1);",        /* this one seems "normal"          */
-            pluralforms(2, plural2_1)
+            pluralforms(2, plural2_1, batch<plural2_1>)
         },
         {
             PF "2" PE "n!=1;",          /* this one seems not "normal"      */
-            pluralforms(2, plural2_1)
+            pluralforms(2, plural2_1, batch<plural2_1>)
         },
         {
             PF "2" PE "(n>1);",
-            pluralforms(2, plural2_2)
+            pluralforms(2, plural2_2, batch<plural2_2>)
         },
         {
             PF "2" PE "n==1||n%10==1?0:1;",
-            pluralforms(2, plural2_mk)
+            pluralforms(2, plural2_mk, batch<plural2_mk>)
         },
         {
             PF "2" PE "(n%10==1&&n%100!=11)?0:1;",
-            pluralforms(2, plural2_mk_2)
+            pluralforms(2, plural2_mk_2, batch<plural2_mk_2>)
         },
 
         /*
@@ -408,97 +518,97 @@ pluralforms::from_string (const std::string & str)
 
         {
             PF "3" PE "n==1?0:n!=0&&n%1000000==0?1:2;",
-            pluralforms(2, plural3_es)
+            pluralforms(2, plural3_es, batch<plural3_es>)
         },
         {
             PF "3" PE "n%10==1&&n%100!=11?0:n!=0?1:2);",
-            pluralforms(2, plural3_lv)
+            pluralforms(2, plural3_lv, batch<plural3_lv>)
         },
         {
             PF "3" PE "n==1?0:n==2?1:2;",
-            pluralforms(3, plural3_ga)
+            pluralforms(3, plural3_ga, batch<plural3_ga>)
         },
         {
             PF "3" PE
             "(n%10==1&&n%100!=11?0:n%10>=2&&(n%100<10||n%100>=20)?1:2);",
-            pluralforms(3, plural3_lt)
+            pluralforms(3, plural3_lt, batch<plural3_lt>)
         },
         {
             PF "3" PE
             "(n%10==1&&n%100!=11?0:n%10>=2&&n%10<=4&&(n%100<10||n%100>=20)?1:2);",
-            pluralforms(3, plural3_1)
+            pluralforms(3, plural3_1, batch<plural3_1>)
         },
         {
             PF "3" PE "(n==1)?0:(n>=2&&n<=4)?1:2;",
-            pluralforms(3, plural3_sk)
+            pluralforms(3, plural3_sk, batch<plural3_sk>)
         },
         {
             PF "3" PE "(n==1?0:n%10>=2&&n%10<=4&&(n%100<10||n%100>=20)?1:2);",
-            pluralforms(3, plural3_pl)
+            pluralforms(3, plural3_pl, batch<plural3_pl>)
         },
         {
             PF "3" PE "(n%100==1?0:n%100==2?1:n%100==3||n%100==4?2:3);",
-            pluralforms(3, plural3_sl)
+            pluralforms(3, plural3_sl, batch<plural3_sl>)
         },
         {
             PF "3" PE "(n==1?0:(((n%100>19)||((n%100==0)&&(n!=0)))?2:1));",
-            pluralforms(3, plural3_ro)
+            pluralforms(3, plural3_ro, batch<plural3_ro>)
         },
         {
             PF "4" PE "(n%1==0&&n==1?0:n%1==0&&n>=2&&n<=4?1:n%1!=0?2:3);",
-            pluralforms(4, plural4_sk)
+            pluralforms(4, plural4_sk, batch<plural4_sk>)
         },
         {
             PF "4" PE "(n==1&&n%1==0)?0:(n>=2&&n<=4&&n%1==0)?1:(n%1!=0)?2:3;",
-            pluralforms(4, plural4_cs)
+            pluralforms(4, plural4_cs, batch<plural4_cs>)
         },
         {
             PF "4" PE
             "(n%10==1&&n%100!=11?0:n%10>=2&&n%10<=4&&(n%100<12||n%100>14)"
             "?1:n%10==0||(n%10>=5&&n%10<=9)||(n%100>=11&&n%100<=14)?2:3);",
-            pluralforms(4, plural4_be)
+            pluralforms(4, plural4_be, batch<plural4_be>)
         },
         {
             PF "4" PE "(n==1||n==11)?0:(n==2||n==12)?1:(n>2&&n<20)?2:3;",
-            pluralforms(4, plural4_gd)
+            pluralforms(4, plural4_gd, batch<plural4_gd>)
         },
         {
             PF "4" PE "(n==1)?0:(n==2)?1:(n!=8&&n!=11)?2:3;",
-            pluralforms(4, plural4_cy)
+            pluralforms(4, plural4_cy, batch<plural4_cy>)
         },
         {
             PF "4" PE
             "(n%10==1&&(n%100>19||n%100<11)?0:(n%10>=2&&n%10<=9)&&"
             "(n%100>19||n%100<11)?1:n%1!=0?2:3);",
-            pluralforms(4, plural4_lt)
+            pluralforms(4, plural4_lt, batch<plural4_lt>)
         },
         {
             PF "4" PE
             "(n%1==0&&n%10==1&&n%100!=11?0:n%1==0&&n%10>=2&&n%10<=4&&"
             "(n%100<12||n%100>14)?1:n%1==0&&(n%10==0||(n%10>=5&&"
             "n%10<=9)||(n%100>=11&&n%100<=14))?2:3);",
-            pluralforms(4, plural4_uk)
+            pluralforms(4, plural4_uk, batch<plural4_uk>)
         },
         {
             PF "4" PE
             "(n==1?0:(n%10>=2&&n%10<=4)&&(n%100<12||n%100>14)?1:n!=1&&"
             "(n%10>=0&&n%10<=1)||(n%10>=5&&n%10<=9)||(n%100>=12&&:"
             "n%100<=14)?2:3);",
-            pluralforms(4, plural4_pl)
+            pluralforms(4, plural4_pl, batch<plural4_pl>)
         },
         {
             PF "4" PE
             "(n==1&&n%1==0)?0:(n==2&&n%1==0)?1:(n%10==0&&n%1==0&&n>10)?2:3;",
-            pluralforms(4, plural4_he)
+            pluralforms(4, plural4_he, batch<plural4_he>)
         },
         {
             PF "5" PE "(n==1?0:n==2?1:n<7?2:n<11?3:4)",
-            pluralforms(5, plural5_ga)
+            pluralforms(5, plural5_ga, batch<plural5_ga>)
         },
         {
             PF "6" PE
             "n==0?0:n==1?1:n==2?2:n%100>=3&&n%100<=10?3:n%100>=11?4:5",
-            pluralforms(6, plural6_ar)
+            pluralforms(6, plural6_ar, batch<plural6_ar>)
         },
     };
 
@@ -512,14 +622,23 @@ pluralforms::from_string (const std::string & str)
     std::string spaceless_str;
     for (auto c : str)
     {
-        if (! std::isspace(c))
+        if (! std::isspace(static_cast<unsigned char>(c)))
             spaceless_str += c;
     }
+    if (spaceless_str.empty())
+        return pluralforms();
+
     if (spaceless_str.back() != ';')
         spaceless_str += ';';
 
+    pluralforms result;
     map::const_iterator it = s_plural_forms.find(spaceless_str);
-    return it != s_plural_forms.end() ? it->second : pluralforms() ;
+    if (it != s_plural_forms.end())
+    {
+        result = it->second;
+        result.m_descriptor = spaceless_str;
+    }
+    return result;
 }
 
 }           // namespace po
@@ -0,0 +1,837 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          pomerge.cpp
+ *
+ *      Merging the translations of a .po file into a new .pot template.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  See the banner of pomerge.hpp.
+ */
+
+#include <algorithm>                    /* std::sort(), std::unique()       */
+#include <cctype>                       /* std::toupper()                   */
+#include <cstdlib>                      /* std::atoi()                      */
+#include <sstream>                      /* std::istringstream               */
+
+#include "c_macros.h"                   /* not_nullptr() macro, etc.        */
+#include "po/iconvert.hpp"              /* po::iconvert class               */
+#include "po/pomerge.hpp"               /* po::pomerge class                */
+#include "po/wstrfunctions.hpp"         /* po::unescape_c_string()          */
+
+namespace po
+{
+
+/**
+ *  The number of old messages, the ones sharing the most trigrams with a
+ *  new message, that are compared with it in full.
+ */
+
+static const std::size_t c_candidates = 16;
+
+/**
+ *  Above this product of the lengths of two messages, the trigram
+ *  similarity is used instead of the full comparison, which takes time
+ *  and memory proportional to it.
+ */
+
+static const std::size_t c_max_cells = 1 << 22;
+
+/**
+ *  A trigram found in more than 1/c_common_ratio of the old messages (and
+ *  in more than c_min_common of them) says little about which is the most
+ *  similar, as a stop word says little about a document. Such trigrams
+ *  are skipped, as long as c_min_grams rarer ones were counted.
+ */
+
+static const std::size_t c_common_ratio = 16;
+static const std::size_t c_min_common = 256;
+static const std::size_t c_min_grams = 3;
+
+/**
+ *  Gets the text of a quoted string such as the one in 'msgid "text"',
+ *  unescaped.
+ */
+
+static bool
+quoted_string (const std::string & line, std::string & text)
+{
+    std::size_t first = line.find('"');
+    std::size_t last = line.find_last_of('"');
+    if (first == std::string::npos || last == first)
+        return false;
+
+    text = unescape_c_string(line.substr(first + 1, last - first - 1));
+    return true;
+}
+
+static bool
+is_header (const poentry & e)
+{
+    return ! e.has_ctxt && e.msgid.empty() && ! e.obsolete;
+}
+
+static bool
+has_flag (const poentry & e, const std::string & flag)
+{
+    return std::find(e.flags.begin(), e.flags.end(), flag) != e.flags.end();
+}
+
+static bool
+same_context (const poentry & a, const poentry & b)
+{
+    return a.has_ctxt == b.has_ctxt && a.msgctxt == b.msgctxt;
+}
+
+static bool
+is_translated (const poentry & e)
+{
+    for (const auto & s : e.msgstrs)
+    {
+        if (! s.empty())
+            return true;
+    }
+    return false;
+}
+
+/**
+ *  Finds the value of a field of a header, such as "charset=" or
+ *  "nplurals=". The value ends at a space, a semicolon, or a newline.
+ *
+ * \return
+ *      Returns the offset of the value, or std::string::npos. The size of
+ *      the value is returned in \a size.
+ */
+
+static std::size_t
+header_value
+(
+    const std::string & header,
+    const std::string & field,
+    std::size_t & size
+)
+{
+    std::size_t pos = header.find(field);
+    if (pos == std::string::npos)
+        return pos;
+
+    pos += field.size();
+
+    std::size_t end = header.find_first_of(" ;\n", pos);
+    if (end == std::string::npos)
+        end = header.size();
+
+    size = end - pos;
+    return pos;
+}
+
+/**
+ *  Converts all the strings of the entries to UTF-8, if the header gives
+ *  another charset, and changes the header to say UTF-8.
+ */
+
+static void
+convert_entries (std::vector<poentry> & entries)
+{
+    poentry * header = nullptr;
+    for (auto & e : entries)
+    {
+        if (is_header(e) && ! e.msgstrs.empty())
+        {
+            header = &e;
+            break;
+        }
+    }
+    if (is_nullptr(header))
+        return;
+
+    std::string & text = header->msgstrs[0];
+    std::size_t size = 0;
+    std::size_t pos = header_value(text, "charset=", size);
+    if (pos == std::string::npos)
+        return;
+
+    std::string charset = text.substr(pos, size);
+    for (auto & ch : charset)
+        ch = char(std::toupper(ch));
+
+    if
+    (
+        charset.empty() || charset == "UTF-8" || charset == "UTF8" ||
+        charset == "CHARSET" || charset == "ASCII" || charset == "US-ASCII"
+    )
+    {
+        return;
+    }
+
+    iconvert cv(charset, "UTF-8");
+    auto convert = [&cv] (std::string & s)
+    {
+        if (! s.empty())
+            s = cv.convert(s);
+    };
+    for (auto & e : entries)
+    {
+        for (auto & c : e.comments)
+            convert(c);
+
+        for (auto & c : e.extracted)
+            convert(c);
+
+        convert(e.msgctxt);
+        convert(e.msgid);
+        convert(e.msgid_plural);
+        convert(e.previous_msgid);
+        for (auto & s : e.msgstrs)
+            convert(s);
+    }
+    pos = header_value(text, "charset=", size);
+    if (pos != std::string::npos)
+        text.replace(pos, size, "UTF-8");
+}
+
+/**
+ *  Reads the entries of a .po or .pot file, keeping everything that
+ *  po_entry_text() writes: comments, references, flags, the previous
+ *  msgid ("#|"), and obsolete entries ("#~"). The strings are converted
+ *  to UTF-8 (see convert_entries()).
+ *
+ * \param text
+ *      The contents of the file.
+ *
+ * \param [out] entries
+ *      Receives the entries, in file order.
+ *
+ * \param [out] errorline
+ *      If not null, receives the number of the line that could not be
+ *      parsed.
+ *
+ * \return
+ *      Returns false if a line could not be parsed.
+ */
+
+bool
+parse_po_entries
+(
+    const std::string & text,
+    std::vector<poentry> & entries,
+    int * errorline
+)
+{
+    entries.clear();
+
+    poentry e;
+    bool started = false;                   /* e has a keyword line         */
+    bool done = false;                      /* e has its msgstr             */
+    bool in_previous = false;               /* continuing a "#| msgid"      */
+    std::string * target = nullptr;         /* string continued by "..."    */
+    auto flush = [&] ()
+    {
+        if (started)
+            entries.push_back(e);
+
+        e = poentry();
+        started = done = in_previous = false;
+        target = nullptr;
+    };
+    auto fail = [errorline] (int lineno)
+    {
+        if (not_nullptr(errorline))
+            *errorline = lineno;
+
+        return false;
+    };
+
+    std::istringstream in(text);
+    std::string line;
+    int lineno = 0;
+    while (std::getline(in, line))
+    {
+        ++lineno;
+        if (! line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        bool obsolete = false;
+        if (line.compare(0, 2, "#~") == 0)
+        {
+            obsolete = true;
+            line.erase(0, line.size() > 2 && line[2] == ' ' ? 3 : 2);
+            if (! line.empty() && line[0] == '|')
+                continue;                   /* previous of an obsolete one  */
+        }
+
+        std::size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos)
+        {
+            target = nullptr;
+            in_previous = false;
+            continue;
+        }
+        if (line[0] == '#')
+        {
+            char kind = line.size() > 1 ? line[1] : ' ' ;
+            if (kind == '|' && in_previous && line.find("\"") == 3)
+            {
+                std::string s;
+                if (quoted_string(line, s))
+                    e.previous_msgid += s;
+
+                continue;
+            }
+            if (done)
+                flush();
+
+            target = nullptr;
+            in_previous = false;
+
+            std::size_t skip = line.size() > 2 && line[2] == ' ' ? 3 : 2 ;
+            std::string rest = line.size() > skip ? line.substr(skip) : "" ;
+            if (kind == ' ')
+                e.comments.push_back(rest);
+            else if (kind == '.')
+                e.extracted.push_back(rest);
+            else if (kind == ':')
+            {
+                std::istringstream refs(rest);
+                std::string r;
+                while (refs >> r)
+                    e.references.push_back(r);
+            }
+            else if (kind == ',')
+            {
+                std::istringstream flags(rest);
+                std::string f;
+                while (std::getline(flags, f, ','))
+                {
+                    std::size_t b = f.find_first_not_of(" \t");
+                    std::size_t x = f.find_last_not_of(" \t");
+                    if (b != std::string::npos)
+                        e.flags.push_back(f.substr(b, x - b + 1));
+                }
+            }
+            else if (kind == '|' && rest.compare(0, 6, "msgid ") == 0)
+            {
+                e.has_previous = in_previous = true;
+                if (! quoted_string(rest, e.previous_msgid))
+                    return fail(lineno);
+            }
+            continue;
+        }
+
+        std::string s;
+        if (line[first] == '"')
+        {
+            if (is_nullptr(target) || ! quoted_string(line, s))
+                return fail(lineno);
+
+            *target += s;
+            continue;
+        }
+
+        std::size_t kwend = line.find_first_of(" \t\"", first);
+        std::string keyword = line.substr(first, kwend - first);
+        if (! quoted_string(line, s))
+            return fail(lineno);
+
+        in_previous = false;
+        if (keyword == "msgctxt")
+        {
+            if (done)
+                flush();
+
+            e.has_ctxt = true;
+            target = &e.msgctxt;
+        }
+        else if (keyword == "msgid")
+        {
+            if (done || (started && ! e.has_ctxt))
+                flush();
+
+            target = &e.msgid;
+        }
+        else if (keyword == "msgid_plural" && started)
+        {
+            e.has_plural = true;
+            target = &e.msgid_plural;
+        }
+        else if (keyword == "msgstr" && started)
+        {
+            if (e.msgstrs.empty())
+                e.msgstrs.resize(1);
+
+            target = &e.msgstrs[0];
+            done = true;
+        }
+        else if (keyword.compare(0, 7, "msgstr[") == 0 && started)
+        {
+            std::size_t n = std::size_t(std::atoi(keyword.c_str() + 7));
+            if (n >= e.msgstrs.size())
+                e.msgstrs.resize(n + 1);
+
+            target = &e.msgstrs[n];
+            done = true;
+        }
+        else
+            return fail(lineno);
+
+        started = true;
+        e.obsolete = obsolete;
+        *target = s;
+    }
+    flush();
+    convert_entries(entries);
+    return true;
+}
+
+/**
+ *  Indexes the old entries.
+ *
+ * \param old
+ *      The entries of the old catalog, as read by parse_po_entries().
+ */
+
+pomerge::pomerge (std::vector<poentry> old) :
+    m_old               (std::move(old)),
+    m_header            (npos),
+    m_nplurals          (2),
+    m_keys              (),
+    m_postings          (),
+    m_gram_counts       (m_old.size(), 0),
+    m_threshold         (sm_default_threshold),
+    m_fuzzy_matching    (true),
+    m_keep_obsolete     (true),
+    m_previous          (false)
+{
+    for (std::size_t i = 0; i < m_old.size(); ++i)
+    {
+        if (is_header(m_old[i]))
+        {
+            m_header = i;
+            break;
+        }
+    }
+    if (m_header != npos && ! m_old[m_header].msgstrs.empty())
+    {
+        std::size_t size = 0;
+        const std::string & text = m_old[m_header].msgstrs[0];
+        std::size_t pos = header_value(text, "nplurals=", size);
+        if (pos != std::string::npos)
+        {
+            int n = std::atoi(text.c_str() + pos);
+            if (n > 0)
+                m_nplurals = unsigned(n);
+        }
+    }
+
+    /*
+     * A live entry wins over an obsolete one with the same key, so the
+     * live ones are inserted first.
+     */
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (std::size_t i = 0; i < m_old.size(); ++i)
+        {
+            const poentry & e = m_old[i];
+            if (i != m_header && e.obsolete == (pass == 1))
+                (void) m_keys.emplace(make_key(e), i);
+        }
+    }
+
+    /*
+     * Only translations that are not guesses already are offered as
+     * fuzzy matches.
+     */
+
+    std::vector<std::uint32_t> grams;
+    for (std::size_t i = 0; i < m_old.size(); ++i)
+    {
+        const poentry & e = m_old[i];
+        if (i == m_header || ! is_translated(e) || has_flag(e, "fuzzy"))
+            continue;
+
+        trigrams(e.msgid, grams);
+        m_gram_counts[i] = std::uint32_t(grams.size());
+        for (auto g : grams)
+            m_postings[g].push_back(std::uint32_t(i));
+    }
+}
+
+std::string
+pomerge::make_key (const poentry & e)
+{
+    return e.has_ctxt ? e.msgctxt + '\004' + e.msgid : e.msgid ;
+}
+
+/**
+ *  Gets the distinct trigrams of a string, which is padded with a null
+ *  byte at each end so that its first and last characters count as much
+ *  as the others.
+ */
+
+void
+pomerge::trigrams (const std::string & s, std::vector<std::uint32_t> & grams)
+{
+    grams.clear();
+
+    std::size_t n = s.size();
+    auto at = [&s, n] (std::size_t i)
+    {
+        return (i == 0 || i > n) ? 0u : std::uint32_t((unsigned char) s[i - 1]);
+    };
+    for (std::size_t i = 0; i < n; ++i)
+        grams.push_back((at(i) << 16) | (at(i + 1) << 8) | at(i + 2));
+
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+/**
+ *  The similarity of two strings as GNU msgmerge measures it: twice the
+ *  length of their longest common subsequence over the sum of their
+ *  lengths. 1.0 means equal, 0.0 means no character in common.
+ *
+ * \param row
+ *      Scratch space, so that repeated calls do not allocate.
+ */
+
+double
+pomerge::similarity
+(
+    const std::string & a,
+    const std::string & b,
+    std::vector<std::uint32_t> & row
+)
+{
+    std::size_t la = a.size();
+    std::size_t lb = b.size();
+    if (la + lb == 0)
+        return 1.0;
+
+    row.assign(lb + 1, 0);
+    for (std::size_t i = 1; i <= la; ++i)
+    {
+        std::uint32_t diagonal = 0;
+        for (std::size_t j = 1; j <= lb; ++j)
+        {
+            std::uint32_t above = row[j];
+            if (a[i - 1] == b[j - 1])
+                row[j] = diagonal + 1;
+            else if (row[j - 1] > row[j])
+                row[j] = row[j - 1];
+
+            diagonal = above;
+        }
+    }
+    return 2.0 * double(row[lb]) / double(la + lb);
+}
+
+/**
+ *  Finds the most similar translated old message, if it is at least as
+ *  similar as the threshold. The old messages sharing trigrams with this
+ *  one are counted from the postings lists, the ones that cannot reach the
+ *  threshold by their lengths alone are dropped, and the c_candidates
+ *  with the best trigram overlap (Dice coefficient) are compared in full.
+ *  Of equally similar messages, one with the same context is preferred.
+ */
+
+std::size_t
+pomerge::find_fuzzy (const poentry & e, workspace & ws) const
+{
+    trigrams(e.msgid, ws.w_grams);
+    if (ws.w_counts.size() < m_old.size())
+        ws.w_counts.assign(m_old.size(), 0);
+
+    ws.w_touched.clear();
+    ws.w_lists.clear();
+    for (auto g : ws.w_grams)
+    {
+        auto p = m_postings.find(g);
+        if (p != m_postings.end())
+            ws.w_lists.push_back(&p->second);
+    }
+    std::sort
+    (
+        ws.w_lists.begin(), ws.w_lists.end(),
+        [] (const std::vector<std::uint32_t> * a,
+            const std::vector<std::uint32_t> * b)
+        {
+            return a->size() < b->size();
+        }
+    );
+
+    std::size_t common = std::max(c_min_common, m_old.size() / c_common_ratio);
+    std::size_t used = 0;
+    for (const auto * list : ws.w_lists)
+    {
+        if (list->size() > common && used >= c_min_grams)
+            break;
+
+        ++used;
+        for (auto i : *list)
+        {
+            if (ws.w_counts[i]++ == 0)
+                ws.w_touched.push_back(i);
+        }
+    }
+
+    std::vector<std::pair<double, std::uint32_t>> candidates;
+    std::size_t la = e.msgid.size();
+    for (auto i : ws.w_touched)
+    {
+        std::uint32_t shared = ws.w_counts[i];
+        ws.w_counts[i] = 0;
+
+        std::size_t lb = m_old[i].msgid.size();
+        double bound = 2.0 * double(std::min(la, lb)) / double(la + lb);
+        if (bound < m_threshold)
+            continue;
+
+        double dice = 2.0 * double(shared) /
+            double(used + m_gram_counts[i]);
+
+        candidates.emplace_back(dice, i);
+    }
+    std::sort
+    (
+        candidates.begin(), candidates.end(),
+        [] (const std::pair<double, std::uint32_t> & a,
+            const std::pair<double, std::uint32_t> & b)
+        {
+            return a.first != b.first ? a.first > b.first : a.second < b.second ;
+        }
+    );
+    if (candidates.size() > c_candidates)
+        candidates.resize(c_candidates);
+
+    std::size_t result = npos;
+    double best = 0.0;
+    for (const auto & c : candidates)
+    {
+        const std::string & b = m_old[c.second].msgid;
+        double score = la * b.size() > c_max_cells ?
+            c.first : similarity(e.msgid, b, ws.w_row) ;
+
+        bool better = result == npos || score > best ||
+        (
+            score == best && same_context(e, m_old[c.second]) &&
+            ! same_context(e, m_old[result])
+        );
+        if (score >= m_threshold && better)
+        {
+            result = c.second;
+            best = score;
+        }
+    }
+    return result;
+}
+
+/**
+ *  Finds the old entry to merge into a new one: the one with the same
+ *  msgctxt and msgid, or else the most similar one, if fuzzy matching is
+ *  on. Safe to call from several threads, each with its own workspace.
+ */
+
+pomerge::match
+pomerge::find (const poentry & e, workspace & ws) const
+{
+    match result{npos, false};
+    if (is_header(e))
+        return result;
+
+    auto it = m_keys.find(make_key(e));
+    if (it != m_keys.end())
+        result.m_index = it->second;
+    else if (m_fuzzy_matching && ! e.msgid.empty())
+    {
+        result.m_index = find_fuzzy(e, ws);
+        result.m_fuzzy = result.m_index != npos;
+    }
+    return result;
+}
+
+/**
+ *  Makes the merged entry for a template entry: the msgids, extracted
+ *  comments, references, and flags of the template, with the translator
+ *  comments and translations of the old entry. The entry is flagged fuzzy
+ *  if the match was fuzzy, the old entry was fuzzy, or the plural forms
+ *  changed.
+ */
+
+poentry
+pomerge::merge_entry (const poentry & e, const match & m) const
+{
+    poentry result = e;
+    result.flags.erase
+    (
+        std::remove(result.flags.begin(), result.flags.end(), "fuzzy"),
+        result.flags.end()
+    );
+    result.has_previous = false;
+    result.previous_msgid.clear();
+    result.obsolete = false;
+    if (m.m_index == npos || m.m_index >= m_old.size())
+    {
+        result.msgstrs.assign(e.has_plural ? m_nplurals : 1, std::string());
+        return result;
+    }
+
+    const poentry & old = m_old[m.m_index];
+    bool fuzzy = m.m_fuzzy || has_flag(old, "fuzzy");
+    result.comments = old.comments;
+    if (e.has_plural == old.has_plural)
+    {
+        result.msgstrs = old.msgstrs;
+        if (e.has_plural && e.msgid_plural != old.msgid_plural)
+            fuzzy = true;
+    }
+    else
+    {
+        std::string first = old.msgstrs.empty() ? std::string() : old.msgstrs[0] ;
+        result.msgstrs.assign(e.has_plural ? m_nplurals : 1, first);
+        fuzzy = true;
+    }
+    if (result.msgstrs.empty())
+        result.msgstrs.resize(1);
+
+    if (fuzzy)
+    {
+        result.flags.insert(result.flags.begin(), "fuzzy");
+        if (m_previous && old.msgid != e.msgid)
+        {
+            result.has_previous = true;
+            result.previous_msgid = old.msgid;
+        }
+    }
+    return result;
+}
+
+/**
+ *  Makes the merged catalog.
+ *
+ * \param pot
+ *      The entries of the new template.
+ *
+ * \param matches
+ *      The result of find() for each entry of the template.
+ *
+ * \return
+ *      Returns the header of the old catalog (with the POT-Creation-Date
+ *      of the template), the merged entries in template order, and then
+ *      the old translations no longer used, as obsolete entries, unless
+ *      set_keep_obsolete(false) was called.
+ */
+
+std::vector<poentry>
+pomerge::merge
+(
+    const std::vector<poentry> & pot,
+    const std::vector<match> & matches
+) const
+{
+    std::vector<poentry> result;
+    const poentry * potheader = nullptr;
+    for (const auto & e : pot)
+    {
+        if (is_header(e))
+        {
+            potheader = &e;
+            break;
+        }
+    }
+    if (m_header != npos)
+    {
+        poentry header = m_old[m_header];
+        if (not_nullptr(potheader) && ! potheader->msgstrs.empty())
+        {
+            static const std::string s_field = "POT-Creation-Date: ";
+            const std::string & from = potheader->msgstrs[0];
+            std::size_t size = 0;
+            std::size_t pos = header_value(from, s_field, size);
+            if (pos != std::string::npos && ! header.msgstrs.empty())
+            {
+                std::size_t end = from.find('\n', pos);
+                std::string date = from.substr(pos, end - pos);
+                std::string & to = header.msgstrs[0];
+                std::size_t topos = to.find(s_field);
+                if (topos != std::string::npos)
+                {
+                    topos += s_field.size();
+                    std::size_t toend = to.find('\n', topos);
+                    if (toend == std::string::npos)
+                        toend = to.size();
+
+                    to.replace(topos, toend - topos, date);
+                }
+            }
+        }
+        result.push_back(header);
+    }
+    else if (not_nullptr(potheader))
+        result.push_back(*potheader);
+
+    std::vector<bool> used(m_old.size(), false);
+    const match none{npos, false};
+    for (std::size_t i = 0; i < pot.size(); ++i)
+    {
+        if (is_header(pot[i]))
+            continue;
+
+        const match & m = i < matches.size() ? matches[i] : none ;
+        if (m.m_index < m_old.size())
+            used[m.m_index] = true;
+
+        result.push_back(merge_entry(pot[i], m));
+    }
+    if (m_keep_obsolete)
+    {
+        for (std::size_t i = 0; i < m_old.size(); ++i)
+        {
+            if (used[i] || i == m_header || ! is_translated(m_old[i]))
+                continue;
+
+            poentry e = m_old[i];
+            e.obsolete = true;
+            e.references.clear();
+            e.has_previous = false;
+            e.previous_msgid.clear();
+            result.push_back(e);
+        }
+    }
+    return result;
+}
+
+}               // namespace po
+
+/*
+ * pomerge.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -25,7 +25,7 @@
  * \library       potext
  * \author        Chris Ahlstrom
  * \date          2024-03-26
- * \updates       2024-04-12
+ * \updates       2026-10-17
  * \license       See above.
  *
  */
@@ -35,6 +35,7 @@
 
 #include "po/dictionary.hpp"            /* po::dictionary class             */
 #include "po/logstream.hpp"             /* po::logstream log-access funcs   */
+#include "po/manifest.hpp"              /* po::manifest key set             */
 #include "po/pluralforms.hpp"           /* po::pluralforms class            */
 #include "po/pomoparserbase.hpp"        /* po::pomoparserbase class         */
 
@@ -72,13 +73,37 @@ pomoparserbase::pomoparserbase
     const std::string & filename,
     std::istream & in,
     dictionary & dic,
-    bool usefuzzy
+    bool usefuzzy,
+    const manifest * mf
 ) :
     m_filename      (filename),
-    m_in_stream     (in),
+    m_in_stream     (&in),
     m_dict          (dic),
     m_converter     (filename),
-    m_use_fuzzy     (usefuzzy)
+    m_use_fuzzy     (usefuzzy),
+    m_manifest      (mf)
+{
+    // no code
+}
+
+/**
+ *  Constructor for a parser without an input stream, which is given its
+ *  input by other means.
+ */
+
+pomoparserbase::pomoparserbase
+(
+    const std::string & filename,
+    dictionary & dic,
+    bool usefuzzy,
+    const manifest * mf
+) :
+    m_filename      (filename),
+    m_in_stream     (nullptr),
+    m_dict          (dic),
+    m_converter     (filename),
+    m_use_fuzzy     (usefuzzy),
+    m_manifest      (mf)
 {
     // no code
 }
@@ -129,6 +154,50 @@ pomoparserbase::warning (const std::string & msg, std::size_t pos)
     }
 }
 
+/**
+ *  Checks the message against the manifest, if any. The parsers call this
+ *  function as soon as the message ID is known, so that unwanted messages
+ *  cost no conversion and no dictionary insertion. When catalogs are
+ *  merged, a message already loaded from a catalog of higher precedence
+ *  is not wanted either (see dictionary::shadowed()).
+ *
+ * \param msgctxt
+ *      The context of the message. If empty, the message has no context.
+ *      (The poparser's "present-but-empty" flag is treated as an empty
+ *      context.)
+ *
+ * \param msgid
+ *      The message ID. The empty header message is always wanted by the
+ *      manifest, but it is shadowed by the header of an earlier catalog.
+ */
+
+bool
+pomoparserbase::wanted
+(
+    const std::string & msgctxt,
+    const std::string & msgid
+) const
+{
+    if (msgctxt.empty())
+    {
+        if (m_dict.shadowed(msgid))
+            return false;
+
+        return is_nullptr(m_manifest) || m_manifest->contains(msgid);
+    }
+    else
+    {
+        std::string ctxt;
+        if (msgctxt != MSGCTXT_EMPTY_FLAG)
+            ctxt = msgctxt;
+
+        if (m_dict.shadowed(ctxt, msgid))
+            return false;
+
+        return is_nullptr(m_manifest) || m_manifest->contains(ctxt, msgid);
+    }
+}
+
 /**
  *  Applies the iconvert character-set conversion to all of the phrases
  *  in the phrase-list. Also calls fix_message() in case there are
@@ -178,6 +247,131 @@ pomoparserbase::fix_message (const std::string & msg)
     return result;
 }
 
+/**
+ * \param header
+ *      This string consist of all of the header lines crammed together,
+ *      separated by backslashes:
+ *
+\verbatim
+    "Project-Id-Version: PACKAGE VERSION\\Report-Msgid-Bugs-To: \\POT-Creation-
+    Date: 2009-01-30 08:01+0100\\PO-Revision-Date: 2009-01-30 08:39 +0100\\
+    Last-Translator: FULL NAME <EMAIL@ADDRESS>\\Language-Team: LANGUAGE <LL@li.
+    org>\\MIME-Version: 1.0\\Content-Type: text/plain; charset=UTF-8\\
+    Content-Transfer-Encoding: 8bit\\"
+\endverbatim
+ *
+ *  Belay that! That was a bug that changed "\n" to "\\". The end character is
+ *  a newline.
+ *
+ * \param [out] big5
+ *      Set to true if the charset is "BIG5", whose two-byte characters the
+ *      .po parsers copy without looking for escapes.
+ */
+
+bool
+pomoparserbase::parse_header (const std::string & header, bool & big5)
+{
+    std::string from_charset;
+    auto pos = header.find("Content-Type: text/plain; charset=");
+    if (pos != std::string::npos)
+    {
+        pos = header.find_first_of("=", pos + 1);
+        if (pos != std::string::npos)
+        {
+            auto slashpos = header.find_first_of("\n", ++pos);
+            if (slashpos != std::string::npos)
+            {
+                auto count = slashpos - pos;
+                from_charset = header.substr(pos, count);
+            }
+        }
+    }
+    else
+        warning(_("No Content-Type header detected"));
+
+    /*
+     *  We're going right to nplurals instead of this.
+     *
+     *      std::string::size_type pluralpos = header.find("Plural-Forms");
+     */
+
+    auto pluralpos = header.find("nplurals=");
+    if (pluralpos != std::string::npos)
+    {
+        auto slashpos = header.find_first_of("\n", pluralpos + 1);
+        if (slashpos != std::string::npos)
+        {
+            auto count = slashpos - pluralpos;
+            std::string plurals = header.substr(pluralpos, count);
+            pluralforms plural_forms = pluralforms::from_string(plurals);
+            if (! plural_forms)
+            {
+                warning(_("Unknown .po Plural-Forms"));
+                /*
+                 * TODO: m_plural_forms = "nplurals=1; plural=0";
+                 */
+            }
+            else
+            {
+                if (! dict().get_plural_forms())
+                {
+                    dict().set_plural_forms(plural_forms);
+                }
+                else
+                {
+                    if (dict().get_plural_forms() != plural_forms)
+                    {
+                        warning
+                        (
+                            _("Plural-Forms mismatch between .po "
+                            "file and dictionary")
+                        );
+                    }
+                }
+            }
+        }
+    }
+    if (from_charset.empty() || from_charset == "CHARSET")
+    {
+        if (pedantic())
+            warning(_("Charset not found for .po; fallback to UTF-8"));
+
+        from_charset = "UTF-8";
+    }
+    else if (from_charset == "BIG5")
+    {
+        big5 = true;
+    }
+    return converter().set_charsets
+    (
+        from_charset, dictionary::storage_charset()
+    );
+}
+
+/**
+ *  Fixes the header as parsed earlier by changing backlashes to the
+ *  string "\n" and adding quotes.  This matches what is stored in a
+ *  .po file.
+ *
+ *      std::string result = "\"";  // start with a double-quote char
+ */
+
+std::string
+pomoparserbase::fix_po_header (const std::string & header)
+{
+    std::string result;
+    for (auto ch : header)
+    {
+        result += ch;
+        if (ch == '\\')                 /* essentially an end-of-liner      */
+            result += "n\"\n\"";        /* Add \n" plus newline and next "  */
+    }
+    if (result.back() == '"')
+        result.pop_back();              /* remove last quote character      */
+
+    return result;
+}
+
 }               // namespace po
 
 /*
@@ -30,7 +30,7 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-13
+ * \updates       2026-10-17
  * \license       See above.
  *
  * Dicionary add() statuses:
@@ -50,6 +50,7 @@
 #include "po/logstream.hpp"             /* po::logstream log-access funcs   */
 #include "po/pluralforms.hpp"           /* po::pluralforms class            */
 #include "po/poparser.hpp"              /* po::poparser class               */
+#include "po/probes.hpp"                /* POTEXT_PROBE1() etc.             */
 
 /**
  *  We cannot enable translation in this module, because it leads to recursion
@@ -79,9 +80,10 @@ poparser::poparser
     const std::string & filename,
     std::istream & in,
     dictionary & dic,
-    bool usefuzzy
+    bool usefuzzy,
+    const manifest * mf
 ) :
-    pomoparserbase  (filename, in, dic, usefuzzy),
+    pomoparserbase  (filename, in, dic, usefuzzy, mf),
     m_eof           (false),
     m_big5          (false),
     m_line_number   (0),
@@ -99,17 +101,28 @@ poparser::parse_po_file
 (
     const std::string & filename,
     std::istream & in,
-    dictionary & dic
+    dictionary & dic,
+    bool usefuzzy,
+    const manifest * mf
 )
 {
-    poparser parser(filename, in, dic);
+    POTEXT_PROBE1(parse__begin, filename.c_str());
+    poparser parser(filename, in, dic, usefuzzy, mf);
     bool result = parser.parse();
     if (result)
         dic.file_mode(dictionary::mode::po);
 
+    POTEXT_PROBE2(parse__end, filename.c_str(), int(result));
     return result;
 }
 
+/**
+ *  Reads the next line. At the end of the file the current line is
+ *  cleared, so it reads as an empty line. std::getline() leaves it alone
+ *  when the stream is already at EOF, and a file ending in 'msgstr[0] ""'
+ *  without a newline then made get_msgid_plural() read that line forever.
+ */
+
 bool
 poparser::next_line ()
 {
@@ -120,6 +133,7 @@ poparser::next_line ()
     }
     else
     {
+        m_current_line.clear();
         m_eof = true;
         return false;
     }
@@ -298,100 +312,6 @@ next:
     return ssout.str();
 }
 
-/**
- * \param header
- *      This string consist of all of the header lines crammed together,
- *      separated by backslashes:
- *
-\verbatim
-    "Project-Id-Version: PACKAGE VERSION\\Report-Msgid-Bugs-To: \\POT-Creation-
-    Date: 2009-01-30 08:01+0100\\PO-Revision-Date: 2009-01-30 08:39 +0100\\
-    Last-Translator: FULL NAME <EMAIL@ADDRESS>\\Language-Team: LANGUAGE <LL@li.
-    org>\\MIME-Version: 1.0\\Content-Type: text/plain; charset=UTF-8\\
-    Content-Transfer-Encoding: 8bit\\"
-\endverbatim
- *
- *  Belay that! That was a bug that changed "\n" to "\\". The end character is
- *  a newline.
- */
-
-bool
-poparser::parse_header (const std::string & header)
-{
-    std::string from_charset;
-    auto pos = header.find("Content-Type: text/plain; charset=");
-    if (pos != std::string::npos)
-    {
-        pos = header.find_first_of("=", pos + 1);
-        if (pos != std::string::npos)
-        {
-            auto slashpos = header.find_first_of("\n", ++pos);
-            if (slashpos != std::string::npos)
-            {
-                auto count = slashpos - pos;
-                from_charset = header.substr(pos, count);
-            }
-        }
-    }
-    else
-        warning(_("No Content-Type header detected"));
-
-    /*
-     *  We're going right to nplurals instead of this.
-     *
-     *      std::string::size_type pluralpos = header.find("Plural-Forms");
-     */
-
-    auto pluralpos = header.find("nplurals=");
-    if (pluralpos != std::string::npos)
-    {
-        auto slashpos = header.find_first_of("\n", pluralpos + 1);
-        if (slashpos != std::string::npos)
-        {
-            auto count = slashpos - pluralpos;
-            std::string plurals = header.substr(pluralpos, count);
-            pluralforms plural_forms = pluralforms::from_string(plurals);
-            if (! plural_forms)
-            {
-                warning(_("Unknown .po Plural-Forms"));
-                /*
-                 * TODO: m_plural_forms = "nplurals=1; plural=0";
-                 */
-            }
-            else
-            {
-                if (! dict().get_plural_forms())
-                {
-                    dict().set_plural_forms(plural_forms);
-                }
-                else
-                {
-                    if (dict().get_plural_forms() != plural_forms)
-                    {
-                        warning
-                        (
-                            _("Plural-Forms mismatch between .po "
-                            "file and dictionary")
-                        );
-                    }
-                }
-            }
-        }
-    }
-    if (from_charset.empty() || from_charset == "CHARSET")
-    {
-        if (pedantic())
-            warning(_("Charset not found for .po; fallback to UTF-8"));
-
-        from_charset = "UTF-8";
-    }
-    else if (from_charset == "BIG5")
-    {
-        m_big5 = true;
-    }
-    return converter().set_charsets(from_charset, dict().get_charset());
-}
-
 bool
 poparser::is_empty_line ()
 {
@@ -589,6 +509,9 @@ poparser::get_msgid_plural
     std::string msgid_plural = get_string(12);
     phraselist msglist;
     bool saw_nonempty_msgstr = false;
+    bool keep = (use_fuzzy() || ! fuzzy) && wanted(msgctxt, msgid);
+    if (fuzzy)
+        dict().note_fuzzy();                /* see set_use_fuzzy()          */
 
 next:
 
@@ -612,14 +535,20 @@ next:
          *  Can leave some empty strings in this vector.
          */
 
-        if (number >= msglist.size())
-            msglist.resize(number + 1);
+        if (keep)
+        {
+            /*
+             *  The conversion is done by convert_list() below.
+             */
+
+            if (number >= msglist.size())
+                msglist.resize(number + 1);
+
+            msglist[number] = msgstr;
+        }
+        else if (msglist.empty())
+            msglist.resize(1);              /* just for the checks below    */
 
-        msglist[number] = converter().convert(msgstr);
-#if defined PLATFORM_DEBUG_TMI
-        if (msglist[number].empty())
-            std::cerr << "ERROR in " << m_filename << std::endl;
-#endif
         goto next;
     }
     else
@@ -630,7 +559,7 @@ next:
 
     if (saw_nonempty_msgstr)
     {
-        if (use_fuzzy() || ! fuzzy)
+        if (keep)
         {
             if (! dict().get_plural_forms())
             {
@@ -719,30 +648,6 @@ fix_header_mo (const std::string & header)
 
 #endif  // defined USE_FIX_HEADER_MO
 
-/**
- *  Fixes the header as parsed earlier by changing backlashes to the
- *  string "\n" and adding quotes.  This matches what is stored in a
- *  .po file.
- *
- *      std::string result = "\"";  // start with a double-quote char
- */
-
-static std::string
-fix_po_header (const std::string & header)
-{
-    std::string result;
-    for (auto ch : header)
-    {
-        result += ch;
-        if (ch == '\\')                 /* essentially an end-of-liner      */
-            result += "n\"\n\"";        /* Add \n" plus newline and next "  */
-    }
-    if (result.back() == '"')
-        result.pop_back();              /* remove last quote character      */
-
-    return result;
-}
-
 /**
  *  Message context and message ID. This function, as of version 0.2,
  *  stores the header with the first (empty) message ID, similar to
@@ -761,8 +666,8 @@ poparser::get_msgstr
     std::string msgstr = get_string(6);
     if (msgid.empty())
     {
-        result = parse_header(msgstr);
-        if (result)
+        result = parse_header(msgstr, m_big5);
+        if (result && wanted(msgctxt, msgid))       /* not shadowed     */
         {
             msgstr = fix_po_header(msgstr);
             (void) dict().add(msgid, msgstr);
@@ -774,7 +679,10 @@ poparser::get_msgstr
     }
     else
     {
-        if (use_fuzzy() || ! fuzzy)
+        if (fuzzy)
+            dict().note_fuzzy();            /* see set_use_fuzzy()          */
+
+        if ((use_fuzzy() || ! fuzzy) && wanted(msgctxt, msgid))
         {
             std::string msg0 = fix_message(msgid);
             std::string msg1 = converter().convert(fix_message(msgstr));
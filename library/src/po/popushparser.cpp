@@ -0,0 +1,668 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          popushparser.cpp
+ *
+ *      A .po parser that is given its input in pieces, as it arrives.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  See the banner of popushparser.hpp. The entries are added to the
+ *  dictionary as poparser::get_msgstr() and poparser::get_msgid_plural()
+ *  add them.
+ */
+
+#include <cctype>                       /* std::isalpha(), std::isdigit()   */
+#include <cstring>                      /* std::memchr()                    */
+
+#include "po/dictionary.hpp"            /* po::dictionary class             */
+#include "po/pluralforms.hpp"           /* po::pluralforms class            */
+#include "po/popushparser.hpp"          /* po::popushparser class           */
+#include "po/probes.hpp"                /* POTEXT_PROBE1() etc.             */
+
+#if ! defined PO_HAVE_GETTEXT_RECURSIVE
+#define _(str)      str
+#endif
+
+namespace po
+{
+
+/**
+ *  An internal flag to handle present-but-empty "msgctxt" tags. See
+ *  poparser::parse().
+ */
+
+#define MSGCTXT_EMPTY_FLAG      "-"
+
+/**
+ *  The longest keyword, "msgid_plural".
+ */
+
+static const std::size_t c_max_keyword = 12;
+
+/**
+ *  The UTF-8 byte-order mark.
+ */
+
+static const char c_bom [] = { '\xef', '\xbb', '\xbf' };
+
+static bool
+is_blank (char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ *  Constructor.
+ */
+
+popushparser::popushparser
+(
+    const std::string & filename,
+    dictionary & dict,
+    bool usefuzzy,
+    const manifest * mf
+) :
+    pomoparserbase  (filename, dict, usefuzzy, mf),
+    m_state         (state::line_start),
+    m_byte_count    (0),
+    m_bom_count     (0),
+    m_line_number   (1),
+    m_big5          (false),
+    m_finished      (false),
+    m_token         (),
+    m_spaces        (0),
+    m_fuzzy         (false),
+    m_has_ctxt      (false),
+    m_has_msgid     (false),
+    m_has_plural    (false),
+    m_has_msgstr    (false),
+    m_msgctxt       (),
+    m_msgid         (),
+    m_msgid_plural  (),
+    m_msgstrs       (),
+    m_target        (nullptr),
+    m_entry_count   (0)
+{
+    POTEXT_PROBE1(parse__begin, filename.c_str());
+}
+
+/**
+ *  Parses the next piece of the catalog. Complete entries are added to
+ *  the dictionary; a partial one is kept for the next call.
+ *
+ * \param data
+ *      The bytes, which need not end at a line, or even a character.
+ *
+ * \param size
+ *      The number of bytes.
+ *
+ * \return
+ *      Returns false if there is an error in the input so far, or if
+ *      finish() has been called. Once false, the rest of the input is
+ *      ignored.
+ */
+
+bool
+popushparser::feed (const char * data, std::size_t size)
+{
+    if (m_finished || failed())
+        return false;
+
+    const char * p = data;
+    const char * end = data + size;
+    try
+    {
+        while (p < end && m_bom_count == m_byte_count && m_byte_count < 3)
+            check_bom(*p++);
+
+        m_byte_count += std::size_t(end - p);
+        while (p < end)
+        {
+            if (m_state == state::in_string && ! m_big5)
+            {
+                const char * q = p;                 /* copy runs of text    */
+                while (q < end && *q != '"' && *q != '\\' && *q != '\n')
+                    ++q;
+
+                if (q > p)
+                {
+                    m_target->append(p, std::size_t(q - p));
+                    p = q;
+                    continue;
+                }
+            }
+            else if (m_state == state::comment)
+            {
+                const void * nl = std::memchr(p, '\n', std::size_t(end - p));
+                if (is_nullptr(nl))
+                    break;                          /* still in the comment */
+
+                p = static_cast<const char *>(nl);
+            }
+            step(*p++);
+        }
+    }
+    catch (const parser_error &)
+    {
+        m_state = state::failed;
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  Ends the input. The last entry is added, and the dictionary is marked
+ *  as loaded from a .po file. It is an error for the input to end inside
+ *  an entry, such as a msgid without a msgstr, or a string without its
+ *  closing quote.
+ *
+ * \return
+ *      Returns true if all of the input was parsed. Returns false if
+ *      there was no input, as poparser::parse() does.
+ */
+
+bool
+popushparser::finish ()
+{
+    if (m_finished)
+        return false;
+
+    m_finished = true;
+    bool result = ! failed() && m_byte_count > 0;
+    if (result)
+    {
+        try
+        {
+            if (m_bom_count == m_byte_count && m_bom_count < 3)
+            {
+                for (std::size_t i = 0; i < m_bom_count; ++i)
+                    step(c_bom[i]);                 /* not a mark after all */
+            }
+            if (m_state != state::line_start)
+                step('\n');                         /* end the last line    */
+
+            end_line();                             /* as if a blank line   */
+        }
+        catch (const parser_error &)
+        {
+            m_state = state::failed;
+            result = false;
+        }
+    }
+    if (result)
+        dict().file_mode(dictionary::mode::po);
+
+    POTEXT_PROBE2(parse__end, filename().c_str(), int(result));
+    return result;
+}
+
+/**
+ *  Matches a byte at the start of the input to the byte-order mark. If
+ *  it does not match, the bytes held so far are parsed after all.
+ */
+
+void
+popushparser::check_bom (char c)
+{
+    ++m_byte_count;
+    if (c == c_bom[m_bom_count])
+    {
+        ++m_bom_count;
+    }
+    else
+    {
+        for (std::size_t i = 0; i < m_bom_count; ++i)
+            step(c_bom[i]);
+
+        step(c);
+    }
+}
+
+/**
+ *  Parses one byte. The callers take care of the common runs of bytes.
+ */
+
+void
+popushparser::step (char c)
+{
+    switch (m_state)
+    {
+    case state::line_start:
+
+        if (c == '\n')
+        {
+            end_line();
+            ++m_line_number;
+        }
+        else if (is_blank(c))
+        {
+            // skip indentation; a line of only spaces is blank
+        }
+        else if (c == '#')
+        {
+            if (m_has_msgstr)
+                complete_entry();
+
+            m_target = nullptr;
+            m_state = state::comment_start;
+        }
+        else if (c == '"')
+        {
+            if (is_nullptr(m_target))
+                error(_("Unexpected string"), std::size_t(m_line_number));
+
+            m_state = state::in_string;
+        }
+        else if (std::isalpha(static_cast<unsigned char>(c)))
+        {
+            m_token.assign(1, c);
+            m_state = state::keyword;
+        }
+        else
+            error(_("Expected a msg tag"), std::size_t(m_line_number));
+
+        break;
+
+    case state::comment_start:
+
+        if (c == ',')
+        {
+            m_token.clear();
+            m_state = state::flags;
+        }
+        else if (c == '\n')
+        {
+            ++m_line_number;
+            m_state = state::line_start;
+        }
+        else
+            m_state = state::comment;
+
+        break;
+
+    case state::comment:
+
+        if (c == '\n')
+        {
+            ++m_line_number;
+            m_state = state::line_start;
+        }
+        break;
+
+    case state::flags:
+
+        if (c == '\n')
+        {
+            if (m_token.find("fuzzy") != std::string::npos)
+                m_fuzzy = true;
+
+            ++m_line_number;
+            m_state = state::line_start;
+        }
+        else
+            m_token += c;
+
+        break;
+
+    case state::keyword:
+
+        if (c == ' ' || c == '\t')
+        {
+            start_keyword();
+            m_spaces = 1;
+            m_state = state::before_string;
+        }
+        else if (c == '"')
+        {
+            start_keyword();
+            if (pedantic())
+                warning(_("A single space must separate keyword and string"));
+
+            m_state = state::in_string;
+        }
+        else if (c == '\n')
+        {
+            error(_("Unexpected end of line"), std::size_t(m_line_number));
+        }
+        else if (m_token.size() < c_max_keyword)
+        {
+            m_token += c;
+        }
+        else
+            error(_("Expected a msg tag"), std::size_t(m_line_number));
+
+        break;
+
+    case state::before_string:
+
+        if (c == '"')
+        {
+            if (m_spaces != 1 && pedantic())
+                warning(_("A single space must separate keyword and string"));
+
+            m_state = state::in_string;
+        }
+        else if (is_blank(c))
+        {
+            ++m_spaces;
+        }
+        else if (c == '\n')
+        {
+            error(_("Unexpected end of line"), std::size_t(m_line_number));
+        }
+        else
+        {
+            error
+            (
+                _("Tagged string must start with quote"),
+                std::size_t(m_line_number)
+            );
+        }
+        break;
+
+    case state::in_string:
+
+        if (c == '"')
+        {
+            m_state = state::after_string;
+        }
+        else if (c == '\\')
+        {
+            m_state = state::escape;
+        }
+        else if (c == '\n')
+        {
+            error(_("missing end-of-line quote"), std::size_t(m_line_number));
+        }
+        else
+        {
+            unsigned char uc = static_cast<unsigned char>(c);
+            *m_target += c;
+            if (m_big5 && uc >= 0x81 && uc <= 0xfe)
+                m_state = state::big5_trail;
+        }
+        break;
+
+    case state::escape:
+
+        m_state = state::in_string;
+        switch (c)
+        {
+        case 'a':  *m_target += '\a'; break;
+        case 'b':  *m_target += '\b'; break;
+        case 'v':  *m_target += '\v'; break;
+        case 'n':  *m_target += '\n'; break;
+        case 't':  *m_target += '\t'; break;
+        case 'r':  *m_target += '\r'; break;
+        case '"':  *m_target += '"';  break;
+        case '?':  *m_target += '?';  break;
+        case '\'': *m_target += '\''; break;
+        case '\\': *m_target += '\\'; break;
+        case '\n':
+
+            error
+            (
+                _("missing/incomplete '\\' code"),
+                std::size_t(m_line_number)
+            );
+            break;
+
+        default:
+            {
+                std::string msg = _("Unhandled escape");
+                msg += " '\\";
+                msg += c;
+                msg += "'";
+                warning(msg, std::size_t(m_line_number));
+                *m_target += '\\';
+                *m_target += c;
+            }
+            break;
+        }
+        break;
+
+    case state::big5_trail:
+
+        if (c == '\n')
+            error(_("Invalid Big5 encoding"), std::size_t(m_line_number));
+
+        *m_target += c;
+        m_state = state::in_string;
+        break;
+
+    case state::after_string:
+
+        if (c == '\n')
+        {
+            ++m_line_number;
+            m_state = state::line_start;
+        }
+        else if (! is_blank(c))
+        {
+            warning
+            (
+                _("Unexpected garbage after string ignored"),
+                std::size_t(m_line_number)
+            );
+            m_state = state::comment;
+        }
+        break;
+
+    case state::failed:
+
+        break;
+    }
+}
+
+/**
+ *  Handles a blank line, which ends the entry.
+ */
+
+void
+popushparser::end_line ()
+{
+    if (m_has_msgstr)
+        complete_entry();
+    else if (m_has_ctxt || m_has_msgid)
+        error(_("Expected 'msgstr'"), std::size_t(m_line_number));
+    else
+        clear_entry();                      /* drop flags of no entry       */
+}
+
+/**
+ *  Acts on the keyword in m_token, checking that it may come where it
+ *  does, and points m_target at the string it sets.
+ */
+
+void
+popushparser::start_keyword ()
+{
+    std::size_t line = std::size_t(m_line_number);
+    if (m_token == "msgctxt")
+    {
+        if (m_has_msgstr)
+            complete_entry();
+        else if (m_has_ctxt || m_has_msgid)
+            error(_("Unexpected 'msgctxt'"), line);
+
+        m_has_ctxt = true;
+        m_target = &m_msgctxt;
+    }
+    else if (m_token == "msgid")
+    {
+        if (m_has_msgstr)
+            complete_entry();
+        else if (m_has_msgid)
+            error(_("Unexpected 'msgid'"), line);
+
+        m_has_msgid = true;
+        m_target = &m_msgid;
+    }
+    else if (m_token == "msgid_plural")
+    {
+        if (! m_has_msgid || m_has_plural || m_has_msgstr)
+            error(_("Unexpected 'msgid_plural'"), line);
+
+        m_has_plural = true;
+        m_target = &m_msgid_plural;
+    }
+    else if (m_token == "msgstr")
+    {
+        if (! m_has_msgid || m_has_plural || m_has_msgstr)
+            error(_("Unexpected 'msgstr'"), line);
+
+        m_has_msgstr = true;
+        m_msgstrs.resize(1);
+        m_target = &m_msgstrs[0];
+    }
+    else if
+    (
+        m_token.size() == 9 && m_token.compare(0, 7, "msgstr[") == 0 &&
+        std::isdigit(static_cast<unsigned char>(m_token[7])) &&
+        m_token[8] == ']'
+    )
+    {
+        if (! m_has_plural)
+            error(_("Expected 'msgstr' entry"), line);
+
+        std::size_t number = std::size_t(m_token[7] - '0');
+        if (number >= m_msgstrs.size())
+            m_msgstrs.resize(number + 1);
+
+        m_has_msgstr = true;
+        m_target = &m_msgstrs[number];
+    }
+    else
+        error(_("Expected a msg tag"), line);
+}
+
+/**
+ *  Adds the entry read to the dictionary, as poparser does, and starts
+ *  a new one.
+ */
+
+void
+popushparser::complete_entry ()
+{
+    std::string msgctxt;
+    if (m_has_ctxt)
+        msgctxt = m_msgctxt.empty() ? MSGCTXT_EMPTY_FLAG : m_msgctxt ;
+
+    std::string ctxt;
+    if (msgctxt != MSGCTXT_EMPTY_FLAG)
+        ctxt = msgctxt;
+
+    if (! m_has_plural)
+    {
+        const std::string & msgstr = m_msgstrs[0];
+        if (m_msgid.empty())
+        {
+            if (parse_header(msgstr, m_big5) && wanted(msgctxt, m_msgid))
+                (void) dict().add(m_msgid, fix_po_header(msgstr));
+        }
+        else if (! msgstr.empty())
+        {
+            if (m_fuzzy)
+                dict().note_fuzzy();        /* see set_use_fuzzy()          */
+
+            if ((use_fuzzy() || ! m_fuzzy) && wanted(msgctxt, m_msgid))
+            {
+                std::string msg0 = fix_message(m_msgid);
+                std::string msg1 = converter().convert(fix_message(msgstr));
+                if (msgctxt.empty())
+                    (void) dict().add(msg0, msg1);
+                else
+                    (void) dict().add(ctxt, msg0, msg1);
+            }
+        }
+    }
+    else
+    {
+        bool keep = (use_fuzzy() || ! m_fuzzy) && wanted(msgctxt, m_msgid);
+        if (m_fuzzy)
+            dict().note_fuzzy();
+
+        bool saw_nonempty_msgstr = false;
+        for (const auto & s : m_msgstrs)
+        {
+            if (! s.empty())
+            {
+                saw_nonempty_msgstr = true;
+                break;
+            }
+        }
+        if (saw_nonempty_msgstr && keep)
+        {
+            if (! dict().get_plural_forms())
+            {
+                warning("msgstr[n] found, but no Plural-Form");
+            }
+            else
+            {
+                unsigned n = dict().get_plural_forms().get_nplural();
+                if (m_msgstrs.size() != n)
+                    warning(_("msgstr[n] count != Plural-Forms.nplural"));
+            }
+
+            std::string msg0 = fix_message(m_msgid);
+            std::string msgplural = fix_message(m_msgid_plural);
+            phraselist msglist2 = convert_list(m_msgstrs);
+            if (msgctxt.empty())
+                (void) dict().add(msg0, msgplural, msglist2);
+            else
+                (void) dict().add(ctxt, msg0, msgplural, msglist2);
+        }
+    }
+    ++m_entry_count;
+    clear_entry();
+}
+
+void
+popushparser::clear_entry ()
+{
+    m_fuzzy = false;
+    m_has_ctxt = false;
+    m_has_msgid = false;
+    m_has_plural = false;
+    m_has_msgstr = false;
+    m_msgctxt.clear();
+    m_msgid.clear();
+    m_msgid_plural.clear();
+    m_msgstrs.clear();
+    m_target = nullptr;
+}
+
+}               // namespace po
+
+/*
+ * popushparser.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,268 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          powriter.cpp
+ *
+ *      Functions to write .po and .pot entries.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  See the banner of powriter.hpp.
+ */
+
+#include "po/powriter.hpp"              /* po::poentry, po::po_string()     */
+#include "po/wstrfunctions.hpp"         /* po::escape_c_string()            */
+
+namespace po
+{
+
+/**
+ *  The width to which the reference lines are wrapped.
+ */
+
+static const std::size_t c_page_width = 79;
+
+/**
+ *  Writes a multi-line comment, one prefix per line.
+ */
+
+static void
+append_comment
+(
+    std::string & result,
+    const std::string & prefix,
+    const std::string & text
+)
+{
+    std::size_t pos = 0;
+    for (;;)
+    {
+        std::size_t nl = text.find('\n', pos);
+        std::string line = text.substr(pos, nl - pos);
+        result += line.empty() ? prefix.substr(0, prefix.size() - 1) : prefix ;
+        result += line;
+        result += '\n';
+        if (nl == std::string::npos)
+            break;
+
+        pos = nl + 1;
+    }
+}
+
+/**
+ *  Creates a keyword line such as 'msgid "text"'. If the text has a
+ *  newline before its end, it is written in the multi-line form:
+ *
+\verbatim
+    msgid ""
+    "first line\n"
+    "second line"
+\endverbatim
+ */
+
+std::string
+po_string (const std::string & keyword, const std::string & text)
+{
+    std::string result = keyword;
+    auto nl = text.find('\n');
+    if (nl == std::string::npos || nl + 1 == text.size())
+    {
+        result += " \"";
+        result += escape_c_string(text);
+        result += "\"\n";
+    }
+    else
+    {
+        result += " \"\"\n";
+        std::size_t pos = 0;
+        while (pos < text.size())
+        {
+            nl = text.find('\n', pos);
+            std::size_t end = nl == std::string::npos ? text.size() : nl + 1 ;
+            result += "\"";
+            result += escape_c_string(text.substr(pos, end - pos));
+            result += "\"\n";
+            pos = end;
+        }
+    }
+    return result;
+}
+
+/**
+ *  Puts a prefix, such as "#~ ", in front of every line of some text.
+ */
+
+static std::string
+prefix_lines (const std::string & prefix, const std::string & text)
+{
+    std::string result;
+    std::size_t pos = 0;
+    while (pos < text.size())
+    {
+        std::size_t nl = text.find('\n', pos);
+        std::size_t end = nl == std::string::npos ? text.size() : nl + 1 ;
+        result += prefix;
+        result += text.substr(pos, end - pos);
+        pos = end;
+    }
+    return result;
+}
+
+/**
+ *  Creates the text of one entry, without the blank line that separates
+ *  entries.
+ */
+
+std::string
+po_entry_text (const poentry & entry)
+{
+    std::string result;
+    for (const auto & c : entry.comments)
+        append_comment(result, "# ", c);
+
+    for (const auto & c : entry.extracted)
+        append_comment(result, "#. ", c);
+
+    std::string refline;
+    for (const auto & r : entry.references)
+    {
+        if (! refline.empty() && refline.size() + 1 + r.size() > c_page_width)
+        {
+            result += refline;
+            result += '\n';
+            refline.clear();
+        }
+        if (refline.empty())
+            refline = "#:";
+
+        refline += ' ';
+        refline += r;
+    }
+    if (! refline.empty())
+    {
+        result += refline;
+        result += '\n';
+    }
+    if (! entry.flags.empty())
+    {
+        result += "#,";
+        for (const auto & f : entry.flags)
+        {
+            result += ' ';
+            result += f;
+        }
+        result += '\n';
+    }
+    if (entry.has_previous)
+        result += prefix_lines("#| ", po_string("msgid", entry.previous_msgid));
+
+    std::string body;
+    if (entry.has_ctxt)
+        body += po_string("msgctxt", entry.msgctxt);
+
+    body += po_string("msgid", entry.msgid);
+    if (entry.has_plural)
+    {
+        body += po_string("msgid_plural", entry.msgid_plural);
+
+        std::size_t count = entry.msgstrs.size() < 2 ? 2 : entry.msgstrs.size();
+        for (std::size_t n = 0; n < count; ++n)
+        {
+            std::string kw = "msgstr[" + std::to_string(n) + "]";
+            std::string msgstr = n < entry.msgstrs.size() ?
+                entry.msgstrs[n] : std::string() ;
+
+            body += po_string(kw, msgstr);
+        }
+    }
+    else
+    {
+        std::string msgstr = entry.msgstrs.empty() ?
+            std::string() : entry.msgstrs[0] ;
+
+        body += po_string("msgstr", msgstr);
+    }
+    result += entry.obsolete ? prefix_lines("#~ ", body) : body ;
+    return result;
+}
+
+/**
+ *  Creates the usual template header, with the placeholders a translator
+ *  or msginit fills in.
+ *
+ * \param package
+ *      The package name for Project-Id-Version. If empty, "PACKAGE VERSION"
+ *      is used.
+ *
+ * \param plurals
+ *      If true, a Plural-Forms placeholder is included.
+ */
+
+std::string
+pot_header_text (const std::string & package, bool plurals)
+{
+    poentry header;
+    header.comments.push_back
+    (
+        "SOME DESCRIPTIVE TITLE.\n"
+        "Copyright (C) YEAR THE PACKAGE'S COPYRIGHT HOLDER\n"
+        "This file is distributed under the same license as the PACKAGE "
+        "package.\n"
+        "FIRST AUTHOR <EMAIL@ADDRESS>, YEAR.\n"
+    );
+    header.flags.push_back("fuzzy");
+    header.has_ctxt = header.has_plural = false;
+
+    std::string msgstr = "Project-Id-Version: ";
+    msgstr += package.empty() ? "PACKAGE VERSION" : package ;
+    msgstr +=
+        "\n"
+        "Report-Msgid-Bugs-To: \n"
+        "PO-Revision-Date: YEAR-MO-DA HO:MI+ZONE\n"
+        "Last-Translator: FULL NAME <EMAIL@ADDRESS>\n"
+        "Language-Team: LANGUAGE <LL@li.org>\n"
+        "Language: \n"
+        "MIME-Version: 1.0\n"
+        "Content-Type: text/plain; charset=UTF-8\n"
+        "Content-Transfer-Encoding: 8bit\n"
+        ;
+    if (plurals)
+        msgstr += "Plural-Forms: nplurals=INTEGER; plural=EXPRESSION;\n";
+
+    header.msgstrs.push_back(msgstr);
+    return po_entry_text(header);
+}
+
+}               // namespace po
+
+/*
+ * powriter.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,205 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          rtcatalog.cpp
+ *
+ *      Real-time-safe lookups on the images of a dictionary.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  See the banner of rtcatalog.hpp. Nothing after the constructor may
+ *  allocate, lock, or log; alloc_test checks it.
+ */
+
+#include "po/dictionary.hpp"            /* po::dictionary class             */
+#include "po/flatcatalog.hpp"           /* po::flatcatalog class            */
+#include "po/rtcatalog.hpp"             /* po::rtcatalog class              */
+
+namespace po
+{
+
+/**
+ *  Makes an empty handle, whose lookups return the message IDs.
+ */
+
+rtcatalog::rtcatalog () :
+    m_chain         (),
+    m_plural_forms  ()
+{
+    // no code
+}
+
+/**
+ *  Takes the images of a dictionary and of its fallbacks. A dictionary
+ *  that is not served from an image (see dictionarymgr::set_shared_cache())
+ *  is compiled into one, which costs about as much as loading it. This is
+ *  not real-time-safe; do it before the real-time threads start.
+ *
+ * \param dict
+ *      The dictionary, e.g. from dictionarymgr::get_dictionary(), which
+ *      loads it and its fallbacks.
+ */
+
+rtcatalog::rtcatalog (const dictionary & dict) :
+    m_chain         (),
+    m_plural_forms  (dict.get_plural_forms())
+{
+    const dictionary * d = &dict;
+    while (not_nullptr(d) && m_chain.size() < sm_max_chain)
+    {
+        std::shared_ptr<const flatcatalog> image = d->shared_flat();
+        if (! image)
+        {
+            auto compiled = std::make_shared<flatcatalog>();
+            if (! compiled->assign(flatcatalog::compile(*d)))
+                break;
+
+            image = compiled;
+        }
+        (void) image->prefault();
+        m_chain.push_back(image);
+        d = d->fallback();
+    }
+}
+
+/**
+ *  Looks up a message without a context, falling back as
+ *  dictionary::find() does.
+ *
+ * \return
+ *      Returns the translation, or \a msgid if there is none.
+ */
+
+std::string_view
+rtcatalog::translate (std::string_view msgid) const noexcept
+{
+    for (const auto & image : m_chain)
+    {
+        std::string_view msgstr = image->msgstr(image->lookup(msgid), 0);
+        if (! msgstr.empty())
+            return msgstr;
+    }
+    return msgid;
+}
+
+/**
+ *  Looks up a message in a context, falling back as
+ *  dictionary::find_ctxt() does.
+ */
+
+std::string_view
+rtcatalog::translate_ctxt
+(
+    std::string_view msgctxt,
+    std::string_view msgid
+) const noexcept
+{
+    for (const auto & image : m_chain)
+    {
+        std::string_view msgstr =
+            image->msgstr(image->lookup(msgctxt, msgid), 0);
+
+        if (! msgstr.empty())
+            return msgstr;
+    }
+    return msgid;
+}
+
+std::string_view
+rtcatalog::translate_plural
+(
+    std::string_view msgid,
+    std::string_view msgid_plural,
+    int n
+) const noexcept
+{
+    return find_plural(nullptr, msgid, msgid_plural, n);
+}
+
+std::string_view
+rtcatalog::translate_ctxt_plural
+(
+    std::string_view msgctxt,
+    std::string_view msgid,
+    std::string_view msgid_plural,
+    int n
+) const noexcept
+{
+    return find_plural(&msgctxt, msgid, msgid_plural, n);
+}
+
+/**
+ *  Looks up the plural form of a message for a count, in the dictionary
+ *  itself, as dictionary::translate_plural() does.
+ *
+ * \param msgctxt
+ *      The context, or null if the message has none.
+ *
+ * \return
+ *      Returns the translation. If there is none, returns \a msgid if
+ *      \a n is 1, or else \a msgid_plural. If the plural form is beyond the
+ *      translations, returns \a msgid.
+ */
+
+std::string_view
+rtcatalog::find_plural
+(
+    const std::string_view * msgctxt,
+    std::string_view msgid,
+    std::string_view msgid_plural,
+    int n
+) const noexcept
+{
+    if (! m_chain.empty())
+    {
+        const flatcatalog & image = *m_chain.front();
+        std::size_t index = not_nullptr(msgctxt) ?
+            image.lookup(*msgctxt, msgid) : image.lookup(msgid) ;
+
+        if (index != flatcatalog::npos)
+        {
+            unsigned form = m_plural_forms.get_plural(n);
+            if (form >= image.msgstr_count(index))
+                return msgid;
+
+            std::string_view msgstr = image.msgstr(index, form);
+            if (! msgstr.empty())
+                return msgstr;
+        }
+    }
+    return n == 1 ? msgid : msgid_plural ;
+}
+
+}               // namespace po
+
+/*
+ * rtcatalog.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,630 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          searchindex.cpp
+ *
+ *      A substring and prefix index of the messages of a dictionary.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  See the banner of searchindex.hpp.
+ */
+
+#include <algorithm>                    /* std::sort(), std::lower_bound()  */
+#include <cstring>                      /* std::strncmp()                   */
+#include <unordered_set>                /* std::unordered_set<> template    */
+
+#include "po/dictionary.hpp"            /* po::dictionary class             */
+#include "po/searchindex.hpp"           /* po::searchindex class            */
+
+namespace po
+{
+
+searchindex::searchindex () :
+    m_entries       (),
+    m_pool          (),
+    m_segments      (),
+    m_suffixes      (),
+    m_suffix_segments (),
+    m_prefixes      (),
+    m_fold_case     (true)
+{
+    // no code
+}
+
+void
+searchindex::clear ()
+{
+    m_entries.clear();
+    m_pool.clear();
+    m_segments.clear();
+    m_suffixes.clear();
+    m_suffix_segments.clear();
+    m_prefixes.clear();
+}
+
+/**
+ *  Folds ASCII letters to lower case, if this index does so.
+ */
+
+std::string
+searchindex::fold (const std::string & text) const
+{
+    std::string result = text;
+    if (m_fold_case)
+    {
+        for (auto & ch : result)
+        {
+            if (ch >= 'A' && ch <= 'Z')
+                ch = char(ch - 'A' + 'a');
+        }
+    }
+    return result;
+}
+
+void
+searchindex::add_string
+(
+    const std::string & s,
+    std::size_t entry,
+    bool msgstr
+)
+{
+    if (! s.empty())
+    {
+        m_segments.push_back
+        (
+            segment{std::uint32_t(m_pool.size()), std::uint32_t(entry), msgstr}
+        );
+        m_pool += fold(s);
+        m_pool += '\0';
+    }
+}
+
+/**
+ *  Marks an empty slot of the suffix array while it is sorted.
+ */
+
+static const std::uint32_t c_no_suffix = UINT32_MAX;
+
+/**
+ *  Gets the start (or the end) of the slots of each symbol in a suffix
+ *  array of a string.
+ */
+
+static void
+get_buckets
+(
+    const std::uint32_t * text,
+    std::size_t n,
+    std::size_t k,
+    std::vector<std::uint32_t> & buckets,
+    bool ends
+)
+{
+    buckets.assign(k, 0);
+    for (std::size_t i = 0; i < n; ++i)
+        ++buckets[text[i]];
+
+    std::uint32_t sum = 0;
+    for (std::size_t c = 0; c < k; ++c)
+    {
+        std::uint32_t count = buckets[c];
+        sum += count;
+        buckets[c] = ends ? sum : sum - count ;
+    }
+}
+
+/**
+ *  Indicates the leftmost of a run of S-type positions (one whose suffix
+ *  sorts below the next one).
+ */
+
+static bool
+is_lms (const std::vector<char> & stype, std::size_t i)
+{
+    return i > 0 && stype[i] && ! stype[i - 1];
+}
+
+/**
+ *  Sorts the L-type suffixes from the sorted ones in the array, then the
+ *  S-type suffixes from those.
+ */
+
+static void
+induce
+(
+    const std::uint32_t * text,
+    std::uint32_t * sa,
+    std::size_t n,
+    std::size_t k,
+    const std::vector<char> & stype,
+    std::vector<std::uint32_t> & buckets
+)
+{
+    get_buckets(text, n, k, buckets, false);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::uint32_t j = sa[i];
+        if (j != c_no_suffix && j > 0 && ! stype[j - 1])
+            sa[buckets[text[j - 1]]++] = j - 1;
+    }
+    get_buckets(text, n, k, buckets, true);
+    for (std::size_t i = n; i-- > 0; /* nothing */)
+    {
+        std::uint32_t j = sa[i];
+        if (j != c_no_suffix && j > 0 && stype[j - 1])
+            sa[--buckets[text[j - 1]]] = j - 1;
+    }
+}
+
+/**
+ *  Builds the suffix array of a string of symbols by induced sorting
+ *  (SA-IS), in time proportional to its length. The LMS substrings are
+ *  sorted by one induction, named, and their order found by recursing on
+ *  the string of names; a second induction then sorts every suffix.
+ *
+ * \param text
+ *      The symbols, each less than k. The last must be 0, and the only 0.
+ *
+ * \param [out] sa
+ *      Gets the n positions of the text, sorted by their suffixes.
+ *
+ * \param n
+ *      The length of the text.
+ *
+ * \param k
+ *      The size of the alphabet.
+ */
+
+static void
+suffix_array
+(
+    const std::uint32_t * text,
+    std::uint32_t * sa,
+    std::size_t n,
+    std::size_t k
+)
+{
+    std::vector<char> stype(n);
+    stype[n - 1] = 1;
+    for (std::size_t i = n - 1; i-- > 0; /* nothing */)
+    {
+        stype[i] = text[i] < text[i + 1] ||
+            (text[i] == text[i + 1] && stype[i + 1]);
+    }
+
+    std::vector<std::uint32_t> buckets;
+    get_buckets(text, n, k, buckets, true);
+    std::fill(sa, sa + n, c_no_suffix);
+    for (std::size_t i = 1; i < n; ++i)
+    {
+        if (is_lms(stype, i))
+            sa[--buckets[text[i]]] = std::uint32_t(i);
+    }
+    induce(text, sa, n, k, stype, buckets);
+
+    /*
+     * Gather the sorted LMS substrings, and name them by their order,
+     * equal substrings getting the same name. The names go in the upper
+     * half, at half of their positions, then are packed at the end.
+     */
+
+    std::size_t n1 = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (is_lms(stype, sa[i]))
+            sa[n1++] = sa[i];
+    }
+    std::fill(sa + n1, sa + n, c_no_suffix);
+
+    std::uint32_t names = 0;
+    std::uint32_t prev = c_no_suffix;
+    for (std::size_t i = 0; i < n1; ++i)
+    {
+        std::uint32_t pos = sa[i];
+        bool differ = prev == c_no_suffix;
+        for (std::size_t d = 0; ! differ; ++d)
+        {
+            if (text[pos + d] != text[prev + d] ||
+                stype[pos + d] != stype[prev + d])
+            {
+                differ = true;
+            }
+            else if (d > 0)
+            {
+                if (is_lms(stype, pos + d) || is_lms(stype, prev + d))
+                    break;
+            }
+        }
+        if (differ)
+        {
+            ++names;
+            prev = pos;
+        }
+        sa[n1 + pos / 2] = names - 1;
+    }
+    for (std::size_t i = n, j = n; i-- > n1; /* nothing */)
+    {
+        if (sa[i] != c_no_suffix)
+            sa[--j] = sa[i];
+    }
+
+    std::uint32_t * text1 = sa + n - n1;
+    if (names < n1)
+    {
+        suffix_array(text1, sa, n1, names);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < n1; ++i)
+            sa[text1[i]] = std::uint32_t(i);
+    }
+
+    /*
+     * Put the LMS suffixes, now in order, at the ends of their buckets,
+     * and induce the rest from them.
+     */
+
+    for (std::size_t i = 1, j = 0; i < n; ++i)
+    {
+        if (is_lms(stype, i))
+            text1[j++] = std::uint32_t(i);
+    }
+    for (std::size_t i = 0; i < n1; ++i)
+        sa[i] = text1[sa[i]];
+
+    std::fill(sa + n1, sa + n, c_no_suffix);
+    get_buckets(text, n, k, buckets, true);
+    for (std::size_t i = n1; i-- > 0; /* nothing */)
+    {
+        std::uint32_t j = sa[i];
+        sa[i] = c_no_suffix;
+        sa[--buckets[text[j]]] = j;
+    }
+    induce(text, sa, n, k, stype, buckets);
+}
+
+/**
+ *  Sorts every position of the pool by the text from there. Each null
+ *  byte becomes a symbol of its own, below the other bytes, so that no
+ *  comparison runs past the end of a string; a 0 is added at the end for
+ *  suffix_array().
+ *
+ *  Texts that are the same to the end of their strings are ordered by the
+ *  position of their ends, an order that std::strncmp() treats as equal.
+ *
+ * \param pool
+ *      The strings, each ended by a null byte.
+ *
+ * \param nulls
+ *      The number of null bytes, which is the number of strings.
+ *
+ * \param [out] sa
+ *      Gets every position of the pool, sorted. The positions of the null
+ *      bytes come first, in order.
+ */
+
+static void
+sort_suffixes
+(
+    const std::string & pool,
+    std::size_t nulls,
+    std::vector<std::uint32_t> & sa
+)
+{
+    std::size_t n = pool.size();
+    std::vector<std::uint32_t> text(n + 1);
+    std::uint32_t nul = 1;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::uint32_t byte = static_cast<unsigned char>(pool[i]);
+        text[i] = byte == 0 ? nul++ : std::uint32_t(nulls) + byte ;
+    }
+    text[n] = 0;
+    sa.resize(n + 1);
+    suffix_array(text.data(), sa.data(), n + 1, nulls + 256);
+    sa.erase(sa.begin());
+}
+
+/**
+ *  Builds the index of all the messages of a dictionary, replacing the
+ *  current one. The time taken is that of sorting every position of every
+ *  string (see sort_suffixes()), so it is best built once and then queried
+ *  many times.
+ *
+ * \param dict
+ *      The dictionary. Its fallback dictionary is not included.
+ *
+ * \param foldcase
+ *      If true (the default), the searches ignore the case of ASCII
+ *      letters.
+ *
+ * \return
+ *      Returns false if the strings are too large for the 32-bit offsets
+ *      of the index, in which case the index is empty.
+ */
+
+bool
+searchindex::build (const dictionary & dict, bool foldcase)
+{
+    clear();
+    m_fold_case = foldcase;
+    auto addentry = [this]
+    (
+        bool has_ctxt,
+        const std::string & ctxt,
+        const std::string & msgid,
+        const std::string & msgid_plural,
+        const phraselist & msgstrs
+    )
+    {
+        std::size_t entry = m_entries.size();
+        m_entries.push_back(match{has_ctxt, ctxt, msgid});
+        add_string(msgid, entry, false);
+        add_string(msgid_plural, entry, false);
+        for (const auto & s : msgstrs)
+            add_string(s, entry, true);
+    };
+    dict.foreach
+    (
+        [&addentry]
+        (
+            const std::string & msgid,
+            const std::string & msgid_plural,
+            const phraselist & msgstrs
+        )
+        {
+            addentry(false, std::string(), msgid, msgid_plural, msgstrs);
+        }
+    );
+    dict.foreach_ctxt
+    (
+        [&addentry]
+        (
+            const std::string & ctxt,
+            const std::string & msgid,
+            const std::string & msgid_plural,
+            const phraselist & msgstrs
+        )
+        {
+            addentry(true, ctxt, msgid, msgid_plural, msgstrs);
+        }
+    );
+    if (m_pool.size() > std::size_t(UINT32_MAX))
+    {
+        clear();
+        return false;
+    }
+
+    /*
+     * The null bytes, one per segment, sort first; the rest are the
+     * suffixes. A suffix at the start of its segment is also a prefix.
+     */
+
+    std::vector<std::uint32_t> sa;
+    sort_suffixes(m_pool, m_segments.size(), sa);
+
+    std::vector<std::uint32_t> owner(m_pool.size());
+    for (std::size_t s = 0; s < m_segments.size(); ++s)
+    {
+        std::size_t start = m_segments[s].s_offset;
+        std::size_t stop = s + 1 < m_segments.size() ?
+            m_segments[s + 1].s_offset : m_pool.size() ;
+
+        auto first = owner.begin() + std::ptrdiff_t(start);
+        auto last = owner.begin() + std::ptrdiff_t(stop);
+        std::fill(first, last, std::uint32_t(s));
+    }
+    m_suffixes.assign(sa.begin() + m_segments.size(), sa.end());
+    m_suffix_segments.resize(m_suffixes.size());
+    m_prefixes.reserve(m_segments.size());
+    for (std::size_t i = 0; i < m_suffixes.size(); ++i)
+    {
+        std::uint32_t s = owner[m_suffixes[i]];
+        m_suffix_segments[i] = s;
+        if (m_suffixes[i] == m_segments[s].s_offset)
+            m_prefixes.push_back(s);
+    }
+    return true;
+}
+
+/**
+ *  Turns the segments matched into the sorted indexes of their messages.
+ *  With a limit, it stops once it has that many messages.
+ */
+
+std::vector<std::size_t>
+searchindex::collect
+(
+    const std::uint32_t * segments,
+    std::size_t count,
+    unsigned where,
+    std::size_t limit
+) const
+{
+    std::vector<std::size_t> result;
+    if (limit == 0)
+    {
+        result.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (in_scope(segments[i], where))
+                result.push_back(m_segments[segments[i]].s_entry);
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+    else
+    {
+        std::unordered_set<std::size_t> seen;
+        seen.reserve(limit);
+        for (std::size_t i = 0; i < count && result.size() < limit; ++i)
+        {
+            if (in_scope(segments[i], where))
+            {
+                std::size_t entry = m_segments[segments[i]].s_entry;
+                if (seen.insert(entry).second)
+                    result.push_back(entry);
+            }
+        }
+        std::sort(result.begin(), result.end());
+    }
+    return result;
+}
+
+/**
+ *  Gets the first messages with a string in the scope, the answer to a
+ *  search for empty text. The segments are in the order of the messages.
+ */
+
+std::vector<std::size_t>
+searchindex::first_entries (unsigned where, std::size_t limit) const
+{
+    std::vector<std::size_t> result;
+    for (std::uint32_t s = 0; s < std::uint32_t(m_segments.size()); ++s)
+    {
+        if (limit > 0 && result.size() == limit)
+            break;
+
+        std::size_t entry = m_segments[s].s_entry;
+        if (in_scope(s, where) && (result.empty() || result.back() != entry))
+            result.push_back(entry);
+    }
+    return result;
+}
+
+/**
+ *  Finds the messages that contain some text.
+ *
+ * \param text
+ *      The text to find. If empty, every message with a string in the
+ *      given scope matches, and the first ones are returned.
+ *
+ * \param where
+ *      Selects the strings searched: msgids, msgstrs, or all.
+ *
+ * \param limit
+ *      If not 0, the search stops once it has found this many messages.
+ *      These are the first ones found in the index, not necessarily the
+ *      lowest indexes.
+ *
+ * \return
+ *      Returns the indexes of the matching messages (see at()), in
+ *      order.
+ */
+
+std::vector<std::size_t>
+searchindex::find
+(
+    const std::string & text,
+    unsigned where,
+    std::size_t limit
+) const
+{
+    std::string key = fold(text);
+    if (key.empty())
+        return first_entries(where, limit);
+
+    const char * pool = m_pool.c_str();
+    std::size_t len = key.size();
+    auto lo = std::lower_bound
+    (
+        m_suffixes.begin(), m_suffixes.end(), key,
+        [pool, len] (std::uint32_t pos, const std::string & k)
+        {
+            return std::strncmp(pool + pos, k.c_str(), len) < 0;
+        }
+    );
+    auto hi = std::upper_bound
+    (
+        lo, m_suffixes.end(), key,
+        [pool, len] (const std::string & k, std::uint32_t pos)
+        {
+            return std::strncmp(k.c_str(), pool + pos, len) < 0;
+        }
+    );
+
+    return collect
+    (
+        m_suffix_segments.data() + (lo - m_suffixes.begin()),
+        std::size_t(hi - lo), where, limit
+    );
+}
+
+/**
+ *  Finds the messages with a string that starts with some text. The
+ *  parameters and result are those of find().
+ */
+
+std::vector<std::size_t>
+searchindex::find_prefix
+(
+    const std::string & text,
+    unsigned where,
+    std::size_t limit
+) const
+{
+    std::string key = fold(text);
+    if (key.empty())
+        return first_entries(where, limit);
+
+    const char * pool = m_pool.c_str();
+    std::size_t len = key.size();
+    const std::vector<segment> & segs = m_segments;
+    auto lo = std::lower_bound
+    (
+        m_prefixes.begin(), m_prefixes.end(), key,
+        [pool, len, &segs] (std::uint32_t s, const std::string & k)
+        {
+            return std::strncmp(pool + segs[s].s_offset, k.c_str(), len) < 0;
+        }
+    );
+    auto hi = std::upper_bound
+    (
+        lo, m_prefixes.end(), key,
+        [pool, len, &segs] (const std::string & k, std::uint32_t s)
+        {
+            return std::strncmp(k.c_str(), pool + segs[s].s_offset, len) < 0;
+        }
+    );
+    return collect
+    (
+        m_prefixes.data() + (lo - m_prefixes.begin()),
+        std::size_t(hi - lo), where, limit
+    );
+}
+
+}               // namespace po
+
+/*
+ * searchindex.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
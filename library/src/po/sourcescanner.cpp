@@ -0,0 +1,799 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          sourcescanner.cpp
+ *
+ *      Finds translatable strings in C and C++ source code.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  The scanning is done in two passes over a file: a small lexer turns the
+ *  text into tokens (identifiers, string literals, punctuation, and
+ *  "other"), and then the token list is searched for keyword calls. This
+ *  is much simpler than tracking the state of a call while lexing, and
+ *  the token list of even a large source file is small.
+ */
+
+#include <cctype>                       /* std::isalnum(), std::isdigit()   */
+
+#include "c_macros.h"                   /* not_nullptr() macro              */
+#include "po/logstream.hpp"             /* po::logstream::error(), etc.     */
+#include "po/sourcescanner.hpp"         /* po::sourcescanner class          */
+#include "po/wstrfunctions.hpp"         /* po::unescape_c_string(), etc.    */
+
+#if ! defined PO_HAVE_GETTEXT_RECURSIVE
+#define _(str)      str
+#endif
+
+namespace po
+{
+
+namespace
+{
+
+/**
+ *  The kinds of tokens the scanner cares about.
+ */
+
+enum class tokenkind
+{
+    identifier,
+    literal,
+    punctuation,
+    comment,
+    other
+};
+
+using token = struct
+{
+    tokenkind kind;
+    std::string text;                   /* unescaped literal, or comment    */
+    int line;                           /* the line the token starts on     */
+    int lastline;                       /* the line the token ends on       */
+};
+
+using tokens = std::vector<token>;
+
+bool
+is_ident_start (char c)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_' ||
+        static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool
+is_ident_char (char c)
+{
+    return is_ident_start(c) || std::isdigit(static_cast<unsigned char>(c));
+}
+
+bool
+is_raw_prefix (const std::string & id)
+{
+    return id == "R" || id == "LR" || id == "uR" || id == "UR" || id == "u8R";
+}
+
+bool
+is_string_prefix (const std::string & id)
+{
+    return id == "L" || id == "u" || id == "U" || id == "u8";
+}
+
+/**
+ *  Removes the comment delimiters, the leading white space and asterisks
+ *  of each line, and any blank lines at the start and the end.
+ */
+
+std::string
+clean_comment (const std::string & raw)
+{
+    std::string body;
+    if (raw.compare(0, 2, "//") == 0)
+    {
+        body = raw.substr(2);
+    }
+    else
+    {
+        body = raw.substr(2);
+        if (body.size() >= 2 && body.compare(body.size() - 2, 2, "*/") == 0)
+            body.resize(body.size() - 2);
+    }
+
+    std::vector<std::string> lines;
+    std::size_t pos = 0;
+    for (;;)
+    {
+        std::size_t nl = body.find('\n', pos);
+        std::string line = body.substr(pos, nl - pos);
+        auto first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+        {
+            line.clear();
+        }
+        else
+        {
+            line.erase(0, first);
+            if (! line.empty() && line[0] == '*')
+            {
+                line.erase(0, line.find_first_not_of('*'));
+                if (! line.empty() && line[0] == ' ')
+                    line.erase(0, 1);
+            }
+            line.erase(line.find_last_not_of(" \t\r\\") + 1);
+        }
+        lines.push_back(line);
+        if (nl == std::string::npos)
+            break;
+
+        pos = nl + 1;
+    }
+    while (! lines.empty() && lines.back().empty())
+        lines.pop_back();
+
+    std::string result;
+    bool started = false;
+    for (const auto & line : lines)
+    {
+        if (! started && line.empty())
+            continue;
+
+        if (started)
+            result += '\n';
+
+        result += line;
+        started = true;
+    }
+    return result;
+}
+
+/**
+ *  A small C/C++ lexer. It does not need to be exact, only to never
+ *  mistake the inside of a comment, character literal, or string literal
+ *  for code.
+ */
+
+class lexer
+{
+
+private:
+
+    const std::string & m_text;
+    std::size_t m_pos;
+    int m_line;
+
+public:
+
+    lexer (const std::string & text) :
+        m_text  (text),
+        m_pos   (0),
+        m_line  (1)
+    {
+        // no code
+    }
+
+    tokens tokenize ();
+
+private:
+
+    bool at_end () const
+    {
+        return m_pos >= m_text.size();
+    }
+
+    char peek (std::size_t ahead = 0) const
+    {
+        std::size_t p = m_pos + ahead;
+        return p < m_text.size() ? m_text[p] : 0 ;
+    }
+
+    void advance ()
+    {
+        if (m_text[m_pos] == '\n')
+            ++m_line;
+
+        ++m_pos;
+    }
+
+    void push
+    (
+        tokens & toks,
+        tokenkind kind,
+        const std::string & text,
+        int line
+    ) const
+    {
+        toks.push_back({kind, text, line, m_line});
+    }
+
+    void skip_line_comment ();
+    void skip_block_comment ();
+    void skip_quoted (char quote, std::string * content);
+    bool read_raw_string (std::string & content);
+    void skip_number ();
+
+};
+
+tokens
+lexer::tokenize ()
+{
+    tokens result;
+    while (! at_end())
+    {
+        char c = peek();
+        int line = m_line;
+        if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            advance();
+        }
+        else if (c == '/' && (peek(1) == '/' || peek(1) == '*'))
+        {
+            std::size_t start = m_pos;
+            if (peek(1) == '/')
+                skip_line_comment();
+            else
+                skip_block_comment();
+
+            std::string raw = m_text.substr(start, m_pos - start);
+            push(result, tokenkind::comment, clean_comment(raw), line);
+        }
+        else if (c == '"')
+        {
+            std::string content;
+            skip_quoted('"', &content);
+            push(result, tokenkind::literal, content, line);
+        }
+        else if (c == '\'')
+        {
+            skip_quoted('\'', nullptr);
+            push(result, tokenkind::other, std::string(), line);
+        }
+        else if (is_ident_start(c))
+        {
+            std::size_t start = m_pos;
+            while (! at_end() && is_ident_char(peek()))
+                advance();
+
+            std::string id = m_text.substr(start, m_pos - start);
+            if (peek() == '"' && is_raw_prefix(id))
+            {
+                std::string content;
+                if (read_raw_string(content))
+                    push(result, tokenkind::literal, content, line);
+                else
+                    push(result, tokenkind::other, std::string(), line);
+            }
+            else if (peek() == '"' && is_string_prefix(id))
+            {
+                std::string content;
+                skip_quoted('"', &content);
+                push(result, tokenkind::literal, content, line);
+            }
+            else if (peek() == '\'' && is_string_prefix(id))
+            {
+                skip_quoted('\'', nullptr);
+                push(result, tokenkind::other, std::string(), line);
+            }
+            else
+                push(result, tokenkind::identifier, id, line);
+        }
+        else if
+        (
+            std::isdigit(static_cast<unsigned char>(c)) ||
+            (c == '.' && std::isdigit(static_cast<unsigned char>(peek(1))))
+        )
+        {
+            skip_number();
+            push(result, tokenkind::other, std::string(), line);
+        }
+        else
+        {
+            advance();
+            push(result, tokenkind::punctuation, std::string(1, c), line);
+        }
+    }
+    return result;
+}
+
+void
+lexer::skip_line_comment ()
+{
+    while (! at_end() && peek() != '\n')
+    {
+        if (peek() == '\\' && peek(1) == '\n')      /* line continuation    */
+            advance();
+
+        advance();
+    }
+}
+
+void
+lexer::skip_block_comment ()
+{
+    advance();                                      /* the slash            */
+    advance();                                      /* the asterisk         */
+    while (! at_end() && ! (peek() == '*' && peek(1) == '/'))
+        advance();
+
+    if (! at_end())
+    {
+        advance();
+        advance();
+    }
+}
+
+/**
+ *  Skips a string or character literal, stopping at the closing quote or
+ *  (for broken code) at the end of the line. The content of a string
+ *  literal is unescaped.
+ */
+
+void
+lexer::skip_quoted (char quote, std::string * content)
+{
+    advance();                                      /* opening quote        */
+    std::size_t start = m_pos;
+    while (! at_end() && peek() != quote && peek() != '\n')
+    {
+        if (peek() == '\\' && m_pos + 1 < m_text.size())
+            advance();
+
+        advance();
+    }
+    if (not_nullptr(content))
+        *content = unescape_c_string(m_text.substr(start, m_pos - start));
+
+    if (! at_end() && peek() == quote)
+        advance();
+}
+
+/**
+ *  Reads R"delimiter( ... )delimiter". The content is not unescaped.
+ */
+
+bool
+lexer::read_raw_string (std::string & content)
+{
+    advance();                                      /* opening quote        */
+    std::size_t start = m_pos;
+    while (! at_end() && peek() != '(' && m_pos - start <= 16)
+        advance();
+
+    if (at_end() || peek() != '(')
+        return false;
+
+    std::string closing = ")" + m_text.substr(start, m_pos - start) + "\"";
+    advance();                                      /* the parenthesis      */
+
+    std::size_t endpos = m_text.find(closing, m_pos);
+    if (endpos == std::string::npos)
+        endpos = m_text.size();
+
+    content = m_text.substr(m_pos, endpos - m_pos);
+    while (m_pos < endpos)
+        advance();
+
+    for (std::size_t i = 0; i < closing.size() && ! at_end(); ++i)
+        advance();
+
+    return true;
+}
+
+/**
+ *  Skips a preprocessing number, including digit separators (1'000'000)
+ *  and signed exponents.
+ */
+
+void
+lexer::skip_number ()
+{
+    while (! at_end())
+    {
+        char c = peek();
+        if (is_ident_char(c) || c == '.')
+        {
+            advance();
+        }
+        else if (c == '\'' && is_ident_char(peek(1)))
+        {
+            advance();
+        }
+        else if
+        (
+            (c == '+' || c == '-') && m_pos > 0 &&
+            std::string("eEpP").find(m_text[m_pos - 1]) != std::string::npos
+        )
+        {
+            advance();
+        }
+        else
+            break;
+    }
+}
+
+/**
+ *  An argument of a keyword call. It is a literal only if it consists
+ *  solely of (adjacent) string literals.
+ */
+
+using argument = struct
+{
+    std::string text;
+    bool literal;
+};
+
+}           // anonymous namespace
+
+/**
+ *  Creates a scanner with the keywords defined in po/gettext.hpp and the
+ *  gettext functions, using the same argument positions as GNU xgettext.
+ */
+
+sourcescanner::sourcescanner () :
+    m_keywords      (),
+    m_comment_tag   (),
+    m_comments      (false)
+{
+    static const char * const s_defaults [] =
+    {
+        "_", "N_", "C_:1c,2", "gettext", "gettext_noop", "dgettext:2",
+        "dcgettext:2", "ngettext:1,2", "dngettext:2,3", "dcngettext:2,3",
+        "pgettext:1c,2", "dpgettext:2c,3", "dcpgettext:2c,3",
+        "npgettext:1c,2,3", "dnpgettext:2c,3,4", "dcnpgettext:2c,3,4"
+    };
+    for (const char * spec : s_defaults)
+        (void) add_keyword(std::string(spec));
+}
+
+/**
+ *  Adds a keyword, replacing one of the same name.
+ */
+
+void
+sourcescanner::add_keyword (const keyword & kw)
+{
+    for (auto & k : m_keywords)
+    {
+        if (k.name == kw.name)
+        {
+            k = kw;
+            return;
+        }
+    }
+    m_keywords.push_back(kw);
+}
+
+/**
+ *  Adds a keyword given in the format of the xgettext --keyword option:
+ *
+ *      -   "name". The message is the first argument.
+ *      -   "name:2". The message is the second argument.
+ *      -   "name:1,2". Singular and plural messages.
+ *      -   "name:1c,2". The first argument is the context.
+ *
+ *  The "t" (total arguments) and quoted-comment forms of xgettext are
+ *  accepted and ignored.
+ *
+ * \return
+ *      Returns false if the specification could not be parsed.
+ */
+
+bool
+sourcescanner::add_keyword (const std::string & spec)
+{
+    keyword kw{std::string(), 1, 0, 0};
+    auto colon = spec.find(':');
+    kw.name = spec.substr(0, colon);
+    bool result = ! kw.name.empty() && is_ident_start(kw.name[0]);
+    for (char c : kw.name)
+    {
+        if (! is_ident_char(c))
+            result = false;
+    }
+    if (result && colon != std::string::npos)
+    {
+        int msgnumbers = 0;
+        std::size_t pos = colon + 1;
+        while (result && pos <= spec.size())
+        {
+            auto comma = spec.find(',', pos);
+            std::string item = spec.substr(pos, comma - pos);
+            pos = comma == std::string::npos ? spec.size() + 1 : comma + 1 ;
+            if (item.empty())
+            {
+                result = false;
+            }
+            else if (item[0] == '"')
+            {
+                continue;                       /* a fixed comment, ignored */
+            }
+            else
+            {
+                std::size_t digits = item.find_first_not_of("0123456789");
+                std::string numeral = item.substr(0, digits);
+                int number = numeral.empty() || numeral.size() > 2 ?
+                    0 : std::stoi(numeral) ;
+
+                std::string suffix =
+                    digits == std::string::npos ? "" : item.substr(digits) ;
+
+                if (number == 0)
+                    result = false;
+                else if (suffix == "c")
+                    kw.ctxt_arg = number;
+                else if (suffix == "t")
+                    continue;                   /* argument count, ignored  */
+                else if (! suffix.empty())
+                    result = false;
+                else if (msgnumbers == 0)
+                    kw.msgid_arg = number;
+                else if (msgnumbers == 1)
+                    kw.plural_arg = number;
+                else
+                    result = false;
+
+                if (result && suffix.empty())
+                    ++msgnumbers;
+            }
+        }
+    }
+    if (result)
+        add_keyword(kw);
+
+    return result;
+}
+
+void
+sourcescanner::clear_keywords ()
+{
+    m_keywords.clear();
+}
+
+/**
+ *  Enables the extraction of comments preceding a keyword call. With an
+ *  empty tag, all such comments are extracted; otherwise the comment block
+ *  must start with the tag (e.g. "TRANSLATORS:"), as with the xgettext
+ *  --add-comments option.
+ */
+
+void
+sourcescanner::set_comment_tag (const std::string & tag)
+{
+    m_comment_tag = tag;
+    m_comments = true;
+}
+
+const sourcescanner::keyword *
+sourcescanner::find_keyword (const std::string & name) const
+{
+    for (const auto & k : m_keywords)
+    {
+        if (k.name == name)
+            return &k;
+    }
+    return nullptr;
+}
+
+/**
+ *  Returns the key of a message: the msgid, or the context, an EOT, and
+ *  the msgid, as in .mo files and manifests.
+ */
+
+std::string
+sourcescanner::make_key (const message & msg)
+{
+    if (msg.has_ctxt)
+    {
+        std::string result = msg.msgctxt;
+        result += '\004';
+        result += msg.msgid;
+        return result;
+    }
+    return msg.msgid;
+}
+
+bool
+sourcescanner::scan_file (const std::string & filename, messages & out) const
+{
+    std::string text;
+    bool result = read_file(filename, text);
+    if (result)
+    {
+        scan(text, filename, out);
+    }
+    else
+    {
+        logstream::error()
+            << _("error") << ": " << _("failure opening")
+            << ": " << filename << std::endl
+            ;
+    }
+    return result;
+}
+
+/**
+ *  Scans source text, appending the messages found to \a out, in order
+ *  of appearance.
+ */
+
+void
+sourcescanner::scan
+(
+    const std::string & text,
+    const std::string & filename,
+    messages & out
+) const
+{
+    lexer lex(text);
+    tokens toks = lex.tokenize();
+    std::size_t count = toks.size();
+    std::string comment;                /* the pending translator comment   */
+    int commentline = 0;                /* the last line of that comment    */
+    for (std::size_t i = 0; i + 1 < count; ++i)
+    {
+        const token & t = toks[i];
+        if (t.kind == tokenkind::comment)
+        {
+            /*
+             *  A comment directly following the pending one continues it,
+             *  whether it has the tag or not.
+             */
+
+            if (! m_comments)
+                continue;
+
+            bool adjacent = ! comment.empty() && t.line <= commentline + 1;
+            if (adjacent)
+            {
+                comment += '\n';
+                comment += t.text;
+                commentline = t.lastline;
+            }
+            else if (t.text.compare(0, m_comment_tag.size(), m_comment_tag) == 0)
+            {
+                comment = t.text;
+                commentline = t.lastline;
+            }
+            continue;
+        }
+        if (t.kind != tokenkind::identifier)
+            continue;
+
+        const token & next = toks[i + 1];
+        if (next.kind != tokenkind::punctuation || next.text != "(")
+            continue;
+
+        const keyword * kw = find_keyword(t.text);
+        if (is_nullptr(kw))
+            continue;
+
+        /*
+         *  Collect the arguments. Nested calls are not consumed here;
+         *  the outer loop will find any keyword calls inside them.
+         */
+
+        std::vector<argument> args;
+        argument current{std::string(), true};
+        bool has_tokens = false;
+        int depth = 1;
+        for (std::size_t j = i + 2; j < count && depth > 0; ++j)
+        {
+            const token & a = toks[j];
+            if (a.kind == tokenkind::comment)
+                continue;
+
+            if (a.kind == tokenkind::punctuation)
+            {
+                char p = a.text[0];
+                if (p == '(' || p == '[' || p == '{')
+                {
+                    ++depth;
+                    current.literal = false;
+                }
+                else if (p == ')' || p == ']' || p == '}')
+                {
+                    if (--depth > 0)
+                        current.literal = false;
+                }
+                else if (p == ',' && depth == 1)
+                {
+                    current.literal = current.literal && has_tokens;
+                    args.push_back(current);
+                    current = argument{std::string(), true};
+                    has_tokens = false;
+                    continue;
+                }
+                else
+                    current.literal = false;
+            }
+            else if (a.kind == tokenkind::literal && depth == 1)
+            {
+                current.text += a.text;
+            }
+            else
+                current.literal = false;
+
+            has_tokens = true;
+        }
+        if (depth > 0)
+            break;                              /* unbalanced, end of file  */
+
+        current.literal = current.literal && has_tokens;
+        args.push_back(current);
+
+        int nargs = int(args.size());
+        if
+        (
+            kw->msgid_arg > nargs || kw->ctxt_arg > nargs ||
+            kw->plural_arg > nargs
+        )
+        {
+            continue;
+        }
+
+        const argument & idarg = args[std::size_t(kw->msgid_arg - 1)];
+        if (! idarg.literal || idarg.text.empty())
+            continue;
+
+        message msg;
+        msg.has_plural = kw->plural_arg > 0;
+        if (msg.has_plural)
+        {
+            const argument & pluralarg = args[std::size_t(kw->plural_arg - 1)];
+            if (! pluralarg.literal)
+                continue;
+
+            msg.msgid_plural = pluralarg.text;
+        }
+        msg.has_ctxt = kw->ctxt_arg > 0;
+        if (msg.has_ctxt)
+        {
+            const argument & ctxtarg = args[std::size_t(kw->ctxt_arg - 1)];
+            if (! ctxtarg.literal)
+                continue;
+
+            msg.msgctxt = ctxtarg.text;
+        }
+        msg.msgid = idarg.text;
+        msg.filename = filename;
+        msg.line = t.line;
+        if (! comment.empty() && t.line <= commentline + 1)
+            msg.comment = comment;
+
+        comment.clear();
+        out.push_back(msg);
+    }
+}
+
+}               // namespace po
+
+/*
+ * sourcescanner.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
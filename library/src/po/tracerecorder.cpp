@@ -0,0 +1,408 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          tracerecorder.cpp
+ *
+ *      Recording the lookups of an application, to replay them later.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ *  See the banner of tracerecorder.hpp for the format of a trace. The
+ *  lookups are appended to a buffer under a mutex, which is written out
+ *  when it is full and when the recorder stops. The strings are numbered
+ *  through a hash map, so a lookup that is repeated, which is most of
+ *  them, writes only a dozen bytes or so.
+ */
+
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <cstdio>                       /* std::fopen(), std::fwrite(), ... */
+#include <cstdlib>                      /* std::atexit(), std::getenv()     */
+#include <cstring>                      /* std::memcmp()                    */
+#include <mutex>                        /* std::mutex, std::lock_guard<>    */
+#include <unordered_map>                /* std::unordered_map<> template    */
+
+#include "c_macros.h"                   /* not_nullptr(), etc.              */
+#include "po/logstream.hpp"             /* po::logstream::error()           */
+#include "po/tracerecorder.hpp"         /* po::tracerecorder class          */
+#include "po/wstrfunctions.hpp"         /* po::read_file()                  */
+
+#if ! defined PO_HAVE_GETTEXT_RECURSIVE
+#define _(str)      str
+#endif
+
+namespace po
+{
+
+/**
+ *  The magic string and version at the start of a trace.
+ */
+
+static const char c_magic [] = "POTXTRC1";
+static const std::size_t c_magic_size = 8;
+
+/**
+ *  The buffer is written out when it holds this many bytes.
+ */
+
+static const std::size_t c_flush_size = 64 * 1024;
+
+/**
+ *  The state of the recorder, guarded by its mutex. The generation is
+ *  bumped by each start(), so that the threads get new numbers in each
+ *  trace.
+ */
+
+struct recorderstate
+{
+    std::mutex rs_mutex;
+    std::FILE * rs_file;
+    std::string rs_buffer;
+    std::unordered_map<std::string, std::uint32_t> rs_strings;
+    std::chrono::steady_clock::time_point rs_last;
+    std::uint32_t rs_threads;
+    unsigned rs_generation;
+    bool rs_exit_hook;
+};
+
+static recorderstate &
+state ()
+{
+    static recorderstate s_state{};
+    return s_state;
+}
+
+std::atomic<bool> tracerecorder::sm_active{false};
+
+static void
+put_number (std::string & out, std::uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out += char((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += char(v);
+}
+
+static bool
+get_number
+(
+    const std::string & in,
+    std::size_t & pos,
+    std::uint64_t & v
+)
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && pos < in.size(); shift += 7)
+    {
+        unsigned char b = static_cast<unsigned char>(in[pos++]);
+        v |= std::uint64_t(b & 0x7f) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/**
+ *  Gets the number of a string, writing the string first if it is new.
+ */
+
+static std::uint32_t
+string_number (recorderstate & rs, const std::string & s)
+{
+    if (s.empty())
+        return 0;
+
+    auto it = rs.rs_strings.find(s);
+    if (it != rs.rs_strings.end())
+        return it->second;
+
+    std::uint32_t result = std::uint32_t(rs.rs_strings.size() + 1);
+    (void) rs.rs_strings.emplace(s, result);
+    rs.rs_buffer += 'S';
+    put_number(rs.rs_buffer, s.size());
+    rs.rs_buffer += s;
+    return result;
+}
+
+/**
+ *  Writes out the buffer. The caller holds the mutex.
+ */
+
+static bool
+flush (recorderstate & rs)
+{
+    bool result = true;
+    if (not_nullptr(rs.rs_file) && ! rs.rs_buffer.empty())
+    {
+        std::size_t n = rs.rs_buffer.size();
+        result = std::fwrite(rs.rs_buffer.data(), 1, n, rs.rs_file) == n;
+        rs.rs_buffer.clear();
+    }
+    return result;
+}
+
+static bool
+close_trace (recorderstate & rs)
+{
+    if (is_nullptr(rs.rs_file))
+        return false;
+
+    bool result = flush(rs);
+    if (std::fclose(rs.rs_file) != 0)
+        result = false;
+
+    rs.rs_file = nullptr;
+    rs.rs_strings.clear();
+    return result;
+}
+
+static void
+stop_at_exit ()
+{
+    (void) tracerecorder::stop();
+}
+
+/**
+ *  Starts recording to a file, replacing it. If the recorder was already
+ *  running, its trace is closed first.
+ *
+ * \return
+ *      Returns false if the file cannot be created.
+ */
+
+bool
+tracerecorder::start (const std::string & filename)
+{
+    recorderstate & rs = state();
+    std::lock_guard<std::mutex> lock(rs.rs_mutex);
+    sm_active.store(false);
+    (void) close_trace(rs);
+    rs.rs_file = std::fopen(filename.c_str(), "wb");
+    if (is_nullptr(rs.rs_file))
+    {
+        logstream::error()
+            << _("cannot create trace") << ": " << filename << std::endl
+            ;
+        return false;
+    }
+    rs.rs_buffer.assign(c_magic, c_magic_size);
+    rs.rs_last = std::chrono::steady_clock::now();
+    rs.rs_threads = 0;
+    ++rs.rs_generation;
+    if (! rs.rs_exit_hook)
+        rs.rs_exit_hook = std::atexit(stop_at_exit) == 0;
+
+    sm_active.store(true);
+    return true;
+}
+
+/**
+ *  Starts recording to the file named by POTEXT_TRACE, if it is set.
+ */
+
+bool
+tracerecorder::start_from_environment ()
+{
+    const char * filename = std::getenv("POTEXT_TRACE");
+    return not_nullptr(filename) && filename[0] != 0 && start(filename);
+}
+
+/**
+ *  Stops recording and closes the trace.
+ *
+ * \return
+ *      Returns false if the recorder was not running, or if the trace
+ *      could not be written.
+ */
+
+bool
+tracerecorder::stop ()
+{
+    recorderstate & rs = state();
+    std::lock_guard<std::mutex> lock(rs.rs_mutex);
+    sm_active.store(false);
+    return close_trace(rs);
+}
+
+/**
+ *  Logs a lookup. The callers check active() first, so that nothing is
+ *  done when the recorder is off.
+ */
+
+void
+tracerecorder::record
+(
+    tracekind kind,
+    const std::string & domain,
+    const std::string & msgctxt,
+    const std::string & msgid,
+    const std::string & msgid_plural,
+    unsigned long count
+)
+{
+    struct threadslot
+    {
+        unsigned ts_generation;
+        std::uint32_t ts_number;
+    };
+    static thread_local threadslot s_thread{0, 0};
+
+    recorderstate & rs = state();
+    std::lock_guard<std::mutex> lock(rs.rs_mutex);
+    if (is_nullptr(rs.rs_file))
+        return;                             /* stopped since the check      */
+
+    if (s_thread.ts_generation != rs.rs_generation)
+    {
+        s_thread.ts_generation = rs.rs_generation;
+        s_thread.ts_number = rs.rs_threads++;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>
+    (
+        now - rs.rs_last
+    );
+    rs.rs_last = now;
+
+    std::uint32_t d = string_number(rs, domain);
+    std::uint32_t c = string_number(rs, msgctxt);
+    std::uint32_t m = string_number(rs, msgid);
+    std::uint32_t p = string_number(rs, msgid_plural);
+    rs.rs_buffer += 'L';
+    rs.rs_buffer += char(kind);
+    put_number(rs.rs_buffer, s_thread.ts_number);
+    put_number(rs.rs_buffer, std::uint64_t(elapsed.count()));
+    put_number(rs.rs_buffer, d);
+    put_number(rs.rs_buffer, c);
+    put_number(rs.rs_buffer, m);
+    put_number(rs.rs_buffer, p);
+    put_number(rs.rs_buffer, count);
+    if (rs.rs_buffer.size() >= c_flush_size)
+        (void) flush(rs);
+}
+
+/**
+ *  Reads a trace.
+ *
+ * \param filename
+ *      The trace written by the recorder.
+ *
+ * \param [out] data
+ *      Receives the strings and the lookups, whose times are made relative
+ *      to the start of the trace.
+ *
+ * \return
+ *      Returns false if the file cannot be read or is not a valid trace.
+ *      A trace cut short (e.g. by a crash) keeps the lookups before the
+ *      cut, and is still valid.
+ */
+
+bool
+tracerecorder::load (const std::string & filename, tracedata & data)
+{
+    data.td_strings.assign(1, std::string());
+    data.td_records.clear();
+    data.td_threads = 0;
+
+    std::string text;
+    if (! read_file(filename, text))
+        return false;
+
+    if
+    (
+        text.size() < c_magic_size ||
+        std::memcmp(text.data(), c_magic, c_magic_size) != 0
+    )
+    {
+        return false;
+    }
+
+    std::size_t pos = c_magic_size;
+    std::uint64_t time = 0;
+    while (pos < text.size())
+    {
+        char tag = text[pos++];
+        if (tag == 'S')
+        {
+            std::uint64_t length;
+            if (! get_number(text, pos, length) || length > text.size() - pos)
+                break;
+
+            data.td_strings.emplace_back(text, pos, std::size_t(length));
+            pos += std::size_t(length);
+        }
+        else if (tag == 'L')
+        {
+            if (pos >= text.size())
+                break;
+
+            unsigned kind = static_cast<unsigned char>(text[pos++]);
+            std::uint64_t v[7];
+            bool ok = kind < unsigned(tracekind::max);
+            for (int i = 0; ok && i < 7; ++i)
+                ok = get_number(text, pos, v[i]);
+
+            if (! ok)
+                break;
+
+            for (int i = 2; i < 6; ++i)
+            {
+                if (v[i] >= data.td_strings.size())
+                    return false;
+            }
+            time += v[1];
+
+            tracerecord r;
+            r.tr_kind = tracekind(kind);
+            r.tr_thread = std::uint32_t(v[0]);
+            r.tr_time = time;
+            r.tr_domain = std::uint32_t(v[2]);
+            r.tr_msgctxt = std::uint32_t(v[3]);
+            r.tr_msgid = std::uint32_t(v[4]);
+            r.tr_msgid_plural = std::uint32_t(v[5]);
+            r.tr_count = (unsigned long)(v[6]);
+            data.td_records.push_back(r);
+            if (r.tr_thread >= data.td_threads)
+                data.td_threads = r.tr_thread + 1;
+        }
+        else
+            return false;
+    }
+    return true;
+}
+
+}               // namespace po
+
+/*
+ * tracerecorder.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
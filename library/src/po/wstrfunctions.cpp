@@ -24,21 +24,24 @@
  * \library       potext
  * \author        Chris Ahlstrom
  * \date          2024-03-30
- * \updates       2024-04-03
+ * \updates       2026-10-17
  * \license       See above.
  *
  *      Functions to work around narrow versus wide strings. Not just for
  *      Windows.
  */
 
+#include <cctype>                       /* std::isxdigit(), std::isdigit()  */
 #include <cerrno>                       /* errno                            */
 #include <climits>                      /* PATH_MAX                         */
 #include <clocale>                      /* std::setlocale()                 */
 #include <codecvt>                      /* std::codecvt()                   */
 #include <cstdlib>                      /* std::getenv()                    */
 #include <cstring>                      /* std::strerror()                  */
+#include <fstream>                      /* std::ifstream, std::ofstream     */
 #include <locale>                       /* std::wstring_convert<>           */
 #include <map>                          /* std::map<>                       */
+#include <sstream>                      /* std::ostringstream               */
 
 #include "po/wstrfunctions.hpp"         /* external wide-related functions  */
 
@@ -293,6 +296,216 @@ extract_po_domain (const std::string & fullpath)
     return result;
 }
 
+/**
+ *  Converts the C escape sequences in a string, as found between the
+ *  double quotes of a .po or .pot file, or in source code, to the actual
+ *  characters. The simple escapes handled by the poparser are supported,
+ *  plus octal ("\004") and hexadecimal ("\x04") escapes. Like the octal
+ *  escapes, a hexadecimal escape takes at most two digits, so it always
+ *  fits in a byte. An unknown escape is kept as is, backslash included.
+ */
+
+std::string
+unescape_c_string (const std::string & source)
+{
+    std::string result;
+    result.reserve(source.size());
+    for (std::size_t i = 0; i < source.size(); ++i)
+    {
+        char c = source[i];
+        if (c != '\\' || i + 1 == source.size())
+        {
+            result += c;
+            continue;
+        }
+        c = source[++i];
+        switch (c)
+        {
+        case 'a':  result += '\a'; break;
+        case 'b':  result += '\b'; break;
+        case 'f':  result += '\f'; break;
+        case 'v':  result += '\v'; break;
+        case 'n':  result += '\n'; break;
+        case 't':  result += '\t'; break;
+        case 'r':  result += '\r'; break;
+        case '"':  result += '"';  break;
+        case '?':  result += '?';  break;
+        case '\'': result += '\''; break;
+        case '\\': result += '\\'; break;
+        case 'x':
+        {
+            int value = 0;
+            std::size_t digits = 0;
+            while
+            (
+                digits < 2 && i + 1 < source.size() &&
+                std::isxdigit(static_cast<unsigned char>(source[i + 1]))
+            )
+            {
+                int h = static_cast<unsigned char>(source[++i]);
+                value = value * 16 +
+                (
+                    std::isdigit(h) ? h - '0' : std::tolower(h) - 'a' + 10
+                );
+                ++digits;
+            }
+            if (digits > 0)
+                result += char(value);
+            else
+                result += "\\x";
+            break;
+        }
+        default:
+
+            if (c >= '0' && c <= '7')
+            {
+                int value = c - '0';
+                for (int d = 0; d < 2; ++d)
+                {
+                    if (i + 1 < source.size())
+                    {
+                        char o = source[i + 1];
+                        if (o >= '0' && o <= '7')
+                        {
+                            value = value * 8 + (o - '0');
+                            ++i;
+                            continue;
+                        }
+                    }
+                    break;
+                }
+                result += char(value);
+            }
+            else
+            {
+                result += '\\';
+                result += c;
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+/**
+ *  The reverse of unescape_c_string(). Control characters are written as
+ *  three-digit octal escapes, so that a following digit cannot be taken as
+ *  part of the escape. The result can be placed between the double quotes
+ *  of a C/C++ string literal or a .po file.
+ */
+
+std::string
+escape_c_string (const std::string & source)
+{
+    static const char * const s_octal = "01234567";
+    std::string result;
+    result.reserve(source.size());
+    for (char c : source)
+    {
+        switch (c)
+        {
+        case '\n':  result += "\\n";  break;
+        case '\t':  result += "\\t";  break;
+        case '\r':  result += "\\r";  break;
+        case '"':   result += "\\\""; break;
+        case '\\':  result += "\\\\"; break;
+        default:
+
+            if (static_cast<unsigned char>(c) < 0x20 || c == 0x7f)
+            {
+                unsigned value = static_cast<unsigned char>(c);
+                result += '\\';
+                result += s_octal[(value >> 6) & 7];
+                result += s_octal[(value >> 3) & 7];
+                result += s_octal[value & 7];
+            }
+            else
+                result += c;
+
+            break;
+        }
+    }
+    return result;
+}
+
+/**
+ *  Reads a whole file, unconverted, into a string.
+ *
+ * \return
+ *      Returns false if the file could not be opened or read.
+ */
+
+bool
+read_file (const std::string & filename, std::string & text)
+{
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    bool result = bool(in);
+    if (result)
+    {
+        std::ostringstream os;
+        os << in.rdbuf();
+        text = os.str();
+        result = ! in.bad();
+    }
+    return result;
+}
+
+/**
+ *  Writes a file only if its contents would change. Generated files (key
+ *  tables, templates) then keep their timestamps when nothing changed,
+ *  which avoids needless rebuilds.
+ *
+ * \return
+ *      Returns false if the file had to be written and could not be.
+ */
+
+bool
+write_file_if_changed (const std::string & filename, const std::string & text)
+{
+    std::string old;
+    if (read_file(filename, old) && old == text)
+        return true;
+
+    std::ofstream out(filename, std::ios::out | std::ios::binary);
+    if (out)
+        out << text;
+
+    return bool(out);
+}
+
+/**
+ *  The 64-bit FNV-1a hash. It is not a cryptographic hash, but it is fast,
+ *  simple, and the same on every platform, so it can name cache files and
+ *  check that a cache has not been damaged.
+ *
+ * \param data
+ *      The bytes to hash.
+ *
+ * \param size
+ *      The number of bytes.
+ *
+ * \param seed
+ *      The starting value, which can be the hash of preceding data.
+ */
+
+std::uint64_t
+fnv1a_hash (const char * data, std::size_t size, std::uint64_t seed)
+{
+    std::uint64_t result = seed;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        result ^= static_cast<unsigned char>(data[i]);
+        result *= 1099511628211ULL;
+    }
+    return result;
+}
+
+std::uint64_t
+fnv1a_hash (const std::string & text, std::uint64_t seed)
+{
+    return fnv1a_hash(text.data(), text.size(), seed);
+}
+
 #if defined POTEXT_WIDE_STRING_SUPPORT
 
 /**
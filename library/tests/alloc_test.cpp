@@ -0,0 +1,646 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          alloc_test.cpp
+ *
+ *      Checks that the lookup functions do not allocate memory.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  This test replaces the global operator new and operator delete with
+ *  versions that count the allocations, and then calls each lookup
+ *  function for hits, misses, fallbacks, contexts, and plurals. The first
+ *  call of each is not counted, since it may fill a cache (e.g. a codeset
+ *  view). Each later call must make exactly the allocations of its
+ *  budget:
+ *
+ *      -   Functions returning a reference or a pointer: none.
+ *      -   Functions returning std::string: one, for the copy returned, if
+ *          it is too long for the small-string buffer, and otherwise none.
+ *
+ *  A miss is logged as a warning, into a buffer that grows now and then.
+ *  Before a run of misses, room is reserved in the buffer, so that the
+ *  growth of the log is not counted against the lookup.
+ *
+ *  The real-time lookups of po::rtcatalog are held to more: no allocation
+ *  even for a miss, no growth of the log, and, with glibc, no call of
+ *  pthread_mutex_lock(), which this test also replaces with a counting
+ *  version.
+ *
+ *  It must be run from the top of the source tree, as hellopotext is.
+ */
+
+#include <cstdlib>                      /* EXIT_SUCCESS, std::malloc()      */
+#include <filesystem>                   /* std::filesystem functions        */
+#include <functional>                   /* std::function<> template         */
+#include <iostream>                     /* std::cout, std::cerr             */
+#include <new>                          /* std::bad_alloc, std::nothrow_t   */
+#include <string>                       /* std::string                      */
+#include <string_view>                  /* std::string_view                 */
+
+#include "po/potext.hpp"                /* po::dictionarymgr, po::gettext   */
+#include "po/logstream.hpp"             /* po::logstream::warning()         */
+#include "po/rtcatalog.hpp"             /* po::rtcatalog class              */
+
+#if defined __GLIBC__
+#include <dlfcn.h>                      /* ::dlsym(), RTLD_NEXT             */
+#include <pthread.h>                    /* ::pthread_mutex_lock()           */
+#endif
+
+/*
+ *  The counting allocation functions. The test is single-threaded.
+ */
+
+static unsigned long s_allocations = 0;
+
+void *
+operator new (std::size_t size)
+{
+    ++s_allocations;
+    void * result = std::malloc(size > 0 ? size : 1);
+    if (result == nullptr)
+        throw std::bad_alloc();
+
+    return result;
+}
+
+void *
+operator new [] (std::size_t size)
+{
+    return operator new(size);
+}
+
+void *
+operator new (std::size_t size, const std::nothrow_t &) noexcept
+{
+    ++s_allocations;
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void *
+operator new [] (std::size_t size, const std::nothrow_t & nt) noexcept
+{
+    return operator new(size, nt);
+}
+
+void
+operator delete (void * p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete [] (void * p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete (void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete [] (void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+/*
+ *  The counting lock functions. std::mutex and std::recursive_mutex lock
+ *  through these.
+ */
+
+static unsigned long s_locks = 0;
+
+#if defined __GLIBC__
+
+using lockfunction = int (*) (pthread_mutex_t *);
+
+static lockfunction s_mutex_lock = nullptr;
+static lockfunction s_mutex_trylock = nullptr;
+
+extern "C" int
+pthread_mutex_lock (pthread_mutex_t * m)
+{
+    ++s_locks;
+    if (s_mutex_lock == nullptr)
+    {
+        s_mutex_lock = reinterpret_cast<lockfunction>
+        (
+            ::dlsym(RTLD_NEXT, "pthread_mutex_lock")
+        );
+    }
+    return s_mutex_lock(m);
+}
+
+extern "C" int
+pthread_mutex_trylock (pthread_mutex_t * m)
+{
+    ++s_locks;
+    if (s_mutex_trylock == nullptr)
+    {
+        s_mutex_trylock = reinterpret_cast<lockfunction>
+        (
+            ::dlsym(RTLD_NEXT, "pthread_mutex_trylock")
+        );
+    }
+    return s_mutex_trylock(m);
+}
+
+#endif
+
+namespace
+{
+
+/**
+ *  The number of counted calls of each lookup.
+ */
+
+const int c_calls = 64;
+
+/**
+ *  The room reserved in the warning log for a run of misses.
+ */
+
+const std::size_t c_log_reserve = 64 * 1024;
+
+bool s_failed = false;
+
+/**
+ *  The budget of a function returning a copy of \a s.
+ */
+
+unsigned long
+copy_budget (const std::string & s)
+{
+    static const std::size_t s_sso_capacity = std::string().capacity();
+    return s.size() > s_sso_capacity ? 1 : 0 ;
+}
+
+/**
+ *  Calls a lookup once to warm it up, and then c_calls times, counting
+ *  the allocations.
+ *
+ * \param name
+ *      The name of the case, for the report.
+ *
+ * \param budget
+ *      The allocations allowed per call.
+ *
+ * \param lookup
+ *      The lookup to make.
+ *
+ * \param miss
+ *      If true, the lookup logs a warning, and room is reserved for the
+ *      warnings first.
+ */
+
+void
+check
+(
+    const std::string & name,
+    unsigned long budget,
+    const std::function<void ()> & lookup,
+    bool miss = false
+)
+{
+    lookup();
+    if (miss)
+    {
+        std::ostream & log = po::logstream::warning();
+        std::streampos start = log.tellp();
+        log << std::string(c_log_reserve, ' ');
+        log.seekp(start);
+    }
+
+    unsigned long total = 0;
+    int wrong = 0;
+    for (int i = 0; i < c_calls; ++i)
+    {
+        unsigned long before = s_allocations;
+        lookup();
+
+        unsigned long count = s_allocations - before;
+        total += count;
+        if (count != budget)
+            ++wrong;
+    }
+
+    bool ok = wrong == 0;
+    std::cout
+        << (ok ? "ok    " : "FAIL  ") << name << ": "
+        << total << " allocations in " << c_calls << " calls, "
+        << budget << " expected per call"
+        << (ok ? "" : ", " + std::to_string(wrong) + " calls differ")
+        << std::endl
+        ;
+    if (! ok)
+        s_failed = true;
+}
+
+/**
+ *  Checks a lookup that returns a copy of \a expected.
+ */
+
+void
+check_copy
+(
+    const std::string & name,
+    const std::string & expected,
+    const std::function<std::string ()> & lookup,
+    bool miss = false
+)
+{
+    std::string result = lookup();
+    if (result != expected)
+    {
+        std::cout
+            << "FAIL  " << name << ": '" << result << "', expected '"
+            << expected << "'" << std::endl
+            ;
+        s_failed = true;
+    }
+    check
+    (
+        name, copy_budget(expected),
+        [&lookup] () { (void) lookup(); }, miss
+    );
+}
+
+/**
+ *  Checks a real-time lookup, which must return \a expected without any
+ *  allocation, lock, or logging, whether it hits or misses.
+ */
+
+void
+check_rt
+(
+    const std::string & name,
+    std::string_view expected,
+    const std::function<std::string_view ()> & lookup
+)
+{
+    std::ostream & log = po::logstream::warning();
+    std::streampos logsize = log.tellp();
+    unsigned long allocations = s_allocations;
+    unsigned long locks = s_locks;
+    bool match = true;
+    for (int i = 0; i < c_calls; ++i)
+    {
+        if (lookup() != expected)
+            match = false;
+    }
+    allocations = s_allocations - allocations;
+    locks = s_locks - locks;
+
+    bool logged = log.tellp() != logsize;
+    bool ok = match && allocations == 0 && locks == 0 && ! logged;
+    std::cout
+        << (ok ? "ok    " : "FAIL  ") << name << ": "
+        << allocations << " allocations, " << locks << " locks"
+        << (logged ? ", logged" : "") << (match ? "" : ", wrong result")
+        << " in " << c_calls << " calls" << std::endl
+        ;
+    if (! ok)
+        s_failed = true;
+}
+
+/**
+ *  The message IDs of the idgettext() check, in msgid_compare() order.
+ */
+
+const char * const c_keys [] =
+{
+    "File",
+    "Test result",
+    "success\004Congratulations!"
+};
+
+/**
+ *  A second key table, as a library using idgettext() would have.
+ */
+
+const char * const c_library_keys [] =
+{
+    "File",
+    "success\004Congratulations!"
+};
+
+}           // namespace (anonymous)
+
+int
+main (int /*argc*/, char * argv [])
+{
+    /*
+     * The dictionary classes, with a de_AT dictionary that falls back to
+     * de for most messages.
+     */
+
+    namespace fs = std::filesystem;
+    if (! fs::is_directory("library/tests/po"))
+    {
+        std::cerr
+            << "Run alloc_test from the top of the source tree" << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    po::dictionarymgr mgr;
+    mgr.add_directory("library/tests/po");
+    mgr.set_language(po::language::from_env("de_AT"));
+
+    const po::dictionary & dict = mgr.get_dictionary();
+    const std::string umlaut{"umlaut"};
+    const std::string bridger{"Bridger"};
+    const std::string fatal{"found %d fatal error"};
+    const std::string fatals{"found %d fatal errors"};
+    const std::string missing{"A message that is in no catalog at all"};
+    const std::string latin1{"ISO-8859-1"};
+
+    check_copy
+    (
+        "translate() hit", "Umlaut",
+        [&] () { return dict.translate(umlaut); }
+    );
+    check_copy
+    (
+        "translate() fallback", "Bridger",
+        [&] () { return dict.translate(bridger); }
+    );
+    check_copy
+    (
+        "translate() miss", missing,
+        [&] () { return dict.translate(missing); }, true
+    );
+    check_copy
+    (
+        "translate_plural() singular", "s'ha trobat %d error fätal",
+        [&] () { return dict.translate_plural(fatal, fatals, 1); }
+    );
+    check_copy
+    (
+        "translate_plural() plural", "s'han trobat %d errors fätals",
+        [&] () { return dict.translate_plural(fatal, fatals, 3); }
+    );
+    check
+    (
+        "translate() in a codeset", copy_budget("Umlaut"),
+        [&] () { (void) dict.translate(umlaut, latin1); }
+    );
+    check
+    (
+        "find() hit", 0,
+        [&] () { (void) dict.find(umlaut); }
+    );
+    check
+    (
+        "find() fallback", 0,
+        [&] () { (void) dict.find(bridger); }
+    );
+    check
+    (
+        "find() miss", 0,
+        [&] () { (void) dict.find(missing); }
+    );
+
+    /*
+     * The same catalogs, served from a shared image.
+     */
+
+    fs::path cache = fs::temp_directory_path() / "potext_alloc_test";
+    po::dictionarymgr flatmgr;
+    flatmgr.set_shared_cache(cache.string());
+    flatmgr.add_directory("library/tests/po");
+    flatmgr.set_language(po::language::from_env("de_AT"));
+
+    const po::dictionary & flatdict = flatmgr.get_dictionary();
+    check_copy
+    (
+        "translate() hit in an image", "Umlaut",
+        [&] () { return flatdict.translate(umlaut); }
+    );
+    check_copy
+    (
+        "translate_plural() in an image", "s'han trobat %d errors fätals",
+        [&] () { return flatdict.translate_plural(fatal, fatals, 3); }
+    );
+    check
+    (
+        "find() fallback in an image", 0,
+        [&] () { (void) flatdict.find(bridger); }
+    );
+    check
+    (
+        "find() miss in an image", 0,
+        [&] () { (void) flatdict.find(missing); }
+    );
+
+    /*
+     * The real-time handles, made from the map dictionary, the image, and
+     * the po directory (which has messages with a context).
+     */
+
+    po::rtcatalog rt(dict);
+    po::rtcatalog rtflat(flatdict);
+    po::dictionarymgr ctxtmgr;
+    ctxtmgr.add_directory("po");
+
+    po::rtcatalog rtctxt(ctxtmgr.get_dictionary(po::language::from_env("de")));
+    if (rt.chain_size() != 2 || rtflat.chain_size() != 2)
+    {
+        std::cout << "FAIL  rtcatalog: the de fallback is missing" << std::endl;
+        s_failed = true;
+    }
+    check_rt
+    (
+        "rtcatalog hit", "Umlaut",
+        [&rt] () { return rt.translate("umlaut"); }
+    );
+    check_rt
+    (
+        "rtcatalog fallback", "Bridger",
+        [&rt] () { return rt.translate("Bridger"); }
+    );
+    check_rt
+    (
+        "rtcatalog miss", missing,
+        [&rt, &missing] () { return rt.translate(missing); }
+    );
+    check_rt
+    (
+        "rtcatalog plural", "s'han trobat %d errors fätals",
+        [&rt] ()
+        {
+            return rt.translate_plural
+            (
+                "found %d fatal error", "found %d fatal errors", 3
+            );
+        }
+    );
+    check_rt
+    (
+        "rtcatalog plural miss", "%d misses",
+        [&rt] () { return rt.translate_plural("%d miss", "%d misses", 2); }
+    );
+    check_rt
+    (
+        "rtcatalog hit in an image", "Umlaut",
+        [&rtflat] () { return rtflat.translate("umlaut"); }
+    );
+    check_rt
+    (
+        "rtcatalog fallback in an image", "Bridger",
+        [&rtflat] () { return rtflat.translate("Bridger"); }
+    );
+    check_rt
+    (
+        "rtcatalog context", "Glückwunsch!",
+        [&rtctxt] ()
+        {
+            return rtctxt.translate_ctxt("success", "Congratulations!");
+        }
+    );
+    check_rt
+    (
+        "rtcatalog context miss", "Congratulations!",
+        [&rtctxt] ()
+        {
+            return rtctxt.translate_ctxt("nonesuch", "Congratulations!");
+        }
+    );
+
+    std::error_code ec;
+    (void) fs::remove_all(cache, ec);
+
+    /*
+     * The gettext() family, with the de domain from the po directory.
+     */
+
+    std::string dirname = po::init_app_locale(argv[0], "alloc_test", "de", "po");
+    if (dirname.empty())
+    {
+        std::cerr << "Could not set up the po directory" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string result{"Test result"};
+    const std::string file{"File"};
+    const std::string files{"Files"};
+    const std::string success{"success"};
+    const std::string congrats{"Congratulations!"};
+    const std::string fr{"fr"};
+    const std::string syserror{"Unknown system error"};
+
+    check_copy
+    (
+        "gettext() hit", "Testergebnis",
+        [&] () { return po::gettext(result); }
+    );
+    check_copy
+    (
+        "gettext() miss", missing,
+        [&] () { return po::gettext(missing); }, true
+    );
+    check_copy
+    (
+        "ngettext() plural", "Dateien",
+        [&] () { return po::ngettext(file, files, 2); }
+    );
+    check_copy
+    (
+        "pgettext() hit", "Glückwunsch!",
+        [&] () { return po::pgettext(success, congrats); }
+    );
+    check_copy
+    (
+        "dgettext() hit", "Erreur système non identifiée",
+        [&] () { return po::dgettext(fr, syserror); }
+    );
+    check_copy
+    (
+        "dgettext() miss", missing,
+        [&] () { return po::dgettext(fr, missing); }, true
+    );
+    check_copy
+    (
+        "dngettext() singular", "Déposer",
+        [&] () { return po::dngettext(fr, file, files, 1); }
+    );
+    check_copy
+    (
+        "dpgettext() hit", "Toutes nos félicitations!",
+        [&] () { return po::dpgettext(fr, success, congrats); }
+    );
+    check
+    (
+        "idgettext() hit", 0,
+        [&] () { (void) po::idgettext(c_keys, 1, "Test result"); }
+    );
+    check
+    (
+        "idgettext() two key tables", 0,
+        [&] ()
+        {
+            (void) po::idgettext(c_keys, 0, "File");
+            (void) po::idgettext(c_library_keys, 0, "File");
+        }
+    );
+
+    /*
+     * Keys missing from a stale key table must not share one string.
+     */
+
+    const std::string & stale = po::idgettext(c_keys, 3, 3, "File");
+    const std::string & stale2 = po::idgettext(c_keys, 3, 3, "Test result");
+    bool distinct = &stale != &stale2 && stale == po::gettext("File") &&
+        stale2 == po::gettext("Test result");
+
+    std::cout
+        << (distinct ? "ok    " : "FAIL  ")
+        << "idgettext() stale keys: '" << stale << "', '" << stale2 << "'"
+        << std::endl
+        ;
+    if (! distinct)
+        s_failed = true;
+
+    if (s_failed)
+    {
+        std::cerr << "A lookup allocates more than its budget" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*
+ * alloc_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,584 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          fuzz_test.cpp
+ *
+ *      A fuzzing harness for the .po and .mo parsers and the Plural-Forms
+ *      lookup, which can also check that their time grows linearly with
+ *      the size of the input.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Catalogs from third parties are loaded as they come, so a hostile or
+ *  merely huge catalog must neither crash the parsers nor take a time out
+ *  of proportion to its size.
+ *
+ *  Built with POTEXT_LIBFUZZER defined (see the enable_fuzzing option),
+ *  this is a libFuzzer target. The first byte of an input selects the
+ *  parser; the rest is the catalog. An input that takes longer than
+ *  POTEXT_FUZZ_NS_PER_BYTE nanoseconds per byte (default 20000) aborts,
+ *  so libFuzzer saves it.
+ *
+ *  Otherwise it is a standalone driver:
+ *
+ *      fuzz_test [--mutate count] [--timing] [file-or-directory ...]
+ *
+ *  Each file is parsed by the parser its extension names (.po or .mo);
+ *  any other file is taken to be a libFuzzer input, such as a saved crash.
+ *  The time per byte of each file is shown. With --mutate, each file is
+ *  also parsed "count" times with random bytes changed, a poor man's
+ *  fuzzer for machines without libFuzzer.
+ *
+ *  With --timing, each scaling case then builds an input of some size and
+ *  one 16 times larger, and fails if the time per byte of the larger is
+ *  more than c_superlinear times that of the smaller. Quadratic behavior
+ *  makes the ratio about 16. The cases aim at the paths that were
+ *  quadratic: a search of the whole .mo data for each string, the
+ *  escaping of quotes when a catalog is written, a dump of the whole
+ *  catalog on each missing plural, and long continued strings. These
+ *  checks go by the clock, so a busy machine can fail them; tests.sh and
+ *  "meson test" leave them out, and they are meant to be run by hand on a
+ *  quiet machine.
+ *
+ *  It must be run from the top of the source tree, as hellopotext is.
+ */
+
+#include <algorithm>                    /* std::min()                       */
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <cstdint>                      /* std::uint8_t, std::uint32_t      */
+#include <cstdlib>                      /* std::abort(), std::getenv()      */
+#include <cstring>                      /* std::memcpy()                    */
+#include <filesystem>                   /* std::filesystem functions        */
+#include <fstream>                      /* std::ifstream                    */
+#include <iostream>                     /* std::cout, std::cerr             */
+#include <random>                       /* std::mt19937                     */
+#include <sstream>                      /* std::istringstream               */
+#include <string>                       /* std::string                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "po/dictionary.hpp"            /* po::dictionary class             */
+#include "po/logstream.hpp"             /* po::logstream callbacks          */
+#include "po/moparser.hpp"              /* po::moparser::parse_mo_file()    */
+#include "po/pluralforms.hpp"           /* po::pluralforms::from_string()   */
+#include "po/poparser.hpp"              /* po::poparser::parse_po_file()    */
+#include "po/popushparser.hpp"          /* po::popushparser class           */
+
+namespace
+{
+
+/**
+ *  The parsers, as selected by the first byte of a libFuzzer input.
+ */
+
+enum class target
+{
+    po,
+    mo,
+    plural,
+    count
+};
+
+/**
+ *  The time per byte allowed a libFuzzer input, and the size below which
+ *  the time is not checked (the fixed costs dominate small inputs).
+ */
+
+const double c_ns_per_byte = 20000.0;
+const std::size_t c_timed_size = 1024;
+
+/**
+ *  How much the time per byte may grow when a scaling input grows 16
+ *  times. Linear parsing stays near 1, and a map insertion per entry adds
+ *  a little; the slack is for timer noise.
+ */
+
+const double c_superlinear = 4.0;
+
+bool s_quiet = false;
+
+void
+quiet (const std::string &)
+{
+    // no code
+}
+
+void
+silence_logs ()
+{
+    if (! s_quiet)
+    {
+        po::logstream::callbacks_set_all(quiet);    /* errors are expected  */
+        s_quiet = true;
+    }
+}
+
+/**
+ *  Parses a .po catalog, and exercises what parsing leaves behind: the
+ *  dump (with its escaping) and plural lookups that miss. The catalog is
+ *  also fed to the push parser in pieces, whose size depends on the input
+ *  so that the pieces end in different places.
+ */
+
+void
+run_po (const std::string & text)
+{
+    std::istringstream in(text);
+    po::dictionary dict;
+    if (po::poparser::parse_po_file("fuzz.po", in, dict))
+    {
+        (void) dict.create_po_dump();
+        for (int n = 0; n < 16; ++n)
+            (void) dict.translate_plural("missing", "missings", n);
+    }
+
+    po::dictionary pushed;
+    po::popushparser parser("fuzz.po", pushed);
+    std::size_t piece = 1 + text.size() % 61;
+    for (std::size_t pos = 0; pos < text.size(); pos += piece)
+    {
+        std::size_t n = std::min(piece, text.size() - pos);
+        if (! parser.feed(text.data() + pos, n))
+            break;
+    }
+    (void) parser.finish();
+}
+
+void
+run_mo (const std::string & text)
+{
+    std::istringstream in(text, std::ios::in | std::ios::binary);
+    po::dictionary dict;
+    if (po::moparser::parse_mo_file("fuzz.mo", in, dict))
+        (void) dict.translate_plural("missing", "missings", 2);
+}
+
+void
+run_plural (const std::string & text)
+{
+    po::pluralforms pf = po::pluralforms::from_string(text);
+    if (pf)
+    {
+        for (int n = 0; n < 8; ++n)
+            (void) pf.get_plural(n);
+    }
+}
+
+void
+run (target t, const std::string & text)
+{
+    switch (t)
+    {
+    case target::po:        run_po(text);       break;
+    case target::mo:        run_mo(text);       break;
+    case target::plural:    run_plural(text);   break;
+    default:                                    break;
+    }
+}
+
+/**
+ *  Runs a parser, returning the time in nanoseconds.
+ */
+
+double
+timed_run (target t, const std::string & text)
+{
+    auto start = std::chrono::steady_clock::now();
+    run(t, text);
+
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+}           // namespace (anonymous)
+
+/**
+ *  The libFuzzer entry point. The standalone driver uses it for files
+ *  that are not catalogs.
+ */
+
+extern "C" int
+LLVMFuzzerTestOneInput (const std::uint8_t * data, std::size_t size)
+{
+    static double s_budget = 0.0;
+    if (s_budget == 0.0)
+    {
+        const char * env = std::getenv("POTEXT_FUZZ_NS_PER_BYTE");
+        s_budget = env != nullptr ? std::atof(env) : 0.0 ;
+        if (s_budget <= 0.0)
+            s_budget = c_ns_per_byte;
+
+        silence_logs();
+    }
+    if (size == 0)
+        return 0;
+
+    target t = target(data[0] % std::uint8_t(target::count));
+    std::string text(reinterpret_cast<const char *>(data) + 1, size - 1);
+    double ns = timed_run(t, text);
+    if (text.size() >= c_timed_size && ns / double(text.size()) > s_budget)
+    {
+        std::cerr
+            << "Too slow: " << ns / double(text.size())
+            << " ns/byte for " << text.size() << " bytes, parser "
+            << int(t) << std::endl
+            ;
+        std::abort();
+    }
+    return 0;
+}
+
+#if ! defined POTEXT_LIBFUZZER
+
+namespace
+{
+
+/**
+ *  Builds a .mo file of the given messages, in the byte order of this
+ *  machine, with a header giving the charset and plural forms. A plural
+ *  message or translation holds its forms separated by NULs.
+ */
+
+std::string
+make_mo (const std::vector<std::pair<std::string, std::string>> & messages)
+{
+    std::vector<std::pair<std::string, std::string>> all
+    {
+        {
+            "",
+            "Content-Type: text/plain; charset=UTF-8\n"
+            "Plural-Forms: nplurals=2; plural=(n != 1);\n"
+        }
+    };
+    all.insert(all.end(), messages.begin(), messages.end());
+
+    std::uint32_t count = std::uint32_t(all.size());
+    std::uint32_t origtable = 28;
+    std::uint32_t trantable = origtable + 8 * count;
+    std::uint32_t header [] =
+    {
+        0x950412de, 0, count, origtable, trantable, 0, 0
+    };
+    std::string result(trantable + 8 * count, '\0');
+    std::memcpy(&result[0], header, sizeof header);
+
+    auto put = [&result] (std::size_t tablepos, const std::string & s)
+    {
+        std::uint32_t entry [] =
+        {
+            std::uint32_t(s.size()), std::uint32_t(result.size())
+        };
+        std::memcpy(&result[tablepos], entry, sizeof entry);
+        result += s;
+        result += '\0';
+    };
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        put(origtable + 8 * i, all[i].first);
+        put(trantable + 8 * i, all[i].second);
+    }
+    return result;
+}
+
+std::string
+mo_entries (int n)
+{
+    std::vector<std::pair<std::string, std::string>> messages;
+    for (int i = 0; i < n; ++i)
+    {
+        std::string k = std::to_string(i);
+        if (i % 4 == 0)
+        {
+            messages.emplace_back
+            (
+                "file " + k + std::string(1, '\0') + "files " + k,
+                "Datei " + k + std::string(1, '\0') + "Dateien " + k
+            );
+        }
+        else
+            messages.emplace_back("message " + k, "Nachricht " + k);
+    }
+    return make_mo(messages);
+}
+
+const char * const c_po_header =
+    "msgid \"\"\n"
+    "msgstr \"\"\n"
+    "\"Content-Type: text/plain; charset=UTF-8\\n\"\n"
+    "\"Plural-Forms: nplurals=2; plural=(n != 1);\\n\"\n\n"
+    ;
+
+std::string
+po_entries (int n)
+{
+    std::string result = c_po_header;
+    for (int i = 0; i < n; ++i)
+    {
+        std::string k = std::to_string(i);
+        if (i % 4 == 0)
+        {
+            result += "msgid \"file " + k + "\"\nmsgid_plural \"files " + k +
+                "\"\nmsgstr[0] \"Datei " + k + "\"\nmsgstr[1] \"Dateien " +
+                k + "\"\n\n";
+        }
+        else
+        {
+            result += "msgid \"message " + k + "\"\nmsgstr \"Nachricht " + k +
+                "\"\n\n";
+        }
+    }
+    return result;
+}
+
+std::string
+po_continued (int n)
+{
+    std::string result = c_po_header;
+    result += "msgid \"\"\n";
+    for (int i = 0; i < n; ++i)
+        result += "\"a long message \\\"quoted\\\", line\\n\"\n";
+
+    result += "msgstr \"\"\n";
+    for (int i = 0; i < n; ++i)
+        result += "\"eine lange Nachricht, Zeile\\n\"\n";
+
+    return result;
+}
+
+std::string
+po_quotes (int n)
+{
+    std::string result = c_po_header;
+    result += "msgid \"quotes\"\nmsgstr \"";
+    for (int i = 0; i < n; ++i)
+        result += "\\\"\\\"\\\"\\\"";
+
+    result += "\"\n";
+    return result;
+}
+
+std::string
+plural_spaces (int n)
+{
+    return "nplurals=2; plural=" + std::string(std::size_t(n) * 32, ' ') +
+        "(n != 1);";
+}
+
+/**
+ *  The best of three runs, in nanoseconds per byte.
+ */
+
+double
+ns_per_byte (target t, const std::string & text)
+{
+    double best = timed_run(t, text);
+    for (int i = 0; i < 2; ++i)
+        best = std::min(best, timed_run(t, text));
+
+    return best / double(text.size());
+}
+
+bool
+check_scaling
+(
+    const std::string & name,
+    target t,
+    std::string (* make) (int),
+    int n
+)
+{
+    std::string small = make(n);
+    std::string large = make(n * 16);
+    double smallcost = ns_per_byte(t, small);
+    double largecost = ns_per_byte(t, large);
+    double ratio = smallcost > 0.0 ? largecost / smallcost : 1.0 ;
+    bool ok = ratio <= c_superlinear;
+    std::cout
+        << (ok ? "ok    " : "FAIL  ") << name << ": " << small.size()
+        << " bytes at " << smallcost << " ns/byte, " << large.size()
+        << " bytes at " << largecost << " ns/byte (x" << ratio << ")"
+        << std::endl
+        ;
+    return ok;
+}
+
+bool
+read_binary (const std::string & filename, std::string & text)
+{
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if (! in)
+        return false;
+
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    text = ss.str();
+    return true;
+}
+
+/**
+ *  Parses a file, and then mutated copies of it.
+ */
+
+bool
+replay (const std::string & filename, int mutations, std::mt19937 & rng)
+{
+    std::string text;
+    if (! read_binary(filename, text))
+    {
+        std::cerr << "Cannot read " << filename << std::endl;
+        return false;
+    }
+
+    std::filesystem::path ext = std::filesystem::path(filename).extension();
+    bool raw = ext != ".po" && ext != ".mo";
+    target t = ext == ".mo" ? target::mo : target::po ;
+    double ns;
+    if (raw)
+    {
+        auto start = std::chrono::steady_clock::now();
+        (void) LLVMFuzzerTestOneInput
+        (
+            reinterpret_cast<const std::uint8_t *>(text.data()), text.size()
+        );
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        ns = elapsed.count();
+    }
+    else
+        ns = timed_run(t, text);
+
+    std::cout
+        << "ok    " << filename << ": " << text.size() << " bytes at "
+        << (text.empty() ? 0.0 : ns / double(text.size())) << " ns/byte"
+        << std::endl
+        ;
+    if (! text.empty() && ! raw)
+    {
+        for (int m = 0; m < mutations; ++m)
+        {
+            std::string mutant = text;
+            int changes = 1 + int(rng() % 8);
+            for (int c = 0; c < changes; ++c)
+            {
+                std::size_t pos = rng() % mutant.size();
+                switch (rng() % 3)
+                {
+                case 0:
+                    mutant[pos] = char(rng());
+                    break;
+
+                case 1:
+                    mutant.erase(pos, 1 + rng() % 16);
+                    break;
+
+                default:
+                    mutant.insert(pos, mutant, rng() % mutant.size(), 16);
+                    break;
+                }
+                if (mutant.empty())
+                    mutant = " ";
+            }
+            run(t, mutant);
+        }
+    }
+    return true;
+}
+
+}           // namespace (anonymous)
+
+int
+main (int argc, char * argv [])
+{
+    namespace fs = std::filesystem;
+    silence_logs();
+
+    int mutations = 0;
+    bool timing = false;
+    bool ok = true;
+    std::mt19937 rng(20261017);
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--mutate" && i + 1 < argc)
+        {
+            mutations = std::atoi(argv[++i]);
+            continue;
+        }
+        if (arg == "--timing")
+        {
+            timing = true;
+            continue;
+        }
+
+        std::error_code ec;
+        if (fs::is_directory(arg, ec))
+        {
+            std::vector<std::string> files;
+            for (const auto & e : fs::recursive_directory_iterator(arg, ec))
+            {
+                if (e.is_regular_file())
+                    files.push_back(e.path().string());
+            }
+            std::sort(files.begin(), files.end());
+            for (const auto & f : files)
+            {
+                fs::path ext = fs::path(f).extension();
+                if (ext == ".po" || ext == ".mo")
+                    ok = replay(f, mutations, rng) && ok;
+            }
+        }
+        else
+            ok = replay(arg, mutations, rng) && ok;
+    }
+
+    if (timing)
+    {
+        ok = check_scaling("mo entries", target::mo, mo_entries, 2000) && ok;
+        ok = check_scaling("po entries", target::po, po_entries, 1000) && ok;
+        ok = check_scaling("po continued", target::po, po_continued, 500)
+            && ok;
+        ok = check_scaling("po quotes", target::po, po_quotes, 2000) && ok;
+        ok = check_scaling
+        (
+            "plural spaces", target::plural, plural_spaces, 500
+        ) && ok;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+#endif      // ! defined POTEXT_LIBFUZZER
+
+/*
+ * fuzz_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,561 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          libintl_bench.cpp
+ *
+ *      Compares the lookups of potext with those of the gettext() of the C
+ *      library (GNU libintl, part of glibc) on the same .mo catalog.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ * Usage:
+ *
+ *      libintl_bench [--lookups n] file.mo lang
+ *
+ *  The messages of the catalog are read first, to make the sets of keys:
+ *  the singular messages (hits), the same with a suffix added (misses),
+ *  the plural messages, and the messages with a context. The catalog is
+ *  then copied into a temporary tree with the two layouts the libraries
+ *  expect:
+ *
+\verbatim
+    potext_bench_PID/lang/LC_MESSAGES/potextbench.mo     for libintl
+    potext_bench_PID/po/lang.mo                          for potext
+\endverbatim
+ *
+ *  Each library is measured in its own child process, so that neither
+ *  sees the catalogs or the heap of the other, and the resident memory
+ *  (from /proc/self/statm, so Linux only) it adds can be told apart. It
+ *  is shown after the load and the hits, and again at the end, after the
+ *  misses: potext keeps the text of each miss warning in its log stream
+ *  until exit, so that the second figure grows with the lookups. The
+ *  load time is that of binding the domain and making the first lookup,
+ *  as libintl maps a catalog on first use. The lookup times are means over
+ *  about n calls of each kind (200000 by default), made through the public
+ *  API: ::gettext(), ::ngettext(), and the pgettext() of gettext.h (see
+ *  extras/code) for libintl, and po::gettext(), po::ngettext(), and
+ *  po::pgettext() for potext, which return a copy of the string.
+ *
+ *  libintl translates only if the locale is not "C", so the libintl
+ *  child sets the C.UTF-8 locale and selects the language by the LANGUAGE
+ *  environment variable.
+ *
+ *  It is not run by "meson test". Build it with optimization:
+ *
+ *      $ meson setup build-bench --buildtype=release -Denable_benchmarks=true
+ *      $ build-bench/library/tests/libintl_bench mo/de.mo de
+ */
+
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <clocale>                      /* std::setlocale(), LC_ALL         */
+#include <cstdlib>                      /* EXIT_SUCCESS, setenv()           */
+#include <filesystem>                   /* std::filesystem functions        */
+#include <fstream>                      /* std::ifstream                    */
+#include <iomanip>                      /* std::setw()                      */
+#include <iostream>                     /* std::cout, std::cerr             */
+#include <string>                       /* std::string                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include <libintl.h>                    /* ::gettext(), ::ngettext(), etc.  */
+#include <sys/wait.h>                   /* waitpid()                        */
+#include <unistd.h>                     /* fork(), pipe(), sysconf()        */
+
+#include "po/potext.hpp"                /* po::gettext(), etc.              */
+#include "po/logstream.hpp"             /* po::logstream callbacks          */
+#include "po/moparser.hpp"              /* po::moparser::parse_mo_file()    */
+
+namespace
+{
+
+namespace fs = std::filesystem;
+
+using clocktype = std::chrono::steady_clock;
+
+/**
+ *  The default number of lookups of each kind, and the domain libintl
+ *  uses.
+ */
+
+const long c_lookups = 200000;
+const char * const c_domain = "potextbench";
+
+/**
+ *  The keys of the lookups, made from the catalog.
+ */
+
+struct pluralkey
+{
+    std::string pk_msgid;
+    std::string pk_plural;
+};
+
+struct contextkey
+{
+    std::string ck_msgctxt;
+    std::string ck_msgid;
+    std::string ck_joined;              /* "msgctxt\004msgid" for libintl   */
+};
+
+struct keyset
+{
+    std::vector<std::string> ks_hits;
+    std::vector<std::string> ks_misses;
+    std::vector<pluralkey> ks_plurals;
+    std::vector<contextkey> ks_contexts;
+};
+
+/**
+ *  The measurements of one library, passed from the child through a pipe.
+ *  A time is -1 if there were no keys of its kind.
+ */
+
+struct benchresult
+{
+    bool br_ok;
+    double br_load_us;
+    double br_hit_ns;
+    double br_miss_ns;
+    double br_plural_ns;
+    double br_context_ns;
+    long br_rss_kib;                    /* after the load and the hits      */
+    long br_rss_end_kib;                /* after the misses, too            */
+    unsigned long br_translated;        /* hits whose result is not msgid   */
+    unsigned long br_checksum;          /* keeps the lookups from vanishing */
+};
+
+void
+quiet (const std::string &)
+{
+    // no code
+}
+
+long
+resident_kib ()
+{
+    long pages = 0;
+    long resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    if (statm >> pages >> resident)
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+
+    return 0;
+}
+
+bool
+read_keys (const std::string & filename, keyset & keys)
+{
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    po::dictionary dict;
+    if (! in || ! po::moparser::parse_mo_file(filename, in, dict))
+        return false;
+
+    dict.foreach
+    (
+        [&keys]
+        (
+            const std::string & msgid,
+            const std::string & msgid_plural,
+            const po::phraselist & /*msgstrs*/
+        )
+        {
+            if (msgid.empty())
+                return;                         /* the header               */
+
+            if (msgid_plural.empty())
+            {
+                keys.ks_hits.push_back(msgid);
+                keys.ks_misses.push_back(msgid + " (missing)");
+            }
+            else
+                keys.ks_plurals.push_back(pluralkey{msgid, msgid_plural});
+        }
+    );
+    dict.foreach_ctxt
+    (
+        [&keys]
+        (
+            const std::string & msgctxt,
+            const std::string & msgid,
+            const std::string & msgid_plural,
+            const po::phraselist & /*msgstrs*/
+        )
+        {
+            if (msgid_plural.empty())
+            {
+                keys.ks_contexts.push_back
+                (
+                    contextkey{msgctxt, msgid, msgctxt + '\004' + msgid}
+                );
+            }
+        }
+    );
+    return ! keys.ks_hits.empty();
+}
+
+/**
+ *  Calls a lookup for each key, enough rounds to make about the given
+ *  number of calls, and returns the mean time of a call in nanoseconds.
+ */
+
+template<typename KEY, typename FUNC>
+double
+time_lookups (const std::vector<KEY> & keys, long lookups, FUNC func)
+{
+    if (keys.empty())
+        return -1.0;
+
+    long rounds = lookups / long(keys.size());
+    if (rounds < 1)
+        rounds = 1;
+
+    auto start = clocktype::now();
+    for (long r = 0; r < rounds; ++r)
+    {
+        for (std::size_t k = 0; k < keys.size(); ++k)
+            func(keys[k], int(r + k) % 10);
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        clocktype::now() - start;
+
+    return elapsed.count() / double(rounds * long(keys.size()));
+}
+
+/**
+ *  The libintl side. The results of ::gettext() are pointers into the
+ *  mapped catalog; the first byte of each is summed so that the calls
+ *  cannot be dropped.
+ */
+
+benchresult
+bench_libintl
+(
+    const keyset & keys, const std::string & top,
+    const std::string & lang, long lookups
+)
+{
+    benchresult result{};
+    if (is_nullptr(std::setlocale(LC_ALL, "C.UTF-8")))
+        (void) std::setlocale(LC_ALL, "C.utf8");
+
+    (void) setenv("LANGUAGE", lang.c_str(), 1);
+
+    unsigned long sum = 0;
+    long rss = resident_kib();
+    auto start = clocktype::now();
+    (void) ::bindtextdomain(c_domain, top.c_str());
+    (void) ::bind_textdomain_codeset(c_domain, "UTF-8");
+    (void) ::textdomain(c_domain);
+    sum += unsigned(*::gettext(keys.ks_hits.front().c_str()));
+
+    std::chrono::duration<double, std::micro> load =
+        clocktype::now() - start;
+
+    result.br_load_us = load.count();
+    for (const auto & msgid : keys.ks_hits)
+    {
+        if (msgid != ::gettext(msgid.c_str()))
+            ++result.br_translated;
+    }
+    result.br_hit_ns = time_lookups
+    (
+        keys.ks_hits, lookups,
+        [&sum] (const std::string & k, int)
+        {
+            sum += unsigned(*::gettext(k.c_str()));
+        }
+    );
+    result.br_plural_ns = time_lookups
+    (
+        keys.ks_plurals, lookups,
+        [&sum] (const pluralkey & k, int n)
+        {
+            sum += unsigned
+            (
+                *::ngettext(k.pk_msgid.c_str(), k.pk_plural.c_str(), n)
+            );
+        }
+    );
+    result.br_context_ns = time_lookups
+    (
+        keys.ks_contexts, lookups,
+        [&sum] (const contextkey & k, int)
+        {
+            const char * t = ::gettext(k.ck_joined.c_str());
+            if (t == k.ck_joined.c_str())
+                t = k.ck_msgid.c_str();         /* as pgettext_aux() does   */
+
+            sum += unsigned(*t);
+        }
+    );
+    result.br_rss_kib = resident_kib() - rss;
+    result.br_miss_ns = time_lookups
+    (
+        keys.ks_misses, lookups,
+        [&sum] (const std::string & k, int)
+        {
+            sum += unsigned(*::gettext(k.c_str()));
+        }
+    );
+    result.br_rss_end_kib = resident_kib() - rss;
+    result.br_checksum = sum;
+    result.br_ok = result.br_translated > 0;
+    return result;
+}
+
+/**
+ *  The potext side. The catalog directory holds only the one catalog, so
+ *  po::init_app_locale() loads just it. The directory is given relative to
+ *  the current one, as an absolute one outside of /usr would be taken for
+ *  a directory of no known type (see analyze_directory_type() in
+ *  gettext.cpp).
+ */
+
+benchresult
+bench_potext
+(
+    const keyset & keys, const std::string & top,
+    const std::string & lang, long lookups, const char * arg0
+)
+{
+    benchresult result{};
+    po::logstream::set_warning_callback(quiet);     /* misses are expected  */
+    po::logstream::set_info_callback(quiet);
+
+    unsigned long sum = 0;
+    long rss = resident_kib();
+    auto start = clocktype::now();
+    std::error_code ec;
+    fs::path podir = fs::relative(fs::path(top) / "po", ec);
+    std::string dirname = po::init_app_locale
+    (
+        arg0, "libintl_bench", lang, podir.string()
+    );
+    if (dirname.empty())
+        return result;
+
+    sum += po::gettext(keys.ks_hits.front()).size();
+
+    std::chrono::duration<double, std::micro> load =
+        clocktype::now() - start;
+
+    result.br_load_us = load.count();
+    for (const auto & msgid : keys.ks_hits)
+    {
+        if (msgid != po::gettext(msgid))
+            ++result.br_translated;
+    }
+    result.br_hit_ns = time_lookups
+    (
+        keys.ks_hits, lookups,
+        [&sum] (const std::string & k, int)
+        {
+            sum += po::gettext(k).size();
+        }
+    );
+    result.br_plural_ns = time_lookups
+    (
+        keys.ks_plurals, lookups,
+        [&sum] (const pluralkey & k, int n)
+        {
+            sum += po::ngettext(k.pk_msgid, k.pk_plural, n).size();
+        }
+    );
+    result.br_context_ns = time_lookups
+    (
+        keys.ks_contexts, lookups,
+        [&sum] (const contextkey & k, int)
+        {
+            sum += po::pgettext(k.ck_msgctxt, k.ck_msgid).size();
+        }
+    );
+    result.br_rss_kib = resident_kib() - rss;
+    result.br_miss_ns = time_lookups
+    (
+        keys.ks_misses, lookups,
+        [&sum] (const std::string & k, int)
+        {
+            sum += po::gettext(k).size();
+        }
+    );
+    result.br_rss_end_kib = resident_kib() - rss;
+    result.br_checksum = sum;
+    result.br_ok = result.br_translated > 0;
+    return result;
+}
+
+/**
+ *  Runs one side in a child process and gets its results.
+ */
+
+template<typename FUNC>
+benchresult
+run_child (FUNC func)
+{
+    benchresult result{};
+    int fds[2];
+    if (pipe(fds) != 0)
+        return result;
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        benchresult r = func();
+        ssize_t n = write(fds[1], &r, sizeof r);
+        _exit(n == ssize_t(sizeof r) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close(fds[1]);
+    if (pid > 0)
+    {
+        if (read(fds[0], &result, sizeof result) != ssize_t(sizeof result))
+            result.br_ok = false;
+
+        (void) waitpid(pid, nullptr, 0);
+    }
+    close(fds[0]);
+    return result;
+}
+
+void
+show_row (const char * name, double a, double b, int precision = 1)
+{
+    std::cout << std::left << std::setw(16) << name << std::right;
+    for (double v : { a, b })
+    {
+        if (v < 0.0)
+            std::cout << std::setw(12) << "-";
+        else
+            std::cout << std::setw(12) << std::setprecision(precision) << v;
+    }
+    std::cout << "\n";
+}
+
+}           // namespace (anonymous)
+
+int
+main (int argc, char * argv [])
+{
+    long lookups = c_lookups;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--lookups" && i + 1 < argc)
+            lookups = std::atol(argv[++i]);
+        else
+            args.push_back(arg);
+    }
+    if (args.size() != 2 || lookups <= 0)
+    {
+        std::cerr
+            << "Usage: libintl_bench [--lookups n] file.mo lang" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string & mofile = args[0];
+    const std::string & lang = args[1];
+    keyset keys;
+    if (! read_keys(mofile, keys))
+    {
+        std::cerr << "Cannot read the messages of " << mofile << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::error_code ec;
+    fs::path top = fs::temp_directory_path() /
+        ("potext_bench_" + std::to_string(getpid()));
+
+    fs::path lcdir = top / lang / "LC_MESSAGES";
+    bool ok = fs::create_directories(lcdir, ec) &&
+        fs::create_directories(top / "po", ec) &&
+        fs::copy_file(mofile, lcdir / (std::string(c_domain) + ".mo"), ec) &&
+        fs::copy_file(mofile, top / "po" / (lang + ".mo"), ec);
+
+    if (! ok)
+    {
+        std::cerr << "Cannot make the catalog tree in " << top << std::endl;
+        (void) fs::remove_all(top, ec);
+        return EXIT_FAILURE;
+    }
+
+    benchresult gnu = run_child
+    (
+        [&] () { return bench_libintl(keys, top.string(), lang, lookups); }
+    );
+    benchresult pot = run_child
+    (
+        [&] ()
+        {
+            return bench_potext(keys, top.string(), lang, lookups, argv[0]);
+        }
+    );
+    (void) fs::remove_all(top, ec);
+
+    std::cout
+        << std::fixed
+        << "Catalog:        " << mofile << " (" << lang << "), "
+        << keys.ks_hits.size() << " singular, " << keys.ks_plurals.size()
+        << " plural, " << keys.ks_contexts.size() << " with context\n\n"
+        << std::left << std::setw(16) << "" << std::right
+        << std::setw(12) << "libintl" << std::setw(12) << "potext" << "\n"
+        ;
+    show_row("Load (us)", gnu.br_load_us, pot.br_load_us);
+    show_row("Hit (ns)", gnu.br_hit_ns, pot.br_hit_ns);
+    show_row("Miss (ns)", gnu.br_miss_ns, pot.br_miss_ns);
+    show_row("Plural (ns)", gnu.br_plural_ns, pot.br_plural_ns);
+    show_row("Context (ns)", gnu.br_context_ns, pot.br_context_ns);
+    show_row("RSS (KiB)", double(gnu.br_rss_kib), double(pot.br_rss_kib), 0);
+    show_row
+    (
+        "RSS end (KiB)",
+        double(gnu.br_rss_end_kib), double(pot.br_rss_end_kib), 0
+    );
+    show_row
+    (
+        "Translated", double(gnu.br_translated), double(pot.br_translated), 0
+    );
+    std::cout << std::endl;
+    if (! gnu.br_ok)
+    {
+        std::cerr
+            << "libintl translated nothing; is the C.UTF-8 locale installed?"
+            << std::endl
+            ;
+    }
+    if (! pot.br_ok)
+        std::cerr << "potext translated nothing" << std::endl;
+
+    return gnu.br_ok && pot.br_ok ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * libintl_bench.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
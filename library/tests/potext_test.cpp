@@ -30,21 +30,40 @@
  * \library       potext
  * \author        tinygettext; refactoring by Chris Ahlstrom
  * \date          2024-02-05
- * \updates       2024-04-13
+ * \updates       2026-10-17
  * \license       See above.
  *
  */
 
 #include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
 #include <cstring>                      /* std::strcmp()                    */
+#include <algorithm>                    /* std::lower_bound()               */
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <filesystem>                   /* std::filesystem functions        */
 #include <fstream>                      /* std::ifstream                    */
 #include <iostream>                     /* std::cout and std::cerr          */
+#include <limits>                       /* std::numeric_limits<>            */
+#include <set>                          /* std::set<> template              */
+#include <sstream>                      /* std::istringstream               */
 #include <stdexcept>                    /* std::runtime_error               */
+#include <thread>                       /* std::thread                      */
 
+#include "po/coldstore.hpp"             /* po::lz_compress(), etc.          */
+#include "po/flatcatalog.hpp"           /* po::flatcatalog class            */
 #include "po/logstream.hpp"             /* po::logstream::get_test_error()  */
+#include "po/manifest.hpp"              /* po::manifest message-ID set      */
+#include "po/iconvert.hpp"              /* po::iconvert class               */
+#include "po/labeltable.hpp"            /* po::labeltable class             */
 #include "po/moparser.hpp"              /* po::moparser class               */
+#include "po/msgidtable.hpp"            /* po::msgidtable class             */
+#include "po/overlay.hpp"               /* po::overlay class                */
+#include "po/pomerge.hpp"               /* po::pomerge class                */
 #include "po/poparser.hpp"              /* po::poparser class               */
+#include "po/popushparser.hpp"          /* po::popushparser class           */
 #include "po/potext.hpp"                /* #includes three header files     */
+#include "po/searchindex.hpp"           /* po::searchindex class            */
+#include "po/sourcescanner.hpp"         /* po::sourcescanner class          */
+#include "po/tracerecorder.hpp"         /* po::tracerecorder class          */
 #include "po/unixfilesystem.hpp"        /* po::unixfilesystem               */
 #include "po/wstrfunctions.hpp"         /* po::is_po_file(), is_mo_file()   */
 
@@ -110,7 +129,25 @@ print_usage (const std::string & arg0)
 << "  [e] " << arg0 << " directory <dir> <msg> [<lang>]\n"
 << "  [f] " << arg0 << " language <lang>\n"
 << "  [g] " << arg0 << " language-dir <dir>\n"
-<< "  [h] " << arg0 << " list-msgstrs <file>\n\n"
+<< "  [h] " << arg0 << " list-msgstrs <file>\n"
+<< "  [i] " << arg0 << " manifest <keys> <file> <msg> [kept | pruned]\n"
+<< "  [j] " << arg0 << " msgid-table <source> <file> [<context>] <msg>\n"
+<< "  [k] " << arg0 << " add-directory <dir> <lang> <dir2> [kept | reloaded]\n"
+<< "  [l] " << arg0 << " codeset <file> <msg> <codeset>\n"
+<< "  [m] " << arg0 << " domains <dom1> <dir1> <dom2> <dir2> <lang> <msg>\n"
+<< "  [n] " << arg0 << " shared-cache <dir> <lang>\n"
+<< "  [o] " << arg0 << " search <file> <text> <msg> [<entries>]\n"
+<< "  [p] " << arg0 << " merge <file.po> <file.pot> <msg> exact|fuzzy|none\n"
+<< "  [q] " << arg0 << " accept-language <dir> <header> <lang>|none\n"
+<< "  [r] " << arg0 << " memory-budget <dir> <lang> <msg>\n"
+<< "  [s] " << arg0 << " cold-strings <file> <length> <msg>\n"
+<< "  [t] " << arg0 << " catalog-cache <file.po> <lang> <msg>\n"
+<< "  [u] " << arg0 << " overlay <file> <msg> <override>\n"
+<< "  [v] " << arg0 << " plurals <file> <singular> <plural>\n"
+<< "  [w] " << arg0 << " push-parse <file.po> <chunk>\n"
+<< "  [x] " << arg0 << " merge-dirs <lang> <dir> <dir> [<dir> ...]\n"
+<< "  [y] " << arg0 << " trace <msg>\n"
+<< "  [z] " << arg0 << " labels <dir> <lang> <lang2> <ctxt>|- <msg> [<msg> ...]\n\n"
 <<
    "[a] Create a dictionary from 'file'; translate the 'msg'.\n"
    "[b] Ditto; translate the 'msg' using the 'context'.\n"
@@ -119,8 +156,65 @@ print_usage (const std::string & arg0)
    "[e] Create a language object from 'lang' and show stuff a bit like [g].\n"
    "[f] Get the language by its name (e.g. fr_FR) and show its attributes.\n"
    "[g] Set a dictionary manager using 'dir', get the languages, and list them.\n"
-   "[h] Create a dictionary from 'file' and print the messages and contexts.\n\n"
-   "Shortcuts: 'tr', 'dir', 'lang', 'ld', and 'lm'\n\n"
+   "[h] Create a dictionary from 'file' and print the messages and contexts.\n"
+   "[i] Load 'file' keeping only the messages in the 'keys' manifest (.pot or\n"
+   "    key list), translate 'msg', and optionally check it was kept/pruned.\n"
+   "[j] Scan 'source' for messages, build the integer message-ID table from\n"
+   "    'file', and check the entry for 'msg' against a normal lookup.\n"
+   "[k] Load the 'lang' dictionary from 'dir', add 'dir2' to the search path,\n"
+   "    and optionally check that the dictionary was kept or reloaded.\n"
+   "[l] Create a dictionary from 'file', translate 'msg' in 'codeset', and\n"
+   "    check that the view converts back to the stored UTF-8 translation.\n"
+   "[m] Bind 'dom1' to 'dir1' and 'dom2' to 'dir2', translate 'msg' in 'lang'\n"
+   "    in each, and check that switching domains keeps both dictionaries.\n"
+   "[n] Load the 'lang' dictionary from 'dir' through a shared catalog cache\n"
+   "    in two managers, and check that the second maps the image made by\n"
+   "    the first and translates every message as the parsed catalog does,\n"
+   "    without copying the translations out of the image.\n"
+   "[o] Create a dictionary from 'file', search it for 'text', check that\n"
+   "    'msg' is found, and check the index against a scan of every message.\n"
+   "    Then time searches of a made-up catalog of 'entries' messages.\n"
+   "[p] Merge the translations of 'file.po' into 'file.pot', check how 'msg'\n"
+   "    was matched, and check that the result reads back unchanged.\n"
+   "[q] Negotiate the Accept-Language 'header' against the catalogs in 'dir',\n"
+   "    check the language picked, and check that the answer is cached.\n"
+   "[r] Set 'lang' in 'dir' with a tiny memory budget, translate 'msg' in\n"
+   "    every language there, and check that the others are evicted, that\n"
+   "    'lang' and its fallback stay, and that evicted ones are reloaded,\n"
+   "    also by dgettext() with the name of the language as the domain.\n"
+   "[s] Create a dictionary from 'file', compress the translations longer\n"
+   "    than 'length', check every lookup against an uncompressed copy,\n"
+   "    and check that it takes less memory. Then translate 'msg'.\n"
+   "[t] Copy 'file.po' as the 'lang' catalog, load it through a catalog\n"
+   "    cache, and check that a new manager maps the image. Then change the\n"
+   "    translation of 'msg', keeping the size and time of the file, and\n"
+   "    check that the stale image is replaced rather than used.\n"
+   "[u] Create a dictionary from 'file', and an overlay of it that overrides\n"
+   "    'msg' with 'override'. Check the override, and that every other\n"
+   "    message shows the base translation. Time making and dropping them.\n"
+   "[v] Check the plural forms of an array of counts against those of each\n"
+   "    count, for several languages. Then create a dictionary from 'file',\n"
+   "    translate 'singular' for all the counts at once, check each against\n"
+   "    translate_plural(), and time both.\n"
+   "[w] Parse 'file.po' with the push parser, fed in pieces of 'chunk'\n"
+   "    bytes, of one byte, and of varying sizes, and check that each\n"
+   "    dictionary matches the one poparser makes. Then check that a\n"
+   "    catalog cut off inside a string is rejected.\n"
+   "[x] Load the 'lang' catalogs of the directories, the first having the\n"
+   "    highest precedence, and check each message against the catalog\n"
+   "    that first has it. Check that the shadowed messages were skipped.\n"
+   "[y] Record a trace of lookups of 'msg' made by the gettext functions in\n"
+   "    two threads, read it back, and check each lookup. Check that nothing\n"
+   "    is recorded once the recorder is stopped.\n"
+   "[z] Register a table of the 'msg's (in 'ctxt', unless '-') in 'dir' for\n"
+   "    'lang', and check the labels against the dictionary. Change to\n"
+   "    'lang2' and check that the labels follow, that a label taken\n"
+   "    earlier is still valid, and that changing back and forth keeps only\n"
+   "    a few translations. Time reading the labels against looking them\n"
+   "    up.\n\n"
+   "Shortcuts: 'tr', 'dir', 'lang', 'ld', 'lm', 'mf', 'mi', 'ad', 'cs', 'dm',\n"
+   "'sc', 'se', 'mm', 'al', 'mb', 'co', 'cc', 'ov', 'pl', 'pp', 'md', 'tc',\n"
+   "and 'lt'\n\n"
 << "See the developer guide (PDF) for more details, especially on the format\n"
    "of the <lang> parameter."
 << std::endl
@@ -128,7 +222,12 @@ print_usage (const std::string & arg0)
 }
 
 static void
-read_dictionary (const std::string & filename, po::dictionary & dict)
+read_dictionary
+(
+    const std::string & filename,
+    po::dictionary & dict,
+    const po::manifest * mf = nullptr
+)
 {
     std::ifstream in(filename.c_str());
     if (! in)
@@ -140,11 +239,11 @@ read_dictionary (const std::string & filename, po::dictionary & dict)
         bool ok = false;
         if (po::is_po_file(filename))
         {
-            ok = po::poparser::parse_po_file(filename, in, dict);
+            ok = po::poparser::parse_po_file(filename, in, dict, true, mf);
         }
         else if (po::is_mo_file(filename))
         {
-            ok = po::moparser::parse_mo_file(filename, in, dict);
+            ok = po::moparser::parse_mo_file(filename, in, dict, true, mf);
         }
 
         /*
@@ -430,6 +529,1918 @@ main (int argc, char * argv [])
                     ;
             }
         }
+        else if (option == "manifest" || option == "mf")
+        {
+            /*
+             * Test [i]
+             */
+
+            if (argc == 5 || argc == 6)
+            {
+                const char * keysname = argv[2];
+                const char * filename = argv[3];
+                const char * msg = argv[4];
+                std::string check = argc == 6 ? argv[5] : "" ;
+                po::manifest mf;
+                if (! mf.load(keysname))
+                {
+                    std::string keys{keysname};
+                    throw std::runtime_error("Could not load " + keys);
+                }
+
+                po::dictionary dict;
+                read_dictionary(filename, dict, &mf);
+
+                std::string tr = dict.translate(msg);
+                bool kept = tr != msg;
+                std::cout
+                    << "Manifest keys: " << mf.size() << "\n"
+                    << "Translation:   \"" << tr << "\" ("
+                    << (kept ? "kept" : "pruned") << ")"
+                    << std::endl
+                    ;
+                if (! check.empty() && check != (kept ? "kept" : "pruned"))
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "Expected '" << msg << "' to be " << check
+                        << std::endl
+                        ;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " manifest <keys> <file> <msg> [kept|pruned]'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "msgid-table" || option == "mi")
+        {
+            /*
+             * Test [j]
+             */
+
+            if (argc == 5 || argc == 6)
+            {
+                const char * sourcename = argv[2];
+                const char * filename = argv[3];
+                std::string ctxt = argc == 6 ? argv[4] : "" ;
+                std::string msg = argc == 6 ? argv[5] : argv[4] ;
+                po::sourcescanner scanner;
+                po::sourcescanner::messages msgs;
+                if (! scanner.scan_file(sourcename, msgs))
+                {
+                    std::string source{sourcename};
+                    throw std::runtime_error("Could not scan " + source);
+                }
+
+                /*
+                 * Build the sorted key table as potext-msgids would.
+                 */
+
+                std::set<std::string> keyset;
+                for (const auto & m : msgs)
+                    (void) keyset.insert(po::sourcescanner::make_key(m));
+
+                std::vector<const char *> keys;
+                for (const auto & k : keyset)
+                    keys.push_back(k.c_str());
+
+                po::dictionary dict;
+                read_dictionary(filename, dict);
+
+                po::msgidtable table;
+                table.assign(keys.data(), keys.size());
+                table.build(&dict, 0);
+
+                std::string key = argc == 6 ?
+                    po::manifest::make_key(ctxt, msg) : msg ;
+
+                auto it = std::lower_bound
+                (
+                    keys.begin(), keys.end(), key.c_str(),
+                    [] (const char * a, const char * b)
+                    {
+                        return po::msgid_compare(a, b) < 0;
+                    }
+                );
+                if (it == keys.end() || key != *it)
+                    throw std::runtime_error("Not in the source: " + key);
+
+                std::size_t id = std::size_t(it - keys.begin());
+                std::string expected = argc == 6 ?
+                    dict.translate_ctxt(ctxt, msg) : dict.translate(msg) ;
+
+                std::cout
+                    << "Keys:          " << keys.size() << "\n"
+                    << "Message ID:    " << id << "\n"
+                    << "Translation:   \"" << table.at(id) << "\""
+                    << std::endl
+                    ;
+                if (table.at(id) != expected)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "Expected \"" << expected << "\""
+                        << std::endl
+                        ;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " msgid-table <source> <file> [<ctxt>] <msg>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "add-directory" || option == "ad")
+        {
+            /*
+             * Test [k]
+             */
+
+            if (argc == 5 || argc == 6)
+            {
+                const char * dir = argv[2];
+                po::language lang = po::language::from_env(argv[3]);
+                const char * dir2 = argv[4];
+                std::string check = argc == 6 ? argv[5] : "" ;
+                if (! lang)
+                {
+                    std::string name{argv[3]};
+                    throw std::runtime_error("Unknown language " + name);
+                }
+
+                po::dictionarymgr mgr;
+                mgr.add_directory(dir);
+                mgr.set_language(lang);
+
+                const po::dictionary * before = &mgr.get_dictionary();
+                unsigned long generation = mgr.generation();
+                mgr.add_directory(dir2);
+
+                const po::dictionary * after = &mgr.get_dictionary();
+                bool kept = after == before && mgr.generation() == generation;
+                std::cout
+                    << "Dictionary:    " << (kept ? "kept" : "reloaded")
+                    << std::endl
+                    ;
+                if (! check.empty() && check != (kept ? "kept" : "reloaded"))
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "Expected the dictionary to be " << check
+                        << std::endl
+                        ;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " add-directory <dir> <lang> <dir2> "
+                    "[kept|reloaded]'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "codeset" || option == "cs")
+        {
+            /*
+             * Test [l]
+             */
+
+            if (argc == 5)
+            {
+                po::dictionary dict;
+                read_dictionary(argv[2], dict);
+
+                std::string msgid{argv[3]};
+                std::string codeset{argv[4]};
+                std::string stored = dict.translate(msgid);
+                std::string viewed = dict.translate(msgid, codeset);
+                po::iconvert back(codeset, "UTF-8");
+                bool ok = back.convert(viewed) == stored;
+                const std::string * msgstr = dict.find(msgid);
+                if (ok && not_nullptr(msgstr))
+                {
+                    const std::string * first = &dict.view(*msgstr, codeset);
+                    ok = &dict.view(*msgstr, codeset) == first;
+                }
+                if (ok)
+                {
+                    ok = dict.set_charset(codeset) &&
+                        dict.translate(msgid) == viewed;
+                }
+                if (ok)
+                {
+                    ok = dict.set_charset("UTF-8") &&
+                        dict.translate(msgid) == stored;
+                }
+                std::cout
+                    << "UTF-8:         " << stored.size() << " bytes\n"
+                    << codeset << ": " << viewed.size() << " bytes"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The " << codeset << " view of '" << msgid
+                        << "' is wrong" << std::endl
+                        ;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " codeset <file> <msg> <codeset>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "domains" || option == "dm")
+        {
+            /*
+             * Test [m]
+             */
+
+            if (argc == 8)
+            {
+                std::string dom1{argv[2]};
+                std::string dom2{argv[4]};
+                po::language lang = po::language::from_env(argv[6]);
+                std::string msgid{argv[7]};
+                if (! lang)
+                {
+                    std::string name{argv[6]};
+                    throw std::runtime_error("Unknown language " + name);
+                }
+
+                po::dictionarymgr mgr;
+                mgr.set_language(lang);
+                (void) mgr.bindtextdomain(dom1, argv[3]);
+                (void) mgr.bindtextdomain(dom2, argv[5]);
+                (void) mgr.textdomain(dom1);
+
+                const po::dictionary * first = &mgr.get_dictionary();
+                std::string msg1 = first->translate(msgid);
+                (void) mgr.textdomain(dom2);
+
+                const po::dictionary * second = &mgr.get_dictionary();
+                std::string msg2 = second->translate(msgid);
+                (void) mgr.textdomain(dom1);
+
+                bool ok = &mgr.get_dictionary() == first &&
+                    &mgr.get_domain_dictionary(dom2) == second &&
+                    first != second && (msg1 != msgid || msg2 != msgid);
+
+                std::cout
+                    << dom1 << ": '" << msg1 << "'\n"
+                    << dom2 << ": '" << msg2 << "'\n"
+                    << "Resident:      " << (ok ? "yes" : "no")
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The domain dictionaries were not kept"
+                        << std::endl
+                        ;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " domains <dom1> <dir1> <dom2> <dir2> "
+                    "<lang> <msg>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "shared-cache" || option == "sc")
+        {
+            /*
+             * Test [n]
+             */
+
+            if (argc == 4)
+            {
+                const char * dir = argv[2];
+                po::language lang = po::language::from_env(argv[3]);
+                if (! lang)
+                {
+                    std::string name{argv[3]};
+                    throw std::runtime_error("Unknown language " + name);
+                }
+
+                namespace fs = std::filesystem;
+                fs::path cache = fs::temp_directory_path() / "potext_test_cache";
+                std::error_code ec;
+                (void) fs::remove_all(cache, ec);
+
+                po::dictionarymgr parsed;
+                parsed.add_directory(dir);
+                parsed.set_language(lang);
+
+                po::dictionarymgr publisher;
+                publisher.set_shared_cache(cache.string());
+                publisher.add_directory(dir);
+                publisher.set_language(lang);
+                (void) publisher.get_dictionary();
+
+                po::dictionarymgr reader;
+                reader.set_shared_cache(cache.string());
+                reader.add_directory(dir);
+                reader.set_language(lang);
+
+                const po::dictionary & expected = parsed.get_dictionary();
+                const po::dictionary & actual = reader.get_dictionary();
+                bool ok = actual.file_mode() == po::dictionary::mode::flat &&
+                    not_nullptr(actual.flat()) && actual.flat()->mapped();
+
+                /*
+                 * Looking up the translations of the image must not copy
+                 * them into the dictionary.
+                 */
+
+                std::size_t usage = actual.memory_usage();
+                std::size_t count = 0;
+                std::size_t mismatches = 0;
+                expected.foreach
+                (
+                    [&]
+                    (
+                        const std::string & msgid,
+                        const std::string & msgid_plural,
+                        const po::phraselist & /*msgstrs*/
+                    )
+                    {
+                        ++count;
+                        if (actual.translate(msgid) != expected.translate(msgid))
+                            ++mismatches;
+
+                        const std::string * msgstr = expected.find(msgid);
+                        std::string_view found = actual.find_view(msgid);
+                        bool same = not_nullptr(msgstr) ?
+                            *msgstr == found : found.empty() ;
+
+                        if (! same)
+                            ++mismatches;
+
+                        if (! msgid_plural.empty())
+                        {
+                            for (int n : { 1, 2, 5 })
+                            {
+                                if
+                                (
+                                    actual.translate_plural(msgid, msgid_plural, n) !=
+                                    expected.translate_plural(msgid, msgid_plural, n)
+                                )
+                                {
+                                    ++mismatches;
+                                }
+                            }
+                        }
+                    }
+                );
+                expected.foreach_ctxt
+                (
+                    [&]
+                    (
+                        const std::string & ctxt,
+                        const std::string & msgid,
+                        const std::string & /*msgid_plural*/,
+                        const po::phraselist & /*msgstrs*/
+                    )
+                    {
+                        ++count;
+                        if
+                        (
+                            actual.translate_ctxt(ctxt, msgid) !=
+                            expected.translate_ctxt(ctxt, msgid)
+                        )
+                        {
+                            ++mismatches;
+                        }
+                    }
+                );
+
+                /*
+                 * A damaged image must be rejected.
+                 */
+
+                bool detected = false;
+                for (const auto & f : fs::directory_iterator(cache, ec))
+                {
+                    std::string image;
+                    if (po::read_file(f.path().string(), image) && ! image.empty())
+                    {
+                        po::flatcatalog fc;
+                        detected = fc.assign(image);
+                        image[image.size() - 1] ^= 0x20;
+                        detected = detected && ! fc.assign(image);
+                    }
+                }
+                (void) fs::remove_all(cache, ec);
+
+                std::size_t copied = actual.memory_usage() - usage;
+                ok = ok && count > 0 && mismatches == 0 && detected &&
+                    copied == 0;
+
+                std::cout
+                    << "Messages:      " << count << "\n"
+                    << "Mismatches:    " << mismatches << "\n"
+                    << "Copied:        " << copied << " bytes\n"
+                    << "Image:         "
+                    << (ok ? actual.flat()->size() : 0) << " bytes"
+                    << (detected ? ", damage detected" : "")
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The shared catalog does not match" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " shared-cache <dir> <lang>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "search" || option == "se")
+        {
+            /*
+             * Test [o]
+             */
+
+            if (argc == 5 || argc == 6)
+            {
+                po::dictionary dict;
+                read_dictionary(argv[2], dict);
+
+                std::string text{argv[3]};
+                std::string msgid{argv[4]};
+                auto index = dict.search_index();
+                std::vector<std::size_t> found = index->find(text);
+                std::vector<std::size_t> starts = index->find_prefix(text);
+
+                /*
+                 * Scan every message, in the order of the index, for the
+                 * same answers.
+                 */
+
+                auto lower = [] (std::string s)
+                {
+                    for (auto & ch : s)
+                    {
+                        if (ch >= 'A' && ch <= 'Z')
+                            ch = char(ch - 'A' + 'a');
+                    }
+                    return s;
+                };
+                std::string key = lower(text);
+                std::vector<std::size_t> scanned;
+                std::vector<std::size_t> prefixed;
+                std::size_t entry = 0;
+                auto scan = [&]
+                (
+                    const std::string & id,
+                    const std::string & plural,
+                    const po::phraselist & msgstrs
+                )
+                {
+                    po::phraselist strings{id, plural};
+                    strings.insert(strings.end(), msgstrs.begin(), msgstrs.end());
+
+                    bool contains = false;
+                    bool starts_with = false;
+                    for (const auto & str : strings)
+                    {
+                        if (str.empty())
+                            continue;
+
+                        std::string folded = lower(str);
+                        if (folded.find(key) != std::string::npos)
+                            contains = true;
+
+                        if (folded.compare(0, key.size(), key) == 0)
+                            starts_with = true;
+                    }
+                    if (contains)
+                        scanned.push_back(entry);
+
+                    if (starts_with)
+                        prefixed.push_back(entry);
+
+                    ++entry;
+                };
+                dict.foreach(scan);
+                dict.foreach_ctxt
+                (
+                    [&scan]
+                    (
+                        const std::string & /*ctxt*/,
+                        const std::string & id,
+                        const std::string & plural,
+                        const po::phraselist & msgstrs
+                    )
+                    {
+                        scan(id, plural, msgstrs);
+                    }
+                );
+
+                bool hit = false;
+                for (auto i : found)
+                {
+                    if (index->at(i).msgid == msgid)
+                        hit = true;
+                }
+
+                bool ok = hit && index->size() == entry &&
+                    found == scanned && starts == prefixed &&
+                    dict.search_index() == index;
+
+                std::cout
+                    << "Messages:      " << index->size() << "\n"
+                    << "Containing:    " << found.size() << "\n"
+                    << "Starting with: " << starts.size()
+                    << std::endl
+                    ;
+                if (argc == 6)
+                {
+                    /*
+                     * A large made-up catalog. A limited search should take
+                     * milliseconds however common the text; the check
+                     * allows far more, so as not to fail on a busy machine.
+                     */
+
+                    using ms = std::chrono::duration<double, std::milli>;
+                    using clock = std::chrono::steady_clock;
+                    static const char * const words [] =
+                    {
+                        "file", "open", "save", "close", "print", "edit",
+                        "view", "help", "about", "quit", "undo", "redo"
+                    };
+                    const std::size_t wordcount = sizeof words / sizeof *words;
+                    const std::size_t limit = 20;
+                    std::size_t entries = std::stoul(argv[5]);
+                    po::dictionary big;
+                    for (std::size_t i = 0; i < entries; ++i)
+                    {
+                        std::string n = std::to_string(i);
+                        std::string w = words[i % wordcount];
+                        std::string w2 = words[(i / wordcount) % wordcount];
+                        (void) big.add
+                        (
+                            "Message " + n + " to " + w + " the " + w2,
+                            "Nachricht " + n + " zum " + w2 + " " + w
+                        );
+                    }
+
+                    po::searchindex bigindex;
+                    auto start = clock::now();
+                    ok = ok && bigindex.build(big);
+
+                    ms built = clock::now() - start;
+                    double worst = 0.0;
+                    for (const char * t : { "e", "", "nach", "7 to", "qqq" })
+                    {
+                        std::string key{t};
+                        auto before = clock::now();
+                        std::vector<std::size_t> hits = bigindex.find
+                        (
+                            key, po::searchindex::all, limit
+                        );
+                        ms took = clock::now() - before;
+                        if (took.count() > worst)
+                            worst = took.count();
+
+                        std::size_t expected = key == "qqq" ? 0 : limit ;
+                        ok = ok && hits.size() == expected &&
+                            std::is_sorted(hits.begin(), hits.end());
+
+                        for (auto h : hits)
+                        {
+                            const std::string & name = bigindex.at(h).msgid;
+                            std::string id = lower(name);
+                            std::string tr = lower(big.translate(name));
+                            ok = ok && (id.find(key) != std::string::npos ||
+                                tr.find(key) != std::string::npos);
+                        }
+                        if (key.empty())
+                        {
+                            for (std::size_t h = 0; h < hits.size(); ++h)
+                                ok = ok && hits[h] == h;
+                        }
+                    }
+                    ok = ok && bigindex.size() == entries && worst < 1000.0;
+                    std::cout
+                        << "Large catalog: " << entries << " messages\n"
+                        << "Index built:   " << built.count() << " ms\n"
+                        << "Slowest find:  " << worst << " ms"
+                        << std::endl
+                        ;
+                }
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The search for '" << text
+                        << "' does not match a scan" << std::endl
+                        ;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " search <file> <text> <msg> [<entries>]'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "merge" || option == "mm")
+        {
+            /*
+             * Test [p]
+             */
+
+            if (argc == 6)
+            {
+                std::string msgid{argv[4]};
+                std::string expected{argv[5]};
+                std::string potext;
+                std::string potfile;
+                std::vector<po::poentry> old;
+                std::vector<po::poentry> pot;
+                bool ok = po::read_file(argv[2], potext) &&
+                    po::parse_po_entries(potext, old) &&
+                    po::read_file(argv[3], potfile) &&
+                    po::parse_po_entries(potfile, pot);
+
+                if (! ok)
+                    throw std::runtime_error("Could not read the catalogs");
+
+                po::pomerge merger(std::move(old));
+                po::pomerge::workspace ws;
+                std::vector<po::pomerge::match> matches;
+                for (const auto & e : pot)
+                    matches.push_back(merger.find(e, ws));
+
+                std::string text;
+                for (const auto & e : merger.merge(pot, matches))
+                    text += po::po_entry_text(e) + "\n";
+
+                /*
+                 * The output must read back to the same text, and poparser
+                 * must see the fuzzy flags.
+                 */
+
+                std::vector<po::poentry> again;
+                std::string retext;
+                ok = po::parse_po_entries(text, again);
+                for (const auto & e : again)
+                    retext += po::po_entry_text(e) + "\n";
+
+                po::dictionary strict;
+                po::dictionary loose;
+                std::istringstream in1(text);
+                std::istringstream in2(text);
+                ok = ok && retext == text &&
+                    po::poparser::parse_po_file("merged.po", in1, strict, false) &&
+                    po::poparser::parse_po_file("merged.po", in2, loose, true);
+
+                bool exact = strict.translate(msgid) != msgid;
+                bool fuzzy = ! exact && loose.translate(msgid) != msgid;
+                std::string actual = exact ? "exact" : (fuzzy ? "fuzzy" : "none") ;
+                ok = ok && actual == expected;
+                std::cout
+                    << "Entries:       " << again.size() << "\n"
+                    << "Match:         " << actual << "\n"
+                    << "Translation:   '" << loose.translate(msgid) << "'"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The merge of '" << msgid << "' is wrong"
+                        << std::endl
+                        ;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " merge <file.po> <file.pot> <msg> "
+                    "exact|fuzzy|none'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "accept-language" || option == "al")
+        {
+            /*
+             * Test [q]
+             */
+
+            if (argc == 5)
+            {
+                std::string header{argv[3]};
+                std::string expected{argv[4]};
+                po::dictionarymgr dm;
+                dm.add_directory(argv[2]);
+
+                po::language lang = dm.negotiate_language(header);
+                std::string actual = lang ? lang.to_string() : "none" ;
+                po::language again = dm.negotiate_language(header);
+                bool ok = actual == expected && again == lang &&
+                    dm.negotiation_hits() == 1 && dm.negotiation_misses() == 1;
+
+                std::cout
+                    << "Header:        '" << header << "'\n"
+                    << "Language:      " << actual << "\n"
+                    << "Cache:         " << dm.negotiation_hits() << " hit, "
+                    << dm.negotiation_misses() << " miss"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The negotiation of '" << header
+                        << "' is wrong" << std::endl
+                        ;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " accept-language <dir> <header> "
+                    "<lang>|none'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "memory-budget" || option == "mb")
+        {
+            /*
+             * Test [r]
+             */
+
+            if (argc == 5)
+            {
+                const char * dir = argv[2];
+                std::string msgid{argv[4]};
+                po::language lang = po::language::from_env(argv[3]);
+                if (! lang)
+                {
+                    std::string name{argv[3]};
+                    throw std::runtime_error("Unknown language " + name);
+                }
+
+                po::dictionarymgr unlimited;
+                unlimited.add_directory(dir);
+
+                po::dictionarymgr dm;
+                dm.add_directory(dir);
+                dm.set_language(lang);
+
+                std::string current = dm.get_dictionary().translate(msgid);
+                dm.set_memory_budget(1);            /* keeps only pinned ones */
+
+                std::set<po::language> languages = dm.get_languages();
+                bool ok = current == unlimited.get_dictionary(lang).translate(msgid);
+                for (int pass = 0; pass < 2; ++pass)
+                {
+                    for (const auto & l : languages)
+                    {
+                        std::string expected =
+                            unlimited.get_dictionary(l).translate(msgid);
+
+                        if (dm.get_dictionary(l).translate(msgid) != expected)
+                            ok = false;
+                    }
+                }
+
+                std::size_t misses = dm.dictionary_misses();
+                std::size_t evictions = dm.dictionary_evictions();
+                ok = ok && evictions > 0 && misses > languages.size() &&
+                    dm.get_dictionary().translate(msgid) == current &&
+                    dm.memory_used() < unlimited.memory_used();
+
+                /*
+                 * dgettext() with a language name as the domain (which
+                 * uses get_domain_dictionary()) must read an evicted
+                 * dictionary again, too.
+                 */
+
+                std::size_t dmisses = 0;
+                for (int pass = 0; pass < 2; ++pass)
+                {
+                    for (const auto & l : languages)
+                    {
+                        std::string expected =
+                            unlimited.get_dictionary(l).translate(msgid);
+
+                        const po::dictionary & d =
+                            dm.get_domain_dictionary(l.to_string());
+
+                        if (d.translate(msgid) != expected)
+                            ++dmisses;
+                    }
+                }
+
+                std::size_t devictions = dm.dictionary_evictions() - evictions;
+                ok = ok && dmisses == 0 && devictions > 0;
+
+                std::cout
+                    << "Languages:     " << languages.size() << "\n"
+                    << "Lookups:       " << dm.dictionary_hits() << " hits, "
+                    << misses << " misses\n"
+                    << "Evictions:     " << evictions << ", then "
+                    << devictions << " with dgettext()\n"
+                    << "Wrong:         " << dmisses << " with dgettext()\n"
+                    << "Memory:        " << dm.memory_used() << " of "
+                    << unlimited.memory_used() << " bytes\n"
+                    << "Translation:   '" << current << "'"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The memory budget was not kept" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " memory-budget <dir> <lang> <msg>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "cold-strings" || option == "co")
+        {
+            /*
+             * Test [s]
+             */
+
+            if (argc == 5)
+            {
+                std::string filename{argv[2]};
+                std::size_t threshold = std::size_t(std::stoul(argv[3]));
+                std::string msgid{argv[4]};
+                po::dictionary plain;
+                po::dictionary cold;
+                read_dictionary(filename, plain);
+                read_dictionary(filename, cold);
+
+                std::size_t before = cold.memory_usage();
+                std::size_t count = cold.compress_strings(threshold);
+                std::size_t after = cold.memory_usage();
+                bool ok = count > 0 && after < before;
+                auto check = [&] (const std::string & a, const std::string & b)
+                {
+                    if (a != b)
+                    {
+                        std::cerr << "Mismatch: '" << a << "'" << std::endl;
+                        ok = false;
+                    }
+                };
+                plain.foreach
+                (
+                    [&] (const std::string & id, const std::string & plural,
+                        const po::phraselist & msgstrs)
+                    {
+                        if (msgstrs.empty() || msgstrs[0].empty())
+                            return;
+
+                        check(cold.translate(id), plain.translate(id));
+                        check(*cold.find(id), *plain.find(id));
+                        if (! plural.empty())
+                        {
+                            check
+                            (
+                                cold.translate_plural(id, plural, 1),
+                                plain.translate_plural(id, plural, 1)
+                            );
+                        }
+                    }
+                );
+                plain.foreach_ctxt
+                (
+                    [&] (const std::string & ctxt, const std::string & id,
+                        const std::string &, const po::phraselist & msgstrs)
+                    {
+                        if (msgstrs.empty() || msgstrs[0].empty())
+                            return;
+
+                        check
+                        (
+                            cold.translate_ctxt(ctxt, id),
+                            plain.translate_ctxt(ctxt, id)
+                        );
+                    }
+                );
+
+                /*
+                 * The lookups must not keep copies of what they decompress.
+                 */
+
+                std::size_t looked = cold.memory_usage();
+                ok = ok && looked == after;
+
+                /*
+                 * The codec must round-trip the whole catalog, and must
+                 * reject it cut short.
+                 */
+
+                std::string text;
+                std::vector<char> packed;
+                ok = ok && po::read_file(filename, text);
+                po::lz_compress(text, packed);
+
+                std::string unpacked(text.size(), ' ');
+                ok = ok && po::lz_decompress
+                (
+                    packed.data(), packed.size(), &unpacked[0], text.size()
+                ) && unpacked == text;
+                ok = ok && ! po::lz_decompress
+                (
+                    packed.data(), packed.size() / 2, &unpacked[0], text.size()
+                );
+
+                std::string translation = cold.translate(msgid);
+                check(translation, plain.translate(msgid));
+                std::cout
+                    << "Compressed:    " << count << " translations\n"
+                    << "Memory:        " << after << " of " << before
+                    << " bytes, " << looked << " after lookups\n"
+                    << "Codec:         " << packed.size() << " of "
+                    << text.size() << " bytes\n"
+                    << "Translation:   '" << translation << "'"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The compressed lookups are wrong" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " cold-strings <file> <length> <msg>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "catalog-cache" || option == "cc")
+        {
+            /*
+             * Test [t]
+             */
+
+            if (argc == 5)
+            {
+                std::string filename{argv[2]};
+                std::string langname{argv[3]};
+                std::string msgid{argv[4]};
+                po::language lang = po::language::from_env(langname);
+                if (! lang)
+                    throw std::runtime_error("Unknown language " + langname);
+
+                namespace fs = std::filesystem;
+                fs::path top = fs::temp_directory_path() / "potext_test_cc";
+                fs::path dir = top / "po";
+                fs::path cache = top / "cache";
+                fs::path catalog = dir / (langname + ".po");
+                std::error_code ec;
+                (void) fs::remove_all(top, ec);
+                (void) fs::create_directories(dir, ec);
+                fs::copy_file(filename, catalog);
+
+                auto load = [&] (bool & mapped) -> std::string
+                {
+                    po::dictionarymgr mgr;
+                    mgr.set_shared_cache(cache.string());
+                    mgr.add_directory(dir.string());
+                    mgr.set_language(lang);
+
+                    const po::dictionary & d = mgr.get_dictionary();
+                    mapped = not_nullptr(d.flat()) && d.flat()->mapped();
+                    return d.translate(msgid);
+                };
+                auto images = [&] ()
+                {
+                    std::size_t count = 0;
+                    for (const auto & f : fs::directory_iterator(cache, ec))
+                    {
+                        if (f.path().extension() == ".cat")
+                            ++count;
+                    }
+                    return count;
+                };
+
+                bool mapped = false;
+                std::string first = load(mapped);
+                std::string second = load(mapped);
+                bool ok = mapped && first == second && first != msgid &&
+                    images() == 1;
+
+                /*
+                 * Change one letter of the translation in place, so that
+                 * only the contents of the catalog tell the change.
+                 */
+
+                std::string text;
+                std::string changed = first;
+                ok = ok && po::read_file(catalog.string(), text);
+
+                std::size_t pos = text.find("msgstr \"" + first + "\"");
+                ok = ok && pos != std::string::npos && ! first.empty();
+                if (ok)
+                {
+                    char & c = changed[0];
+                    c = c == 'X' ? 'Y' : 'X' ;
+                    text[pos + 8] = c;
+
+                    fs::file_time_type stamp = fs::last_write_time(catalog);
+                    std::ofstream out
+                    (
+                        catalog, std::ios::binary | std::ios::trunc
+                    );
+                    out << text;
+                    out.close();
+                    fs::last_write_time(catalog, stamp);
+                }
+
+                std::string third = load(mapped);
+                ok = ok && mapped && third == changed && images() == 1;
+
+                std::string fourth = load(mapped);
+                ok = ok && mapped && fourth == changed;
+                (void) fs::remove_all(top, ec);
+                std::cout
+                    << "Cache:         "
+                    << po::dictionarymgr::user_cache_directory()
+                    << " (default)\n"
+                    << "Translation:   '" << first << "', then '" << third
+                    << "'" << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The catalog cache is stale" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " catalog-cache <file.po> <lang> <msg>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "overlay" || option == "ov")
+        {
+            /*
+             * Test [u]
+             */
+
+            if (argc == 5)
+            {
+                std::string filename{argv[2]};
+                std::string msgid{argv[3]};
+                std::string override{argv[4]};
+                std::string ctxtoverride = override + "!";
+                auto base = std::make_shared<po::dictionary>();
+                read_dictionary(filename, *base);
+
+                po::overlay tenant(base);
+                bool ok = tenant.translate(msgid) == base->translate(msgid);
+                tenant.add(msgid, override);
+                tenant.add("tenant", msgid, ctxtoverride);
+                ok = ok && tenant.translate(msgid) == override;
+                ok = ok && not_nullptr(tenant.find(msgid)) &&
+                    *tenant.find(msgid) == override;
+                ok = ok &&
+                    tenant.translate_ctxt("tenant", msgid) == ctxtoverride;
+
+                std::size_t count = 0;
+                std::size_t mismatches = 0;
+                base->foreach
+                (
+                    [&] (const std::string & id, const std::string & plural,
+                        const po::phraselist &)
+                    {
+                        if (id.empty() || id == msgid)
+                            return;
+
+                        ++count;
+                        if (tenant.translate(id) != base->translate(id))
+                            ++mismatches;
+
+                        if (tenant.find(id) != base->find(id))
+                            ++mismatches;
+
+                        if (! plural.empty())
+                        {
+                            for (int n : { 1, 2, 5 })
+                            {
+                                if
+                                (
+                                    tenant.translate_plural(id, plural, n) !=
+                                    base->translate_plural(id, plural, n)
+                                )
+                                {
+                                    ++mismatches;
+                                }
+                            }
+                        }
+                    }
+                );
+                base->foreach_ctxt
+                (
+                    [&] (const std::string & ctxt, const std::string & id,
+                        const std::string &, const po::phraselist &)
+                    {
+                        ++count;
+                        if
+                        (
+                            tenant.translate_ctxt(ctxt, id) !=
+                            base->translate_ctxt(ctxt, id)
+                        )
+                        {
+                            ++mismatches;
+                        }
+                    }
+                );
+
+                /*
+                 * A plural override replaces the singular one, and removing
+                 * it lets the base show through again.
+                 */
+
+                std::string plural = msgid + "s";
+                tenant.add(msgid, plural, po::phraselist{override, override});
+                ok = ok && tenant.size() == 2;
+                ok = ok &&
+                    tenant.translate_plural(msgid, plural, 1) == override;
+                ok = ok && tenant.remove(msgid) && ! tenant.remove(msgid);
+                ok = ok && tenant.translate(msgid) == base->translate(msgid);
+                ok = ok &&
+                    tenant.translate_ctxt("tenant", msgid) == ctxtoverride;
+
+                /*
+                 * Make and drop overlays of a few overrides each.
+                 */
+
+                const int rounds = 10000;
+                std::size_t overlaybytes = 0;
+                auto start = std::chrono::steady_clock::now();
+                for (int r = 0; r < rounds; ++r)
+                {
+                    po::overlay t(base);
+                    for (int i = 0; i < 4; ++i)
+                        t.add(msgid + std::to_string(i), override);
+
+                    overlaybytes = t.memory_usage();
+                }
+                std::chrono::duration<double, std::micro> elapsed =
+                    std::chrono::steady_clock::now() - start;
+
+                std::size_t basebytes = base->memory_usage();
+                ok = ok && count > 0 && mismatches == 0 &&
+                    overlaybytes < basebytes;
+
+                std::cout
+                    << "Messages:      " << count << "\n"
+                    << "Mismatches:    " << mismatches << "\n"
+                    << "Overlay:       " << overlaybytes << " bytes for 4, "
+                    << elapsed.count() / rounds << " us to make and drop\n"
+                    << "Base:          " << basebytes << " bytes\n"
+                    << "Translation:   '" << override << "'"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The overlay lookups are wrong" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " overlay <file> <msg> <override>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "plurals" || option == "pl")
+        {
+            /*
+             * Test [v]
+             */
+
+            if (argc == 5)
+            {
+                std::string filename{argv[2]};
+                std::string msgid{argv[3]};
+                std::string msgidplural{argv[4]};
+
+                /*
+                 * The counts cover the table, the blocks of the batch
+                 * functions and their tails, and the negative and huge
+                 * counts that are not in the table.
+                 */
+
+                std::vector<int> counts;
+                for (int n = -300; n < 2000; ++n)
+                    counts.push_back(n);
+
+                for (int n = 1; n < 1000000000; n *= 7)
+                    counts.push_back(n);
+
+                counts.push_back(std::numeric_limits<int>::max());
+                counts.push_back(std::numeric_limits<int>::min());
+
+                static const char * const s_descriptors [] =
+                {
+                    "nplurals=1; plural=0;",
+                    "nplurals=2; plural=(n != 1);",
+                    "nplurals=2; plural=(n > 1);",
+                    "nplurals=3; plural=(n%10==1 && n%100!=11 ? 0 : "
+                        "n%10>=2 && n%10<=4 && (n%100<10 || n%100>=20) "
+                        "? 1 : 2);",
+                    "nplurals=3; plural=(n==1 ? 0 : n%10>=2 && n%10<=4 && "
+                        "(n%100<10 || n%100>=20) ? 1 : 2);",
+                    "nplurals=3; plural=(n%100==1 ? 0 : n%100==2 ? 1 : "
+                        "n%100==3 || n%100==4 ? 2 : 3);",
+                    "nplurals=4; plural=(n==1 || n==11) ? 0 : "
+                        "(n==2 || n==12) ? 1 : (n > 2 && n < 20) ? 2 : 3;"
+                };
+                std::vector<unsigned> indices(counts.size());
+                std::size_t mismatches = 0;
+                bool ok = true;
+                for (const char * d : s_descriptors)
+                {
+                    po::pluralforms pf = po::pluralforms::from_string(d);
+                    ok = ok && bool(pf);
+                    pf.get_plurals(counts.data(), counts.size(), &indices[0]);
+                    for (std::size_t i = 0; i < counts.size(); ++i)
+                    {
+                        if (indices[i] != pf.get_plural(counts[i]))
+                            ++mismatches;
+                    }
+                }
+
+                po::dictionary dict;
+                read_dictionary(filename, dict);
+
+                std::vector<const std::string *> results(counts.size());
+                bool found = dict.translate_plurals
+                (
+                    msgid, msgidplural, counts.data(), counts.size(),
+                    &results[0]
+                );
+                for (std::size_t i = 0; i < counts.size(); ++i)
+                {
+                    std::string t =
+                        dict.translate_plural(msgid, msgidplural, counts[i]);
+
+                    if (*results[i] != t)
+                        ++mismatches;
+                }
+
+                /*
+                 * A dictionary serving a compiled image gives the same.
+                 */
+
+                auto flat = std::make_shared<po::flatcatalog>();
+                po::dictionary image;
+                ok = ok && flat->assign(po::flatcatalog::compile(dict)) &&
+                    image.attach(flat);
+
+                std::vector<const std::string *> flatresults(counts.size());
+                found = image.translate_plurals
+                (
+                    msgid, msgidplural, counts.data(), counts.size(),
+                    &flatresults[0]
+                ) && found;
+                for (std::size_t i = 0; i < counts.size(); ++i)
+                {
+                    if (*flatresults[i] != *results[i])
+                        ++mismatches;
+                }
+
+                const int rounds = 200;
+                std::size_t total = rounds * counts.size();
+                std::size_t chars = 0;  /* keeps the loops from vanishing  */
+                auto start = std::chrono::steady_clock::now();
+                for (int r = 0; r < rounds; ++r)
+                {
+                    for (int n : counts)
+                    {
+                        std::string t =
+                            dict.translate_plural(msgid, msgidplural, n);
+
+                        chars += t.size();
+                    }
+                }
+                std::chrono::duration<double, std::nano> single =
+                    std::chrono::steady_clock::now() - start;
+
+                start = std::chrono::steady_clock::now();
+                for (int r = 0; r < rounds; ++r)
+                {
+                    (void) dict.translate_plurals
+                    (
+                        msgid, msgidplural, counts.data(), counts.size(),
+                        &results[0]
+                    );
+                    chars += results[0]->size();
+                }
+                std::chrono::duration<double, std::nano> batch =
+                    std::chrono::steady_clock::now() - start;
+
+                ok = ok && found && mismatches == 0 && chars > 0;
+                std::cout
+                    << "Counts:        " << counts.size() << "\n"
+                    << "Mismatches:    " << mismatches << "\n"
+                    << "Singly:        " << single.count() / total
+                    << " ns per count\n"
+                    << "Batched:       " << batch.count() / total
+                    << " ns per count\n"
+                    << "Translation:   '" << *results[301] << "', '"
+                    << *results[302] << "'"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr
+                        << "The batched plural forms are wrong" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " plurals <file> <singular> <plural>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "push-parse" || option == "pp")
+        {
+            /*
+             * Test [w]
+             */
+
+            if (argc == 4)
+            {
+                std::string filename{argv[2]};
+                std::size_t chunk = std::size_t(std::stoul(argv[3]));
+                std::string text;
+                if (! po::read_file(filename, text))
+                    throw std::runtime_error("Could not read " + filename);
+
+                /*
+                 * Lists every message of a dictionary, in order, for
+                 * comparing two of them.
+                 */
+
+                auto listing = [] (const po::dictionary & d)
+                {
+                    std::string out = d.get_charset();
+                    out += '\n';
+                    out += std::to_string(d.get_plural_forms().get_nplural());
+                    out += '\n';
+                    d.foreach
+                    (
+                        [&out]
+                        (
+                            const std::string & msgid,
+                            const std::string & msgid_plural,
+                            const po::phraselist & msgstrs
+                        )
+                        {
+                            out += msgid + '\0' + msgid_plural;
+                            for (const auto & m : msgstrs)
+                                out += '\0' + m;
+
+                            out += '\n';
+                        }
+                    );
+                    d.foreach_ctxt
+                    (
+                        [&out]
+                        (
+                            const std::string & ctxt,
+                            const std::string & msgid,
+                            const std::string & msgid_plural,
+                            const po::phraselist & msgstrs
+                        )
+                        {
+                            out += ctxt + '\4' + msgid + '\0' + msgid_plural;
+                            for (const auto & m : msgstrs)
+                                out += '\0' + m;
+
+                            out += '\n';
+                        }
+                    );
+                    return out;
+                };
+
+                po::dictionary expected;
+                read_dictionary(filename, expected);
+
+                std::string want = listing(expected);
+                bool ok = chunk > 0;
+                std::size_t entries = 0;
+                for (int pass = 0; ok && pass < 3; ++pass)
+                {
+                    po::dictionary dict;
+                    po::popushparser parser(filename, dict);
+                    std::size_t pos = 0;
+                    for (int i = 0; pos < text.size(); ++i)
+                    {
+                        std::size_t n = pass == 0 ? chunk :
+                            pass == 1 ? 1 : std::size_t(1 + (i * 7) % 23) ;
+
+                        n = std::min(n, text.size() - pos);
+                        ok = parser.feed(text.data() + pos, n) && ok;
+                        pos += n;
+                    }
+                    ok = parser.finish() && ok;
+                    ok = ok && listing(dict) == want &&
+                        dict.file_mode() == po::dictionary::mode::po;
+
+                    entries = parser.entry_count();
+                }
+
+                /*
+                 * Input cut off inside the first translation must fail,
+                 * however it is split, and must not pass for a catalog.
+                 */
+
+                bool rejected = true;
+                std::size_t cut = text.find("\nmsgstr \"");
+                if (cut != std::string::npos)
+                {
+                    cut = text.find("\nmsgstr \"", cut + 1);
+                    if (cut != std::string::npos)
+                    {
+                        po::dictionary dict;
+                        po::popushparser parser(filename, dict);
+                        (void) parser.feed(text.substr(0, cut + 10));
+                        rejected = ! parser.finish() && parser.failed();
+                        po::logstream::clear_test_error();
+                    }
+                }
+                bool matched = ok;
+                ok = ok && rejected && entries > 0;
+                std::cout
+                    << "Entries:       " << entries << "\n"
+                    << "Chunk size:    " << chunk << "\n"
+                    << "Truncation:    "
+                    << (rejected ? "rejected" : "accepted") << "\n"
+                    << "Dictionaries:  " << (matched ? "match" : "differ")
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr
+                        << "The push parser is wrong" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname << " push-parse <file.po> <chunk>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "merge-dirs" || option == "md")
+        {
+            /*
+             * Test [x]
+             */
+
+            if (argc >= 5)
+            {
+                std::string langname{argv[2]};
+                po::language lang = po::language::from_env(langname);
+                if (! lang)
+                    throw std::runtime_error("Unknown language " + langname);
+
+                po::dictionarymgr mgr;
+                std::vector<std::unique_ptr<po::dictionary>> catalogs;
+                for (int i = 3; i < argc; ++i)
+                {
+                    std::string dir{argv[i]};
+                    mgr.add_directory(dir);
+                    catalogs.emplace_back(new po::dictionary);
+                    read_dictionary
+                    (
+                        dir + "/" + langname + ".po", *catalogs.back()
+                    );
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                const po::dictionary & merged = mgr.get_dictionary(lang);
+                std::chrono::duration<double, std::micro> elapsed =
+                    std::chrono::steady_clock::now() - start;
+
+                /*
+                 * Each message must have the translation of the first
+                 * catalog that has it. A message of a later catalog that
+                 * an earlier one has is shadowed.
+                 */
+
+                std::size_t count = 0;
+                std::size_t shadowed = 0;
+                std::size_t mismatches = 0;
+                for (std::size_t i = 0; i < catalogs.size(); ++i)
+                {
+                    catalogs[i]->foreach
+                    (
+                        [&]
+                        (
+                            const std::string & msgid,
+                            const std::string & /*msgid_plural*/,
+                            const po::phraselist & /*msgstrs*/
+                        )
+                        {
+                            std::size_t first = 0;
+                            const std::string * e = nullptr;
+                            while (is_nullptr(e))
+                                e = catalogs[first++]->find(msgid);
+
+                            const std::string * t = merged.find(msgid);
+                            if (first - 1 < i)
+                                ++shadowed;
+                            else
+                                ++count;
+
+                            if (is_nullptr(t) || *t != *e)
+                                ++mismatches;
+                        }
+                    );
+                    catalogs[i]->foreach_ctxt
+                    (
+                        [&]
+                        (
+                            const std::string & ctxt,
+                            const std::string & msgid,
+                            const std::string & /*msgid_plural*/,
+                            const po::phraselist & /*msgstrs*/
+                        )
+                        {
+                            std::size_t first = 0;
+                            const std::string * e = nullptr;
+                            while (is_nullptr(e))
+                                e = catalogs[first++]->find_ctxt(ctxt, msgid);
+
+                            const std::string * t =
+                                merged.find_ctxt(ctxt, msgid);
+
+                            if (first - 1 < i)
+                                ++shadowed;
+                            else
+                                ++count;
+
+                            if (is_nullptr(t) || *t != *e)
+                                ++mismatches;
+                        }
+                    );
+                }
+
+                bool ok = mismatches == 0 && count > 0 &&
+                    merged.shadowed_count() >= shadowed;
+
+                std::cout
+                    << "Catalogs:      " << catalogs.size() << "\n"
+                    << "Messages:      " << count << "\n"
+                    << "Shadowed:      " << merged.shadowed_count()
+                    << " skipped, " << shadowed << " expected\n"
+                    << "Mismatches:    " << mismatches << "\n"
+                    << "Load time:     " << elapsed.count() << " us"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr
+                        << "The merged catalogs are wrong" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '"
+                    << appname
+                    << " merge-dirs <lang> <dir> <dir> [<dir> ...]'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "trace" || option == "tc")
+        {
+            /*
+             * Test [y]
+             */
+
+            if (argc == 3)
+            {
+                namespace fs = std::filesystem;
+
+                std::string msg{argv[2]};
+                std::string plural = msg + "s";
+                fs::path file = fs::temp_directory_path() / "potext_test.trace";
+                if (! po::tracerecorder::start(file.string()))
+                    throw std::runtime_error("Cannot start the recorder");
+
+                (void) po::gettext(msg);
+                (void) po::ngettext(msg, plural, 3);
+                (void) po::pgettext("context", msg);
+                (void) po::dgettext("domain", msg);
+
+                std::thread other([&msg] () { (void) po::gettext(msg); });
+                other.join();
+                (void) po::tracerecorder::stop();
+                (void) po::gettext(msg);                /* not recorded     */
+
+                /*
+                 * The records, in order, as the kind, domain, msgctxt,
+                 * msgid, plural msgid, count, and thread.
+                 */
+
+                struct expected
+                {
+                    po::tracekind kind;
+                    std::string domain, msgctxt, msgid, plural;
+                    unsigned long count;
+                    std::uint32_t thread;
+                };
+                const expected wanted [] =
+                {
+                    { po::tracekind::gettext,  "", "", msg, "", 0, 0 },
+                    { po::tracekind::ngettext, "", "", msg, plural, 3, 0 },
+                    { po::tracekind::pgettext, "", "context", msg, "", 0, 0 },
+                    { po::tracekind::dgettext, "domain", "", msg, "", 0, 0 },
+                    { po::tracekind::gettext,  "", "", msg, "", 0, 1 }
+                };
+                const std::size_t wantedcount =
+                    sizeof wanted / sizeof wanted[0];
+
+                po::tracedata trace;
+                bool ok = po::tracerecorder::load(file.string(), trace);
+                std::size_t bad = 0;
+                if (ok)
+                {
+                    const std::vector<std::string> & s = trace.td_strings;
+                    std::uint64_t lasttime = 0;
+                    for (std::size_t i = 0; i < trace.td_records.size(); ++i)
+                    {
+                        const po::tracerecord & r = trace.td_records[i];
+                        if (i >= wantedcount)
+                        {
+                            ++bad;
+                            continue;
+                        }
+
+                        const expected & w = wanted[i];
+                        if
+                        (
+                            r.tr_kind != w.kind ||
+                            s[r.tr_domain] != w.domain ||
+                            s[r.tr_msgctxt] != w.msgctxt ||
+                            s[r.tr_msgid] != w.msgid ||
+                            s[r.tr_msgid_plural] != w.plural ||
+                            r.tr_count != w.count ||
+                            r.tr_thread != w.thread ||
+                            r.tr_time < lasttime
+                        )
+                        {
+                            ++bad;
+                        }
+                        lasttime = r.tr_time;
+                    }
+                    ok = bad == 0 &&
+                        trace.td_records.size() == wantedcount &&
+                        trace.td_threads == 2;
+                }
+
+                std::error_code ec;
+                std::uintmax_t size = fs::file_size(file, ec);
+                (void) fs::remove(file, ec);
+                std::cout
+                    << "Lookups:       " << trace.td_records.size()
+                    << " recorded, " << wantedcount << " expected\n"
+                    << "Strings:       " << trace.td_strings.size() << "\n"
+                    << "Threads:       " << trace.td_threads << "\n"
+                    << "Bad records:   " << bad << "\n"
+                    << "Trace size:    " << size << " bytes"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The trace is wrong" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '" << appname << " trace <msg>'"
+                    << std::endl
+                    ;
+            }
+        }
+        else if (option == "labels" || option == "lt")
+        {
+            /*
+             * Test [z]
+             */
+
+            if (argc >= 7)
+            {
+                using clock = std::chrono::steady_clock;
+
+                const char * dir = argv[2];
+                po::language lang = po::language::from_env(argv[3]);
+                po::language lang2 = po::language::from_env(argv[4]);
+                if (! lang || ! lang2)
+                    throw std::runtime_error("Unknown language");
+
+                std::string ctxt{argv[5]};
+                if (ctxt == "-")
+                    ctxt.clear();
+
+                std::vector<const char *> msgids(argv + 6, argv + argc);
+                std::size_t count = msgids.size();
+                po::dictionarymgr reference;
+                reference.add_directory(dir);
+
+                po::dictionarymgr dm;
+                dm.add_directory(dir);
+                dm.set_language(lang);
+
+                po::labeltable table(dm, msgids.data(), count, ctxt);
+                auto check =
+                    [&] (const po::language & l, std::size_t & translated)
+                {
+                    const std::vector<std::string_view> & labels =
+                        table.labels();
+
+                    bool good = labels.size() == count;
+                    translated = 0;
+                    for (std::size_t i = 0; good && i < count; ++i)
+                    {
+                        std::string msgid{msgids[i]};
+                        po::dictionary & d = reference.get_dictionary(l);
+                        std::string expected = ctxt.empty() ?
+                            d.translate(msgid) : d.translate_ctxt(ctxt, msgid) ;
+
+                        if (table[i] != expected)
+                            good = false;
+                        else if (expected != msgid)
+                            ++translated;
+
+                        if                          /* packed contiguously  */
+                        (
+                            i + 1 < count && labels[i].data() +
+                                labels[i].size() != labels[i + 1].data()
+                        )
+                        {
+                            good = false;
+                        }
+                    }
+                    return good && translated > 0;
+                };
+
+                std::size_t translated = 0;
+                std::size_t translated2 = 0;
+                bool ok = check(lang, translated);
+                std::string_view before = table[0];
+                std::string beforecopy{before};
+                unsigned long generation = table.generation();
+                ok = ok && table.generation() == generation; /* no refresh  */
+
+                dm.set_language(lang2);
+                ok = check(lang2, translated2) && ok &&
+                    table.generation() != generation &&
+                    before == beforecopy;
+
+                /*
+                 * Switching back and forth must not pile up translations.
+                 * The view taken before is not valid after this.
+                 */
+
+                for (int s = 0; s < 20; ++s)
+                {
+                    dm.set_language(s % 2 == 0 ? lang : lang2);
+                    (void) table[0];
+                }
+                std::size_t snapshots = table.snapshots();
+                ok = ok && snapshots == po::labeltable::c_snapshots &&
+                    check(lang2, translated2);
+
+                /*
+                 * The lookups use find(), as translate() would log each
+                 * miss.
+                 */
+
+                const int rounds = 100000;
+                std::size_t total = 0;
+                std::size_t found = 0;
+                auto start = clock::now();
+                for (int r = 0; r < rounds; ++r)
+                    total += table[std::size_t(r) % count].size();
+
+                auto middle = clock::now();
+                const po::dictionary & dict = dm.get_dictionary();
+                for (int r = 0; r < rounds; ++r)
+                {
+                    std::string msgid{msgids[std::size_t(r) % count]};
+                    const std::string * msgstr = ctxt.empty() ?
+                        dict.find(msgid) : dict.find_ctxt(ctxt, msgid) ;
+
+                    if (not_nullptr(msgstr))
+                        ++found;
+                }
+                auto stop = clock::now();
+                double labelns = std::chrono::duration<double, std::nano>
+                (
+                    middle - start
+                ).count() / rounds;
+                double lookupns = std::chrono::duration<double, std::nano>
+                (
+                    stop - middle
+                ).count() / rounds;
+                ok = ok && total > 0 && found > 0;
+                std::cout
+                    << "Labels:        " << count << "\n"
+                    << "Translated:    " << translated << " in "
+                    << lang.to_string() << ", " << translated2 << " in "
+                    << lang2.to_string() << "\n"
+                    << "Kept label:    '" << beforecopy << "'\n"
+                    << "Snapshots:     " << snapshots << " after 20 changes\n"
+                    << "Label read:    " << labelns << " ns\n"
+                    << "Lookup:        " << lookupns << " ns"
+                    << std::endl
+                    ;
+                if (! ok)
+                {
+                    result = EXIT_FAILURE;
+                    std::cerr << "The labels are wrong" << std::endl;
+                }
+            }
+            else
+            {
+                result = EXIT_FAILURE;
+                std::cerr
+                    << "Use format: '" << appname
+                    << " labels <dir> <lang> <lang2> <ctxt>|- <msg>"
+                    << " [<msg> ...]'"
+                    << std::endl
+                    ;
+            }
+        }
         else
             print_usage(appname);
     }
@@ -0,0 +1,461 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          stress_test.cpp
+ *
+ *      Looks up translations from several threads while other threads
+ *      switch the language and domain, change the search path, and drop
+ *      and reload the catalogs.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ * Usage:
+ *
+ *      stress_test [lookups-per-thread]
+ *
+ *  The lookup threads call the gettext() family, idgettext(), and two
+ *  labeltables, and each result must be one of the translations of its
+ *  message in the catalogs, or the message ID itself (e.g. while the
+ *  language switches to one whose catalog is not loaded yet). The changing
+ *  threads use the dictionary manager of the gettext module,
+ *  po::dictionary_manager(), directly.
+ *
+ *  The test is most useful when built with ThreadSanitizer, which reports
+ *  the data races that do not happen to corrupt a result:
+ *
+ *      $ meson setup build-tsan -Denable_tsan=true
+ *      $ meson test -C build-tsan 'Potext Stress Test'
+ *
+ *  or "./work.sh --tsan", which does both.
+ *
+ *  It must be run from the top of the source tree, as hellopotext is.
+ */
+
+#include <atomic>                       /* std::atomic<>                    */
+#include <clocale>                      /* LC_MESSAGES                      */
+#include <cstdlib>                      /* EXIT_SUCCESS, std::atoi()        */
+#include <fstream>                      /* std::ifstream                    */
+#include <iostream>                     /* std::cout, std::cerr             */
+#include <map>                          /* std::map<>                       */
+#include <memory>                       /* std::unique_ptr<>                */
+#include <mutex>                        /* std::mutex, std::lock_guard<>    */
+#include <set>                          /* std::set<>                       */
+#include <string>                       /* std::string                      */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "po/potext.hpp"                /* po::dictionarymgr, po::gettext   */
+#include "po/labeltable.hpp"            /* po::labeltable class             */
+#include "po/logstream.hpp"             /* po::logstream callbacks          */
+#include "po/poparser.hpp"              /* po::poparser::parse_po_file()    */
+
+namespace
+{
+
+/**
+ *  The defaults: lookups per thread, and the numbers of threads.
+ */
+
+const int c_lookups = 20000;
+const int c_lookup_threads = 4;
+
+/**
+ *  The catalogs the results may come from.
+ */
+
+const char * const c_catalogs [] =
+{
+    "po/de.po", "po/es.po", "po/fr.po", "po/pl.po",
+    "library/tests/po/de.po", "library/tests/po/de_AT.po",
+    "library/tests/po/fr.po"
+};
+
+/**
+ *  The languages the threads switch among. "pl" is not loaded at first.
+ */
+
+const char * const c_languages [] = { "de", "es", "fr", "pl" };
+const int c_language_count = int(sizeof c_languages / sizeof c_languages[0]);
+
+/**
+ *  The message IDs of the idgettext() lookups, in msgid_compare() order,
+ *  of a second key table (as of a library), and of the labeltables.
+ */
+
+const char * const c_keys [] =
+{
+    "File",
+    "Person",
+    "success\004Congratulations!"
+};
+
+const char * const c_library_keys [] = { "File", "Person" };
+const char * const c_labels [] = { "File", "Person" };
+const char * const c_ctxt_labels [] = { "Congratulations!" };
+
+/**
+ *  For each message ID, the strings a lookup of it may return.
+ */
+
+std::map<std::string, std::set<std::string>> s_valid;
+
+std::atomic<bool> s_done{false};
+std::atomic<unsigned long> s_translated{0};
+std::atomic<unsigned long> s_untranslated{0};
+std::atomic<unsigned long> s_failures{0};
+std::atomic<unsigned long> s_changes{0};
+std::mutex s_report_mutex;
+
+/**
+ *  The labeltables, made once the gettext module is set up.
+ */
+
+std::unique_ptr<po::labeltable> s_labels;
+std::unique_ptr<po::labeltable> s_ctxt_labels;
+
+void
+quiet (const std::string &)
+{
+    // no code
+}
+
+void
+add_valid
+(
+    const std::string & msgid,
+    const std::string & msgid_plural,
+    const po::phraselist & msgstrs
+)
+{
+    std::set<std::string> & valid = s_valid[msgid];
+    valid.insert(msgid);
+    if (! msgid_plural.empty())
+        valid.insert(msgid_plural);
+
+    for (const auto & s : msgstrs)
+        valid.insert(s);
+}
+
+/**
+ *  Gathers the valid results from the catalogs, read here with a parser
+ *  of their own.
+ */
+
+bool
+load_valid ()
+{
+    for (const char * filename : c_catalogs)
+    {
+        std::ifstream in(filename);
+        po::dictionary dict;
+        if (! in || ! po::poparser::parse_po_file(filename, in, dict))
+        {
+            std::cerr << "Could not read " << filename << std::endl;
+            return false;
+        }
+        dict.foreach(add_valid);
+        dict.foreach_ctxt
+        (
+            [] (const std::string &, const std::string & msgid,
+                const std::string & msgid_plural, const po::phraselist & s)
+            {
+                add_valid(msgid, msgid_plural, s);
+            }
+        );
+    }
+    return true;
+}
+
+void
+verify
+(
+    const char * function,
+    const std::string & msgid,
+    const std::string & result
+)
+{
+    const auto it = s_valid.find(msgid);
+    if (it != s_valid.end() && it->second.count(result) > 0)
+    {
+        if (result == msgid)
+            ++s_untranslated;
+        else
+            ++s_translated;
+    }
+    else if (s_failures++ < 10)
+    {
+        std::lock_guard<std::mutex> lock(s_report_mutex);
+        std::cerr
+            << "FAIL  " << function << "(\"" << msgid << "\") returned '"
+            << result << "'" << std::endl
+            ;
+    }
+}
+
+/**
+ *  A lookup thread. It runs through the lookup functions in turn.
+ */
+
+void
+lookups (int seed, int count)
+{
+    const std::string file{"File"};
+    const std::string files{"Files"};
+    const std::string person{"Person"};
+    const std::string people{"People"};
+    const std::string congrats{"Congratulations!"};
+    const std::string success{"success"};
+    const std::string failure{"failure"};
+    for (int i = 0; i < count; ++i)
+    {
+        int k = seed + i;
+        std::string lang = c_languages[k % c_language_count];
+        unsigned long n = (unsigned long)(k % 7);
+        switch (k % 14)
+        {
+        case 0:
+            verify("gettext", file, po::gettext(file));
+            break;
+
+        case 1:
+            verify("ngettext", file, po::ngettext(file, files, n));
+            break;
+
+        case 2:
+            verify("ngettext", person, po::ngettext(person, people, n));
+            break;
+
+        case 3:
+            verify("pgettext", congrats, po::pgettext(success, congrats));
+            break;
+
+        case 4:
+            verify("dgettext", file, po::dgettext(lang, file));
+            break;
+
+        case 5:
+            verify
+            (
+                "dngettext", person, po::dngettext(lang, person, people, n)
+            );
+            break;
+
+        case 6:
+            verify
+            (
+                "dpgettext", congrats, po::dpgettext(lang, failure, congrats)
+            );
+            break;
+
+        case 7:
+            verify
+            (
+                "dcgettext", file, po::dcgettext(lang, file, LC_MESSAGES)
+            );
+            break;
+
+        case 8:
+            verify
+            (
+                "dcngettext", file,
+                po::dcngettext(lang, file, files, n, LC_MESSAGES)
+            );
+            break;
+
+        case 9:
+            verify("idgettext", file, po::idgettext(c_keys, 0, "File"));
+            verify
+            (
+                "idgettext", person, po::idgettext(c_library_keys, 1, "Person")
+            );
+            break;
+
+        case 10:
+            verify
+            (
+                "idgettext", congrats,
+                po::idgettext(c_keys, 2, "success\004Congratulations!")
+            );
+            break;
+
+        case 11:
+            verify("labeltable", person, std::string((*s_labels)[1]));
+            break;
+
+        case 12:
+            verify
+            (
+                "labeltable", congrats, std::string((*s_ctxt_labels)[0])
+            );
+            break;
+
+        default:
+            verify
+            (
+                "dcpgettext", congrats,
+                po::dcpgettext(lang, success, congrats, LC_MESSAGES)
+            );
+            break;
+        }
+        if (i % 8 == 0)
+            std::this_thread::yield();          /* let the changes happen   */
+    }
+}
+
+/**
+ *  The changing threads. Each repeats its change until the lookups are
+ *  done.
+ */
+
+void
+switch_languages ()
+{
+    po::dictionarymgr & dm = po::dictionary_manager();
+    for (int k = 0; ! s_done; ++k)
+    {
+        dm.set_language(po::language::from_env(c_languages[k % 4]));
+        ++s_changes;
+        std::this_thread::yield();
+    }
+}
+
+void
+switch_domains ()
+{
+    for (int k = 0; ! s_done; ++k)
+    {
+        (void) po::textdomain(c_languages[k % 3]);
+        ++s_changes;
+        std::this_thread::yield();
+    }
+}
+
+void
+change_directories ()
+{
+    po::dictionarymgr & dm = po::dictionary_manager();
+    const std::string tests{"library/tests/po"};
+    for (int k = 0; ! s_done; ++k)
+    {
+        if (k % 2 == 0)
+            dm.add_directory(tests, k % 4 == 0);
+        else
+            dm.remove_directory(tests);
+
+        (void) dm.get_languages();
+        (void) dm.negotiate_language("fr-CA, de;q=0.5");
+        ++s_changes;
+        std::this_thread::yield();
+    }
+}
+
+void
+reload_catalogs ()
+{
+    po::dictionarymgr & dm = po::dictionary_manager();
+    for (int k = 0; ! s_done; ++k)
+    {
+        switch (k % 4)
+        {
+        case 0:
+            dm.set_memory_budget(1);            /* drops all it can         */
+            break;
+
+        case 1:
+            dm.set_memory_budget(0);
+            break;
+
+        default:
+            dm.set_use_fuzzy(k % 4 == 2);
+            break;
+        }
+        ++s_changes;
+        std::this_thread::yield();
+    }
+}
+
+}           // namespace (anonymous)
+
+int
+main (int argc, char * argv [])
+{
+    int count = argc > 1 ? std::atoi(argv[1]) : c_lookups ;
+    if (count <= 0)
+        count = c_lookups;
+
+    po::logstream::set_warning_callback(quiet);     /* misses are expected  */
+    po::logstream::set_info_callback(quiet);
+    if (! load_valid())
+        return EXIT_FAILURE;
+
+    std::string dirname = po::init_app_locale(argv[0], "stress_test", "de", "po");
+    if (dirname.empty())
+    {
+        std::cerr << "Could not set up the po directory" << std::endl;
+        return EXIT_FAILURE;
+    }
+    po::dictionary_manager().add_directory("po");
+    s_labels.reset(new po::labeltable(po::dictionary_manager(), c_labels));
+    s_ctxt_labels.reset
+    (
+        new po::labeltable(po::dictionary_manager(), c_ctxt_labels, "success")
+    );
+
+    std::vector<std::thread> changers;
+    changers.emplace_back(switch_languages);
+    changers.emplace_back(switch_domains);
+    changers.emplace_back(change_directories);
+    changers.emplace_back(reload_catalogs);
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < c_lookup_threads; ++t)
+        readers.emplace_back(lookups, t * 3, count);
+
+    for (auto & t : readers)
+        t.join();
+
+    s_done = true;
+    for (auto & t : changers)
+        t.join();
+
+    bool ok = s_failures == 0 && s_translated > 0;
+    std::cout
+        << (ok ? "ok    " : "FAIL  ") << c_lookup_threads * count
+        << " lookups: " << s_translated << " translated, " << s_untranslated
+        << " untranslated, " << s_failures << " invalid; " << s_changes
+        << " changes" << std::endl
+        ;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * stress_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
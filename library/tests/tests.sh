@@ -52,6 +52,10 @@ POTEXT_TEST="$POTEXT_TEST_BINARY_DIR/potext_test"
 HELLO_POTEXT="$POTEXT_TEST_BINARY_DIR/hellopotext"
 MO_PARSER_TEST="$POTEXT_TEST_BINARY_DIR/mo_parser_test"
 PO_PARSER_TEST="$POTEXT_TEST_BINARY_DIR/po_parser_test"
+ALLOC_TEST="$POTEXT_TEST_BINARY_DIR/alloc_test"
+STRESS_TEST="$POTEXT_TEST_BINARY_DIR/stress_test"
+FUZZ_TEST="$POTEXT_TEST_BINARY_DIR/fuzz_test"
+XGETTEXT="./build/library/tools/potext-xgettext"
 POTEXT_TEST_DIR="./library/tests"
 POTEXT_TEST_LINES="$POTEXT_TEST_DIR/testlines.list"
 COUNTER=0
@@ -101,6 +105,64 @@ echo "[$LASTRESULT] mo_parser_text"
 
 #----------------------------------------------------------------------------
 
+echo
+echo "$ALLOC_TEST:"
+echo
+LASTRESULT="PASSED"
+$ALLOC_TEST
+if test $? != 0 ; then
+   LASTRESULT="FAILED"
+   RESULT="FAILED"
+fi
+echo "[$LASTRESULT] alloc_test"
+
+#----------------------------------------------------------------------------
+
+echo
+echo "$STRESS_TEST:"
+echo
+LASTRESULT="PASSED"
+$STRESS_TEST
+if test $? != 0 ; then
+   LASTRESULT="FAILED"
+   RESULT="FAILED"
+fi
+echo "[$LASTRESULT] stress_test"
+
+#----------------------------------------------------------------------------
+# The scaling checks of fuzz_test go by the clock, and are left out here;
+# run "fuzz_test --timing" by hand to get them.
+
+echo
+echo "$FUZZ_TEST:"
+echo
+LASTRESULT="PASSED"
+$FUZZ_TEST --mutate 100 $POTEXT_TEST_DIR/mo $POTEXT_TEST_DIR/po \
+   $POTEXT_TEST_DIR/broken.po ./po
+if test $? != 0 ; then
+   LASTRESULT="FAILED"
+   RESULT="FAILED"
+fi
+echo "[$LASTRESULT] fuzz_test"
+
+#----------------------------------------------------------------------------
+# The tools are built only with -Denable_tools=true.
+
+if test -x $XGETTEXT ; then
+   echo
+   echo "$XGETTEXT:"
+   echo
+   LASTRESULT="PASSED"
+   $POTEXT_TEST_DIR/xgettext_test.sh $XGETTEXT
+   if test $? != 0 ; then
+      LASTRESULT="FAILED"
+      RESULT="FAILED"
+   fi
+   echo "[$LASTRESULT] xgettext_test"
+fi
+
+#----------------------------------------------------------------------------
+
 echo
 echo "$POTEXT_TEST tests from $POTEXT_TEST_LINES:"
 echo
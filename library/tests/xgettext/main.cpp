@@ -0,0 +1,24 @@
+/*
+ * main.cpp (potext xgettext fixture)
+ *
+ *      Scanned by xgettext_test.sh, not compiled. See messages.pot.
+ */
+
+#include "strings.hpp"
+
+int
+main (int argc, char * argv [])
+{
+    /* TRANSLATORS: The title of the main window. */
+    show(_("Hello, world!"));
+
+    // A plain comment, which is not extracted.
+    show(ngettext("%d file", "%d files", argc));
+
+    show(pgettext("menu", "Open"));
+
+    /* TRANSLATORS: A button; keep it short. */
+    show(tr("dialog", "Cancel"));
+    show(gettext(argv[0]));                 /* not a literal; ignored   */
+    return 0;
+}
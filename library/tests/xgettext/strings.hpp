@@ -0,0 +1,15 @@
+/*
+ * strings.hpp (potext xgettext fixture)
+ *
+ *      Scanned by xgettext_test.sh, not compiled. See messages.pot.
+ */
+
+#define _(str) po::gettext (str)
+
+static const char * const c_labels [] =
+{
+    N_("Label one"),
+    N_("Label "
+       "two"),
+    R"(Raw, and not a message)"
+};
@@ -0,0 +1,16 @@
+/*
+ * widget.cpp (potext xgettext fixture)
+ *
+ *      Scanned by xgettext_test.sh, not compiled. See messages.pot.
+ */
+
+#include "strings.hpp"
+
+void
+widget ()
+{
+    show(_("Hello, world!"));               /* also in main.cpp         */
+    show(_("Tab\tand \"quotes\""));
+    show(tr("toolbar", "Open"));
+    show(C_("menu", "Quit"));
+}
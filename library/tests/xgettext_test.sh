@@ -0,0 +1,80 @@
+#!/bin/sh
+#
+#******************************************************************************
+# xgettext_test.sh (potext)
+#------------------------------------------------------------------------------
+##
+# \file           xgettext_test.sh
+# \library        potext
+# \author         Chris Ahlstrom
+# \date           2026-10-18
+# \update         2026-10-18
+# \license        $XPC_SUITE_GPL_LICENSE$
+#
+#     Extracts the fixture sources in library/tests/xgettext with
+#     potext-xgettext and compares the result with the checked-in
+#     messages.pot. Run from the top directory of potext:
+#
+#     potext $ ./library/tests/xgettext_test.sh [ path/to/potext-xgettext ]
+#
+#     The extraction is done with one thread and with several, which must
+#     give the same .pot. Then it is done twice with a cache, and the second
+#     run must skip every file. Last, "--keyword=" must act like a bare "-k".
+#
+#------------------------------------------------------------------------------
+
+XGETTEXT="${1:-./build/library/tools/potext-xgettext}"
+FIXTURE_DIR="library/tests/xgettext"
+EXPECTED="$FIXTURE_DIR/messages.pot"
+SOURCES="$FIXTURE_DIR/main.cpp $FIXTURE_DIR/widget.cpp $FIXTURE_DIR/strings.hpp"
+OPTIONS="-ktr:1c,2 --add-comments=TRANSLATORS:"
+WORK_DIR=$(mktemp -d)
+RESULT="PASSED"
+
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+#  check name command...
+#
+#     Runs the command and reports whether it succeeded.
+
+check ()
+{
+   NAME="$1"
+   shift
+   if "$@" ; then
+      echo "[PASSED] $NAME"
+   else
+      echo "[FAILED] $NAME"
+      RESULT="FAILED"
+   fi
+}
+
+$XGETTEXT -j1 $OPTIONS -o "$WORK_DIR/j1.pot" $SOURCES
+check "xgettext -j1" diff -u "$EXPECTED" "$WORK_DIR/j1.pot"
+
+$XGETTEXT -j4 $OPTIONS -o "$WORK_DIR/j4.pot" $SOURCES
+check "xgettext -j4" diff -u "$EXPECTED" "$WORK_DIR/j4.pot"
+
+$XGETTEXT -j4 $OPTIONS --cache "$WORK_DIR/cache" \
+   -o "$WORK_DIR/first.pot" $SOURCES
+$XGETTEXT -j4 $OPTIONS --cache "$WORK_DIR/cache" -v \
+   -o "$WORK_DIR/cached.pot" $SOURCES 2> "$WORK_DIR/cached.log"
+check "xgettext --cache output" diff -u "$EXPECTED" "$WORK_DIR/cached.pot"
+check "xgettext --cache skipping" \
+   grep -q "^3 files (3 unchanged)" "$WORK_DIR/cached.log"
+
+$XGETTEXT -j1 -k -ktr:1c,2 -o "$WORK_DIR/bare.pot" $SOURCES
+$XGETTEXT -j1 --keyword= -ktr:1c,2 -o "$WORK_DIR/empty.pot" $SOURCES
+check "xgettext --keyword=" diff -u "$WORK_DIR/bare.pot" "$WORK_DIR/empty.pot"
+check "xgettext -k" grep -q "^msgctxt \"toolbar\"" "$WORK_DIR/bare.pot"
+check "xgettext -k drops defaults" \
+   sh -c "! grep -q '^msgid \"Label one\"' '$WORK_DIR/bare.pot'"
+
+echo "XGETTEXT RESULT: $RESULT"
+test "$RESULT" = "PASSED"
+
+#******************************************************************************
+# xgettext_test.sh (potext)
+#------------------------------------------------------------------------------
+# vim: ts=3 sw=3 wm=4 et ft=sh
+#------------------------------------------------------------------------------
@@ -0,0 +1,194 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          msgids.cpp
+ *
+ *      The potext-msgids tool, which generates the message-ID key table
+ *      used by the integer message-ID mode of po/gettext.hpp.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ * Usage:
+ *
+ *      potext-msgids [--output file.hpp] [--namespace name]
+ *          [--keys file.keys] source-file ...
+ *
+ *  The header is written to standard output unless --output is given.
+ *  The --keys option also writes the keys as a manifest (see manifest.hpp),
+ *  so that the catalogs can be pruned to the same set of messages.
+ *
+ *  The keys are sorted bytewise, which is the order msgid_index() expects.
+ *  The output depends only on the set of messages found, not on the order
+ *  of the source files, so that a build system can compare it with the
+ *  previous output and avoid needless recompiles.
+ */
+
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <iostream>                     /* std::cout, std::cerr             */
+#include <set>                          /* std::set<> template              */
+#include <sstream>                      /* std::ostringstream               */
+
+#include "po/sourcescanner.hpp"         /* po::sourcescanner class          */
+#include "po/wstrfunctions.hpp"         /* po::escape_c_string(), etc.      */
+
+static void
+show_help ()
+{
+    std::cout
+        << "Usage: potext-msgids [options] source-file ...\n\n"
+        << "Options:\n\n"
+        << "  --output file       Write the key header to this file.\n"
+        << "  --namespace name    The namespace of the table (po_msgids).\n"
+        << "  --keys file         Also write the keys as a manifest.\n"
+        << "  --help              Show this help.\n"
+        << std::endl
+        ;
+}
+
+/**
+ *  Writes the file only if its contents change, so that its timestamp
+ *  changes only when the keys change.
+ */
+
+static bool
+write_if_changed (const std::string & filename, const std::string & text)
+{
+    bool result = po::write_file_if_changed(filename, text);
+    if (! result)
+        std::cerr << "Cannot write " << filename << std::endl;
+
+    return result;
+}
+
+static std::string
+make_header (const std::set<std::string> & keys, const std::string & ns)
+{
+    std::ostringstream os;
+    os
+        << "/*\n"
+        << " * Generated by potext-msgids. Do not edit.\n"
+        << " */\n\n"
+        << "#include <cstddef>\n\n"
+        << "namespace " << ns << "\n{\n\n"
+        << "inline constexpr const char * keys [] =\n{\n"
+        ;
+    if (keys.empty())
+        os << "    \"\"\n";                /* no zero-length arrays in C++     */
+
+    for (const auto & k : keys)
+        os << "    \"" << po::escape_c_string(k) << "\",\n";
+
+    os
+        << "};\n\n"
+        << "inline constexpr std::size_t count = "
+        << (keys.empty() ? 1 : keys.size()) << ";\n\n"
+        << "}           // namespace " << ns << "\n"
+        ;
+    return os.str();
+}
+
+static std::string
+make_key_list (const std::set<std::string> & keys)
+{
+    std::string result = "# Generated by potext-msgids. Do not edit.\n";
+    for (const auto & k : keys)
+    {
+        result += po::escape_c_string(k);
+        result += '\n';
+    }
+    return result;
+}
+
+int
+main (int argc, char * argv [])
+{
+    std::string outfile;
+    std::string keysfile;
+    std::string ns = "po_msgids";
+    std::vector<std::string> sources;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--help" || arg == "-h")
+        {
+            show_help();
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--output" && has_value)
+            outfile = argv[++i];
+        else if (arg == "--namespace" && has_value)
+            ns = argv[++i];
+        else if (arg == "--keys" && has_value)
+            keysfile = argv[++i];
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            std::cerr << "Bad option: " << arg << std::endl;
+            show_help();
+            return EXIT_FAILURE;
+        }
+        else
+            sources.push_back(arg);
+    }
+    if (sources.empty())
+    {
+        show_help();
+        return EXIT_FAILURE;
+    }
+
+    po::sourcescanner scanner;
+    po::sourcescanner::messages msgs;
+    bool ok = true;
+    for (const auto & s : sources)
+    {
+        if (! scanner.scan_file(s, msgs))
+            ok = false;
+    }
+
+    std::set<std::string> keys;
+    for (const auto & m : msgs)
+        (void) keys.insert(po::sourcescanner::make_key(m));
+
+    std::string header = make_header(keys, ns);
+    if (outfile.empty())
+        std::cout << header;
+    else if (! write_if_changed(outfile, header))
+        ok = false;
+
+    if (! keysfile.empty() && ! write_if_changed(keysfile, make_key_list(keys)))
+        ok = false;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * msgids.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
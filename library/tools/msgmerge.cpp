@@ -0,0 +1,306 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          msgmerge.cpp
+ *
+ *      The potext-msgmerge tool, a multi-threaded replacement for msgmerge.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ * Usage:
+ *
+ *      potext-msgmerge [options] def.po ref.pot
+ *
+ *  The translations of def.po are merged into the messages of ref.pot, and
+ *  the result is written to standard output, to the --output file, or
+ *  back to def.po with --update. The matching is done by po::pomerge (see
+ *  pomerge.hpp). The messages of the template are matched by a pool of
+ *  threads, each taking the next block of messages from a shared index
+ *  and storing the matches in their slots, so the output does not depend
+ *  on the scheduling of the threads. A file is rewritten only if its
+ *  contents change.
+ */
+
+#include <algorithm>                    /* std::min()                       */
+#include <atomic>                       /* std::atomic<>                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <iostream>                     /* std::cout, std::cerr             */
+#include <stdexcept>                    /* std::runtime_error               */
+#include <thread>                       /* std::thread                      */
+
+#include "po/pomerge.hpp"               /* po::pomerge, po::parse_po...()   */
+#include "po/wstrfunctions.hpp"         /* po::read_file(), etc.            */
+
+namespace
+{
+
+/**
+ *  The number of messages a thread takes at a time.
+ */
+
+const std::size_t c_block = 64;
+
+void
+show_help ()
+{
+    std::cout
+<< "Usage: potext-msgmerge [options] def.po ref.pot\n\n"
+<< "Options:\n\n"
+<< "  -o, --output file         Write the merged catalog to this file;\n"
+<< "                            the default is standard output.\n"
+<< "  -U, --update              Write the merged catalog back to def.po.\n"
+<< "  -N, --no-fuzzy-matching   Do not guess translations for new messages.\n"
+<< "      --threshold x         The similarity (0 to 1) a fuzzy match needs\n"
+<< "                            (default 0.6).\n"
+<< "      --previous            Write the msgid of each fuzzy match as \"#|\".\n"
+<< "      --no-obsolete         Drop the translations no longer used.\n"
+<< "  -j, --jobs n              The number of threads (default: all cores).\n"
+<< "  -v, --verbose             Show the counts of matches.\n"
+<< "  -h, --help                Show this help.\n"
+<< std::endl
+    ;
+}
+
+/**
+ *  Reads and parses a catalog, reporting any error.
+ */
+
+bool
+read_entries (const std::string & filename, std::vector<po::poentry> & entries)
+{
+    std::string text;
+    if (! po::read_file(filename, text))
+    {
+        std::cerr << "Cannot read " << filename << std::endl;
+        return false;
+    }
+
+    int line = 0;
+    if (! po::parse_po_entries(text, entries, &line))
+    {
+        std::cerr << filename << ":" << line << ": syntax error" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  Gets the value of an option given as "--name=value", "--name value",
+ *  "-x value", or "-xvalue".
+ */
+
+bool
+option_value
+(
+    int argc, char * argv [], int & i,
+    const std::string & shortname,
+    const std::string & longname,
+    std::string & value
+)
+{
+    std::string arg = argv[i];
+    std::string longeq = longname + "=";
+    if (arg.compare(0, longeq.size(), longeq) == 0)
+    {
+        value = arg.substr(longeq.size());
+        return true;
+    }
+    if (arg == longname || (! shortname.empty() && arg == shortname))
+    {
+        if (i + 1 >= argc)
+            throw std::runtime_error("Missing value for " + arg);
+
+        value = argv[++i];
+        return true;
+    }
+    if
+    (
+        ! shortname.empty() && arg.size() > 2 &&
+        arg.compare(0, 2, shortname) == 0 && arg[1] != '-'
+    )
+    {
+        value = arg.substr(2);
+        return true;
+    }
+    return false;
+}
+
+}               // namespace
+
+int
+main (int argc, char * argv [])
+{
+    std::string outfile;
+    std::vector<std::string> files;
+    bool update = false;
+    bool fuzzy = true;
+    bool previous = false;
+    bool obsolete = true;
+    bool verbose = false;
+    double threshold = po::pomerge::sm_default_threshold;
+    unsigned jobs = std::thread::hardware_concurrency();
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            std::string value;
+            if (arg == "-h" || arg == "--help")
+            {
+                show_help();
+                return EXIT_SUCCESS;
+            }
+            else if (arg == "-U" || arg == "--update")
+                update = true;
+            else if (arg == "-N" || arg == "--no-fuzzy-matching")
+                fuzzy = false;
+            else if (arg == "--previous")
+                previous = true;
+            else if (arg == "--no-obsolete")
+                obsolete = false;
+            else if (arg == "-v" || arg == "--verbose")
+                verbose = true;
+            else if (option_value(argc, argv, i, "-o", "--output", value))
+                outfile = value;
+            else if (option_value(argc, argv, i, "", "--threshold", value))
+                threshold = std::stod(value);
+            else if (option_value(argc, argv, i, "-j", "--jobs", value))
+                jobs = unsigned(std::stoul(value));
+            else if (arg.size() > 1 && arg[0] == '-')
+                throw std::runtime_error("Bad option: " + arg);
+            else
+                files.push_back(arg);
+        }
+    }
+    catch (const std::exception & err)
+    {
+        std::cerr << err.what() << std::endl;
+        show_help();
+        return EXIT_FAILURE;
+    }
+    if (files.size() != 2 || (update && ! outfile.empty()))
+    {
+        show_help();
+        return EXIT_FAILURE;
+    }
+    if (update)
+        outfile = files[0];
+
+    std::vector<po::poentry> old;
+    std::vector<po::poentry> pot;
+    if (! read_entries(files[0], old) || ! read_entries(files[1], pot))
+        return EXIT_FAILURE;
+
+    po::pomerge merger(std::move(old));
+    merger.set_threshold(threshold);
+    merger.set_fuzzy_matching(fuzzy);
+    merger.set_previous(previous);
+    merger.set_keep_obsolete(obsolete);
+
+    std::vector<po::pomerge::match> matches(pot.size());
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] ()
+    {
+        po::pomerge::workspace ws;
+        for (;;)
+        {
+            std::size_t first = next.fetch_add(c_block);
+            if (first >= pot.size())
+                break;
+
+            std::size_t last = std::min(first + c_block, pot.size());
+            for (std::size_t i = first; i < last; ++i)
+                matches[i] = merger.find(pot[i], ws);
+        }
+    };
+    if (jobs == 0)
+        jobs = 1;
+
+    std::size_t blocks = (pot.size() + c_block - 1) / c_block;
+    if (jobs > blocks)
+        jobs = blocks > 0 ? unsigned(blocks) : 1 ;
+
+    std::vector<std::thread> pool;
+    for (unsigned j = 1; j < jobs; ++j)
+        pool.emplace_back(worker);
+
+    worker();                                   /* this thread helps, too   */
+    for (auto & t : pool)
+        t.join();
+
+    std::vector<po::poentry> merged = merger.merge(pot, matches);
+    std::string text;
+    for (const auto & e : merged)
+    {
+        if (! text.empty())
+            text += "\n";
+
+        text += po::po_entry_text(e);
+    }
+
+    bool ok = true;
+    if (outfile.empty() || outfile == "-")
+        std::cout << text;
+    else if (! po::write_file_if_changed(outfile, text))
+    {
+        std::cerr << "Cannot write " << outfile << std::endl;
+        ok = false;
+    }
+    if (verbose)
+    {
+        std::size_t exact = 0;
+        std::size_t fuzzycount = 0;
+        std::size_t untranslated = 0;
+        for (std::size_t i = 0; i < pot.size(); ++i)
+        {
+            const po::pomerge::match & m = matches[i];
+            if (pot[i].msgid.empty() && ! pot[i].has_ctxt)
+                continue;                       /* the header               */
+
+            if (m.m_index == po::pomerge::npos)
+                ++untranslated;
+            else if (m.m_fuzzy)
+                ++fuzzycount;
+            else
+                ++exact;
+        }
+        std::cerr
+            << exact << " exact, " << fuzzycount << " fuzzy, "
+            << untranslated << " untranslated, " << jobs << " threads"
+            << std::endl
+            ;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * msgmerge.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
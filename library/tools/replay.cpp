@@ -0,0 +1,446 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          replay.cpp
+ *
+ *      The potext-replay tool, which replays a lookup trace against a set
+ *      of catalogs and reports the latencies.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-17
+ * \license       See above.
+ *
+ * Usage:
+ *
+ *      potext-replay [options] --language lang trace-file
+ *
+ *  The trace is written by po::tracerecorder (see tracerecorder.hpp). The
+ *  catalogs are loaded by a po::dictionarymgr set up by the options, and
+ *  the dictionary of each domain in the trace is looked up before the
+ *  timing starts, so that the loading of catalogs is reported apart from
+ *  the lookups. Each thread then makes every lookup of the trace, in
+ *  order, starting at its own place in it so that the threads do not move
+ *  in step. Each lookup is timed, and the percentiles of all of them are
+ *  shown. The time includes that of copying the result, as the gettext
+ *  functions return a copy, and a few tens of nanoseconds of clock
+ *  overhead.
+ */
+
+#include <algorithm>                    /* std::sort()                      */
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <iomanip>                      /* std::setprecision()              */
+#include <iostream>                     /* std::cout, std::cerr             */
+#include <stdexcept>                    /* std::runtime_error               */
+#include <thread>                       /* std::thread                      */
+
+#include "po/dictionarymgr.hpp"         /* po::dictionarymgr class          */
+#include "po/tracerecorder.hpp"         /* po::tracerecorder, tracedata     */
+
+namespace
+{
+
+using clocktype = std::chrono::steady_clock;
+
+void
+show_help ()
+{
+    std::cout
+<< "Usage: potext-replay [options] --language lang trace-file\n\n"
+<< "Options:\n\n"
+<< "  -d, --directory dir       Add a catalog directory; the first one given\n"
+<< "                            has precedence. May be repeated.\n"
+<< "  -b, --bind domain=dir     Bind a domain to its catalog directory.\n"
+<< "  -l, --language lang       The language of the lookups, e.g. \"de\".\n"
+<< "  -c, --codeset name        Convert the translations to this codeset.\n"
+<< "      --no-fuzzy            Do not use the fuzzy translations.\n"
+<< "      --shared-cache dir    Map the catalogs from compiled images kept\n"
+<< "                            in this directory.\n"
+<< "      --cold bytes          Compress the translations longer than this.\n"
+<< "  -j, --jobs n              The number of threads (default 1).\n"
+<< "  -r, --rounds n            The times each thread replays the trace\n"
+<< "                            (default 1).\n"
+<< "  -v, --verbose             Show the trace and the catalogs loaded.\n"
+<< "  -h, --help                Show this help.\n"
+<< std::endl
+    ;
+}
+
+/**
+ *  Gets the value of an option given as "--name=value", "--name value",
+ *  "-x value", or "-xvalue".
+ */
+
+bool
+option_value
+(
+    int argc, char * argv [], int & i,
+    const std::string & shortname,
+    const std::string & longname,
+    std::string & value
+)
+{
+    std::string arg = argv[i];
+    std::string longeq = longname + "=";
+    if (arg.compare(0, longeq.size(), longeq) == 0)
+    {
+        value = arg.substr(longeq.size());
+        return true;
+    }
+    if (arg == longname || (! shortname.empty() && arg == shortname))
+    {
+        if (i + 1 >= argc)
+            throw std::runtime_error("Missing value for " + arg);
+
+        value = argv[++i];
+        return true;
+    }
+    if
+    (
+        ! shortname.empty() && arg.size() > 2 &&
+        arg.compare(0, 2, shortname) == 0 && arg[1] != '-'
+    )
+    {
+        value = arg.substr(2);
+        return true;
+    }
+    return false;
+}
+
+/**
+ *  The results of one thread.
+ */
+
+struct replayresult
+{
+    std::vector<std::uint32_t> rr_latencies;    /* nanoseconds              */
+    std::size_t rr_translated;
+};
+
+/**
+ *  Makes each lookup of the trace, rounds times, starting at the given
+ *  record. A lookup counts as translated if the result differs from the
+ *  string returned when there is no translation.
+ */
+
+void
+replay
+(
+    const po::tracedata & trace,
+    const std::vector<const po::dictionary *> & dicts,
+    const std::string & codeset,
+    std::size_t first,
+    unsigned rounds,
+    replayresult & result
+)
+{
+    const std::vector<std::string> & s = trace.td_strings;
+    std::size_t count = trace.td_records.size();
+    result.rr_latencies.reserve(count * rounds);
+    result.rr_translated = 0;
+    for (unsigned round = 0; round < rounds; ++round)
+    {
+        for (std::size_t k = 0; k < count; ++k)
+        {
+            const po::tracerecord & r = trace.td_records[(first + k) % count];
+            const po::dictionary & d = *dicts[r.tr_domain];
+            const std::string & msgctxt = s[r.tr_msgctxt];
+            const std::string & msgid = s[r.tr_msgid];
+            const std::string & plural = s[r.tr_msgid_plural];
+            int n = int(r.tr_count);
+            bool translated = false;
+            auto start = clocktype::now();
+            switch (r.tr_kind)
+            {
+            case po::tracekind::ngettext:
+            case po::tracekind::dngettext:
+
+                translated = d.translate_plural
+                (
+                    msgid, plural, n, codeset
+                ) != (n == 1 ? msgid : plural);
+                break;
+
+            case po::tracekind::pgettext:
+            case po::tracekind::dpgettext:
+
+                translated =
+                    d.translate_ctxt(msgctxt, msgid, codeset) != msgid;
+                break;
+
+            case po::tracekind::idgettext:
+
+                if (r.tr_msgctxt != 0)
+                {
+                    translated =
+                        d.translate_ctxt(msgctxt, msgid, codeset) != msgid;
+                }
+                else
+                    translated = d.translate(msgid, codeset) != msgid;
+                break;
+
+            default:
+
+                translated = d.translate(msgid, codeset) != msgid;
+                break;
+            }
+            auto stop = clocktype::now();
+            result.rr_latencies.push_back
+            (
+                std::uint32_t
+                (
+                    std::chrono::duration_cast<std::chrono::nanoseconds>
+                    (
+                        stop - start
+                    ).count()
+                )
+            );
+            if (translated)
+                ++result.rr_translated;
+        }
+    }
+}
+
+/**
+ *  Gets a percentile of sorted latencies.
+ */
+
+std::uint32_t
+percentile (const std::vector<std::uint32_t> & sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+
+    std::size_t i = std::size_t(p / 100.0 * double(sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+}               // namespace
+
+int
+main (int argc, char * argv [])
+{
+    std::vector<std::string> directories;
+    std::vector<std::pair<std::string, std::string>> bindings;
+    std::vector<std::string> files;
+    std::string langname;
+    std::string codeset;
+    std::string sharedcache;
+    std::size_t cold = 0;
+    bool fuzzy = true;
+    bool verbose = false;
+    unsigned jobs = 1;
+    unsigned rounds = 1;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            std::string value;
+            if (arg == "-h" || arg == "--help")
+            {
+                show_help();
+                return EXIT_SUCCESS;
+            }
+            else if (arg == "--no-fuzzy")
+                fuzzy = false;
+            else if (arg == "-v" || arg == "--verbose")
+                verbose = true;
+            else if (option_value(argc, argv, i, "-d", "--directory", value))
+                directories.push_back(value);
+            else if (option_value(argc, argv, i, "-b", "--bind", value))
+            {
+                std::size_t eq = value.find('=');
+                if (eq == std::string::npos || eq == 0)
+                    throw std::runtime_error("Bad binding: " + value);
+
+                bindings.emplace_back
+                (
+                    value.substr(0, eq), value.substr(eq + 1)
+                );
+            }
+            else if (option_value(argc, argv, i, "-l", "--language", value))
+                langname = value;
+            else if (option_value(argc, argv, i, "-c", "--codeset", value))
+                codeset = value;
+            else if (option_value(argc, argv, i, "", "--shared-cache", value))
+                sharedcache = value;
+            else if (option_value(argc, argv, i, "", "--cold", value))
+                cold = std::size_t(std::stoul(value));
+            else if (option_value(argc, argv, i, "-j", "--jobs", value))
+                jobs = unsigned(std::stoul(value));
+            else if (option_value(argc, argv, i, "-r", "--rounds", value))
+                rounds = unsigned(std::stoul(value));
+            else if (arg.size() > 1 && arg[0] == '-')
+                throw std::runtime_error("Bad option: " + arg);
+            else
+                files.push_back(arg);
+        }
+    }
+    catch (const std::exception & err)
+    {
+        std::cerr << err.what() << std::endl;
+        show_help();
+        return EXIT_FAILURE;
+    }
+    if (files.size() != 1 || langname.empty())
+    {
+        show_help();
+        return EXIT_FAILURE;
+    }
+
+    po::language lang = po::language::from_name(langname);
+    if (! lang)
+    {
+        std::cerr << "Unknown language: " << langname << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    po::tracedata trace;
+    if (! po::tracerecorder::load(files[0], trace))
+    {
+        std::cerr << "Cannot read the trace " << files[0] << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (trace.td_records.empty())
+    {
+        std::cerr << "The trace " << files[0] << " is empty" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    po::dictionarymgr mgr;
+    mgr.set_use_fuzzy(fuzzy);
+    mgr.set_shared_cache(sharedcache);
+    mgr.set_cold_threshold(cold);
+    for (const auto & dir : directories)
+        mgr.add_directory(dir);
+
+    for (const auto & b : bindings)
+        (void) mgr.bindtextdomain(b.first, b.second);
+
+    mgr.set_language(lang);
+
+    /*
+     * Load the dictionary of each domain used, outside of the timing. The
+     * empty domain is that of gettext() and friends, the current one.
+     */
+
+    auto loadstart = clocktype::now();
+    std::vector<const po::dictionary *> dicts(trace.td_strings.size(), nullptr);
+    for (const auto & r : trace.td_records)
+    {
+        if (dicts[r.tr_domain] == nullptr)
+        {
+            const std::string & domain = trace.td_strings[r.tr_domain];
+            if (domain.empty())
+                dicts[r.tr_domain] = &mgr.get_dictionary();
+            else
+                dicts[r.tr_domain] = &mgr.get_domain_dictionary(domain);
+        }
+    }
+    double loadms = std::chrono::duration<double, std::milli>
+    (
+        clocktype::now() - loadstart
+    ).count();
+
+    if (jobs == 0)
+        jobs = 1;
+
+    if (rounds == 0)
+        rounds = 1;
+
+    std::size_t count = trace.td_records.size();
+    std::vector<replayresult> results(jobs);
+    std::vector<std::thread> pool;
+    auto wallstart = clocktype::now();
+    for (unsigned j = 1; j < jobs; ++j)
+    {
+        pool.emplace_back
+        (
+            replay, std::cref(trace), std::cref(dicts), std::cref(codeset),
+            count * j / jobs, rounds, std::ref(results[j])
+        );
+    }
+    replay(trace, dicts, codeset, 0, rounds, results[0]);
+    for (auto & t : pool)
+        t.join();
+
+    double wallsec = std::chrono::duration<double>
+    (
+        clocktype::now() - wallstart
+    ).count();
+
+    std::vector<std::uint32_t> all;
+    all.reserve(count * rounds * jobs);
+
+    std::size_t translated = 0;
+    double total = 0.0;
+    for (const auto & r : results)
+    {
+        all.insert(all.end(), r.rr_latencies.begin(), r.rr_latencies.end());
+        translated += r.rr_translated;
+    }
+    for (auto ns : all)
+        total += double(ns);
+
+    std::sort(all.begin(), all.end());
+    if (verbose)
+    {
+        std::cout
+            << "Trace: " << count << " lookups, "
+            << trace.td_strings.size() - 1 << " strings, "
+            << trace.td_threads << " threads, "
+            << double(trace.td_records.back().tr_time) / 1.0e9 << " s\n"
+            << "Catalogs: loaded in " << loadms << " ms, "
+            << mgr.get_dictionary().memory_usage()
+            << " bytes in the current domain\n"
+            ;
+    }
+    std::cout
+        << std::fixed << std::setprecision(1)
+        << "Lookups:    " << all.size() << " (" << jobs << " threads, "
+        << rounds << " rounds)\n"
+        << "Translated: "
+        << 100.0 * double(translated) / double(all.size()) << "%\n"
+        << "Latency ns: mean " << total / double(all.size())
+        << ", p50 " << percentile(all, 50.0)
+        << ", p90 " << percentile(all, 90.0)
+        << ", p99 " << percentile(all, 99.0)
+        << ", p99.9 " << percentile(all, 99.9)
+        << ", max " << all.back() << "\n"
+        << "Throughput: " << double(all.size()) / wallsec / 1.0e6
+        << " million lookups/s"
+        << std::endl
+        ;
+    return EXIT_SUCCESS;
+}
+
+/*
+ * replay.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
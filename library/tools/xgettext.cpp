@@ -0,0 +1,628 @@
+/*
+ *  This file is part of potext.
+ *
+ *  potext is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  potext is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with potext; if not, write to the Free Software Foundation, Inc., 59
+ *  Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *  See tinydoc/LICENSE.md for the original tinygettext licensing statement.
+ *  If you do not like the changes or the GPL licensing, use the original
+ *  tinygettext project, available at GitHub:
+ *
+ *      https://github.com/tinygettext/tinygettext
+ */
+
+/**
+ * \file          xgettext.cpp
+ *
+ *      The potext-xgettext tool, a multi-threaded replacement for xgettext
+ *      for C and C++ sources.
+ *
+ * \library       potext
+ * \author        Chris Ahlstrom
+ * \date          2026-10-17
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ * Usage:
+ *
+ *      potext-xgettext [options] source-file ...
+ *
+ *  The source files are scanned in parallel by a pool of threads, each
+ *  taking the next file from a shared index. Each file's messages are
+ *  stored in that file's slot, and the slots are merged in the order the
+ *  files were given, so the output does not depend on the scheduling of
+ *  the threads. The .pot file is rewritten only if its contents change.
+ *
+ *  With the --cache option, the FNV-1a hash of each file's contents and the
+ *  messages found in it are saved. On the next run a file whose hash is
+ *  unchanged is not tokenized again. The cache is discarded if the
+ *  keywords or comment options change.
+ */
+
+#include <algorithm>                    /* std::sort()                      */
+#include <atomic>                       /* std::atomic<>                    */
+#include <cstdint>                      /* std::uint64_t                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <iostream>                     /* std::cout, std::cerr             */
+#include <map>                          /* std::map<>                       */
+#include <set>                          /* std::set<>                       */
+#include <sstream>                      /* std::istringstream               */
+#include <stdexcept>                    /* std::runtime_error               */
+#include <thread>                       /* std::thread                      */
+#include <unordered_map>                /* std::unordered_map<>             */
+
+#include "po/powriter.hpp"              /* po::poentry, po::po_entry_text() */
+#include "po/sourcescanner.hpp"         /* po::sourcescanner class          */
+#include "po/wstrfunctions.hpp"         /* po::read_file(), etc.            */
+
+namespace
+{
+
+using message = po::sourcescanner::message;
+using messages = po::sourcescanner::messages;
+
+/**
+ *  The results for one source file.
+ */
+
+using fileresult = struct
+{
+    std::uint64_t hash;                 /* the FNV-1a hash of the contents  */
+    messages msgs;                      /* the messages found               */
+    bool ok;                            /* the file could be read           */
+    bool cached;                        /* the messages came from the cache */
+};
+
+using cacheentry = struct
+{
+    std::uint64_t hash;
+    messages msgs;
+};
+
+using cachemap = std::unordered_map<std::string, cacheentry>;
+
+const std::string c_cache_magic = "# potext-xgettext cache 1";
+
+std::string
+hex_string (std::uint64_t value)
+{
+    std::ostringstream os;
+    os << std::hex << value;
+    return os.str();
+}
+
+void
+show_help ()
+{
+    std::cout
+<< "Usage: potext-xgettext [options] source-file ...\n\n"
+<< "Options:\n\n"
+<< "  -o, --output file         Write the template to this file (messages.pot);\n"
+<< "                            '-' writes to standard output.\n"
+<< "  -f, --files-from file     Read the source file names from this file.\n"
+<< "  -k, --keyword[=spec]      Add a keyword, e.g. -ktr:1c,2. With no spec\n"
+<< "                            the default keywords are dropped.\n"
+<< "  -c, --add-comments[=tag]  Extract comments (starting with 'tag') that\n"
+<< "                            precede keyword calls.\n"
+<< "  -j, --jobs n              The number of threads (default: all cores).\n"
+<< "      --cache file          Skip the files that are unchanged since the\n"
+<< "                            last run that used this cache file.\n"
+<< "      --package-name name   The Project-Id-Version of the header.\n"
+<< "  -s, --sort-output         Sort the messages by ID, not by location.\n"
+<< "  -v, --verbose             Show the file and message counts.\n"
+<< "  -h, --help                Show this help.\n"
+<< std::endl
+    ;
+}
+
+/**
+ *  Splits a tab-separated cache line.
+ */
+
+std::vector<std::string>
+split_tabs (const std::string & line)
+{
+    std::vector<std::string> result;
+    std::size_t pos = 0;
+    for (;;)
+    {
+        std::size_t tab = line.find('\t', pos);
+        result.push_back(line.substr(pos, tab - pos));
+        if (tab == std::string::npos)
+            break;
+
+        pos = tab + 1;
+    }
+    return result;
+}
+
+/**
+ *  The cache is a text file. After the magic line and the configuration
+ *  hash, each file has a "file" line followed by a "msg" line for each of
+ *  its messages. The strings are C-escaped, so they contain no tabs or
+ *  newlines:
+ *
+ *      file <hash> <path>
+ *      msg <line> <c|-><p|-> <msgctxt> <msgid> <msgid_plural> <comment>
+ */
+
+bool
+load_cache
+(
+    const std::string & filename,
+    const std::string & config,
+    cachemap & cache
+)
+{
+    std::string text;
+    if (! po::read_file(filename, text))
+        return false;
+
+    std::istringstream in(text);
+    std::string line;
+    if (! std::getline(in, line) || line != c_cache_magic)
+        return false;
+
+    if (! std::getline(in, line) || line != "config\t" + config)
+        return false;
+
+    cacheentry * current = nullptr;
+    while (std::getline(in, line))
+    {
+        std::vector<std::string> fields = split_tabs(line);
+        if (fields[0] == "file" && fields.size() == 3)
+        {
+            cacheentry & ce = cache[po::unescape_c_string(fields[2])];
+            ce.hash = std::stoull(fields[1], nullptr, 16);
+            ce.msgs.clear();
+            current = &ce;
+        }
+        else if (fields[0] == "msg" && fields.size() == 7 && current)
+        {
+            message m;
+            m.line = std::stoi(fields[1]);
+            m.has_ctxt = fields[2].size() == 2 && fields[2][0] == 'c';
+            m.has_plural = fields[2].size() == 2 && fields[2][1] == 'p';
+            m.msgctxt = po::unescape_c_string(fields[3]);
+            m.msgid = po::unescape_c_string(fields[4]);
+            m.msgid_plural = po::unescape_c_string(fields[5]);
+            m.comment = po::unescape_c_string(fields[6]);
+            current->msgs.push_back(m);
+        }
+        else
+        {
+            cache.clear();                  /* damaged; start over          */
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string
+cache_text
+(
+    const std::string & config,
+    const std::vector<std::string> & files,
+    const std::vector<fileresult> & results
+)
+{
+    std::string result = c_cache_magic + "\nconfig\t" + config + "\n";
+    for (std::size_t f = 0; f < files.size(); ++f)
+    {
+        const fileresult & fr = results[f];
+        if (! fr.ok)
+            continue;
+
+        result += "file\t" + hex_string(fr.hash) + "\t";
+        result += po::escape_c_string(files[f]) + "\n";
+        for (const auto & m : fr.msgs)
+        {
+            result += "msg\t" + std::to_string(m.line) + "\t";
+            result += m.has_ctxt ? 'c' : '-' ;
+            result += m.has_plural ? 'p' : '-' ;
+            result += "\t" + po::escape_c_string(m.msgctxt);
+            result += "\t" + po::escape_c_string(m.msgid);
+            result += "\t" + po::escape_c_string(m.msgid_plural);
+            result += "\t" + po::escape_c_string(m.comment) + "\n";
+        }
+    }
+    return result;
+}
+
+/**
+ *  Merges the messages of all files, in file order, into .pot entries.
+ *  Duplicates get their references and comments appended.
+ */
+
+std::vector<po::poentry>
+merge_messages
+(
+    const std::vector<fileresult> & results,
+    bool sortoutput
+)
+{
+    std::vector<po::poentry> entries;
+    std::map<std::string, std::size_t> index;
+    for (const auto & fr : results)
+    {
+        for (const auto & m : fr.msgs)
+        {
+            std::string key = po::sourcescanner::make_key(m);
+            std::string ref = m.filename + ":" + std::to_string(m.line);
+            auto it = index.find(key);
+            if (it == index.end())
+            {
+                po::poentry e;
+                e.has_ctxt = m.has_ctxt;
+                e.msgctxt = m.msgctxt;
+                e.msgid = m.msgid;
+                e.has_plural = m.has_plural;
+                e.msgid_plural = m.msgid_plural;
+                if (! m.comment.empty())
+                    e.extracted.push_back(m.comment);
+
+                e.references.push_back(ref);
+                index[key] = entries.size();
+                entries.push_back(e);
+            }
+            else
+            {
+                po::poentry & e = entries[it->second];
+                if (m.has_plural)
+                {
+                    if (! e.has_plural)
+                    {
+                        e.has_plural = true;
+                        e.msgid_plural = m.msgid_plural;
+                    }
+                    else if (e.msgid_plural != m.msgid_plural)
+                    {
+                        std::cerr
+                            << ref << ": plural form differs from the one "
+                            << "at " << e.references.front() << std::endl
+                            ;
+                    }
+                }
+                if
+                (
+                    ! m.comment.empty() &&
+                    std::find(e.extracted.begin(), e.extracted.end(),
+                        m.comment) == e.extracted.end()
+                )
+                {
+                    e.extracted.push_back(m.comment);
+                }
+                if
+                (
+                    std::find(e.references.begin(), e.references.end(), ref)
+                        == e.references.end()
+                )
+                {
+                    e.references.push_back(ref);
+                }
+            }
+        }
+    }
+    if (sortoutput)
+    {
+        std::sort
+        (
+            entries.begin(), entries.end(),
+            [] (const po::poentry & a, const po::poentry & b)
+            {
+                if (a.msgid != b.msgid)
+                    return a.msgid < b.msgid;
+
+                if (a.has_ctxt != b.has_ctxt)
+                    return ! a.has_ctxt;
+
+                return a.msgctxt < b.msgctxt;
+            }
+        );
+    }
+    return entries;
+}
+
+/**
+ *  Gets the value of an option given as "--name=value", "--name value",
+ *  "-x value", or "-xvalue".
+ */
+
+bool
+option_value
+(
+    int argc, char * argv [], int & i,
+    const std::string & shortname,
+    const std::string & longname,
+    std::string & value
+)
+{
+    std::string arg = argv[i];
+    std::string longeq = longname + "=";
+    if (arg.compare(0, longeq.size(), longeq) == 0)
+    {
+        value = arg.substr(longeq.size());
+        return true;
+    }
+    if (arg == longname || (! shortname.empty() && arg == shortname))
+    {
+        if (i + 1 >= argc)
+            throw std::runtime_error("Missing value for " + arg);
+
+        value = argv[++i];
+        return true;
+    }
+    if
+    (
+        ! shortname.empty() && arg.size() > 2 &&
+        arg.compare(0, 2, shortname) == 0 && arg[1] != '-'
+    )
+    {
+        value = arg.substr(2);
+        return true;
+    }
+    return false;
+}
+
+}               // namespace
+
+int
+main (int argc, char * argv [])
+{
+    std::string outfile = "messages.pot";
+    std::string cachefile;
+    std::string package;
+    std::vector<std::string> files;
+    std::vector<std::string> keywords;
+    bool nodefaults = false;
+    bool comments = false;
+    std::string commenttag;
+    bool sortoutput = false;
+    bool verbose = false;
+    unsigned jobs = std::thread::hardware_concurrency();
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            std::string value;
+            if (arg == "-h" || arg == "--help")
+            {
+                show_help();
+                return EXIT_SUCCESS;
+            }
+            else if (arg == "-k" || arg == "--keyword")
+            {
+                nodefaults = true;              /* as with xgettext -k      */
+            }
+            else if (arg == "-c" || arg == "--add-comments")
+            {
+                comments = true;
+                commenttag.clear();
+            }
+            else if (arg == "-s" || arg == "--sort-output")
+                sortoutput = true;
+            else if (arg == "-v" || arg == "--verbose")
+                verbose = true;
+            else if (option_value(argc, argv, i, "-o", "--output", value))
+                outfile = value;
+            else if (option_value(argc, argv, i, "-k", "--keyword", value))
+            {
+                if (value.empty())
+                    nodefaults = true;          /* "--keyword=" is "-k"     */
+                else
+                    keywords.push_back(value);
+            }
+            else if (option_value(argc, argv, i, "-c", "--add-comments", value))
+            {
+                comments = true;
+                commenttag = value;
+            }
+            else if (option_value(argc, argv, i, "-j", "--jobs", value))
+                jobs = unsigned(std::stoul(value));
+            else if (option_value(argc, argv, i, "", "--cache", value))
+                cachefile = value;
+            else if (option_value(argc, argv, i, "", "--package-name", value))
+                package = value;
+            else if (option_value(argc, argv, i, "-f", "--files-from", value))
+            {
+                std::string list;
+                if (! po::read_file(value, list))
+                    throw std::runtime_error("Cannot read " + value);
+
+                std::istringstream in(list);
+                std::string line;
+                while (std::getline(in, line))
+                {
+                    if (! line.empty() && line.back() == '\r')
+                        line.pop_back();
+
+                    if (! line.empty() && line[0] != '#')
+                        files.push_back(line);
+                }
+            }
+            else if (arg.size() > 1 && arg[0] == '-')
+                throw std::runtime_error("Bad option: " + arg);
+            else
+                files.push_back(arg);
+        }
+    }
+    catch (const std::exception & err)
+    {
+        std::cerr << err.what() << std::endl;
+        show_help();
+        return EXIT_FAILURE;
+    }
+
+    /*
+     *  The "-k" option is applied after all the others, so that its
+     *  position on the command line does not matter.
+     */
+
+    po::sourcescanner scanner;
+    std::string config = nodefaults ? "nodefaults" : "defaults" ;
+    if (nodefaults)
+        scanner.clear_keywords();
+
+    for (const auto & k : keywords)
+    {
+        if (! scanner.add_keyword(k))
+        {
+            std::cerr << "Bad keyword: " << k << std::endl;
+            return EXIT_FAILURE;
+        }
+        config += " " + k;
+    }
+    if (comments)
+    {
+        scanner.set_comment_tag(commenttag);
+        config += " comments=" + commenttag;
+    }
+    config = hex_string(po::fnv1a_hash(config));
+    if (files.empty())
+    {
+        show_help();
+        return EXIT_FAILURE;
+    }
+
+    /*
+     *  Drop duplicate file names, keeping the first.
+     */
+
+    std::set<std::string> seen;
+    std::vector<std::string> sources;
+    for (const auto & f : files)
+    {
+        if (seen.insert(f).second)
+            sources.push_back(f);
+    }
+
+    cachemap cache;
+    if (! cachefile.empty())
+    {
+        try
+        {
+            (void) load_cache(cachefile, config, cache);
+        }
+        catch (const std::exception &)
+        {
+            cache.clear();                      /* a bad number; ignore it  */
+        }
+    }
+
+    std::vector<fileresult> results(sources.size());
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] ()
+    {
+        for (;;)
+        {
+            std::size_t f = next.fetch_add(1);
+            if (f >= sources.size())
+                break;
+
+            fileresult & fr = results[f];
+            std::string text;
+            fr.ok = po::read_file(sources[f], text);
+            fr.cached = false;
+            if (! fr.ok)
+                continue;
+
+            fr.hash = po::fnv1a_hash(text);
+            auto it = cache.find(sources[f]);
+            if (it != cache.end() && it->second.hash == fr.hash)
+            {
+                fr.msgs = it->second.msgs;
+                for (auto & m : fr.msgs)
+                    m.filename = sources[f];
+
+                fr.cached = true;
+            }
+            else
+                scanner.scan(text, sources[f], fr.msgs);
+        }
+    };
+    if (jobs == 0)
+        jobs = 1;
+
+    if (jobs > sources.size())
+        jobs = unsigned(sources.size());
+
+    std::vector<std::thread> pool;
+    for (unsigned j = 1; j < jobs; ++j)
+        pool.emplace_back(worker);
+
+    worker();                                   /* this thread helps, too   */
+    for (auto & t : pool)
+        t.join();
+
+    bool ok = true;
+    std::size_t cachedcount = 0;
+    for (std::size_t f = 0; f < sources.size(); ++f)
+    {
+        if (! results[f].ok)
+        {
+            std::cerr << "Cannot read " << sources[f] << std::endl;
+            ok = false;
+        }
+        else if (results[f].cached)
+            ++cachedcount;
+    }
+
+    std::vector<po::poentry> entries = merge_messages(results, sortoutput);
+    bool plurals = false;
+    for (const auto & e : entries)
+    {
+        if (e.has_plural)
+            plurals = true;
+    }
+
+    std::string pot = po::pot_header_text(package, plurals);
+    for (const auto & e : entries)
+    {
+        pot += "\n";
+        pot += po::po_entry_text(e);
+    }
+    if (outfile == "-")
+        std::cout << pot;
+    else if (! po::write_file_if_changed(outfile, pot))
+    {
+        std::cerr << "Cannot write " << outfile << std::endl;
+        ok = false;
+    }
+
+    if (! cachefile.empty())
+    {
+        std::string text = cache_text(config, sources, results);
+        if (! po::write_file_if_changed(cachefile, text))
+        {
+            std::cerr << "Cannot write " << cachefile << std::endl;
+            ok = false;
+        }
+    }
+    if (verbose)
+    {
+        std::cerr
+            << sources.size() << " files (" << cachedcount << " unchanged), "
+            << entries.size() << " messages, " << jobs << " threads"
+            << std::endl
+            ;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * xgettext.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
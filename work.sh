@@ -8,7 +8,7 @@
 # \library        potext
 # \author         Chris Ahlstrom
 # \date           2024-02-06
-# \update         2024-04-14
+# \update         2026-10-18
 # \version        $Revision$
 # \license        $XPC_SUITE_GPL_LICENSE$
 #
@@ -30,7 +30,7 @@ LANG=C
 export LANG
 CYGWIN=binmode
 export CYGWIN
-export POTEXT_SCRIPT_EDIT_DATE="2024-04-14"
+export POTEXT_SCRIPT_EDIT_DATE="2026-10-18"
 export POTEXT_LIBRARY_API_VERSION="0.2"
 export POTEXT_LIBRARY_VERSION="$POTEXT_LIBRARY_API_VERSION.0"
 export POTEXT="potext"
@@ -48,6 +48,7 @@ DOMAKEPDF="no"       # --pdf. Make the manual, always as a separate step.
 DOPACK="no"          # --pack. Clean and create a tar-file.
 DORELEASE="no"       # --release. as opposed to debug; also PDF made
 DOSTATIC="yes"       # --static
+DOTSAN="no"          # --tsan. Build with ThreadSanitizer, run stress test.
 DOVERSION="no"       # --version. Duouble duh!
 EXTRAFLAGS=""
 MAKEFILE="./build/build.ninja"
@@ -125,6 +126,11 @@ if test $# -ge 1 ; then
             DOSTATIC="yes"
             ;;
 
+         --tsan)
+            DOTSAN="yes"
+            DOMAKE="no"
+            ;;
+
          --version)
             DOVERSION="yes"
             DOBOOTSTRAP="no"
@@ -172,6 +178,8 @@ be more to come.
  --install           Run 'meson install' to install the library and PDF.
  --dist              Make a Meson dist package and exit.
  --clang             Rebuild the code using the Clang compilers.
+ --tsan              Build in 'build-tsan' with ThreadSanitizer, and run the
+                     stress test there. Add --clang to use Clang.
  --pdf               Build just the PDF documentation and exit.
  --clean             Delete the usual derived files from the project. Also
                      do "git checkout doc/potext-developer-guide.pdf"
@@ -354,6 +362,25 @@ if test "$DOMAKE" = "yes" ; then
 
 fi
 
+# Build with ThreadSanitizer in a directory of its own, and run the stress
+# test, which fails if TSan reports a data race.
+
+if test "$DOTSAN" = "yes" ; then
+
+   TSANOPTIONS="-Denable_tsan=true"
+   if test "$DOCLANG" = "yes" ; then
+      export CC=clang
+      export CXX=clang++
+      TSANOPTIONS="$TSANOPTIONS -Db_lundef=false"
+   fi
+   if test ! -f "./build-tsan/build.ninja" ; then
+      meson setup $TSANOPTIONS build-tsan/
+   fi
+   meson test -C build-tsan 'Potext Stress Test'
+   exit $?
+
+fi
+
 # Check for root, then install. We could let meson prompt the user
 # to automatically become root.
 